@@ -0,0 +1,132 @@
+//
+//  EditorBenchmark.cpp
+//  Obvious
+//
+//  Opens N plugin editors and drives every instance's value parameter from
+//  an automation thread, as a DAW's audio thread would, while the main
+//  thread runs the message loop. Reports the message thread's CPU time,
+//  which is what the editors cost the host's UI.
+//
+//  The editors are not put on the desktop unless --desktop is given (it
+//  needs a display), so by default painting is not included; everything
+//  that decides whether to paint is. No OBS is needed: the engines connect
+//  in the background and queue while they cannot.
+//
+//  Options:
+//    --editors N      number of instances with an open editor     (50)
+//    --seconds S      length of the run                           (10)
+//    --rate Hz        parameter changes per second per instance   (1000)
+//    --desktop        show the editors in windows
+//
+
+#include <JuceHeader.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <thread>
+
+#include "PluginProcessor.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double threadCpuSeconds()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1.0e9;
+}
+
+static juce::String option(const juce::ArgumentList& args, const juce::String& name, const juce::String& fallback)
+{
+    return args.containsOption(name) ? args.getValueForOption(name) : fallback;
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    const int numEditors  = juce::jmax(1, option(args, "--editors", "50").getIntValue());
+    const double seconds  = option(args, "--seconds", "10").getDoubleValue();
+    const double rate     = juce::jmax(1.0, option(args, "--rate", "1000").getDoubleValue());
+    const bool desktop    = args.containsOption("--desktop");
+
+    std::vector<std::unique_ptr<ObviousAudioProcessor>> instances;
+    std::vector<std::unique_ptr<juce::AudioProcessorEditor>> editors;
+
+    for (int i = 0; i < numEditors; ++i) {
+        auto instance = std::make_unique<ObviousAudioProcessor>();
+        auto settingsStorage = instance->settings();
+        settingsStorage.setProperty(ParameterIDIP, "127.0.0.1", nullptr);
+        settingsStorage.setProperty(ParameterIDPort, "1", nullptr);
+        settingsStorage.setProperty(ParameterIDScene, "Scene", nullptr);
+        settingsStorage.setProperty(ParameterIDSource, "source" + juce::String(i), nullptr);
+        settingsStorage.setProperty(ParameterIDCommandCategory, (int)CommandCategorySource, nullptr);
+        settingsStorage.setProperty(ParameterIDCommand, (int)ScaleX, nullptr);
+        settingsStorage.setProperty(ParameterIDRangeUpper, 2.0, nullptr);
+
+        std::unique_ptr<juce::AudioProcessorEditor> editor(instance->createEditorIfNeeded());
+        if (desktop) {
+            editor->setTopLeftPosition(40 + (i % 10) * 30, 40 + (i / 10) * 30);
+            editor->addToDesktop(juce::ComponentPeer::windowHasTitleBar);
+            editor->setVisible(true);
+        }
+
+        instances.push_back(std::move(instance));
+        editors.push_back(std::move(editor));
+    }
+
+    std::atomic<uint64_t> changes { 0 };
+    double messageThreadCpu = 0.0;
+    double wallSeconds = 0.0;
+
+    // Runs on the message thread once the loop is going, so the thread CPU clock is the message thread's
+    juce::MessageManager::callAsync([&] {
+        messageThreadCpu = threadCpuSeconds();
+    });
+
+    std::thread automation([&] {
+
+        const auto interval = std::chrono::duration<double>(1.0 / rate);
+        const auto start = Clock::now();
+        auto next = start;
+
+        for (int64_t step = 0; Clock::now() - start < std::chrono::duration<double>(seconds); ++step) {
+
+            const double t = (double)step / rate;
+            for (int i = 0; i < numEditors; ++i) {
+                const float target = (float)(0.5 + 0.45 * std::sin(juce::MathConstants<double>::twoPi * (0.5 + i * 0.05) * t));
+                instances[(size_t)i]->parameters.getParameter(ParameterIDValue)->setValueNotifyingHost(target);
+            }
+            changes.fetch_add((uint64_t)numEditors, std::memory_order_relaxed);
+
+            next += std::chrono::duration_cast<Clock::duration>(interval);
+            std::this_thread::sleep_until(next);
+
+        }
+
+        wallSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        juce::MessageManager::callAsync([&] {
+            messageThreadCpu = threadCpuSeconds() - messageThreadCpu;
+            juce::MessageManager::getInstance()->stopDispatchLoop();
+        });
+
+    });
+
+    juce::MessageManager::getInstance()->runDispatchLoop();
+    automation.join();
+
+    editors.clear();
+    instances.clear();
+
+    std::printf("editors              %d%s\n", numEditors, desktop ? " (on the desktop)" : " (not painted)");
+    std::printf("wall time            %.3f s\n", wallSeconds);
+    std::printf("parameter changes    %llu (%.0f/s)\n", (unsigned long long)changes.load(), (double)changes.load() / wallSeconds);
+    std::printf("message thread cpu   %.3f s, %.1f%% of one core, %.3f ms/s per editor\n",
+                messageThreadCpu, 100.0 * messageThreadCpu / wallSeconds, 1000.0 * messageThreadCpu / wallSeconds / numEditors);
+
+    return 0;
+}
@@ -0,0 +1,300 @@
+//
+//  LoadHarness.cpp
+//  Obvious
+//
+//  Runs N editor-less ObviousAudioProcessor instances against a stand-in for
+//  OBS on 127.0.0.1 and reports throughput, end-to-end latency and CPU.
+//
+//  Stand-ins:
+//    --server mock      (default) the native receiver built against the stub
+//                       libobs, in this process. Latency is measured from the
+//                       parameter change to the command being applied on the
+//                       stand-in's tick.
+//    --server external  anything listening on --host/--port, e.g. the real
+//                       Obvious.lua under LuaJIT: luajit obslua-standin.lua
+//                       Only send-side figures are reported.
+//
+//  Options:
+//    --instances N    number of plugin instances             (16)
+//    --seconds S      length of the automation run           (10)
+//    --sample-rate R  host sample rate                       (48000)
+//    --block-size B   host block size                        (512)
+//    --speed X        1 = real time, 10 = ten times faster, 0 = unpaced (1)
+//    --obs-fps F      tick rate of the mock stand-in, 0 = continuous (60)
+//    --command ID     command to send (ScaleX). Trigger commands drive the
+//                     trigger parameter with a square wave, value commands
+//                     drive the value parameter along a sine.
+//    --host, --port   where to connect                       (127.0.0.1, 11111)
+//
+
+#include <JuceHeader.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <thread>
+#include <unistd.h>
+
+#include "PluginProcessor.h"
+
+#include "ObviousDispatcher.h"
+#include "ObviousServer.h"
+#include "SpscQueue.h"
+#include "obs-stub.h"
+
+using Clock = std::chrono::steady_clock;
+
+static int64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+//==============================================================================
+struct PendingSend {
+    int64_t sentNs = 0;
+    double value = 0.0;
+};
+
+/*
+ In-process stand-in for OBS. Commands are matched back to the instance that
+ sent them through the source name ("source<index>"), and to the parameter
+ change through the value, so sends the plugin never made count as dropped.
+ */
+class MockObs
+{
+public:
+    MockObs(int numInstances, int fps) : framesPerSecond(fps)
+    {
+        obsstub::reset();
+        obsstub::setLogEnabled(false);
+        for (int i = 0; i < numInstances; ++i) {
+            obsstub::addSceneItem("Scene", "source" + std::to_string(i));
+            pending.push_back(std::make_unique<obvious::SpscQueue<PendingSend>>(1 << 16));
+        }
+    }
+
+    ~MockObs() { stop(); }
+
+    bool start(int port)
+    {
+        if (!server.start(port)) return false;
+        running = true;
+        tickThread = std::thread([this] { run(); });
+        return true;
+    }
+
+    void stop()
+    {
+        running = false;
+        if (tickThread.joinable()) tickThread.join();
+        server.stop();
+    }
+
+    // Harness thread
+    void expect(int instance, double value)
+    {
+        PendingSend send { nowNs(), value };
+        pending[(size_t)instance]->push(send);
+    }
+
+    obvious::Server server;
+    std::atomic<uint64_t> applied { 0 };
+    std::atomic<uint64_t> unmatched { 0 };
+    std::atomic<uint64_t> skipped { 0 };
+    std::vector<int64_t> latenciesNs;  // tick thread until stop()
+
+private:
+    void run()
+    {
+        obvious::Dispatcher dispatcher([this](int clientID, int code, const std::string& text) { server.respond(clientID, code, text); });
+        const auto frame = framesPerSecond > 0 ? std::chrono::microseconds(1000000 / framesPerSecond) : std::chrono::microseconds(200);
+        auto next = Clock::now();
+
+        while (running) {
+            server.drain([this, &dispatcher](int clientID, const obvious::Message& message) {
+                match(message);
+                dispatcher.apply(clientID, message);
+                applied.fetch_add(1, std::memory_order_relaxed);
+            });
+            next += frame;
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    void match(const obvious::Message& message)
+    {
+        if (message.source.compare(0, 6, "source") != 0) return;
+        const size_t instance = (size_t)std::atoi(message.source.c_str() + 6);
+        if (instance >= pending.size()) return;
+
+        const int64_t received = nowNs();
+        PendingSend send;
+        while (pending[instance]->pop(send)) {
+            if (std::abs(send.value - message.value) < 2.0e-6) {
+                latenciesNs.push_back(received - send.sentNs);
+                return;
+            }
+            skipped.fetch_add(1, std::memory_order_relaxed);
+        }
+        unmatched.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    int framesPerSecond;
+    std::vector<std::unique_ptr<obvious::SpscQueue<PendingSend>>> pending;
+    std::atomic<bool> running { false };
+    std::thread tickThread;
+};
+
+//==============================================================================
+static double percentile(std::vector<int64_t>& sorted, double p)
+{
+    if (sorted.empty()) return 0.0;
+    const size_t index = std::min(sorted.size() - 1, (size_t)(p * (double)(sorted.size() - 1) + 0.5));
+    return (double)sorted[index] / 1.0e6;
+}
+
+// Resident set size from /proc (Linux), 0 where it is not available
+static int64_t residentBytes()
+{
+    long pages = 0, resident = 0;
+    if (FILE* statm = std::fopen("/proc/self/statm", "r")) {
+        if (std::fscanf(statm, "%ld %ld", &pages, &resident) != 2) resident = 0;
+        std::fclose(statm);
+    }
+    return (int64_t)resident * (int64_t)sysconf(_SC_PAGESIZE);
+}
+
+static juce::String option(const juce::ArgumentList& args, const juce::String& name, const juce::String& fallback)
+{
+    return args.containsOption(name) ? args.getValueForOption(name) : fallback;
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    const int numInstances   = option(args, "--instances", "16").getIntValue();
+    const double seconds     = option(args, "--seconds", "10").getDoubleValue();
+    const double sampleRate  = option(args, "--sample-rate", "48000").getDoubleValue();
+    const int blockSize      = option(args, "--block-size", "512").getIntValue();
+    const double speed       = option(args, "--speed", "1").getDoubleValue();
+    const int obsFps         = option(args, "--obs-fps", "60").getIntValue();
+    const int commandID      = option(args, "--command", juce::String((int)ScaleX)).getIntValue();
+    const juce::String host  = option(args, "--host", "127.0.0.1");
+    const bool useMock       = option(args, "--server", "mock") == "mock";
+    int port                 = option(args, "--port", useMock ? "0" : "11111").getIntValue();
+
+    std::unique_ptr<MockObs> mock;
+    if (useMock) {
+        mock = std::make_unique<MockObs>(numInstances, obsFps);
+        if (!mock->start(port)) {
+            std::printf("Could not start the stand-in server on port %d\n", port);
+            return 1;
+        }
+        port = mock->server.boundPort();
+    }
+
+    std::vector<std::unique_ptr<ObviousAudioProcessor>> instances;
+    bool usesTrigger = false;
+
+    // What each instance costs a host loading a project, before any editor is opened
+    const int64_t residentBefore = residentBytes();
+    const auto constructionStart = Clock::now();
+    for (int i = 0; i < numInstances; ++i) {
+        auto instance = std::make_unique<ObviousAudioProcessor>();
+        Command command = instance->commandWithID(commandID);
+        usesTrigger = command.triggerParameterID == ParameterIDTrigger;
+
+        auto settingsStorage = instance->settings();
+        settingsStorage.setProperty(ParameterIDIP, host, nullptr);
+        settingsStorage.setProperty(ParameterIDPort, juce::String(port), nullptr);
+        settingsStorage.setProperty(ParameterIDScene, "Scene", nullptr);
+        settingsStorage.setProperty(ParameterIDSource, "source" + juce::String(i), nullptr);
+        settingsStorage.setProperty(ParameterIDCommandCategory, (int)command.category, nullptr);
+        settingsStorage.setProperty(ParameterIDCommand, commandID, nullptr);
+        instance->engine.sendEnabled = true;
+        instance->prepareToPlay(sampleRate, blockSize);
+        instances.push_back(std::move(instance));
+    }
+
+    const double constructionSeconds = std::chrono::duration<double>(Clock::now() - constructionStart).count();
+    const int64_t residentPerInstance = (residentBytes() - residentBefore) / numInstances;
+
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::MidiBuffer midi;
+    const juce::String parameterID = usesTrigger ? ParameterIDTrigger : ParameterIDValue;
+    const double blockSeconds = blockSize / sampleRate;
+    const int numBlocks = (int)(seconds / blockSeconds);
+
+    uint64_t changes = 0;
+    const std::clock_t cpuStart = std::clock();
+    const auto wallStart = Clock::now();
+
+    for (int block = 0; block < numBlocks; ++block) {
+
+        const double t = block * blockSeconds;
+
+        for (int i = 0; i < numInstances; ++i) {
+            ObviousAudioProcessor& instance = *instances[(size_t)i];
+            instance.processBlock(buffer, midi);
+
+            // Each instance follows its own curve so the stand-in sees interleaved traffic
+            float target;
+            if (usesTrigger) target = std::fmod(t * (1.0 + i * 0.1), 1.0) < 0.5 ? 1.0f : 0.0f;
+            else target = (float)(0.5 + 0.45 * std::sin(juce::MathConstants<double>::twoPi * (0.5 + i * 0.05) * t));
+
+            auto* parameter = instance.parameters.getParameter(parameterID);
+            const float before = parameter->getValue();
+            parameter->setValueNotifyingHost(target);
+            const float after = parameter->getValue();
+
+            if (after != before) {
+                ++changes;
+                if (mock) mock->expect(i, usesTrigger ? (double)after : (double)instance.translateSliderValue(after));
+            }
+        }
+
+        if (speed > 0.0) {
+            std::this_thread::sleep_until(wallStart + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>((block + 1) * blockSeconds / speed)));
+        }
+    }
+
+    const double wallSeconds = std::chrono::duration<double>(Clock::now() - wallStart).count();
+    const double cpuSeconds = (double)(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+
+    // Let the stand-in catch up before tearing down
+    if (mock) {
+        const auto deadline = Clock::now() + std::chrono::seconds(2);
+        while (mock->server.messagesReceived() < changes && Clock::now() < deadline) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    instances.clear();
+
+    std::printf("instances            %d\n", numInstances);
+    std::printf("construction         %.3f ms/instance, %.1f KB resident/instance\n", 1000.0 * constructionSeconds / numInstances, residentPerInstance / 1024.0);
+    std::printf("blocks               %d x %d samples @ %.0f Hz, speed %s\n", numBlocks, blockSize, sampleRate, speed > 0.0 ? juce::String(speed).toRawUTF8() : "unpaced");
+    std::printf("wall time            %.3f s\n", wallSeconds);
+    std::printf("parameter changes    %llu (%.0f/s)\n", (unsigned long long)changes, changes / wallSeconds);
+    std::printf("cpu                  %.3f s total, %.3f ms/s per instance%s\n", cpuSeconds, 1000.0 * cpuSeconds / wallSeconds / numInstances, mock ? " (includes the stand-in)" : "");
+
+    if (mock) {
+        mock->stop();
+
+        const uint64_t received = mock->server.messagesReceived();
+        std::printf("messages received    %llu (%.0f/s)\n", (unsigned long long)received, received / wallSeconds);
+        std::printf("bytes received       %llu (%.0f/s)\n", (unsigned long long)mock->server.bytesReceived(), mock->server.bytesReceived() / wallSeconds);
+        std::printf("dropped/coalesced    %llu\n", (unsigned long long)(changes > received ? changes - received : 0));
+        std::printf("skipped in order     %llu, unmatched %llu\n", (unsigned long long)mock->skipped.load(), (unsigned long long)mock->unmatched.load());
+
+        std::vector<int64_t>& latencies = mock->latenciesNs;
+        std::sort(latencies.begin(), latencies.end());
+        std::printf("latency ms           p50 %.3f  p90 %.3f  p99 %.3f  p99.9 %.3f  max %.3f\n",
+                    percentile(latencies, 0.5), percentile(latencies, 0.9), percentile(latencies, 0.99), percentile(latencies, 0.999), percentile(latencies, 1.0));
+    }
+
+    return 0;
+}
@@ -0,0 +1,176 @@
+//
+//  MicroBenchmarks.cpp
+//  Obvious
+//
+//  ns/op and heap allocations/op for the plugin's hot functions. The engine's
+//  socket is replaced by a byte counter, so nothing leaves the process.
+//
+//  Usage: ObviousMicroBenchmarks [--filter text] [--csv]
+//
+
+#include <JuceHeader.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+#include "PluginProcessor.h"
+
+//==============================================================================
+// Allocation counting for the whole process
+
+static std::atomic<uint64_t> allocationCount { 0 };
+
+void* operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+//==============================================================================
+class BenchmarkEngine : public ObviousEngine
+{
+public:
+    using ObviousEngine::ObviousEngine;
+
+    uint64_t bytesWritten = 0;
+
+protected:
+    int writeMessage(const std::string &message) override {
+        bytesWritten += message.size();
+        return (int)message.size();
+    }
+};
+
+struct Result {
+    juce::String name;
+    int64_t iterations;
+    double nsPerOp;
+    double allocationsPerOp;
+};
+
+static volatile float sink;
+
+template <typename Function>
+static Result measure(const juce::String& name, Function&& function)
+{
+    using Clock = std::chrono::steady_clock;
+    const auto minimumTime = std::chrono::milliseconds(200);
+
+    function(); // warm up caches and lazily created state
+
+    int64_t iterations = 16;
+    while (true) {
+        const uint64_t allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+        const auto start = Clock::now();
+        for (int64_t i = 0; i < iterations; ++i) function();
+        const auto elapsed = Clock::now() - start;
+        const uint64_t allocations = allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+
+        if (elapsed >= minimumTime || iterations >= ((int64_t)1 << 32)) {
+            const double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+            return { name, iterations, ns / (double)iterations, (double)allocations / (double)iterations };
+        }
+        iterations *= 2;
+    }
+}
+
+static void configure(ObviousAudioProcessor& processor, BenchmarkEngine& engine)
+{
+    auto settingsStorage = processor.settings();
+    settingsStorage.setProperty(ParameterIDScene, "Scene", nullptr);
+    settingsStorage.setProperty(ParameterIDSource, "Source", nullptr);
+    settingsStorage.setProperty(ParameterIDCommandCategory, CommandCategorySource, nullptr);
+    settingsStorage.setProperty(ParameterIDCommand, ScaleX, nullptr);
+    settingsStorage.setProperty(ParameterIDRangeLower, 0.0, nullptr);
+    settingsStorage.setProperty(ParameterIDRangeUpper, 2.0, nullptr);
+    engine.sendEnabled = true;
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+    const juce::String filter = args.containsOption("--filter") ? args.getValueForOption("--filter") : juce::String();
+    const bool csv = args.containsOption("--csv");
+
+    ObviousAudioProcessor processor;
+    BenchmarkEngine engine(processor.parameters.state);
+    configure(processor, engine);
+
+    const std::string heartbeatResponse = std::to_string(HeartbeatResponse) + char(31) + ".";
+    std::string incoming;
+    for (int i = 0; i < 8; ++i) incoming += heartbeatResponse + char(30);
+
+    juce::MemoryBlock state;
+    processor.getStateInformation(state);
+
+    // A 512-sample stereo block of noise for the envelope follower, the spectrum analyser and the onset detector
+    juce::AudioBuffer<float> block(2, 512);
+    juce::Random random(1);
+    for (int channel = 0; channel < block.getNumChannels(); ++channel)
+        for (int i = 0; i < block.getNumSamples(); ++i)
+            block.setSample(channel, i, random.nextFloat() * 2.0f - 1.0f);
+    EnvelopeFollower envelope;
+    envelope.prepare(48000.0);
+    EnvelopeFollower::Settings peakSettings, rmsSettings;
+    rmsSettings.mode = EnvelopeFollower::RMS;
+    float level = 0.0f;
+    SpectrumAnalyser spectrum;
+    spectrum.prepare(48000.0);
+    SpectrumAnalyser::Levels levels;
+    OnsetDetector onsets;
+    onsets.prepare(48000.0);
+    const OnsetDetector::Settings onsetSettings;
+
+    float value = 0.0f;
+    auto nextValue = [&value] { value += 0.001f; if (value > 1.0f) value = 0.0f; return value; };
+
+    std::vector<std::pair<juce::String, std::function<Result()>>> benchmarks = {
+        { "send(parameterID, value)", [&] { return measure("send(parameterID, value)", [&] { engine.send(ParameterIDValue, nextValue()); }); } },
+        { "send(command, value)",     [&] { return measure("send(command, value)", [&] { engine.send(ScaleX, nextValue()); }); } },
+        { "commandWithID",            [&] { return measure("commandWithID", [&] { sink = (float)processor.commandWithID(Opacity).recommendedRangeUpper; }); } },
+        { "translateSliderValue",     [&] { return measure("translateSliderValue", [&] { sink = engine.translateSliderValue(nextValue()); }); } },
+        { "clientMessageReceived",    [&] { return measure("clientMessageReceived", [&] { engine.clientMessageReceived(heartbeatResponse); }); } },
+        { "handleIncomingData x8",    [&] { return measure("handleIncomingData x8", [&] { engine.handleIncomingData(incoming.data(), (int)incoming.size()); }); } },
+        { "settings",                 [&] { return measure("settings", [&] { sink = (float)processor.settings().getNumProperties(); }); } },
+        { "settings().getProperty",   [&] { return measure("settings().getProperty", [&] { sink = (float)(int)processor.settings().getProperty(ParameterIDCommand, CommandDefinitionDefault); }); } },
+        { "getStateInformation",      [&] { return measure("getStateInformation", [&] { juce::MemoryBlock block; processor.getStateInformation(block); sink = (float)block.getSize(); }); } },
+        { "construct processor",      [&] { return measure("construct processor", [&] { ObviousAudioProcessor instance; sink = (float)instance.getParameters().size(); }); } },
+        { "setStateInformation",      [&] { return measure("setStateInformation", [&] { processor.setStateInformation(state.getData(), (int)state.getSize()); }); } },
+        { "envelope peak 2x512",      [&] { return measure("envelope peak 2x512", [&] { envelope.process(block.getArrayOfReadPointers(), 2, 512, peakSettings, level); sink = level; }); } },
+        { "envelope rms 2x512",       [&] { return measure("envelope rms 2x512", [&] { envelope.process(block.getArrayOfReadPointers(), 2, 512, rmsSettings, level); sink = level; }); } },
+        { "spectrum 2x512",           [&] { return measure("spectrum 2x512", [&] { spectrum.process(block.getArrayOfReadPointers(), 2, 512, peakSettings, levels); sink = levels[0]; }); } },
+        { "onsets 2x512",             [&] { return measure("onsets 2x512", [&] { sink = (float)onsets.process(block.getArrayOfReadPointers(), 2, 512, onsetSettings); }); } },
+    };
+
+    if (csv) std::printf("benchmark,iterations,ns_per_op,allocations_per_op\n");
+    else std::printf("%-28s %12s %12s %12s\n", "benchmark", "iterations", "ns/op", "allocs/op");
+
+    for (auto& benchmark : benchmarks) {
+        if (filter.isNotEmpty() && !benchmark.first.containsIgnoreCase(filter)) continue;
+
+        // setStateInformation replaces the settings, so restore them between runs
+        configure(processor, engine);
+        const Result result = benchmark.second();
+
+        if (csv) std::printf("%s,%lld,%.1f,%.2f\n", result.name.toRawUTF8(), (long long)result.iterations, result.nsPerOp, result.allocationsPerOp);
+        else std::printf("%-28s %12lld %12.1f %12.2f\n", result.name.toRawUTF8(), (long long)result.iterations, result.nsPerOp, result.allocationsPerOp);
+    }
+
+    return 0;
+}
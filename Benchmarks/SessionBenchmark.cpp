@@ -0,0 +1,122 @@
+//
+//  SessionBenchmark.cpp
+//  Obvious
+//
+//  What a host does with every instance when it saves and loads a project:
+//  builds N configured instances, saves each one's state, and restores
+//  every instance from it. Restoring is timed for the current binary state
+//  and for the XML state earlier versions saved, which projects from before
+//  the binary format still contain.
+//
+//  Options:
+//    --instances N    number of plugin instances             (500)
+//    --rounds R       save/restore passes, best one reported (5)
+//
+
+#include <JuceHeader.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+#include "PluginProcessor.h"
+
+using Clock = std::chrono::steady_clock;
+
+static juce::String option(const juce::ArgumentList& args, const juce::String& name, const juce::String& fallback)
+{
+    return args.containsOption(name) ? args.getValueForOption(name) : fallback;
+}
+
+template <typename Function>
+static double bestOf(int rounds, Function&& function)
+{
+    double best = std::numeric_limits<double>::max();
+    for (int round = 0; round < rounds; ++round) {
+        const auto start = Clock::now();
+        function();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    const int numInstances = juce::jmax(1, option(args, "--instances", "500").getIntValue());
+    const int rounds       = juce::jmax(1, option(args, "--rounds", "5").getIntValue());
+
+    std::vector<std::unique_ptr<ObviousAudioProcessor>> instances;
+
+    for (int i = 0; i < numInstances; ++i) {
+        auto instance = std::make_unique<ObviousAudioProcessor>();
+        auto settingsStorage = instance->settings();
+        settingsStorage.setProperty(ParameterIDIP, "127.0.0.1", nullptr);
+        settingsStorage.setProperty(ParameterIDPort, "11111", nullptr);
+        settingsStorage.setProperty(ParameterIDScene, "Scene " + juce::String(i / 20), nullptr);
+        settingsStorage.setProperty(ParameterIDSource, "source" + juce::String(i), nullptr);
+        settingsStorage.setProperty(ParameterIDCommandCategory, (int)CommandCategorySource, nullptr);
+        settingsStorage.setProperty(ParameterIDCommand, (int)ScaleX, nullptr);
+        settingsStorage.setProperty(ParameterIDRangeUpper, 2.0, nullptr);
+        instance->parameters.getParameter(ParameterIDValue)->setValueNotifyingHost((float)i / (float)numInstances);
+        instances.push_back(std::move(instance));
+    }
+
+    std::vector<juce::MemoryBlock> binaryStates((size_t)numInstances);
+    std::vector<juce::MemoryBlock> xmlStates((size_t)numInstances);
+
+    const double saveSeconds = bestOf(rounds, [&] {
+        for (int i = 0; i < numInstances; ++i) {
+            binaryStates[(size_t)i].reset();
+            instances[(size_t)i]->getStateInformation(binaryStates[(size_t)i]);
+        }
+    });
+
+    // The state as earlier versions wrote it
+    for (int i = 0; i < numInstances; ++i) {
+        std::unique_ptr<juce::XmlElement> xml(instances[(size_t)i]->parameters.copyState().createXml());
+        juce::AudioProcessor::copyXmlToBinary(*xml, xmlStates[(size_t)i]);
+    }
+
+    auto restore = [&](const std::vector<juce::MemoryBlock>& states) {
+        return bestOf(rounds, [&] {
+            for (int i = 0; i < numInstances; ++i) {
+                instances[(size_t)i]->setStateInformation(states[(size_t)i].getData(), (int)states[(size_t)i].getSize());
+            }
+        });
+    };
+
+    // Both formats must come back to the same settings
+    int mismatches = 0;
+    auto check = [&] {
+        for (int i = 0; i < numInstances; ++i) {
+            if (instances[(size_t)i]->settings().getProperty(ParameterIDSource).toString() != "source" + juce::String(i)) ++mismatches;
+        }
+    };
+
+    const double binaryRestoreSeconds = restore(binaryStates);
+    check();
+    const double xmlRestoreSeconds = restore(xmlStates);
+    check();
+
+    size_t binaryBytes = 0, xmlBytes = 0;
+    for (int i = 0; i < numInstances; ++i) {
+        binaryBytes += binaryStates[(size_t)i].getSize();
+        xmlBytes += xmlStates[(size_t)i].getSize();
+    }
+
+    instances.clear();
+
+    std::printf("instances            %d, best of %d rounds\n", numInstances, rounds);
+    std::printf("save                 %.3f ms total, %.1f us/instance, %.0f bytes/instance\n",
+                1000.0 * saveSeconds, 1.0e6 * saveSeconds / numInstances, (double)binaryBytes / numInstances);
+    std::printf("restore binary       %.3f ms total, %.1f us/instance\n",
+                1000.0 * binaryRestoreSeconds, 1.0e6 * binaryRestoreSeconds / numInstances);
+    std::printf("restore legacy xml   %.3f ms total, %.1f us/instance, %.0f bytes/instance\n",
+                1000.0 * xmlRestoreSeconds, 1.0e6 * xmlRestoreSeconds / numInstances, (double)xmlBytes / numInstances);
+    std::printf("mismatched restores  %d\n", mismatches);
+
+    return mismatches == 0 ? 0 : 1;
+}
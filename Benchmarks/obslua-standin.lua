@@ -0,0 +1,149 @@
+-- Runs the real Obvious.lua outside OBS, under LuaJIT, with a stub obslua
+-- module, so ObviousLoadHarness can be pointed at it on a box without OBS:
+--
+--   luajit obslua-standin.lua [port] [path to "OBS lua scripts"/] [apply log]
+--   ObviousLoadHarness --server external --port <port>
+--
+-- Every scene, source and filter name resolves, and every apply is counted.
+-- Throughput is printed once a second.
+
+local ffi = require("ffi")
+ffi.cdef[[
+int usleep(unsigned int usec);
+typedef struct { long tv_sec; long tv_nsec; } obvious_timespec;
+int clock_gettime(int clk_id, obvious_timespec *tp);
+]]
+
+local now = ffi.new("obvious_timespec")
+local function gettimeNs()
+    ffi.C.clock_gettime(1, now) -- CLOCK_MONOTONIC
+    return tonumber(now.tv_sec) * 1000000000 + tonumber(now.tv_nsec)
+end
+
+local port = tonumber(arg[1]) or 11111
+local scriptDir = arg[2] or "../OBS lua scripts/"
+package.path = scriptDir .. "?.lua;" .. package.path
+
+local applied = 0
+local timers = {}
+local sources = {}
+
+local function sourceNamed(name)
+    local source = sources[name]
+    if not source then
+        source = { name = name, width = 1920, height = 1080, settings = {}, filters = {}, items = {} }
+        sources[name] = source
+    end
+    return source
+end
+
+local function copy(from, to)
+    for k, v in pairs(from) do to[k] = v end
+end
+
+obslua = {
+    timer_add = function(callback, ms) timers[callback] = { interval = ms, due = 0 } end,
+    timer_remove = function(callback) timers[callback] = nil end,
+
+    os_gettime_ns = gettimeNs,
+    obs_get_video_frame_time = function() return math.floor(gettimeNs() / 16666667) * 16666667 end,
+    obs_get_active_fps = function() return 60 end,
+
+    OBS_PATH_FILE_SAVE = 1,
+    obs_data_set_default_int = function() end,
+    obs_data_get_int = function(settings, name) return settings[name] end,
+    obs_data_get_string = function(settings, name) return settings[name] or "" end,
+    obs_properties_create = function() return {} end,
+    obs_properties_add_int = function() end,
+    obs_properties_add_path = function() end,
+
+    obs_get_source_by_name = function(name) return sourceNamed(name) end,
+    obs_source_release = function() end,
+    obs_scene_from_source = function(source) return source end,
+    obs_scene_find_source_recursive = function(scene, name)
+        local item = scene.items[name]
+        if not item then
+            item = { source = sourceNamed(name), scale = { x = 1, y = 1 }, pos = { x = 0, y = 0 }, crop = { left = 0, top = 0, right = 0, bottom = 0 },
+                     rot = 0, bounds = { x = 0, y = 0 }, boundsType = 0 }
+            scene.items[name] = item
+        end
+        return item
+    end,
+    obs_sceneitem_get_source = function(item) return item.source end,
+
+    vec2 = function() return { x = 0, y = 0 } end,
+    obs_sceneitem_crop = function() return { left = 0, top = 0, right = 0, bottom = 0 } end,
+    obs_sceneitem_get_scale = function(item, scale) copy(item.scale, scale) end,
+    obs_sceneitem_set_scale = function(item, scale) copy(scale, item.scale); applied = applied + 1 end,
+    obs_sceneitem_get_pos = function(item, pos) copy(item.pos, pos) end,
+    obs_sceneitem_set_pos = function(item, pos) copy(pos, item.pos); applied = applied + 1 end,
+    obs_sceneitem_get_crop = function(item, crop) copy(item.crop, crop) end,
+    obs_sceneitem_set_crop = function(item, crop) copy(crop, item.crop); applied = applied + 1 end,
+    obs_sceneitem_set_visible = function(item, visible) item.visible = visible; applied = applied + 1 end,
+    obs_sceneitem_get_rot = function(item) return item.rot end,
+    obs_sceneitem_set_rot = function(item, rot) item.rot = rot; applied = applied + 1 end,
+    OBS_BOUNDS_NONE = 0,
+    OBS_BOUNDS_SCALE_INNER = 2,
+    obs_sceneitem_get_bounds_type = function(item) return item.boundsType end,
+    obs_sceneitem_set_bounds_type = function(item, boundsType) item.boundsType = boundsType end,
+    obs_sceneitem_get_bounds = function(item, bounds) copy(item.bounds, bounds) end,
+    obs_sceneitem_set_bounds = function(item, bounds) copy(bounds, item.bounds); applied = applied + 1 end,
+    obs_sceneitem_defer_update_begin = function() end,
+    obs_sceneitem_defer_update_end = function() end,
+    obs_sceneitem_visible = function(item) return item.visible ~= false end,
+    obs_source_get_width = function(source) return source.width end,
+    obs_source_get_height = function(source) return source.height end,
+
+    obs_source_get_filter_by_name = function(source, name)
+        local filter = source.filters[name]
+        if not filter then
+            filter = { name = name, settings = {} }
+            source.filters[name] = filter
+        end
+        return filter
+    end,
+    obs_source_get_settings = function(source) return source.settings end,
+    obs_source_update = function() applied = applied + 1 end,
+    obs_data_set_double = function(data, name, value) data[name] = value end,
+    obs_data_get_double = function(data, name) return data[name] or 0 end,
+    obs_data_create = function() return {} end,
+    obs_data_set_string = function(data, name, value) data[name] = value end,
+    obs_data_release = function() end,
+
+    obs_source_media_restart = function() applied = applied + 1 end,
+    obs_source_media_stop = function() applied = applied + 1 end,
+    obs_source_media_play_pause = function() applied = applied + 1 end,
+    obs_source_media_set_time = function(source, ms) source.mediaTime = ms; applied = applied + 1 end,
+    obs_source_media_get_time = function(source) return source.mediaTime or 0 end,
+}
+
+dofile(scriptDir .. "Obvious.lua")
+
+-- Every name resolves here, so there is no catalogue to offer; answer as a script from before it would
+CatalogueSubscribe = nil
+
+script_load({})
+script_update({ Port = port, ApplyLog = arg[3] })
+print("Obvious.lua stand-in listening on port " .. port)
+
+local tickMs = 10
+local elapsedMs = 0
+local lastApplied = 0
+
+while true do
+    for callback, timer in pairs(timers) do
+        if timer.due <= elapsedMs then
+            timer.due = elapsedMs + timer.interval
+            local ok, err = pcall(callback)
+            if not ok then print(err) end
+        end
+    end
+
+    ffi.C.usleep(tickMs * 1000)
+    elapsedMs = elapsedMs + tickMs
+
+    if elapsedMs % 1000 == 0 then
+        print(string.format("%d applied/s", applied - lastApplied))
+        lastApplied = applied
+    end
+end
@@ -26,30 +26,204 @@ TypeSetNumChars=230
 Disconnect=240
 Heartbeat=250
 HeartbeatResponse=260
+StatsSubscribe=270
+Sequenced=280
+CatalogueSubscribe=290
+ValueQuery=300
+ValueSubscribe=310
+TypeSetState=320
+Relative=330
+Transform=340
+Rotation=350
+BoundsWidth=360
+BoundsHeight=370
+LFO=380
+Values=390
+Scheduled=400
 
 ResponseCodeError=10
 ResponseCodeRequestTypeText=20
 ResponseCodeRequestTypeCursorChar=30
 ResponseCodeRequestTypeCursorVisible=40
 ResponseCodeRequestTypeNumChars=50
+ResponseCodeStats=60
+ResponseCodeCatalogueBegin=70
+ResponseCodeCatalogueAdd=80
+ResponseCodeCatalogueRemove=90
+ResponseCodeCatalogueEnd=100
+ResponseCodeValue=110
+ResponseCodeRequestTypeState=120
 
 CommandDelimiter=string.char(30)
 CommandChunkDelimiter=string.char(31)
+CatalogueFieldDelimiter=string.char(29)
+ValuesRecordDelimiter=string.char(28)
 
 
 DefaultPort = 11111
+StatsIntervalMs = 1000
+MaxDatagramsPerTick = 256
+CatalogueIntervalMs = 100
 
 obs = obslua
 local socket = require("ljsocket")
+local ffi = require("ffi")
 
 -- Configuration items
 local port = DefaultPort
 local server = nil
 local clients = {}
 
+-- Continuous values can also arrive as UDP datagrams on the same port, wrapped as
+-- Sequenced<US>sender<US>sequence<US>command... Each sender's newest sequence number
+-- is kept so late datagrams never overwrite a newer value
+local datagramServer = nil
+local sequencedSenders = {}
+
 -- Set true to get debug printing
 local debug_print_enabled = true
 
+-- Clients that sent StatsSubscribe, and the optional frame-stamped apply log
+local statsClients = {}
+local applyLogPath = ""
+local applyLogFile = nil
+
+-- Clients that sent CatalogueSubscribe, and what they were last told: the items of every
+-- scene (including those in groups) and the filters of every source. Signals mark scenes and
+-- sources dirty; only those are scanned again, and the differences are sent as adds and removes
+local catalogueClients = {}
+local catalogue = nil
+local catalogueDirtyScenes = {}
+local catalogueDirtySources = {}
+local catalogueWatched = {}
+
+-- One value subscription per client: the command and target it follows and the value it was
+-- last sent or set. Read once per rendered frame and sent only when it changed
+local valueSubscriptions = {}
+local lastValueFrameTime = 0
+
+-- Changes sent as Relative, summed per command and target until the next rendered frame, then
+-- added to the value OBS shows. Senders moving the same target all move it, by the sum of their changes
+local relativeChanges = {}
+local lastRelativeFrameTime = 0
+
+-- Crop is whole pixels, so the part of a relative crop change below one is carried here, per
+-- command and target, and added to the next change instead of being lost every frame
+local cropRemainders = {}
+
+-- LFOs per command and target, evaluated at the time of every rendered frame from the tempo and
+-- beat they were anchored to when they arrived
+local lfos = {}
+local lastLFOFrameTime = 0
+
+-- Messages sent as Scheduled, in the order they arrived, each with the os_gettime_ns it is due at
+local scheduledMessages = {}
+
+-- Cost of this script, reset after every report (times in ns from os_gettime_ns)
+local stats = {}
+
+local function resetStats()
+    stats = {
+        ticks = 0,
+        receiveNs = 0,
+        parseNs = 0,
+        applyNs = 0,
+        tickMaxNs = 0,
+        messages = 0,
+        maxPerTick = 0,
+        backlog = 0,
+        stale = 0,
+        targets = {},
+        startNs = obs.os_gettime_ns(),
+    }
+end
+
+-- Plugins on this machine write commands to a shared-memory ring instead of the socket.
+-- Layout and protocol are in Source/Core/ObviousSharedRingFormat.h; this side creates the
+-- segment, owns readIndex and advances consumerTicks so writers know it is being drained.
+-- LuaJIT has no atomics, so a record is only trusted once its checksum matches the copy read.
+SharedRingCapacity = 4096
+SharedRingMaxMessage = 232
+SharedRingStallLimit = 60
+
+ffi.cdef[[
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t capacity;
+    uint64_t writeIndex;
+    uint64_t readIndex;
+    uint64_t consumerTicks;
+    uint8_t reserved[16];
+} ObviousSharedRingHeader;
+
+typedef struct {
+    uint64_t sequence;
+    uint32_t sender;
+    uint16_t length;
+    uint16_t reserved;
+    uint32_t checksum;
+    uint32_t padding;
+    char bytes[232];
+} ObviousSharedRingRecord;
+]]
+
+local sharedRing = nil
+
+local function adler32(text)
+    local a, b = 1, 0
+    for i = 1, #text do
+        a = (a + string.byte(text, i)) % 65521
+        b = (b + a) % 65521
+    end
+    return b * 65536 + a
+end
+
+-- Once per tick, after the sockets; and with tick false before each command read from a socket,
+-- so what a plugin put in the ring before writing to its socket is applied first
+local function drainSharedRing(tick)
+
+    local ring = sharedRing
+    if ring == nil then return end
+
+    local header = ring.header
+    if tick then header.consumerTicks = header.consumerTicks + 1 end
+
+    local index = tonumber(header.readIndex)
+    local last = tonumber(header.writeIndex)
+
+    while index < last do
+
+        local record = ring.records[index % ring.capacity]
+        local length = record.length
+        local text = nil
+
+        if tonumber(record.sequence) == index + 1 and length <= SharedRingMaxMessage then
+            text = ffi.string(record.bytes, length)
+            if adler32(text) ~= record.checksum then text = nil end
+        end
+
+        -- Not published yet; a writer that died mid-record is skipped after SharedRingStallLimit ticks
+        if text == nil then
+            if not tick then break end
+            ring.stalledDrains = ring.stalledDrains + 1
+            if ring.stalledDrains < SharedRingStallLimit then break end
+        else
+            local sender = sequencedSenders[tostring(record.sender)]
+            local client = nil
+            if sender then client = sender.client end
+            handleClientMessage(client, text)
+        end
+
+        ring.stalledDrains = 0
+        index = index + 1
+        header.readIndex = index
+
+    end
+
+end
+
 -- Description displayed in the Scripts dialog window
 function script_description()
     return '<h2>Obvious ' .. version ..'</h2>' ..
@@ -68,43 +242,133 @@ end
 function script_load(settings)
 
     connectServer()
+    resetStats()
 
     obs.timer_add(serverCallback, 10)
     obs.timer_add(clientCallback, 10)
+    obs.timer_add(statsCallback, StatsIntervalMs)
+    obs.timer_add(catalogueCallback, CatalogueIntervalMs)
 
 end
 
 function clientCallback()
 
   local closeClients = {}
+  local tickStart = obs.os_gettime_ns()
+  local messagesBefore = stats.messages
 
   for i, client in ipairs(clients) do
 
+      local receiveStart = obs.os_gettime_ns()
       local str, err = client:receive()
+      stats.receiveNs = stats.receiveNs + (obs.os_gettime_ns() - receiveStart)
 
       if str then
+          -- A full buffer means more data is already waiting in the socket
+          if #str >= 64000 then stats.backlog = stats.backlog + 1 end
+          drainSharedRing(false)
           handleClientMessage(client, str)
       elseif err == "closed" then
-          table.insert(removeClients, client)
+          table.insert(closeClients, client)
       elseif err ~= "timeout" then
           error(err)
       end
 
   end
 
+  if datagramServer then
+      for i = 1, MaxDatagramsPerTick do
+          local receiveStart = obs.os_gettime_ns()
+          local str = datagramServer:receive()
+          stats.receiveNs = stats.receiveNs + (obs.os_gettime_ns() - receiveStart)
+          if not str then break end
+          handleClientMessage(nil, str)
+      end
+  end
+
+  drainSharedRing(true)
+  applyRelativeChanges()
+  runLFOs()
+  pushValueChanges()
+
   for i, client in ipairs(closeClients) do
-      closeClient(client)
+      removeClient(client)
   end
 
+  local tickNs = obs.os_gettime_ns() - tickStart
+  local tickMessages = stats.messages - messagesBefore
+  stats.ticks = stats.ticks + 1
+  if tickNs > stats.tickMaxNs then stats.tickMaxNs = tickNs end
+  if tickMessages > stats.maxPerTick then stats.maxPerTick = tickMessages end
+
+  if applyLogFile and tickMessages > 0 then applyLogFile:flush() end
+
+end
+
+-- Strips the Sequenced envelope. Returns the client that registered the sender (for replies)
+-- and the wrapped command ID, or nil for a registration or a value older than one already applied
+local function unwrapSequenced(client, words)
+
+    local senderID = words[2]
+    if senderID == nil then return client, nil end
+
+    local sender = sequencedSenders[senderID]
+    if sender == nil then
+        sender = { client = nil, lastSequence = 0 }
+        sequencedSenders[senderID] = sender
+    end
+    if client then sender.client = client end
+
+    local sequence = tonumber(words[3])
+    if sequence == nil or #words < 4 then return client, nil end
+
+    if sequence <= sender.lastSequence then
+        stats.stale = stats.stale + 1
+        return client or sender.client, nil
+    end
+    sender.lastSequence = sequence
+
+    for i = 1, 3 do table.remove(words, 1) end
+    return client or sender.client, tonumber(words[1])
+
+end
+
+local function recordApply(commandID, sceneName, sourceName, filterName, value, applyNs)
+
+    stats.messages = stats.messages + 1
+    stats.applyNs = stats.applyNs + applyNs
+
+    local name = (sceneName or "") .. "/" .. (sourceName or "")
+    if filterName then name = name .. "/" .. filterName end
+
+    local target = stats.targets[name]
+    if target == nil then
+        target = { count = 0, ns = 0, maxNs = 0 }
+        stats.targets[name] = target
+    end
+    target.count = target.count + 1
+    target.ns = target.ns + applyNs
+    if applyNs > target.maxNs then target.maxNs = applyNs end
+
+    if applyLogFile then
+        applyLogFile:write(string.format("%d\t%d\t%d\t%s\t%s\t%s\t%s\t%d\n",
+            obs.obs_get_video_frame_time(), obs.os_gettime_ns(), commandID,
+            sceneName or "", sourceName or "", filterName or "", tostring(value), applyNs))
+    end
+
 end
 
 function script_unload()
 
     obs.timer_remove(serverCallback)
     obs.timer_remove(clientCallback)
+    obs.timer_remove(statsCallback)
+    obs.timer_remove(catalogueCallback)
 
     disconnectClients()
     disconnectServer()
+    closeApplyLog()
+    releaseTypeStates()
 
 end
 
@@ -123,6 +387,23 @@ function connectServer()
   assert(server:bind(info))
   assert(server:listen())
 
+  -- Optional: without it, plugins with UDP turned off work as before
+  local datagramInfo = socket.find_first_address("*", port, { socket_type = "dgram", protocol = "udp" })
+  if datagramInfo then
+      datagramServer = socket.create(datagramInfo.family, datagramInfo.socket_type, datagramInfo.protocol)
+      if datagramServer then
+          datagramServer:set_blocking(false)
+          datagramServer:set_option("reuseaddr", true)
+          if not datagramServer:bind(datagramInfo) then
+              print("Could not listen for UDP values on port " .. port)
+              datagramServer:close()
+              datagramServer = nil
+          end
+      end
+  end
+
+  openSharedRing()
+
 end
 
 function disconnectServer()
@@ -133,6 +414,102 @@ function disconnectServer()
         server = nil
     end
 
+    if datagramServer ~= nil then
+        datagramServer:close()
+        datagramServer = nil
+    end
+
+    closeSharedRing()
+
+end
+
+-- libc functions for the shared ring; ljsocket may already have declared some of them
+local function declare(definition)
+    pcall(ffi.cdef, definition)
+end
+
+function openSharedRing()
+
+    closeSharedRing()
+
+    -- POSIX shared memory only; Windows plugins always use TCP
+    if ffi.os == "Windows" then return end
+
+    declare("int ftruncate(int fd, int64_t length);")
+    declare("void *mmap(void *addr, size_t length, int prot, int flags, int fd, int64_t offset);")
+    declare("int munmap(void *addr, size_t length);")
+    declare("int close(int fd);")
+    declare("int shm_unlink(const char *name);")
+
+    local libc = ffi.C
+    local O_RDWR, O_CREAT = 2, 0x40
+    if ffi.os == "OSX" then
+        O_CREAT = 0x200
+        declare("int shm_open(const char *name, int oflag, ...);")
+    else
+        declare("int shm_open(const char *name, int oflag, unsigned int mode);")
+        -- Before glibc 2.34 shm_open is in librt
+        local ok, rt = pcall(ffi.load, "librt.so.1")
+        if ok and pcall(function() return rt.shm_open end) then libc = rt end
+    end
+
+    local name = "/obvious-" .. port
+    local size = ffi.sizeof("ObviousSharedRingHeader") + SharedRingCapacity * ffi.sizeof("ObviousSharedRingRecord")
+
+    local fd = libc.shm_open(name, bit.bor(O_RDWR, O_CREAT), 384) -- 0600
+    if fd < 0 then
+        print("Shared memory unavailable, plugins on this machine will use TCP")
+        return
+    end
+
+    local data = nil
+    if libc.ftruncate(fd, size) == 0 then
+        data = ffi.C.mmap(nil, size, 3, 1, fd, 0) -- PROT_READ | PROT_WRITE, MAP_SHARED
+    end
+    ffi.C.close(fd)
+
+    if data == nil or ffi.cast("intptr_t", data) == -1 then
+        print("Could not map shared memory, plugins on this machine will use TCP")
+        libc.shm_unlink(name)
+        return
+    end
+
+    local header = ffi.cast("ObviousSharedRingHeader *", data)
+
+    -- Take over a segment left by an earlier session, dropping anything unread
+    local start = 0
+    if ffi.string(header.magic, 8) == "OBVSHRNG" and header.version == 1 and header.recordSize == ffi.sizeof("ObviousSharedRingRecord") and tonumber(header.capacity) == SharedRingCapacity then
+        start = tonumber(header.writeIndex)
+    else
+        ffi.fill(data, size, 0)
+        ffi.copy(header.magic, "OBVSHRNG", 8)
+        header.version = 1
+        header.recordSize = ffi.sizeof("ObviousSharedRingRecord")
+        header.capacity = SharedRingCapacity
+    end
+    header.writeIndex = start
+    header.readIndex = start
+
+    sharedRing = {
+        header = header,
+        records = ffi.cast("ObviousSharedRingRecord *", header + 1),
+        capacity = SharedRingCapacity,
+        size = size,
+        name = name,
+        libc = libc,
+        stalledDrains = 0,
+    }
+
+end
+
+function closeSharedRing()
+
+    if sharedRing ~= nil then
+        ffi.C.munmap(sharedRing.header, sharedRing.size)
+        sharedRing.libc.shm_unlink(sharedRing.name)
+        sharedRing = nil
+    end
+
 end
 
 function disconnectClients()
@@ -157,11 +534,67 @@ end
 
 function disconnectClient(client)
 
-    local n = tableIndexOf(clients, client)
     local host, port = client:get_peer_name()
     print("Disconnecting client @ " .. host .. ":" .. port)
     assert(client:close())
-    table.remove(clients, n)
+    removeClient(client)
+
+end
+
+-- Forgets a client whose socket is already closed
+function removeClient(client)
+
+    local n = tableIndexOf(clients, client)
+    if n then table.remove(clients, n) end
+
+    n = tableIndexOf(statsClients, client)
+    if n then table.remove(statsClients, n) end
+
+    n = tableIndexOf(catalogueClients, client)
+    if n then table.remove(catalogueClients, n) end
+
+    valueSubscriptions[client] = nil
+
+    for _, pending in pairs(relativeChanges) do
+        if pending.client == client then pending.client = nil end
+    end
+
+    for _, scheduled in ipairs(scheduledMessages) do
+        if scheduled.client == client then scheduled.client = nil end
+    end
+
+    -- Nothing would stop them any more
+    for key, lfo in pairs(lfos) do
+        if lfo.client == client then lfos[key] = nil end
+    end
+
+    for _, sender in pairs(sequencedSenders) do
+        if sender.client == client then sender.client = nil end
+    end
+
+end
+
+function openApplyLog()
+
+    closeApplyLog()
+
+    if applyLogPath ~= "" then
+        applyLogFile = io.open(applyLogPath, "a")
+        if applyLogFile then
+            applyLogFile:write("# frame_time_ns\tapplied_ns\tcommand\tscene\tsource\tfilter\tvalue\tapply_ns\n")
+        else
+            print("Could not open apply log '" .. applyLogPath .. "'")
+        end
+    end
+
+end
+
+function closeApplyLog()
+
+    if applyLogFile then
+        applyLogFile:close()
+        applyLogFile = nil
+    end
 
 end
 
@@ -172,6 +605,7 @@ end
 function script_properties()
     local props = obs.obs_properties_create()
     obs.obs_properties_add_int(props, "Port", "Port", 0, 99999, 1)
+    obs.obs_properties_add_path(props, "ApplyLog", "Apply log file (optional)", obs.OBS_PATH_FILE_SAVE, "Log files (*.log *.tsv)", nil)
     return props
 end
 
@@ -180,6 +614,12 @@ function script_update(settings)
     disconnectClients()
     disconnectServer()
     connectServer()
+
+    local path = obs.obs_data_get_string(settings, "ApplyLog")
+    if path ~= applyLogPath or applyLogFile == nil then
+        applyLogPath = path
+        openApplyLog()
+    end
 end
 
 function script_save(settings)
@@ -195,6 +635,403 @@ local function printAndSend(client, message, responseCode)
     clientSend(client, message, responseCode)
 end
 
+-- Sends "key=value;..." to subscribed clients. slowTarget is last, as target names may contain ';'
+function statsCallback()
+
+    local elapsedNs = obs.os_gettime_ns() - stats.startNs
+
+    if #statsClients > 0 and stats.ticks > 0 then
+
+        local slowTarget, slowAvg, slowMax = "", 0, 0
+        for name, target in pairs(stats.targets) do
+            local avg = target.ns / target.count
+            if avg > slowAvg then slowTarget, slowAvg, slowMax = name, avg, target.maxNs end
+        end
+
+        local fps = obs.obs_get_active_fps()
+        local frames = (elapsedNs / 1000000000) * fps
+        local perFrame = 0
+        if frames > 0 then perFrame = stats.messages / frames end
+
+        local report = string.format("ticks=%d;receiveUs=%.1f;parseUs=%.1f;applyUs=%.1f;tickMaxUs=%.1f;messages=%d;perFrame=%.2f;maxPerTick=%d;backlog=%d;stale=%d;targetAvgUs=%.1f;targetMaxUs=%.1f;slowTarget=%s",
+            stats.ticks,
+            stats.receiveNs / stats.ticks / 1000, stats.parseNs / stats.ticks / 1000, stats.applyNs / stats.ticks / 1000,
+            stats.tickMaxNs / 1000, stats.messages, perFrame, stats.maxPerTick, stats.backlog, stats.stale,
+            slowAvg / 1000, slowMax / 1000, slowTarget)
+
+        for _, client in ipairs(statsClients) do
+            clientSend(client, report, ResponseCodeStats)
+        end
+
+    end
+
+    resetStats()
+
+end
+
+local function catalogueMessage(responseCode, kind, first, second)
+    local entry = kind .. CatalogueFieldDelimiter .. first
+    if second then entry = entry .. CatalogueFieldDelimiter .. second end
+    return responseCode .. CommandChunkDelimiter .. entry .. CommandDelimiter
+end
+
+-- Marks everything a change to the named source can affect: its filters, the scene of that
+-- name and every scene it is an item of
+local function markCatalogueDirty(name)
+    if catalogue == nil or name == nil then return end
+    catalogueDirtySources[name] = true
+    if catalogue.scenes[name] then catalogueDirtyScenes[name] = true end
+    for sceneName, items in pairs(catalogue.scenes) do
+        if items[name] then catalogueDirtyScenes[sceneName] = true end
+    end
+end
+
+-- Connects to a source's item and filter signals once. The callbacks read the name from
+-- `watched`, which a rename updates
+local function watchSource(source, name)
+
+    if catalogueWatched[name] then return end
+
+    local watched = { name = name }
+    catalogueWatched[name] = watched
+
+    local handler = obs.obs_source_get_signal_handler(source)
+
+    if obs.obs_scene_from_source(source) or obs.obs_group_from_source(source) then
+        local itemsChanged = function(calldata) markCatalogueDirty(watched.name) end
+        obs.signal_handler_connect(handler, "item_add", itemsChanged)
+        obs.signal_handler_connect(handler, "item_remove", itemsChanged)
+    end
+
+    local filtersChanged = function(calldata) catalogueDirtySources[watched.name] = true end
+    obs.signal_handler_connect(handler, "filter_add", filtersChanged)
+    obs.signal_handler_connect(handler, "filter_remove", filtersChanged)
+
+end
+
+local function sceneItemNames(scene, names)
+    local items = obs.obs_scene_enum_items(scene)
+    if items then
+        for _, item in ipairs(items) do
+            local source = obs.obs_sceneitem_get_source(item)
+            local name = obs.obs_source_get_name(source)
+            names[name] = true
+            watchSource(source, name)
+            -- findSceneItem searches inside groups, so their items belong to the scene too
+            if obs.obs_sceneitem_is_group(item) then
+                sceneItemNames(obs.obs_sceneitem_group_get_scene(item), names)
+            end
+        end
+        obs.sceneitem_list_release(items)
+    end
+    return names
+end
+
+-- The item names of a scene, or nil when there is no scene of that name
+local function scanScene(name)
+    local source = obs.obs_get_source_by_name(name)
+    if source == nil then return nil end
+    local names = nil
+    local scene = obs.obs_scene_from_source(source)
+    if scene then
+        watchSource(source, name)
+        names = sceneItemNames(scene, {})
+    end
+    obs.obs_source_release(source)
+    return names
+end
+
+-- The filter names of a source, or nil when there is no source of that name
+local function scanFilters(name)
+    local source = obs.obs_get_source_by_name(name)
+    if source == nil then return nil end
+    local names = {}
+    local filters = obs.obs_source_enum_filters(source)
+    if filters then
+        for _, filter in ipairs(filters) do names[obs.obs_source_get_name(filter)] = true end
+        obs.source_list_release(filters)
+    end
+    obs.obs_source_release(source)
+    return names
+end
+
+-- Appends the names only in `new` as adds and those only in `old` as removes
+local function diffCatalogue(changes, kind, context, old, new)
+    for name in pairs(old or {}) do
+        if new == nil or not new[name] then table.insert(changes, catalogueMessage(ResponseCodeCatalogueRemove, kind, context, name)) end
+    end
+    for name in pairs(new or {}) do
+        if old == nil or not old[name] then table.insert(changes, catalogueMessage(ResponseCodeCatalogueAdd, kind, context, name)) end
+    end
+end
+
+local function updateCatalogue()
+
+    local changes = {}
+
+    local dirtyScenes = catalogueDirtyScenes
+    catalogueDirtyScenes = {}
+    for sceneName in pairs(dirtyScenes) do
+
+        local old = catalogue.scenes[sceneName]
+        local new = scanScene(sceneName)
+
+        if old == nil and new ~= nil then table.insert(changes, catalogueMessage(ResponseCodeCatalogueAdd, "S", sceneName)) end
+        diffCatalogue(changes, "I", sceneName, old, new)
+        if old ~= nil and new == nil then table.insert(changes, catalogueMessage(ResponseCodeCatalogueRemove, "S", sceneName)) end
+
+        catalogue.scenes[sceneName] = new
+
+        -- Sources seen for the first time need their filters
+        for sourceName in pairs(new or {}) do
+            if catalogue.filters[sourceName] == nil then catalogueDirtySources[sourceName] = true end
+        end
+
+    end
+
+    local dirtySources = catalogueDirtySources
+    catalogueDirtySources = {}
+    for sourceName in pairs(dirtySources) do
+        local new = scanFilters(sourceName)
+        diffCatalogue(changes, "F", sourceName, catalogue.filters[sourceName], new)
+        catalogue.filters[sourceName] = new
+    end
+
+    if #changes > 0 then
+        local message = table.concat(changes)
+        for _, client in ipairs(catalogueClients) do client:send(message) end
+    end
+
+end
+
+local function onSourceCreated(calldata)
+    local source = obs.calldata_source(calldata, "source")
+    if catalogue and source and obs.obs_scene_from_source(source) then
+        catalogueDirtyScenes[obs.obs_source_get_name(source)] = true
+    end
+end
+
+local function onSourceRemoved(calldata)
+    local source = obs.calldata_source(calldata, "source")
+    if source then
+        local name = obs.obs_source_get_name(source)
+        markCatalogueDirty(name)
+        catalogueWatched[name] = nil
+    end
+end
+
+local function onSourceRenamed(calldata)
+
+    local source = obs.calldata_source(calldata, "source")
+    local previousName = obs.calldata_string(calldata, "prev_name")
+    local newName = obs.calldata_string(calldata, "new_name")
+
+    local watched = catalogueWatched[previousName]
+    if watched then
+        watched.name = newName
+        catalogueWatched[newName] = watched
+        catalogueWatched[previousName] = nil
+    end
+
+    markCatalogueDirty(previousName)
+    markCatalogueDirty(newName)
+
+    if catalogue and source then
+        if obs.obs_scene_from_source(source) then catalogueDirtyScenes[newName] = true end
+        -- A filter's name is listed under its source
+        local parent = obs.obs_filter_get_parent(source)
+        if parent then catalogueDirtySources[obs.obs_source_get_name(parent)] = true end
+    end
+
+end
+
+-- The first subscriber makes the only full scan; later ones are sent what is already known
+local function subscribeCatalogue(client)
+
+    if catalogue == nil then
+
+        catalogue = { scenes = {}, filters = {} }
+
+        local handler = obs.obs_get_signal_handler()
+        obs.signal_handler_connect(handler, "source_create", onSourceCreated)
+        obs.signal_handler_connect(handler, "source_remove", onSourceRemoved)
+        obs.signal_handler_connect(handler, "source_destroy", onSourceRemoved)
+        obs.signal_handler_connect(handler, "source_rename", onSourceRenamed)
+
+        local scenes = obs.obs_frontend_get_scenes()
+        if scenes then
+            for _, scene in ipairs(scenes) do catalogueDirtyScenes[obs.obs_source_get_name(scene)] = true end
+            obs.source_list_release(scenes)
+        end
+
+    end
+
+    updateCatalogue()
+
+    local snapshot = { ResponseCodeCatalogueBegin .. CommandChunkDelimiter .. "." .. CommandDelimiter }
+    for sceneName, items in pairs(catalogue.scenes) do
+        table.insert(snapshot, catalogueMessage(ResponseCodeCatalogueAdd, "S", sceneName))
+        for sourceName in pairs(items) do table.insert(snapshot, catalogueMessage(ResponseCodeCatalogueAdd, "I", sceneName, sourceName)) end
+    end
+    for sourceName, filters in pairs(catalogue.filters) do
+        for filterName in pairs(filters) do table.insert(snapshot, catalogueMessage(ResponseCodeCatalogueAdd, "F", sourceName, filterName)) end
+    end
+    table.insert(snapshot, ResponseCodeCatalogueEnd .. CommandChunkDelimiter .. "." .. CommandDelimiter)
+
+    client:send(table.concat(snapshot))
+    if tableIndexOf(catalogueClients, client) == nil then table.insert(catalogueClients, client) end
+
+end
+
+function catalogueCallback()
+    if catalogue ~= nil and (next(catalogueDirtyScenes) ~= nil or next(catalogueDirtySources) ~= nil) then
+        updateCatalogue()
+    end
+end
+
+-- Like findSceneItem, without telling the client when there is none
+local function lookUpSceneItem(sceneName, sourceName)
+    local sceneSource = obs.obs_get_source_by_name(sceneName)
+    if sceneSource == nil then return nil end
+    local item = nil
+    local scene = obs.obs_scene_from_source(sceneSource)
+    if scene then item = obs.obs_scene_find_source_recursive(scene, sourceName) end
+    obs.obs_source_release(sceneSource)
+    return item
+end
+
+local filterSettingNames = {
+    [Hue] = "hue_shift",
+    [Saturation] = "saturation",
+    [RollSpeedH] = "speed_x",
+    [RollSpeedV] = "speed_y",
+    [Opacity] = "opacity",
+}
+
+-- The current value of what `command` sets on a target, or nil when it cannot be read
+local function readValue(command, sceneName, sourceName, filterName)
+
+    local sceneItem = lookUpSceneItem(sceneName, sourceName)
+    if sceneItem == nil then return nil end
+    local source = obs.obs_sceneitem_get_source(sceneItem)
+
+    if command == ScaleX or command == ScaleY then
+        local scale = obs.vec2()
+        obs.obs_sceneitem_get_scale(sceneItem, scale)
+        if command == ScaleX then return scale.x end
+        return scale.y
+
+    elseif command == PositionProportionateX or command == PositionProportionateY then
+        local position = obs.vec2()
+        obs.obs_sceneitem_get_pos(sceneItem, position)
+        if command == PositionProportionateX then
+            local width = obs.obs_source_get_width(source)
+            if width > 0 then return position.x / width end
+        else
+            local height = obs.obs_source_get_height(source)
+            if height > 0 then return position.y / height end
+        end
+        return nil
+
+    elseif command == CropTop or command == CropBottom or command == CropLeft or command == CropRight then
+        local crop = obs.obs_sceneitem_crop()
+        obs.obs_sceneitem_get_crop(sceneItem, crop)
+        if command == CropTop then return crop.top
+        elseif command == CropBottom then return crop.bottom
+        elseif command == CropLeft then return crop.left end
+        return crop.right
+
+    elseif command == Rotation then
+        return obs.obs_sceneitem_get_rot(sceneItem)
+
+    elseif command == BoundsWidth or command == BoundsHeight then
+        local bounds = obs.vec2()
+        obs.obs_sceneitem_get_bounds(sceneItem, bounds)
+        if command == BoundsWidth then return bounds.x end
+        return bounds.y
+
+    elseif command == SetVisible then
+        if obs.obs_sceneitem_visible(sceneItem) then return 1 end
+        return 0
+
+    elseif command == MediaCursor then
+        return obs.obs_source_media_get_time(source)
+
+    elseif filterSettingNames[command] and filterName then
+        local filter = obs.obs_source_get_filter_by_name(source, filterName)
+        if filter == nil then return nil end
+        local value = nil
+        local filterSettings = obs.obs_source_get_settings(filter)
+        if filterSettings then
+            value = obs.obs_data_get_double(filterSettings, filterSettingNames[command])
+            obs.obs_data_release(filterSettings)
+        end
+        obs.obs_source_release(filter)
+        return value
+    end
+
+    return nil
+
+end
+
+local function sendValue(client, subscription, value)
+    clientSend(client, subscription.command .. CatalogueFieldDelimiter .. subscription.scene .. CatalogueFieldDelimiter ..
+        subscription.source .. CatalogueFieldDelimiter .. (subscription.filter or "") .. CatalogueFieldDelimiter .. string.format("%.6f", value), ResponseCodeValue)
+end
+
+-- Values read back as floats differ from the doubles that were set by rounding only
+local function valueChanged(old, new)
+    return old == nil or math.abs(new - old) > 1e-5 * math.max(1, math.abs(old))
+end
+
+-- ValueQuery and ValueSubscribe: words are command ID, scene, source, [filter,] the command to read
+local function requestValue(client, commandID, words)
+
+    local command = tonumber(words[#words])
+    if commandID == ValueSubscribe then valueSubscriptions[client] = nil end
+    if command == nil or command == 0 or #words < 4 then return end
+
+    local request = { command = command, scene = words[2], source = words[3] }
+    if #words > 4 then request.filter = words[4] end
+
+    local value = readValue(command, request.scene, request.source, request.filter)
+    if value ~= nil then sendValue(client, request, value) end
+
+    if commandID == ValueSubscribe then
+        request.value = value
+        valueSubscriptions[client] = request
+    end
+
+end
+
+-- Once per rendered frame, sends each subscriber its value if OBS changed it
+function pushValueChanges()
+
+    if next(valueSubscriptions) == nil then return end
+
+    local frameTime = obs.obs_get_video_frame_time()
+    if frameTime == lastValueFrameTime then return end
+    lastValueFrameTime = frameTime
+
+    for client, subscription in pairs(valueSubscriptions) do
+        local value = readValue(subscription.command, subscription.scene, subscription.source, subscription.filter)
+        if value ~= nil and valueChanged(subscription.value, value) then
+            subscription.value = value
+            sendValue(client, subscription, value)
+        end
+    end
+
+end
+
+-- What a client has just set is not sent back to it
+local function valueApplied(client, commandID, sceneName, sourceName, filterName)
+    local subscription = valueSubscriptions[client]
+    if subscription and subscription.command == commandID and subscription.scene == sceneName
+        and subscription.source == sourceName and subscription.filter == filterName then
+        subscription.value = readValue(commandID, sceneName, sourceName, filterName)
+    end
+end
+
 local function findSceneItem(client, sceneName, sourceName)
     local sceneSource = obs.obs_get_source_by_name(sceneName)
     if sceneSource then
@@ -310,73 +1147,475 @@ local function crop(client, sceneName, sourceName, command, value)
 
 end
 
-local typeTextDict = {}
-local typeNumCharsDict = {}
-local cursorCharacterDict = {}
-local cursorCharacterVisibleDict = {}
+-- The commands a Transform can carry
+local transformCommands = {
+    [PositionProportionateX] = true, [PositionProportionateY] = true, [ScaleX] = true, [ScaleY] = true, [Rotation] = true,
+    [CropTop] = true, [CropBottom] = true, [CropLeft] = true, [CropRight] = true, [BoundsWidth] = true, [BoundsHeight] = true,
+}
+
+-- Transform payload: command<GS>value<GS>command<GS>value...
+local function transformFields(text)
+    local fields = {}
+    local pattern = "([^" .. CatalogueFieldDelimiter .. "]+)" .. CatalogueFieldDelimiter .. "([^" .. CatalogueFieldDelimiter .. "]+)"
+    for command, value in string.gmatch(text, pattern) do
+        command = tonumber(command)
+        if transformCommands[command] then fields[command] = tonumber(value) end
+    end
+    return fields
+end
+
+-- Sets any of an item's position, scale, rotation, crop and bounds (`fields`, keyed by command ID)
+-- in one deferred update, so no frame is rendered with only some of them applied
+local function setTransform(client, sceneName, sourceName, fields)
+
+    local sceneItem = findSceneItem(client, sceneName, sourceName)
+    if sceneItem == nil then return end
+
+    obs.obs_sceneitem_defer_update_begin(sceneItem)
+
+    local x, y = fields[PositionProportionateX], fields[PositionProportionateY]
+    if x or y then
+        local source = obs.obs_sceneitem_get_source(sceneItem)
+        local position = obs.vec2()
+        obs.obs_sceneitem_get_pos(sceneItem, position)
+        if x then position.x = obs.obs_source_get_width(source) * x end
+        if y then position.y = obs.obs_source_get_height(source) * y end
+        obs.obs_sceneitem_set_pos(sceneItem, position)
+    end
+
+    if fields[ScaleX] or fields[ScaleY] then
+        local scale = obs.vec2()
+        obs.obs_sceneitem_get_scale(sceneItem, scale)
+        scale.x = fields[ScaleX] or scale.x
+        scale.y = fields[ScaleY] or scale.y
+        obs.obs_sceneitem_set_scale(sceneItem, scale)
+    end
+
+    if fields[Rotation] then obs.obs_sceneitem_set_rot(sceneItem, fields[Rotation]) end
+
+    if fields[CropTop] or fields[CropBottom] or fields[CropLeft] or fields[CropRight] then
+        local crop = obs.obs_sceneitem_crop()
+        obs.obs_sceneitem_get_crop(sceneItem, crop)
+        crop.top = fields[CropTop] or crop.top
+        crop.bottom = fields[CropBottom] or crop.bottom
+        crop.left = fields[CropLeft] or crop.left
+        crop.right = fields[CropRight] or crop.right
+        obs.obs_sceneitem_set_crop(sceneItem, crop)
+    end
+
+    if fields[BoundsWidth] or fields[BoundsHeight] then
+        -- Bounds do nothing without a bounds type; an item without one gets OBS's "scale to inner bounds"
+        if obs.obs_sceneitem_get_bounds_type(sceneItem) == obs.OBS_BOUNDS_NONE then
+            obs.obs_sceneitem_set_bounds_type(sceneItem, obs.OBS_BOUNDS_SCALE_INNER)
+        end
+        local bounds = obs.vec2()
+        obs.obs_sceneitem_get_bounds(sceneItem, bounds)
+        bounds.x = fields[BoundsWidth] or bounds.x
+        bounds.y = fields[BoundsHeight] or bounds.y
+        obs.obs_sceneitem_set_bounds(sceneItem, bounds)
+    end
+
+    obs.obs_sceneitem_defer_update_end(sceneItem)
 
-local function typeDictionaryKey(sceneName, sourceName)
-    return sceneName .. sourceName
 end
 
-local function typeText(client, sceneName, sourceName)
+-- Sets what `command` sets on a target, as its absolute command does
+local function applyValue(client, command, sceneName, sourceName, filterName, value)
+    if command == Rotation or command == BoundsWidth or command == BoundsHeight then
+        setTransform(client, sceneName, sourceName, { [command] = value })
+    elseif command == ScaleX then
+        setScale(client, sceneName, sourceName, value, nil)
+    elseif command == ScaleY then
+        setScale(client, sceneName, sourceName, nil, value)
+    elseif command == PositionProportionateX then
+        setProportionatePositions(client, sceneName, sourceName, value, nil)
+    elseif command == PositionProportionateY then
+        setProportionatePositions(client, sceneName, sourceName, nil, value)
+    elseif command == CropTop or command == CropBottom or command == CropLeft or command == CropRight then
+        crop(client, sceneName, sourceName, command, value)
+    elseif filterSettingNames[command] then
+        setFilterValue(client, sceneName, sourceName, filterName, filterSettingNames[command], value)
+    end
+end
 
-    local source = findSource(client, sceneName, sourceName)
-    if source then
+local continuousCommands = {
+    [PositionProportionateX] = true, [PositionProportionateY] = true, [ScaleX] = true, [ScaleY] = true, [Rotation] = true,
+    [CropTop] = true, [CropBottom] = true, [CropLeft] = true, [CropRight] = true, [BoundsWidth] = true, [BoundsHeight] = true,
+    [Hue] = true, [Saturation] = true, [RollSpeedH] = true, [RollSpeedV] = true, [Opacity] = true,
+}
 
-        local key = typeDictionaryKey(sceneName, sourceName)
-        local fullString = typeTextDict[key]
-        if fullString then
+-- Relative: words are Relative, command ID, scene, source, [filter,] the change
+local function addRelativeChange(client, words)
 
+    local command = tonumber(words[2])
+    local change = tonumber(words[#words])
+    if command == nil or change == nil or #words < 5 then return end
 
-            local numChars = typeNumCharsDict[key]
-            if numChars then
-                -- local reformattedText = string.gsub(fullString, "<SPACE>", " ")
-                -- local subText = string.sub(reformattedText, 1, numChars)
-                local subText = string.sub(fullString, 1, numChars)
+    if not continuousCommands[command] then
+        printAndSend(client, "Command ID (" .. command .. ") cannot be relative", ResponseCodeError)
+        return
+    end
 
-                if cursorCharacterVisibleDict[key] then
+    local filterName = nil
+    if #words > 5 then filterName = words[5] end
 
-                    local cursorCharacter = cursorCharacterDict[key]
-                    if cursorCharacter then
+    local key = command .. CommandChunkDelimiter .. words[3] .. CommandChunkDelimiter .. words[4] .. CommandChunkDelimiter .. (filterName or "")
+    local pending = relativeChanges[key]
+    if pending == nil then
+        relativeChanges[key] = { client = client, command = command, scene = words[3], source = words[4], filter = filterName, change = change }
+    else
+        pending.change = pending.change + change
+        if client then pending.client = client end
+    end
 
-                        if cursorCharacterVisibleDict[key] == "yes" then subText = subText .. cursorCharacter end
+end
 
-                        local sourceSettings = obs.obs_source_get_settings(source)
-                        if sourceSettings then
+-- Sets the value of each { client, command, scene, source, filter, value } in `targets`. The
+-- transform values for one item are applied together, as one Transform
+local function applyValues(targets)
 
-                            obs.obs_data_set_string(sourceSettings, "text", subText)
-                            obs.obs_source_update(source, sourceSettings)
+    local transforms = {}
 
-                            obs.obs_data_release(sourceSettings)
+    for _, target in ipairs(targets) do
 
-                        else
-                            printAndSend(client, "Could not get settings for text source named '" .. sourceName .. "' in scene named '" .. sceneName .. "'", ResponseCodeError, ResponseCodeError)
-                        end
+        local applyStart = obs.os_gettime_ns()
 
-                    else
-                        print("Requesting cursor character")
-                        clientSend(client, ".", ResponseCodeRequestTypeCursorChar)
-                    end
+        if transformCommands[target.command] then
+            local key = target.scene .. CommandChunkDelimiter .. target.source
+            local transform = transforms[key]
+            if transform == nil then
+                transform = { client = target.client, scene = target.scene, source = target.source, fields = {} }
+                transforms[key] = transform
+            end
+            transform.fields[target.command] = target.value
+        else
+            applyValue(target.client, target.command, target.scene, target.source, target.filter, target.value)
+        end
 
-                else
-                    print("Requesting cursor visibility")
-                    clientSend(client, ".", ResponseCodeRequestTypeCursorVisible)
-                end
+        recordApply(target.command, target.scene, target.source, target.filter, target.value, obs.os_gettime_ns() - applyStart)
 
+    end
 
+    for _, transform in pairs(transforms) do
+        setTransform(transform.client, transform.scene, transform.source, transform.fields)
+    end
 
-            else
-                print("Requesting number of characters to print")
-                clientSend(client, ".", ResponseCodeRequestTypeNumChars)
+    for _, target in ipairs(targets) do
+        if target.client and valueSubscriptions[target.client] then
+            valueApplied(target.client, target.command, target.scene, target.source, target.filter)
+        end
+    end
+
+end
+
+local function reportMissingFilter(target)
+    if findSceneItem(target.client, target.scene, target.source) and target.filter then
+        printAndSend(target.client, "No filter named '" .. target.filter .. "' was found on source named '" .. target.source .. "' in scene named '" .. target.scene .. "'", ResponseCodeError)
+    end
+end
+
+-- Once per rendered frame, adds each target's summed changes to its current value
+function applyRelativeChanges()
+
+    if next(relativeChanges) == nil then return end
+
+    local frameTime = obs.obs_get_video_frame_time()
+    if frameTime == lastRelativeFrameTime then return end
+    lastRelativeFrameTime = frameTime
+
+    local changes = relativeChanges
+    relativeChanges = {}
+
+    local applied = {}
+
+    for key, pending in pairs(changes) do
+        local value = readValue(pending.command, pending.scene, pending.source, pending.filter)
+        if value ~= nil then
+            value = value + pending.change
+            if pending.command == CropTop or pending.command == CropBottom or pending.command == CropLeft or pending.command == CropRight then
+                value = value + (cropRemainders[key] or 0)
+                local pixels = math.floor(value + 0.5)
+                cropRemainders[key] = value - pixels
+                value = pixels
             end
+            pending.value = value
+            table.insert(applied, pending)
         else
-            print("Requesting text to print")
-            clientSend(client, ".", ResponseCodeRequestTypeText)
+            reportMissingFilter(pending)
+        end
+    end
+
+    applyValues(applied)
+
+end
+
+-- Values: the last word is records separated by ValuesRecordDelimiter, each command<GS>scene<GS>source<GS>filter<GS>value
+-- with an empty filter for a source command. All of them are applied together, as the same frame's values
+local function applyValueRecords(client, text)
+
+    local targets = {}
+
+    for record in string.gmatch(text, "[^" .. ValuesRecordDelimiter .. "]+") do
+
+        -- Empty fields are kept, so the filter stays in its place
+        local fields = {}
+        for field in string.gmatch(record .. CatalogueFieldDelimiter, "([^" .. CatalogueFieldDelimiter .. "]*)" .. CatalogueFieldDelimiter) do
+            table.insert(fields, field)
+        end
+
+        local command = tonumber(fields[1])
+        local value = tonumber(fields[5])
+
+        if command == nil or value == nil or #fields < 5 then
+            printAndSend(client, "Malformed Values record", ResponseCodeError)
+        elseif not continuousCommands[command] then
+            printAndSend(client, "Command ID (" .. command .. ") cannot be sent in Values", ResponseCodeError)
+        else
+            local filterName = nil
+            if fields[4] ~= "" then filterName = fields[4] end
+            table.insert(targets, { client = client, command = command, scene = fields[2], source = fields[3], filter = filterName, value = value })
         end
 
     end
 
+    applyValues(targets)
+
+end
+
+-- Each waveform over one cycle, p from 0 to 1, between -1 and 1
+local lfoWaveforms = {
+    [1] = function(p) return math.sin(2 * math.pi * p) end,
+    [2] = function(p) return 1 - 4 * math.abs(p - 0.5) end,
+    [3] = function(p) return 2 * p - 1 end,
+    [4] = function(p) if p < 0.5 then return 1 end return -1 end,
+}
+
+-- LFO: words are LFO, scene, source, [filter,] then command<GS>waveform<GS>beats<GS>phase<GS>centre<GS>
+-- amplitude<GS>lower<GS>upper<GS>bpm<GS>beat<GS>playing. Waveform 0 stops the target's LFO
+local function setLFO(client, words)
+
+    if #words < 4 then return end
+
+    local fields = {}
+    for field in string.gmatch(words[#words], "[^" .. CatalogueFieldDelimiter .. "]+") do
+        table.insert(fields, tonumber(field))
+    end
+
+    local command = fields[1]
+    if command == nil then return end
+
+    if not continuousCommands[command] then
+        printAndSend(client, "Command ID (" .. command .. ") cannot run an LFO", ResponseCodeError)
+        return
+    end
+
+    local filterName = nil
+    if #words > 4 then filterName = words[4] end
+
+    local key = command .. CommandChunkDelimiter .. words[2] .. CommandChunkDelimiter .. words[3] .. CommandChunkDelimiter .. (filterName or "")
+
+    if #fields < 11 or not lfoWaveforms[fields[2]] then
+        lfos[key] = nil
+        return
+    end
+
+    lfos[key] = {
+        client = client, command = command, scene = words[2], source = words[3], filter = filterName,
+        waveform = lfoWaveforms[fields[2]], beats = math.max(fields[3], 1 / 64), phase = fields[4],
+        centre = fields[5], amplitude = fields[6], lower = fields[7], upper = fields[8],
+        bpm = fields[9], beat = fields[10], playing = fields[11] == 1, anchorNs = obs.os_gettime_ns(),
+    }
+
+end
+
+-- Once per rendered frame, sets each LFO's target to its value at the frame's time. An LFO whose
+-- target has gone is reported once and dropped; the plugin sends it again with its next anchor
+function runLFOs()
+
+    if next(lfos) == nil then return end
+
+    local frameTime = obs.obs_get_video_frame_time()
+    if frameTime == lastLFOFrameTime then return end
+    lastLFOFrameTime = frameTime
+
+    local targets = {}
+
+    for key, lfo in pairs(lfos) do
+
+        if lookUpSceneItem(lfo.scene, lfo.source) == nil
+            or (lfo.filter and readValue(lfo.command, lfo.scene, lfo.source, lfo.filter) == nil) then
+            reportMissingFilter(lfo)
+            lfos[key] = nil
+        else
+            local beat = lfo.beat
+            if lfo.playing then beat = beat + (frameTime - lfo.anchorNs) / 1e9 * lfo.bpm / 60 end
+            local value = lfo.centre + lfo.amplitude * lfo.waveform((beat / lfo.beats + lfo.phase) % 1)
+            value = math.max(lfo.lower, math.min(lfo.upper, value))
+            -- A stopped transport or a flat part of the wave sets nothing
+            if value ~= lfo.value then
+                lfo.value = value
+                table.insert(targets, lfo)
+            end
+        end
+
+    end
+
+    applyValues(targets)
+
+end
+
+-- Scheduled: words are Scheduled, the delay in ms, then the command to apply after it
+local function scheduleMessage(client, words)
+
+    local delay = tonumber(words[2])
+    if delay == nil or #words < 4 then return end
+
+    local message = table.concat(words, CommandChunkDelimiter, 3)
+    table.insert(scheduledMessages, { client = client, due = obs.os_gettime_ns() + math.max(delay, 0) * 1000000, message = message })
+
+end
+
+-- Applies the scheduled messages due by the middle of the next frame, so each lands on the
+-- frame nearest the time it was due. Run from script_tick, which OBS calls once per video frame.
+local function runScheduled()
+
+    if #scheduledMessages == 0 then return end
+
+    local due = obs.os_gettime_ns() + obs.obs_get_frame_interval_ns() / 2
+    local waiting = {}
+    local ready = {}
+
+    for _, scheduled in ipairs(scheduledMessages) do
+        if scheduled.due <= due then table.insert(ready, scheduled) else table.insert(waiting, scheduled) end
+    end
+
+    scheduledMessages = waiting
+
+    for _, scheduled in ipairs(ready) do
+        handleClientMessage(scheduled.client, scheduled.message)
+    end
+
+end
+
+-- Once per video frame, unlike the timers, which can run more or less often than frames are made
+function script_tick(seconds)
+    runScheduled()
+end
+
+-- Typing state per target. The text is indexed into UTF-8 character end offsets once when it
+-- arrives, so showing the first n characters is one string.sub, and the text source is updated
+-- through one small settings object per target rather than a copy of all its settings
+local typeStates = {}
+
+local function typeState(sceneName, sourceName)
+    local key = sceneName .. CommandChunkDelimiter .. sourceName
+    local state = typeStates[key]
+    if state == nil then
+        state = { offsets = {} }
+        typeStates[key] = state
+    end
+    return state
+end
+
+-- Byte offset of the end of each character: a lead byte and its continuation bytes
+local function characterOffsets(text)
+    local offsets = {}
+    local offset = 0
+    for character in string.gmatch(text, "[%z\1-\127\192-\255][\128-\191]*") do
+        offset = offset + #character
+        offsets[#offsets + 1] = offset
+    end
+    return offsets
+end
+
+local function setTypeText(state, text)
+    state.text = text
+    state.offsets = characterOffsets(text)
+    state.shownChars = nil
+end
+
+-- TypeSetState: "numChars<GS>cursorVisible<GS>cursorCharacter<GS>text", the text last and possibly empty
+local function setTypeState(state, payload)
+    local pattern = "^([^" .. CatalogueFieldDelimiter .. "]*)" .. CatalogueFieldDelimiter
+        .. "([^" .. CatalogueFieldDelimiter .. "]*)" .. CatalogueFieldDelimiter
+        .. "([^" .. CatalogueFieldDelimiter .. "]*)" .. CatalogueFieldDelimiter .. "(.*)$"
+    local numChars, cursorVisible, cursorCharacter, text = string.match(payload, pattern)
+    if numChars == nil or tonumber(numChars) == nil then return false end
+
+    if text ~= state.text then setTypeText(state, text) end
+    state.numChars = math.floor(tonumber(numChars))
+    state.cursorVisible = cursorVisible == "1"
+    state.cursorCharacter = cursorCharacter
+    state.requested = nil
+    return true
+end
+
+function releaseTypeStates()
+    for _, state in pairs(typeStates) do
+        if state.data then obs.obs_data_release(state.data) end
+    end
+    typeStates = {}
+end
+
+-- How long the plugin has to answer ResponseCodeRequestTypeState before it is taken to be
+-- one from before TypeSetState, which only answers the requests for one field at a time
+local typeStateRequestTimeoutNs = 1000000000
+
+-- The old request path: ask for the first field still missing, one per step
+local function requestTypeField(client, state)
+    if state.text == nil then
+        print("Requesting text to print")
+        clientSend(client, ".", ResponseCodeRequestTypeText)
+    elseif state.numChars == nil then
+        print("Requesting number of characters to print")
+        clientSend(client, ".", ResponseCodeRequestTypeNumChars)
+    elseif state.cursorVisible == nil then
+        print("Requesting cursor visibility")
+        clientSend(client, ".", ResponseCodeRequestTypeCursorVisible)
+    else
+        print("Requesting cursor character")
+        clientSend(client, ".", ResponseCodeRequestTypeCursorChar)
+    end
+end
+
+local function typeText(client, sceneName, sourceName)
+
+    local state = typeState(sceneName, sourceName)
+
+    -- The plugin sends the whole state when it connects and whenever its settings change, so this
+    -- is only a target driven before its state arrived. Asked once, not on every step, unless
+    -- the plugin does not answer.
+    if state.text == nil or state.numChars == nil or state.cursorVisible == nil or state.cursorCharacter == nil then
+        if state.requested == nil then
+            print("Requesting type text state")
+            clientSend(client, ".", ResponseCodeRequestTypeState)
+            state.requested = obs.os_gettime_ns()
+        elseif obs.os_gettime_ns() - state.requested > typeStateRequestTimeoutNs then
+            requestTypeField(client, state)
+        end
+        return
+    end
+
+    local numChars = math.max(0, math.min(state.numChars, #state.offsets))
+    local cursor = ""
+    if state.cursorVisible then cursor = state.cursorCharacter end
+
+    -- Automation repeats the same length many times between characters
+    if numChars == state.shownChars and cursor == state.shownCursor then return end
+
+    local source = findSource(client, sceneName, sourceName)
+    if source == nil then return end
+
+    local subText = ""
+    if numChars > 0 then subText = string.sub(state.text, 1, state.offsets[numChars]) end
+
+    if state.data == nil then state.data = obs.obs_data_create() end
+    obs.obs_data_set_string(state.data, "text", subText .. cursor)
+    obs.obs_source_update(source, state.data)
+
+    state.shownChars = numChars
+    state.shownCursor = cursor
+
 end
 
 function serverCallback()
@@ -400,7 +1639,9 @@ end
 
 function handleClientMessage(client, messagesString)
 
-    messages = {}
+    local parseStart = obs.os_gettime_ns()
+
+    local messages = {}
 
     for w in string.gmatch(messagesString, "[^" .. CommandDelimiter .. "]+") do
         table.insert(messages, w)
@@ -408,7 +1649,7 @@ function handleClientMessage(client, messagesString)
 
     for _, message in ipairs(messages) do
     -- for message in values(messages) do
-        words = {}
+        local words = {}
 
         for w in string.gmatch(message, "[^" .. CommandChunkDelimiter .. "]+") do
             table.insert(words, w)
@@ -417,11 +1658,23 @@ function handleClientMessage(client, messagesString)
         -- print(message)
 
         local commandID = tonumber(words[1])
+
+        if commandID == Sequenced then
+            client, commandID = unwrapSequenced(client, words)
+        end
+
         local sceneName = words[2]
         local sourceName = words[3]
         local value = tonumber(words[#words])
 
-        if commandID == Heartbeat then
+        local applyStart = obs.os_gettime_ns()
+        stats.parseNs = stats.parseNs + (applyStart - parseStart)
+
+        if commandID == nil then
+
+            -- Sender registration, or a value that arrived after a newer one
+
+        elseif commandID == Heartbeat then
 
             clientSend(client, ".", HeartbeatResponse)
 
@@ -429,6 +1682,34 @@ function handleClientMessage(client, messagesString)
 
             disconnectClient(client)
 
+        elseif commandID == StatsSubscribe then
+
+            if tableIndexOf(statsClients, client) == nil then table.insert(statsClients, client) end
+
+        elseif commandID == CatalogueSubscribe then
+
+            if client then subscribeCatalogue(client) end
+
+        elseif commandID == ValueQuery or commandID == ValueSubscribe then
+
+            if client then requestValue(client, commandID, words) end
+
+        elseif commandID == Relative then
+
+            addRelativeChange(client, words)
+
+        elseif commandID == LFO then
+
+            setLFO(client, words)
+
+        elseif commandID == Values then
+
+            applyValueRecords(client, words[#words])
+
+        elseif commandID == Scheduled then
+
+            scheduleMessage(client, words)
+
         elseif commandID == PositionProportionateX then
 
             setProportionatePositions(client, sceneName, sourceName, value, nil)
@@ -447,38 +1728,39 @@ function handleClientMessage(client, messagesString)
 
         elseif commandID == MediaRestart then
 
-            if value ~= 1 then return end
-
-            local source = findSource(client, sceneName, sourceName)
-            if source then
-                obs.obs_source_media_restart(source)
+            -- Only the press (here and for the media commands below); the rest of the batch still runs
+            if value == 1 then
+                local source = findSource(client, sceneName, sourceName)
+                if source then
+                    obs.obs_source_media_restart(source)
+                end
             end
 
         elseif commandID == MediaStop then
 
-            if value ~= 1 then return end
-
-            local source = findSource(client, sceneName, sourceName)
-            if source then
-                obs.obs_source_media_stop(source)
+            if value == 1 then
+                local source = findSource(client, sceneName, sourceName)
+                if source then
+                    obs.obs_source_media_stop(source)
+                end
             end
 
         elseif commandID == MediaPlay then
 
-            if value ~= 1 then return end
-
-            local source = findSource(client, sceneName, sourceName)
-            if source then
-                obs.obs_source_media_play_pause(source, false)
+            if value == 1 then
+                local source = findSource(client, sceneName, sourceName)
+                if source then
+                    obs.obs_source_media_play_pause(source, false)
+                end
             end
 
         elseif commandID == MediaPause then
 
-            if value ~= 1 then return end
-
-            local source = findSource(client, sceneName, sourceName)
-            if source then
-                obs.obs_source_media_play_pause(source, true)
+            if value == 1 then
+                local source = findSource(client, sceneName, sourceName)
+                if source then
+                    obs.obs_source_media_play_pause(source, true)
+                end
             end
 
         elseif commandID == MediaCursor then
@@ -524,35 +1806,61 @@ function handleClientMessage(client, messagesString)
 
         elseif commandID == TypeText then
 
-            local text = words[#words]
-            typeTextDict[typeDictionaryKey(sceneName, sourceName)] = text
+            setTypeText(typeState(sceneName, sourceName), words[#words])
             typeText(client, sceneName, sourceName)
 
+        elseif commandID == TypeSetState then
+
+            if setTypeState(typeState(sceneName, sourceName), words[#words]) then
+                typeText(client, sceneName, sourceName)
+            else
+                printAndSend(client, "Malformed type text state for source named '" .. sourceName .. "'", ResponseCodeError)
+            end
+
         elseif commandID == TypeSetNumChars then
 
-            typeNumCharsDict[typeDictionaryKey(sceneName, sourceName)] = math.floor(value)
+            typeState(sceneName, sourceName).numChars = math.floor(value)
             typeText(client, sceneName, sourceName)
 
         elseif commandID == TypeSetCursorCharacter then
 
-            local text = words[#words]
-            local key = typeDictionaryKey(sceneName, sourceName)
-            cursorCharacterDict[key] = text
+            typeState(sceneName, sourceName).cursorCharacter = words[#words]
             typeText(client, sceneName, sourceName)
 
         elseif commandID == TypeSetCursorVisible then
 
-            local visible = "no"
-            if value == 1 then visible = "yes" end
-            cursorCharacterVisibleDict[typeDictionaryKey(sceneName, sourceName)] = visible -- visible
+            typeState(sceneName, sourceName).cursorVisible = value == 1
             typeText(client, sceneName, sourceName)
 
         elseif commandID == CropTop or commandID == CropBottom or commandID == CropLeft or commandID == CropRight then
 
             crop(client, sceneName, sourceName, commandID, value)
 
+        elseif commandID == Rotation or commandID == BoundsWidth or commandID == BoundsHeight then
+
+            setTransform(client, sceneName, sourceName, { [commandID] = value })
+
+        elseif commandID == Transform then
+
+            local fields = transformFields(words[#words])
+            setTransform(client, sceneName, sourceName, fields)
+            if client and valueSubscriptions[client] then
+                for command in pairs(fields) do valueApplied(client, command, sceneName, sourceName, nil) end
+            end
+
         else
             printAndSend(client, "Unknown command ID (" .. commandID .. ")", ResponseCodeError)
         end
+
+        parseStart = obs.os_gettime_ns()
+
+        if commandID ~= nil and commandID ~= Heartbeat and commandID ~= Disconnect and commandID ~= StatsSubscribe
+            and commandID ~= CatalogueSubscribe and commandID ~= ValueQuery and commandID ~= ValueSubscribe
+            and commandID ~= Relative and commandID ~= LFO and commandID ~= Values and commandID ~= Scheduled then
+            local filterName = nil
+            if #words > 4 then filterName = words[4] end
+            recordApply(commandID, sceneName, sourceName, filterName, words[#words], parseStart - applyStart)
+            if client and valueSubscriptions[client] then valueApplied(client, commandID, sceneName, sourceName, filterName) end
+        end
     end
 end
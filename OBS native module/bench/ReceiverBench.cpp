@@ -0,0 +1,300 @@
+//
+//  ReceiverBench.cpp
+//  Obvious native receiver
+//
+//  Measures the receiver against the stub libobs:
+//    parse     - decoding commands
+//    dispatch  - decoding and applying them to the stub scene graph
+//    loopback  - TCP client -> socket thread -> queue -> tick -> apply
+//    shared    - plugin-side writer -> shared-memory ring -> tick -> apply
+//    latency   - one command at a time over each path, write to applied
+//
+//  Usage: obvious-receiver-bench [messages] [sources]
+//
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ObviousDispatcher.h"
+#include "ObviousProtocol.h"
+#include "ObviousServer.h"
+#include "ObviousSharedRingFormat.h"
+#include "obs-stub.h"
+
+using Clock = std::chrono::steady_clock;
+
+static std::string encode(int command, const std::string& scene, const std::string& source, const std::string& filter, double value)
+{
+    std::string s = std::to_string(command) + obvious::CommandChunkDelimiter + scene + obvious::CommandChunkDelimiter + source + obvious::CommandChunkDelimiter;
+    if (!filter.empty()) s += filter + obvious::CommandChunkDelimiter;
+    return s + std::to_string(value);
+}
+
+// A mix resembling a busy show: mostly transforms, some filters and crops.
+static std::vector<std::string> makeMessages(int count, int numSources)
+{
+    static const int sourceCommands[] = { obvious::PositionProportionateX, obvious::PositionProportionateY, obvious::ScaleX, obvious::ScaleY, obvious::CropLeft, obvious::CropTop };
+    static const int filterCommands[] = { obvious::Opacity, obvious::Hue };
+
+    std::vector<std::string> messages;
+    messages.reserve((size_t)count);
+    for (int i = 0; i < count; ++i) {
+        const std::string source = "source" + std::to_string(i % numSources);
+        const double value = (i % 1000) / 1000.0;
+        if (i % 4 == 3) messages.push_back(encode(filterCommands[i % 2], "Scene", source, "Filter", value));
+        else messages.push_back(encode(sourceCommands[i % 6], "Scene", source, "", value));
+    }
+    return messages;
+}
+
+static void buildScene(int numSources)
+{
+    obsstub::reset();
+    obsstub::setLogEnabled(false);
+    for (int i = 0; i < numSources; ++i) {
+        const std::string source = "source" + std::to_string(i);
+        obsstub::addSceneItem("Scene", source);
+        obsstub::addFilter(source, "Filter");
+    }
+}
+
+static void report(const char* name, int count, Clock::duration elapsed)
+{
+    const double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    std::printf("%-10s %10d msgs %10.1f ns/msg %12.0f msgs/s\n", name, count, ns / count, count / (ns * 1e-9));
+}
+
+static void benchParse(const std::vector<std::string>& messages)
+{
+    obvious::Message message;
+    const auto start = Clock::now();
+    for (const std::string& text : messages) obvious::parseMessage(text, message);
+    report("parse", (int)messages.size(), Clock::now() - start);
+}
+
+static void benchDispatch(const std::vector<std::string>& messages, int numSources)
+{
+    buildScene(numSources);
+    int responses = 0;
+    obvious::Dispatcher dispatcher([&responses](int, int, const std::string&) { ++responses; });
+    obvious::Message message;
+
+    const auto start = Clock::now();
+    for (const std::string& text : messages) {
+        obvious::parseMessage(text, message);
+        dispatcher.apply(0, message);
+    }
+    report("dispatch", (int)messages.size(), Clock::now() - start);
+
+    if (responses > 0) std::printf("           %d error responses\n", responses);
+}
+
+static void benchLoopback(const std::vector<std::string>& messages, int numSources)
+{
+    buildScene(numSources);
+
+    obvious::Server server;
+    if (!server.start(0)) {
+        std::printf("loopback   could not start server\n");
+        return;
+    }
+    obvious::Dispatcher dispatcher([&server](int clientID, int code, const std::string& text) { server.respond(clientID, code, text); });
+
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons((uint16_t)server.boundPort());
+    if (::connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+        std::printf("loopback   could not connect\n");
+        ::close(fd);
+        return;
+    }
+    int yes = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+
+    std::string stream;
+    for (const std::string& text : messages) stream += text + obvious::CommandDelimiter;
+
+    const auto start = Clock::now();
+    std::thread writer([fd, &stream] {
+        size_t written = 0;
+        while (written < stream.size()) {
+            const ssize_t n = ::send(fd, stream.data() + written, stream.size() - written, 0);
+            if (n <= 0) break;
+            written += (size_t)n;
+        }
+    });
+
+    size_t applied = 0;
+    const size_t expected = messages.size();
+    while (applied < expected && Clock::now() - start < std::chrono::seconds(30)) {
+        applied += server.drain([&dispatcher](int clientID, const obvious::Message& message) { dispatcher.apply(clientID, message); });
+        std::this_thread::yield();
+    }
+    const auto elapsed = Clock::now() - start;
+
+    writer.join();
+    ::close(fd);
+    server.stop();
+
+    report("loopback", (int)applied, elapsed);
+    if (server.inboundQueueStalls() > 0) std::printf("           %llu queue-full stalls\n", (unsigned long long)server.inboundQueueStalls());
+}
+
+// Maps the ring the server created, the way ObviousSharedRing does in the plugin
+struct RingWriter {
+    ObviousSharedRingFormat::Header* header = nullptr;
+    size_t size = 0;
+
+    explicit RingWriter(int port)
+    {
+        const int fd = shm_open(ObviousSharedRingFormat::segmentName(port).c_str(), O_RDWR, 0);
+        if (fd < 0) return;
+        struct stat info;
+        if (fstat(fd, &info) == 0) {
+            size = (size_t)info.st_size;
+            void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (data != MAP_FAILED) header = static_cast<ObviousSharedRingFormat::Header*>(data);
+        }
+        ::close(fd);
+    }
+
+    ~RingWriter()
+    {
+        if (header != nullptr) munmap(static_cast<void*>(header), size);
+    }
+
+    bool write(const std::string& text)
+    {
+        return ObviousSharedRingFormat::tryWrite(header, reinterpret_cast<ObviousSharedRingFormat::Record*>(header + 1), 1, text.data(), text.size());
+    }
+};
+
+static void benchShared(const std::vector<std::string>& messages, int numSources)
+{
+    buildScene(numSources);
+
+    obvious::Server server;
+    if (!server.start(0) || !server.isUsingSharedRing()) {
+        std::printf("shared     could not create the shared ring\n");
+        return;
+    }
+    obvious::Dispatcher dispatcher([&server](int clientID, int code, const std::string& text) { server.respond(clientID, code, text); });
+
+    RingWriter ring(server.boundPort());
+    if (ring.header == nullptr) {
+        std::printf("shared     could not map the shared ring\n");
+        return;
+    }
+
+    uint64_t fullRetries = 0;
+    const auto start = Clock::now();
+    std::thread writer([&ring, &messages, &fullRetries] {
+        for (const std::string& text : messages) {
+            while (!ring.write(text)) {
+                ++fullRetries;
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    size_t applied = 0;
+    const size_t expected = messages.size();
+    while (applied < expected && Clock::now() - start < std::chrono::seconds(30)) {
+        applied += server.drain([&dispatcher](int clientID, const obvious::Message& message) { dispatcher.apply(clientID, message); });
+        std::this_thread::yield();
+    }
+    const auto elapsed = Clock::now() - start;
+
+    writer.join();
+    server.stop();
+
+    report("shared", (int)applied, elapsed);
+    if (fullRetries > 0) std::printf("           %llu ring-full retries\n", (unsigned long long)fullRetries);
+}
+
+static void reportLatency(const char* name, std::vector<double>& microseconds)
+{
+    if (microseconds.empty()) return;
+    std::sort(microseconds.begin(), microseconds.end());
+    auto at = [&microseconds](double fraction) { return microseconds[(size_t)(fraction * (double)(microseconds.size() - 1))]; };
+    std::printf("%-10s %10d msgs  p50 %8.1f us  p99 %8.1f us  max %8.1f us\n", name, (int)microseconds.size(), at(0.5), at(0.99), microseconds.back());
+}
+
+// Round trip of a single command, written and then drained as the tick thread would, one at a time
+static void benchLatency(const std::vector<std::string>& messages, int numSources)
+{
+    const size_t rounds = std::min<size_t>(messages.size(), 20000);
+
+    buildScene(numSources);
+    obvious::Server server;
+    if (!server.start(0)) return;
+    obvious::Dispatcher dispatcher([&server](int clientID, int code, const std::string& text) { server.respond(clientID, code, text); });
+    auto apply = [&dispatcher](int clientID, const obvious::Message& message) { dispatcher.apply(clientID, message); };
+
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons((uint16_t)server.boundPort());
+    int yes = 1;
+    if (::connect(fd, (sockaddr*)&address, sizeof(address)) == 0) {
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+
+        std::vector<double> tcp;
+        for (size_t i = 0; i < rounds; ++i) {
+            const std::string text = messages[i] + obvious::CommandDelimiter;
+            const auto start = Clock::now();
+            if (::send(fd, text.data(), text.size(), 0) != (ssize_t)text.size()) break;
+            while (server.drain(apply) == 0 && Clock::now() - start < std::chrono::seconds(1)) {}
+            tcp.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        }
+        reportLatency("lat-tcp", tcp);
+    }
+    ::close(fd);
+
+    RingWriter ring(server.boundPort());
+    if (ring.header != nullptr) {
+        std::vector<double> shared;
+        for (size_t i = 0; i < rounds; ++i) {
+            const auto start = Clock::now();
+            if (!ring.write(messages[i])) break;
+            while (server.drain(apply) == 0 && Clock::now() - start < std::chrono::seconds(1)) {}
+            shared.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        }
+        reportLatency("lat-shared", shared);
+    }
+
+    server.stop();
+}
+
+int main(int argc, char* argv[])
+{
+    const int count = argc > 1 ? std::atoi(argv[1]) : 200000;
+    const int numSources = argc > 2 ? std::atoi(argv[2]) : 32;
+
+    const std::vector<std::string> messages = makeMessages(count, numSources);
+
+    benchParse(messages);
+    benchDispatch(messages, numSources);
+    benchLoopback(messages, numSources);
+    benchShared(messages, numSources);
+    benchLatency(messages, numSources);
+
+    return 0;
+}
@@ -0,0 +1,352 @@
+//
+//  ObviousDispatcher.cpp
+//  Obvious native receiver
+//
+
+#include "ObviousDispatcher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace obvious {
+
+namespace {
+
+// How long the plugin has to answer ResponseCodeRequestTypeState, as typeStateRequestTimeoutNs in Obvious.lua
+constexpr auto typeStateRequestTimeout = std::chrono::seconds(1);
+
+// Byte offset of the end of each UTF-8 character, as characterOffsets() in Obvious.lua: a lead byte and its continuation bytes
+void characterOffsets(const std::string& text, std::vector<size_t>& offsets)
+{
+    offsets.clear();
+    for (size_t i = 0; i < text.size();) {
+        ++i;
+        while (i < text.size() && ((unsigned char)text[i] & 0xC0) == 0x80) ++i;
+        offsets.push_back(i);
+    }
+}
+
+} // namespace
+
+Dispatcher::Dispatcher(Responder responder) : respond(std::move(responder))
+{
+}
+
+void Dispatcher::printAndSend(int clientID, const std::string& text, int responseCode)
+{
+    blog(LOG_WARNING, "[Obvious] Error code %d: %s", responseCode, text.c_str());
+    respond(clientID, responseCode, text);
+}
+
+// Once per client and command, as automation repeats the command every block
+void Dispatcher::reportUnsupported(int clientID, int commandID, const char* name)
+{
+    if (!unsupportedReported.insert({ clientID, commandID }).second) return;
+    printAndSend(clientID, std::string("The native receiver does not support ") + name + " (" + std::to_string(commandID) + "); use Obvious.lua for it", ResponseCodeError);
+}
+
+obs_sceneitem_t* Dispatcher::findSceneItem(int clientID, const Message& message)
+{
+    obs_source_t* sceneSource = obs_get_source_by_name(message.scene.c_str());
+    if (sceneSource) {
+
+        obs_scene_t* scene = obs_scene_from_source(sceneSource);
+        obs_sceneitem_t* sceneItem = scene ? obs_scene_find_source_recursive(scene, message.source.c_str()) : nullptr;
+
+        obs_source_release(sceneSource);
+
+        if (sceneItem) {
+            return sceneItem;
+        }
+        printAndSend(clientID, "Could not find source named '" + message.source + "' in scene named '" + message.scene + "'", ResponseCodeError);
+    }
+    else {
+        printAndSend(clientID, "Could not find scene named '" + message.scene + "'", ResponseCodeError);
+    }
+
+    return nullptr;
+}
+
+obs_source_t* Dispatcher::findSource(int clientID, const Message& message)
+{
+    obs_sceneitem_t* sceneItem = findSceneItem(clientID, message);
+    return sceneItem ? obs_sceneitem_get_source(sceneItem) : nullptr;
+}
+
+void Dispatcher::setScale(int clientID, const Message& message, const double* scaleX, const double* scaleY)
+{
+    obs_sceneitem_t* sceneItem = findSceneItem(clientID, message);
+    if (sceneItem) {
+        struct vec2 scale;
+        obs_sceneitem_get_scale(sceneItem, &scale);
+        if (scaleX) scale.x = (float)*scaleX;
+        if (scaleY) scale.y = (float)*scaleY;
+        obs_sceneitem_set_scale(sceneItem, &scale);
+    }
+}
+
+void Dispatcher::setProportionatePositions(int clientID, const Message& message, const double* xProportion, const double* yProportion)
+{
+    obs_sceneitem_t* sceneItem = findSceneItem(clientID, message);
+    obs_source_t* source = sceneItem ? obs_sceneitem_get_source(sceneItem) : nullptr;
+    if (source) {
+        struct vec2 position;
+        obs_sceneitem_get_pos(sceneItem, &position);
+        if (xProportion) position.x = (float)(obs_source_get_width(source) * *xProportion);
+        if (yProportion) position.y = (float)(obs_source_get_height(source) * *yProportion);
+        obs_sceneitem_set_pos(sceneItem, &position);
+    }
+}
+
+void Dispatcher::setFilterValue(int clientID, const Message& message, const char* filterParameterName)
+{
+    obs_source_t* source = findSource(clientID, message);
+    if (!source) return;
+
+    obs_source_t* filter = obs_source_get_filter_by_name(source, message.filter.c_str());
+    if (filter) {
+        obs_data_t* filterSettings = obs_source_get_settings(filter);
+        if (filterSettings) {
+            obs_data_set_double(filterSettings, filterParameterName, message.value);
+            obs_source_update(filter, filterSettings);
+            obs_data_release(filterSettings);
+        }
+        else {
+            printAndSend(clientID, "Could not get settings for filter named '" + message.filter + "' on source named '" + message.source + "' in scene named '" + message.scene + "'", ResponseCodeError);
+        }
+        obs_source_release(filter);
+    }
+    else {
+        printAndSend(clientID, "No filter named '" + message.filter + "' was found on source named '" + message.source + "' in scene named '" + message.scene + "'", ResponseCodeError);
+    }
+}
+
+void Dispatcher::crop(int clientID, const Message& message)
+{
+    obs_sceneitem_t* sceneItem = findSceneItem(clientID, message);
+    if (sceneItem) {
+        struct obs_sceneitem_crop crop;
+        obs_sceneitem_get_crop(sceneItem, &crop);
+        const int value = (int)message.value;
+        switch (message.commandID) {
+            case CropTop:    crop.top = value;    break;
+            case CropBottom: crop.bottom = value; break;
+            case CropLeft:   crop.left = value;   break;
+            case CropRight:  crop.right = value;  break;
+            default: break;
+        }
+        obs_sceneitem_set_crop(sceneItem, &crop);
+    }
+}
+
+Dispatcher::TypeTextState& Dispatcher::typeTextState(const Message& message)
+{
+    // same key as typeState() in Obvious.lua
+    return typeTextStates[message.scene + CommandChunkDelimiter + message.source];
+}
+
+// "numChars<GS>cursorVisible<GS>cursorCharacter<GS>text", as setTypeState() in Obvious.lua
+bool Dispatcher::setTypeState(TypeTextState& state, const std::string& payload)
+{
+    const size_t visibleStart = payload.find(TypeStateFieldDelimiter);
+    if (visibleStart == std::string::npos) return false;
+    const size_t cursorStart = payload.find(TypeStateFieldDelimiter, visibleStart + 1);
+    if (cursorStart == std::string::npos) return false;
+    const size_t textStart = payload.find(TypeStateFieldDelimiter, cursorStart + 1);
+    if (textStart == std::string::npos) return false;
+
+    char* end = nullptr;
+    const double numChars = std::strtod(payload.c_str(), &end);
+    if (end == payload.c_str()) return false;
+
+    state.numChars = (int)std::floor(numChars);
+    state.cursorVisible = payload.compare(visibleStart + 1, cursorStart - visibleStart - 1, "1") == 0;
+    state.cursorCharacter = payload.substr(cursorStart + 1, textStart - cursorStart - 1);
+    state.text = payload.substr(textStart + 1);
+    characterOffsets(state.text, state.offsets);
+    state.hasNumChars = state.hasCursorVisible = state.hasCursorCharacter = state.hasText = true;
+    state.requested = false;
+    return true;
+}
+
+// As requestTypeField() in Obvious.lua: the first field still missing, one per step
+void Dispatcher::requestTypeField(int clientID, const TypeTextState& state)
+{
+    if (!state.hasText) respond(clientID, ResponseCodeRequestTypeText, ".");
+    else if (!state.hasNumChars) respond(clientID, ResponseCodeRequestTypeNumChars, ".");
+    else if (!state.hasCursorVisible) respond(clientID, ResponseCodeRequestTypeCursorVisible, ".");
+    else respond(clientID, ResponseCodeRequestTypeCursorChar, ".");
+}
+
+void Dispatcher::typeText(int clientID, const Message& message)
+{
+    obs_source_t* source = findSource(clientID, message);
+    if (!source) return;
+
+    TypeTextState& state = typeTextState(message);
+
+    // The plugin sends TypeSetState on connect and on every change; ask once for a target driven before it arrived,
+    // and fall back to asking field by field if the plugin predates TypeSetState and never answers
+    if (!state.hasText || !state.hasNumChars || !state.hasCursorVisible || !state.hasCursorCharacter) {
+        const auto now = std::chrono::steady_clock::now();
+        if (!state.requested) {
+            respond(clientID, ResponseCodeRequestTypeState, ".");
+            state.requested = true;
+            state.requestedAt = now;
+        }
+        else if (now - state.requestedAt > typeStateRequestTimeout) {
+            requestTypeField(clientID, state);
+        }
+        return;
+    }
+
+    // Counted in characters, so a multi-byte character is never cut
+    const size_t numChars = std::min((size_t)std::max(0, state.numChars), state.offsets.size());
+    std::string subText = state.text.substr(0, numChars > 0 ? state.offsets[numChars - 1] : 0);
+    if (state.cursorVisible) subText += state.cursorCharacter;
+
+    obs_data_t* sourceSettings = obs_source_get_settings(source);
+    if (sourceSettings) {
+        obs_data_set_string(sourceSettings, "text", subText.c_str());
+        obs_source_update(source, sourceSettings);
+        obs_data_release(sourceSettings);
+    }
+    else {
+        printAndSend(clientID, "Could not get settings for text source named '" + message.source + "' in scene named '" + message.scene + "'", ResponseCodeError);
+    }
+}
+
+void Dispatcher::apply(int clientID, const Message& message)
+{
+    const double value = message.value;
+
+    switch (message.commandID) {
+
+        case PositionProportionateX:
+            setProportionatePositions(clientID, message, &value, nullptr);
+            break;
+
+        case PositionProportionateY:
+            setProportionatePositions(clientID, message, nullptr, &value);
+            break;
+
+        case ScaleX:
+            setScale(clientID, message, &value, nullptr);
+            break;
+
+        case ScaleY:
+            setScale(clientID, message, nullptr, &value);
+            break;
+
+        case MediaRestart:
+        case MediaStop:
+        case MediaPlay:
+        case MediaPause: {
+            if (value != 1) break;
+            obs_source_t* source = findSource(clientID, message);
+            if (!source) break;
+            if (message.commandID == MediaRestart) obs_source_media_restart(source);
+            else if (message.commandID == MediaStop) obs_source_media_stop(source);
+            else obs_source_media_play_pause(source, message.commandID == MediaPause);
+            break;
+        }
+
+        case MediaCursor: {
+            obs_source_t* source = findSource(clientID, message);
+            if (source) obs_source_media_set_time(source, (int64_t)value);
+            break;
+        }
+
+        case Hue:
+            setFilterValue(clientID, message, "hue_shift");
+            break;
+
+        case Saturation:
+            setFilterValue(clientID, message, "saturation");
+            break;
+
+        case RollSpeedH:
+            setFilterValue(clientID, message, "speed_x");
+            break;
+
+        case RollSpeedV:
+            setFilterValue(clientID, message, "speed_y");
+            break;
+
+        case Opacity:
+            setFilterValue(clientID, message, "opacity");
+            break;
+
+        case SetVisible: {
+            obs_sceneitem_t* sceneItem = findSceneItem(clientID, message);
+            if (sceneItem) obs_sceneitem_set_visible(sceneItem, value == 1);
+            break;
+        }
+
+        case TypeText: {
+            TypeTextState& state = typeTextState(message);
+            state.text = message.lastChunk;
+            characterOffsets(state.text, state.offsets);
+            state.hasText = true;
+            typeText(clientID, message);
+            break;
+        }
+
+        case TypeSetState: {
+            if (setTypeState(typeTextState(message), message.lastChunk)) {
+                typeText(clientID, message);
+            }
+            else {
+                printAndSend(clientID, "Malformed type text state for source named '" + message.source + "'", ResponseCodeError);
+            }
+            break;
+        }
+
+        case TypeSetNumChars: {
+            TypeTextState& state = typeTextState(message);
+            state.numChars = (int)std::floor(value);
+            state.hasNumChars = true;
+            typeText(clientID, message);
+            break;
+        }
+
+        case TypeSetCursorCharacter: {
+            TypeTextState& state = typeTextState(message);
+            state.cursorCharacter = message.lastChunk;
+            state.hasCursorCharacter = true;
+            typeText(clientID, message);
+            break;
+        }
+
+        case TypeSetCursorVisible: {
+            TypeTextState& state = typeTextState(message);
+            state.cursorVisible = value == 1;
+            state.hasCursorVisible = true;
+            typeText(clientID, message);
+            break;
+        }
+
+        case CropTop:
+        case CropBottom:
+        case CropLeft:
+        case CropRight:
+            crop(clientID, message);
+            break;
+
+        case StatsSubscribe:
+            if (std::find(statsClients.begin(), statsClients.end(), clientID) == statsClients.end()) statsClients.push_back(clientID);
+            break;
+
+        default:
+            if (const char* name = unsupportedCommandName(message.commandID)) {
+                reportUnsupported(clientID, message.commandID, name);
+            }
+            else {
+                printAndSend(clientID, "Unknown command ID (" + std::to_string(message.commandID) + ")", ResponseCodeError);
+            }
+            break;
+    }
+}
+
+} // namespace obvious
@@ -0,0 +1,79 @@
+//
+//  ObviousDispatcher.h
+//  Obvious native receiver
+//
+//  Applies decoded commands to OBS. Mirrors handleClientMessage() in
+//  Obvious.lua and must only be used from the OBS tick thread.
+//
+
+#ifndef ObviousDispatcher_h
+#define ObviousDispatcher_h
+
+#include <chrono>
+#include <functional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <obs.h>
+
+#include "ObviousProtocol.h"
+
+namespace obvious {
+
+class Dispatcher
+{
+public:
+    // Called for every response that has to go back to the sending client.
+    using Responder = std::function<void(int clientID, int responseCode, const std::string& text)>;
+
+    explicit Dispatcher(Responder responder);
+
+    void apply(int clientID, const Message& message);
+
+    // Clients that sent StatsSubscribe
+    const std::vector<int>& statsSubscribers() const { return statsClients; }
+
+private:
+    Responder respond;
+    std::vector<int> statsClients;
+    std::set<std::pair<int, int>> unsupportedReported;    // (clientID, commandID)
+
+    void printAndSend(int clientID, const std::string& text, int responseCode);
+    void reportUnsupported(int clientID, int commandID, const char* name);
+
+    obs_sceneitem_t* findSceneItem(int clientID, const Message& message);
+    obs_source_t* findSource(int clientID, const Message& message);
+
+    void setScale(int clientID, const Message& message, const double* scaleX, const double* scaleY);
+    void setProportionatePositions(int clientID, const Message& message, const double* xProportion, const double* yProportion);
+    void setFilterValue(int clientID, const Message& message, const char* filterParameterName);
+    void crop(int clientID, const Message& message);
+    void typeText(int clientID, const Message& message);
+
+    struct TypeTextState {
+        std::string text;
+        std::vector<size_t> offsets;    // byte offset of the end of each character in text
+        bool hasText = false;
+        int numChars = 0;
+        bool hasNumChars = false;
+        std::string cursorCharacter;
+        bool hasCursorCharacter = false;
+        bool cursorVisible = false;
+        bool hasCursorVisible = false;
+        bool requested = false;     // ResponseCodeRequestTypeState sent; not sent again
+        std::chrono::steady_clock::time_point requestedAt;
+    };
+
+    std::unordered_map<std::string, TypeTextState> typeTextStates;
+
+    TypeTextState& typeTextState(const Message& message);
+    void requestTypeField(int clientID, const TypeTextState& state);
+    static bool setTypeState(TypeTextState& state, const std::string& payload);
+};
+
+} // namespace obvious
+
+#endif /* ObviousDispatcher_h */
@@ -0,0 +1,120 @@
+//
+//  ObviousModule.cpp
+//  Obvious native receiver
+//
+//  libobs module entry points. Replaces Obvious.lua: load either this
+//  module or the script, not both, as they listen on the same port.
+//
+//  The port is read from obvious-receiver/config.json in the OBS plugin
+//  config folder, e.g. { "Port": 11111 }.
+//
+
+#include <obs-module.h>
+
+#include <chrono>
+#include <memory>
+
+#include "ObviousDispatcher.h"
+#include "ObviousReceiverStats.h"
+#include "ObviousServer.h"
+
+OBS_DECLARE_MODULE()
+
+namespace {
+
+constexpr int DefaultPort = 11111;
+constexpr double StatsIntervalSeconds = 1.0;
+
+using Clock = std::chrono::steady_clock;
+
+struct Receiver {
+    obvious::Server server;
+    obvious::Dispatcher dispatcher { [this](int clientID, int responseCode, const std::string& text) {
+        server.respond(clientID, responseCode, text);
+    } };
+    obvious::ReceiverStats stats;
+    Clock::time_point statsStart = Clock::now();
+    uint64_t staleReported = 0;
+};
+
+uint64_t nanosecondsSince(Clock::time_point start)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+std::unique_ptr<Receiver> receiver;
+
+int configuredPort()
+{
+    int port = DefaultPort;
+
+    char* path = obs_module_config_path("config.json");
+    if (path) {
+        obs_data_t* config = obs_data_create_from_json_file_safe(path, "bak");
+        if (config) {
+            obs_data_set_default_int(config, "Port", DefaultPort);
+            port = (int)obs_data_get_int(config, "Port");
+            obs_data_release(config);
+        }
+        bfree(path);
+    }
+
+    return port;
+}
+
+void tick(void* param, float seconds)
+{
+    (void)seconds;
+    Receiver* r = static_cast<Receiver*>(param);
+
+    const Clock::time_point tickStart = Clock::now();
+    const size_t messages = r->server.drain([r](int clientID, const obvious::Message& message) {
+        const Clock::time_point applyStart = Clock::now();
+        r->dispatcher.apply(clientID, message);
+        r->stats.applied(message, nanosecondsSince(applyStart));
+    });
+    r->stats.tickFinished(messages, nanosecondsSince(tickStart));
+
+    const double elapsed = (double)nanosecondsSince(r->statsStart) / 1.0e9;
+    if (elapsed >= StatsIntervalSeconds) {
+        const uint64_t stale = r->server.staleDropped();
+        const std::string report = r->stats.report(elapsed, obs_get_active_fps(), r->server.inboundBacklog(), stale - r->staleReported);
+        r->staleReported = stale;
+        for (int clientID : r->dispatcher.statsSubscribers()) {
+            r->server.respond(clientID, obvious::ResponseCodeStats, report);
+        }
+        r->statsStart = Clock::now();
+    }
+}
+
+} // namespace
+
+MODULE_EXPORT const char* obs_module_description(void)
+{
+    return "Receiver for Obvious, VST controller for OBS";
+}
+
+bool obs_module_load(void)
+{
+    receiver = std::make_unique<Receiver>();
+
+    const int port = configuredPort();
+    if (!receiver->server.start(port)) {
+        blog(LOG_ERROR, "[Obvious] Could not listen on port %d", port);
+        receiver.reset();
+        return false;
+    }
+
+    obs_add_tick_callback(tick, receiver.get());
+    blog(LOG_INFO, "[Obvious] Listening on port %d", receiver->server.boundPort());
+    return true;
+}
+
+void obs_module_unload(void)
+{
+    if (!receiver) return;
+
+    obs_remove_tick_callback(tick, receiver.get());
+    receiver->server.stop();
+    receiver.reset();
+}
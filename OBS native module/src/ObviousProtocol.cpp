@@ -0,0 +1,118 @@
+//
+//  ObviousProtocol.cpp
+//  Obvious native receiver
+//
+
+#include "ObviousProtocol.h"
+
+#include <cstdlib>
+
+namespace obvious {
+
+void splitNonEmpty(std::string_view input, char delimiter, std::vector<std::string_view>& out)
+{
+    out.clear();
+    size_t start = 0;
+    for (size_t i = 0; i <= input.size(); ++i) {
+        if (i == input.size() || input[i] == delimiter) {
+            if (i > start) out.push_back(input.substr(start, i - start));
+            start = i + 1;
+        }
+    }
+}
+
+// tonumber() equivalent for the value chunk; std::from_chars for doubles is
+// still missing from some of the toolchains OBS is built with.
+static bool toNumber(std::string_view chunk, double& out)
+{
+    if (chunk.empty() || chunk.size() > 63) return false;
+    char buffer[64];
+    chunk.copy(buffer, chunk.size());
+    buffer[chunk.size()] = '\0';
+    char* end = nullptr;
+    out = std::strtod(buffer, &end);
+    return end == buffer + chunk.size();
+}
+
+bool parseMessage(std::string_view message, Message& out)
+{
+    thread_local std::vector<std::string_view> words;
+    splitNonEmpty(message, CommandChunkDelimiter, words);
+    if (words.empty()) return false;
+
+    double commandID;
+    if (!toNumber(words[0], commandID)) return false;
+
+    out.commandID = (int)commandID;
+    out.scene.assign(words.size() > 1 ? words[1] : std::string_view());
+    out.source.assign(words.size() > 2 ? words[2] : std::string_view());
+    out.filter.assign(words.size() > 3 ? words[3] : std::string_view());
+    out.lastChunk.assign(words.back());
+    out.hasValue = toNumber(words.back(), out.value);
+    if (!out.hasValue) out.value = 0.0;
+
+    return true;
+}
+
+static bool toUnsigned(std::string_view chunk, uint64_t& out)
+{
+    if (chunk.empty() || chunk.size() > 20) return false;
+    char buffer[24];
+    chunk.copy(buffer, chunk.size());
+    buffer[chunk.size()] = '\0';
+    char* end = nullptr;
+    out = std::strtoull(buffer, &end, 10);
+    return end == buffer + chunk.size();
+}
+
+bool parseSequenced(std::string_view message, uint32_t& sender, uint64_t& sequence, std::string_view& inner)
+{
+    const size_t senderStart = message.find(CommandChunkDelimiter);
+    if (senderStart == std::string_view::npos) return false;
+
+    std::string_view rest = message.substr(senderStart + 1);
+    const size_t senderEnd = rest.find(CommandChunkDelimiter);
+
+    uint64_t senderValue;
+    if (!toUnsigned(rest.substr(0, senderEnd), senderValue)) return false;
+    sender = (uint32_t)senderValue;
+
+    if (senderEnd == std::string_view::npos) {
+        sequence = 0;
+        inner = std::string_view();
+        return true;
+    }
+
+    rest = rest.substr(senderEnd + 1);
+    const size_t sequenceEnd = rest.find(CommandChunkDelimiter);
+    if (sequenceEnd == std::string_view::npos || !toUnsigned(rest.substr(0, sequenceEnd), sequence)) return false;
+
+    inner = rest.substr(sequenceEnd + 1);
+    return !inner.empty();
+}
+
+const char* unsupportedCommandName(int commandID)
+{
+    switch (commandID) {
+        case Relative:     return "Relative";
+        case Transform:    return "Transform";
+        case Rotation:     return "Rotation";
+        case BoundsWidth:  return "BoundsWidth";
+        case BoundsHeight: return "BoundsHeight";
+        case LFO:          return "LFO";
+        case Values:       return "Values";
+        case Scheduled:    return "Scheduled";
+        default:           return nullptr;
+    }
+}
+
+std::string encodeResponse(int code, std::string_view text)
+{
+    std::string response = std::to_string(code);
+    response += CommandChunkDelimiter;
+    response.append(text);
+    response += CommandDelimiter;
+    return response;
+}
+
+} // namespace obvious
@@ -0,0 +1,147 @@
+//
+//  ObviousProtocol.h
+//  Obvious native receiver
+//
+//  Wire protocol shared with the Obvious plugin and Obvious.lua.
+//  Keep the IDs in step with Source/CommandDefinitions.h and the
+//  constants at the top of Obvious.lua.
+//
+
+#ifndef ObviousProtocol_h
+#define ObviousProtocol_h
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace obvious {
+
+enum Command : int {
+    PositionProportionateX  =    10,
+    PositionProportionateY  =    20,
+                    ScaleX  =    30,
+                    ScaleY  =    40,
+              MediaRestart  =    50,
+                 MediaStop  =    60,
+                 MediaPlay  =    70,
+                MediaPause  =    80,
+               MediaCursor  =    90,
+                       Hue  =   100,
+                Saturation  =   110,
+                RollSpeedH  =   120,
+                RollSpeedV  =   130,
+                   Opacity  =   140,
+                   CropTop  =   150,
+                CropBottom  =   160,
+                  CropLeft  =   170,
+                 CropRight  =   180,
+                SetVisible  =   190,
+                  TypeText  =   200,
+    TypeSetCursorCharacter  =   210,
+      TypeSetCursorVisible  =   220,
+           TypeSetNumChars  =   230,
+                Disconnect  =   240,
+                 Heartbeat  =   250,
+         HeartbeatResponse  =   260,
+            StatsSubscribe  =   270,
+                 Sequenced  =   280,
+        CatalogueSubscribe  =   290,
+                ValueQuery  =   300,
+            ValueSubscribe  =   310,
+              TypeSetState  =   320,
+                  Relative  =   330,
+                 Transform  =   340,
+                  Rotation  =   350,
+               BoundsWidth  =   360,
+              BoundsHeight  =   370,
+                       LFO  =   380,
+                    Values  =   390,
+                 Scheduled  =   400,
+};
+
+enum ResponseCode : int {
+    ResponseCodeError                   = 10,
+    ResponseCodeRequestTypeText         = 20,
+    ResponseCodeRequestTypeCursorChar   = 30,
+    ResponseCodeRequestTypeCursorVisible= 40,
+    ResponseCodeRequestTypeNumChars     = 50,
+    ResponseCodeStats                   = 60,
+    ResponseCodeRequestTypeState        = 120,
+};
+
+constexpr char CommandDelimiter = char(30);
+constexpr char CommandChunkDelimiter = char(31);
+constexpr char TypeStateFieldDelimiter = char(29);
+
+/*
+ One decoded command. The chunk layout matches Obvious.lua, which splits on
+ runs of the chunk delimiter (empty chunks are skipped):
+
+   command, scene, source, [filter,] value-or-text
+ */
+struct Message {
+    int commandID = 0;
+    std::string scene;
+    std::string source;
+    std::string filter;
+    std::string lastChunk;  // text payload for TypeText / TypeSetCursorCharacter
+    double value = 0.0;
+    bool hasValue = false;
+};
+
+// Splits on `delimiter`, skipping empty pieces (Lua's "[^d]+" gmatch).
+void splitNonEmpty(std::string_view input, char delimiter, std::vector<std::string_view>& out);
+
+// Decodes one command (without its trailing CommandDelimiter). Returns false
+// when the command chunk is missing or not a number.
+bool parseMessage(std::string_view message, Message& out);
+
+/*
+ Splits "280<US>sender<US>sequence<US>command..." into its header and the
+ wrapped command. `inner` is left empty for a registration, "280<US>sender",
+ which only ties the sender to the TCP connection it arrived on.
+ */
+bool parseSequenced(std::string_view message, uint32_t& sender, uint64_t& sequence, std::string_view& inner);
+
+/*
+ Name of a command Obvious.lua applies and this receiver does not, or nullptr.
+ CatalogueSubscribe, ValueQuery and ValueSubscribe are not listed: the plugin
+ sends them to find out what the receiver offers and expects the usual
+ "Unknown command ID" reply.
+ */
+const char* unsupportedCommandName(int commandID);
+
+// Builds "<code><US><text><RS>", the response framing used by clientSend().
+std::string encodeResponse(int code, std::string_view text);
+
+/*
+ Reassembles a TCP byte stream into commands. Unlike the Lua receiver, a
+ command split across two reads is kept until its delimiter arrives.
+ */
+class StreamSplitter
+{
+public:
+    template <typename Callback>
+    void feed(const char* data, size_t length, Callback&& onMessage)
+    {
+        pending.append(data, length);
+        size_t start = 0;
+        for (size_t i = 0; i < pending.size(); ++i) {
+            if (pending[i] == CommandDelimiter) {
+                if (i > start) onMessage(std::string_view(pending.data() + start, i - start));
+                start = i + 1;
+            }
+        }
+        pending.erase(0, start);
+    }
+
+    void reset() { pending.clear(); }
+
+private:
+    std::string pending;
+};
+
+} // namespace obvious
+
+#endif /* ObviousProtocol_h */
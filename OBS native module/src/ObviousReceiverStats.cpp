@@ -0,0 +1,65 @@
+//
+//  ObviousReceiverStats.cpp
+//  Obvious native receiver
+//
+
+#include "ObviousReceiverStats.h"
+
+#include <cstdio>
+
+namespace obvious {
+
+void ReceiverStats::applied(const Message& message, uint64_t ns)
+{
+    ++messages;
+    applyNs += ns;
+
+    std::string name = message.scene + "/" + message.source;
+    if (!message.filter.empty()) name += "/" + message.filter;
+
+    Target& target = targets[name];
+    ++target.count;
+    target.ns += ns;
+    if (ns > target.maxNs) target.maxNs = ns;
+}
+
+void ReceiverStats::tickFinished(size_t tickMessages, uint64_t tickNs)
+{
+    ++ticks;
+    if (tickNs > tickMaxNs) tickMaxNs = tickNs;
+    if (tickMessages > maxPerTick) maxPerTick = tickMessages;
+}
+
+std::string ReceiverStats::report(double intervalSeconds, double fps, size_t backlog, uint64_t stale)
+{
+    const std::string* slowTarget = nullptr;
+    double slowAvg = 0.0;
+    uint64_t slowMax = 0;
+
+    for (const auto& entry : targets) {
+        const double avg = (double)entry.second.ns / (double)entry.second.count;
+        if (avg > slowAvg) {
+            slowTarget = &entry.first;
+            slowAvg = avg;
+            slowMax = entry.second.maxNs;
+        }
+    }
+
+    const double frames = intervalSeconds * fps;
+    const double perTick = ticks > 0 ? (double)ticks : 1.0;
+
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer),
+                  "ticks=%llu;receiveUs=0.0;parseUs=0.0;applyUs=%.1f;tickMaxUs=%.1f;messages=%llu;perFrame=%.2f;maxPerTick=%zu;backlog=%zu;stale=%llu;targetAvgUs=%.1f;targetMaxUs=%.1f;slowTarget=",
+                  (unsigned long long)ticks, (double)applyNs / perTick / 1000.0, (double)tickMaxNs / 1000.0,
+                  (unsigned long long)messages, frames > 0.0 ? (double)messages / frames : 0.0, maxPerTick, backlog, (unsigned long long)stale,
+                  slowAvg / 1000.0, (double)slowMax / 1000.0);
+
+    std::string text = buffer;
+    if (slowTarget) text += *slowTarget;
+
+    *this = ReceiverStats();
+    return text;
+}
+
+} // namespace obvious
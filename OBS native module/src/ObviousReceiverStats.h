@@ -0,0 +1,48 @@
+//
+//  ObviousReceiverStats.h
+//  Obvious native receiver
+//
+//  Cost of applying commands on the OBS tick thread, reported to clients
+//  that sent StatsSubscribe in the same "key=value;..." format as
+//  Obvious.lua. Receive and parse run on the socket thread here, so they
+//  are reported as 0; backlog is the inbound queue depth at report time.
+//
+
+#ifndef ObviousReceiverStats_h
+#define ObviousReceiverStats_h
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "ObviousProtocol.h"
+
+namespace obvious {
+
+class ReceiverStats
+{
+public:
+    void applied(const Message& message, uint64_t applyNs);
+    void tickFinished(size_t messages, uint64_t tickNs);
+
+    // Builds the report for the time since the last one and starts a new interval
+    std::string report(double intervalSeconds, double fps, size_t backlog, uint64_t stale);
+
+private:
+    struct Target {
+        uint64_t count = 0;
+        uint64_t ns = 0;
+        uint64_t maxNs = 0;
+    };
+
+    uint64_t ticks = 0;
+    uint64_t applyNs = 0;
+    uint64_t tickMaxNs = 0;
+    uint64_t messages = 0;
+    size_t maxPerTick = 0;
+    std::unordered_map<std::string, Target> targets;
+};
+
+} // namespace obvious
+
+#endif /* ObviousReceiverStats_h */
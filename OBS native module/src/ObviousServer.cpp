@@ -0,0 +1,339 @@
+//
+//  ObviousServer.cpp
+//  Obvious native receiver
+//
+
+#include "ObviousServer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0  // macOS uses SO_NOSIGPIPE instead, set in acceptClients()
+#endif
+
+namespace obvious {
+
+static constexpr int PollIntervalMs = 5;
+static constexpr size_t MaxUnsentBytes = 1 << 20;
+
+Server::Server(size_t queueCapacity) : inbound(queueCapacity), outbound(queueCapacity)
+{
+}
+
+Server::~Server()
+{
+    stop();
+}
+
+bool Server::start(int requestedPort)
+{
+    stop();
+
+    listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0) return false;
+
+    int yes = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons((uint16_t)requestedPort);
+
+    if (::bind(listenFd, (sockaddr*)&address, sizeof(address)) != 0 || ::listen(listenFd, 64) != 0) {
+        ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    socklen_t length = sizeof(address);
+    getsockname(listenFd, (sockaddr*)&address, &length);
+    port = ntohs(address.sin_port);
+
+    fcntl(listenFd, F_SETFL, fcntl(listenFd, F_GETFL) | O_NONBLOCK);
+
+    // Optional: without it values simply keep arriving over TCP
+    datagramFd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (datagramFd >= 0) {
+        address.sin_port = htons((uint16_t)port);
+        if (::bind(datagramFd, (sockaddr*)&address, sizeof(address)) == 0) {
+            fcntl(datagramFd, F_SETFL, fcntl(datagramFd, F_GETFL) | O_NONBLOCK);
+        }
+        else {
+            ::close(datagramFd);
+            datagramFd = -1;
+        }
+    }
+
+    // Optional as well: plugins fall back to TCP when the segment is missing
+    sharedRing.create(port);
+
+    running.store(true, std::memory_order_release);
+    thread = std::thread([this] { run(); });
+    return true;
+}
+
+void Server::stop()
+{
+    if (thread.joinable()) {
+        running.store(false, std::memory_order_release);
+        thread.join();
+    }
+
+    for (Client& client : clients) closeClient(client);
+    clients.clear();
+    senders.clear();
+    sharedRing.destroy();
+    ringClients.clear();
+
+    if (datagramFd >= 0) {
+        ::close(datagramFd);
+        datagramFd = -1;
+    }
+
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        listenFd = -1;
+    }
+}
+
+void Server::respond(int clientID, int responseCode, const std::string& text)
+{
+    respondSlot.clientID = clientID;
+    respondSlot.bytes = encodeResponse(responseCode, text);
+    if (!outbound.push(respondSlot)) outboundDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Server::run()
+{
+    std::vector<pollfd> fds;
+
+    while (running.load(std::memory_order_acquire)) {
+
+        fds.clear();
+        fds.push_back({ listenFd, POLLIN, 0 });
+        fds.push_back({ datagramFd, POLLIN, 0 });   // ignored by poll() when -1
+        for (const Client& client : clients) fds.push_back({ client.fd, (short)(client.unsent.empty() ? POLLIN : POLLIN | POLLOUT), 0 });
+
+        const int ready = ::poll(fds.data(), (nfds_t)fds.size(), PollIntervalMs);
+
+        if (ready > 0) {
+            if (fds[0].revents & POLLIN) acceptClients();
+            if (fds[1].revents & POLLIN) readDatagrams();
+
+            for (size_t i = 2; i < fds.size(); ++i) {
+                if (fds[i].revents == 0) continue;
+                Client& client = clients[i - 2];
+                if ((fds[i].revents & POLLOUT) && !writeUnsent(client)) closeClient(client);
+                else if (client.fd >= 0 && !readClient(client)) closeClient(client);
+            }
+
+            clients.erase(std::remove_if(clients.begin(), clients.end(), [](const Client& client) { return client.fd < 0; }), clients.end());
+        }
+
+        writeResponses();
+    }
+}
+
+void Server::acceptClients()
+{
+    while (true) {
+        const int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0) return;
+
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        int yes = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+       #ifdef SO_NOSIGPIPE
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &yes, sizeof(yes));
+       #endif
+
+        Client client;
+        client.fd = fd;
+        client.id = nextClientID++;
+        clients.push_back(std::move(client));
+    }
+}
+
+bool Server::readClient(Client& client)
+{
+    char buffer[4096];
+
+    while (true) {
+        const ssize_t n = ::recv(client.fd, buffer, sizeof(buffer), 0);
+        if (n == 0) return false;
+        if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+        receivedBytes.fetch_add((uint64_t)n, std::memory_order_relaxed);
+
+        bool keepOpen = true;
+        client.splitter.feed(buffer, (size_t)n, [this, &client, &keepOpen](std::string_view text) {
+
+            if (!keepOpen || !parseMessage(text, pushSlot.message)) return;
+            receivedMessages.fetch_add(1, std::memory_order_relaxed);
+
+            if (pushSlot.message.commandID == Heartbeat) {
+                if (!write(client, encodeResponse(HeartbeatResponse, "."))) keepOpen = false;
+            }
+            else if (pushSlot.message.commandID == Disconnect) {
+                keepOpen = false;
+            }
+            else if (pushSlot.message.commandID == Sequenced) {
+                if (unwrapSequenced(text, client.id, pushSlot.clientID) && parseMessage(text, pushSlot.message)) queueInbound();
+            }
+            else {
+                pushSlot.clientID = client.id;
+                queueInbound();
+            }
+        });
+
+        if (!keepOpen) return false;
+    }
+}
+
+void Server::readDatagrams()
+{
+    char buffer[65536];
+    std::vector<std::string_view> messages;
+
+    while (true) {
+        const ssize_t n = ::recv(datagramFd, buffer, sizeof(buffer), 0);
+        if (n <= 0) return;
+
+        receivedBytes.fetch_add((uint64_t)n, std::memory_order_relaxed);
+        splitNonEmpty(std::string_view(buffer, (size_t)n), CommandDelimiter, messages);
+
+        for (std::string_view text : messages) {
+
+            if (!parseMessage(text, pushSlot.message) || pushSlot.message.commandID != Sequenced) continue;
+            receivedMessages.fetch_add(1, std::memory_order_relaxed);
+
+            if (!unwrapSequenced(text, 0, pushSlot.clientID) || !parseMessage(text, pushSlot.message)) continue;
+
+            // A newer datagram will follow, so never hold up the socket thread for this one
+            if (!inbound.push(pushSlot)) staleValues.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool Server::unwrapSequenced(std::string_view& text, int fromClientID, int& clientID)
+{
+    uint32_t senderID;
+    uint64_t sequence;
+    std::string_view inner;
+    if (!parseSequenced(text, senderID, sequence, inner)) return false;
+
+    Sender& sender = senders[senderID];
+    if (fromClientID != 0) sender.clientID = fromClientID;
+
+    if (inner.empty()) {
+        // Passed on so the tick thread can route replies about this sender's ring commands
+        pushSlot.message.commandID = Sequenced;
+        pushSlot.message.value = (double)senderID;
+        pushSlot.clientID = fromClientID;
+        if (fromClientID != 0) queueInbound();
+        return false;
+    }
+
+    if (sequence <= sender.lastSequence) {
+        staleValues.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    sender.lastSequence = sequence;
+    clientID = sender.clientID;
+    text = inner;
+    return true;
+}
+
+void Server::queueInbound()
+{
+    if (inbound.push(pushSlot)) return;
+
+    /*
+     The tick thread is behind. Rather than dropping commands (triggers
+     must not be lost), wait for it; TCP flow control then slows the
+     senders down.
+     */
+    inboundStalls.fetch_add(1, std::memory_order_relaxed);
+    while (running.load(std::memory_order_acquire) && !inbound.push(pushSlot)) {
+        writeResponses();
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+void Server::writeResponses()
+{
+    while (outbound.pop(writeSlot)) {
+        for (Client& client : clients) {
+            if (client.id == writeSlot.clientID && client.fd >= 0) {
+                if (!write(client, writeSlot.bytes)) closeClient(client);
+                break;
+            }
+        }
+    }
+}
+
+// Sends what the socket will take now; the count sent, or -1 when the connection has failed
+static ssize_t sendAvailable(int fd, const char* data, size_t size)
+{
+    size_t written = 0;
+    while (written < size) {
+        const ssize_t n = ::send(fd, data + written, size - written, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n <= 0) return -1;
+        written += (size_t)n;
+    }
+    return (ssize_t)written;
+}
+
+bool Server::write(Client& client, const std::string& bytes)
+{
+    /*
+     Whatever the socket will not take now is kept and finished when it
+     becomes writable, so a response is never cut short. A client that
+     stops reading loses whole responses once too much is waiting.
+     */
+    if (!client.unsent.empty()) {
+        if (client.unsent.size() + bytes.size() > MaxUnsentBytes) outboundDropped.fetch_add(1, std::memory_order_relaxed);
+        else client.unsent += bytes;
+        return true;
+    }
+
+    const ssize_t written = sendAvailable(client.fd, bytes.data(), bytes.size());
+    if (written < 0) return false;
+    client.unsent.assign(bytes, (size_t)written, std::string::npos);
+    return true;
+}
+
+bool Server::writeUnsent(Client& client)
+{
+    const ssize_t written = sendAvailable(client.fd, client.unsent.data(), client.unsent.size());
+    if (written < 0) return false;
+    client.unsent.erase(0, (size_t)written);
+    return true;
+}
+
+void Server::closeClient(Client& client)
+{
+    if (client.fd >= 0) {
+        ::close(client.fd);
+        client.fd = -1;
+    }
+    client.splitter.reset();
+    client.unsent.clear();
+}
+
+} // namespace obvious
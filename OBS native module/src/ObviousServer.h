@@ -0,0 +1,155 @@
+//
+//  ObviousServer.h
+//  Obvious native receiver
+//
+//  TCP server running on its own thread. Heartbeats and disconnects are
+//  answered on the socket thread; everything else is parsed there and handed
+//  to the OBS tick thread through a lock-free queue.
+//
+//  A UDP socket on the same port takes sequenced continuous values. Those
+//  (and their end-of-gesture resends over TCP) are unwrapped here, and any
+//  older than a value already queued from the same sender are dropped.
+//
+//  Plugins on the same machine write to a shared-memory ring instead, which
+//  the tick thread reads directly in drain().
+//
+
+#ifndef ObviousServer_h
+#define ObviousServer_h
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "ObviousProtocol.h"
+#include "ObviousSharedRingReader.h"
+#include "SpscQueue.h"
+
+namespace obvious {
+
+struct InboundMessage {
+    int clientID = 0;
+    Message message;
+};
+
+struct OutboundMessage {
+    int clientID = 0;
+    std::string bytes;
+};
+
+class Server
+{
+public:
+    explicit Server(size_t queueCapacity = 4096);
+    ~Server();
+
+    // Binds to `port` on all interfaces and starts the socket thread.
+    bool start(int port);
+    void stop();
+
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+    int boundPort() const { return port; }
+
+    // Tick thread: hands every queued message, then everything in the shared ring, to `apply(clientID, message)`.
+    // What the ring holds before a queued message was written to it first, so it is applied first.
+    template <typename Apply>
+    size_t drain(Apply&& apply)
+    {
+        size_t count = 0;
+        auto applyRing = [this, &apply, &count](uint32_t sender, std::string_view text) {
+            if (!parseMessage(text, ringSlot)) return;
+            const auto client = ringClients.find(sender);
+            apply(client == ringClients.end() ? 0 : client->second, ringSlot);
+            ++count;
+        };
+
+        while (inbound.pop(drainSlot)) {
+            // A sender registration, so replies about its ring commands reach its connection
+            if (drainSlot.message.commandID == Sequenced) {
+                ringClients[(uint32_t)drainSlot.message.value] = drainSlot.clientID;
+                continue;
+            }
+            sharedRing.drain(false, applyRing);
+            apply(drainSlot.clientID, drainSlot.message);
+            ++count;
+        }
+
+        sharedRing.drain(true, applyRing);
+
+        return count;
+    }
+
+    bool isUsingSharedRing() const { return sharedRing.isOpen(); }
+
+    // Tick thread: queues a response for the socket thread to write.
+    void respond(int clientID, int responseCode, const std::string& text);
+
+    uint64_t messagesReceived() const { return receivedMessages.load(std::memory_order_relaxed); }
+    uint64_t bytesReceived() const { return receivedBytes.load(std::memory_order_relaxed); }
+
+    // Times the socket thread had to wait for the tick thread to catch up.
+    uint64_t inboundQueueStalls() const { return inboundStalls.load(std::memory_order_relaxed); }
+    uint64_t droppedOutbound() const { return outboundDropped.load(std::memory_order_relaxed); }
+
+    // Commands parsed but not yet drained by the tick thread
+    size_t inboundBacklog() const { return inbound.sizeApprox(); }
+
+    // Sequenced values that arrived after a newer one, or found the queue full
+    uint64_t staleDropped() const { return staleValues.load(std::memory_order_relaxed); }
+
+private:
+    struct Client {
+        int fd = -1;
+        int id = 0;
+        StreamSplitter splitter;
+        std::string unsent;     // tail of a response the socket would not take yet
+    };
+
+    void run();
+    void acceptClients();
+    bool readClient(Client& client);
+    void readDatagrams();
+    bool unwrapSequenced(std::string_view& text, int fromClientID, int& clientID);
+    void queueInbound();
+    void writeResponses();
+    void closeClient(Client& client);
+    bool write(Client& client, const std::string& bytes);
+    bool writeUnsent(Client& client);
+
+    SpscQueue<InboundMessage> inbound;
+    SpscQueue<OutboundMessage> outbound;
+    InboundMessage pushSlot;
+    InboundMessage drainSlot;
+    Message ringSlot;
+    SharedRingReader sharedRing;
+    std::unordered_map<uint32_t, int> ringClients;    // tick thread only
+    OutboundMessage respondSlot;
+    OutboundMessage writeSlot;
+
+    std::atomic<uint64_t> receivedMessages { 0 };
+    std::atomic<uint64_t> receivedBytes { 0 };
+    std::atomic<uint64_t> inboundStalls { 0 };
+    std::atomic<uint64_t> outboundDropped { 0 };
+    std::atomic<uint64_t> staleValues { 0 };
+
+    struct Sender {
+        int clientID = 0;           // the TCP connection that registered it, for error responses
+        uint64_t lastSequence = 0;
+    };
+
+    std::thread thread;
+    std::atomic<bool> running { false };
+    int listenFd = -1;
+    int datagramFd = -1;
+    int port = 0;
+    int nextClientID = 1;
+    std::vector<Client> clients;
+    std::unordered_map<uint32_t, Sender> senders;
+};
+
+} // namespace obvious
+
+#endif /* ObviousServer_h */
@@ -0,0 +1,61 @@
+//
+//  ObviousSharedRingReader.cpp
+//  Obvious native receiver
+//
+
+#include "ObviousSharedRingReader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace obvious {
+
+SharedRingReader::~SharedRingReader()
+{
+    destroy();
+}
+
+bool SharedRingReader::create(int port, uint64_t capacity)
+{
+    destroy();
+
+    name = ObviousSharedRingFormat::segmentName(port);
+    const size_t segmentSize = ObviousSharedRingFormat::segmentSize(capacity);
+
+    const int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || ((size_t)info.st_size != segmentSize && ftruncate(fd, (off_t)segmentSize) != 0)) {
+        ::close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) return false;
+
+    header = static_cast<ObviousSharedRingFormat::Header*>(data);
+    records = reinterpret_cast<ObviousSharedRingFormat::Record*>(header + 1);
+    size = segmentSize;
+    stalledDrains = 0;
+
+    ObviousSharedRingFormat::initialise(header, capacity);
+    return true;
+}
+
+void SharedRingReader::destroy()
+{
+    if (header == nullptr) return;
+
+    munmap(static_cast<void*>(header), size);
+    shm_unlink(name.c_str());
+
+    header = nullptr;
+    records = nullptr;
+    size = 0;
+}
+
+} // namespace obvious
@@ -0,0 +1,59 @@
+//
+//  ObviousSharedRingReader.h
+//  Obvious native receiver
+//
+//  Creates the shared-memory ring plugins on this machine write commands
+//  to (layout in Source/Core/ObviousSharedRingFormat.h), and reads it on
+//  the tick thread without any system calls.
+//
+
+#ifndef ObviousSharedRingReader_h
+#define ObviousSharedRingReader_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "ObviousSharedRingFormat.h"
+
+namespace obvious {
+
+class SharedRingReader
+{
+public:
+    ~SharedRingReader();
+
+    // Creates (or takes over) the segment for `port`. Returns false when shared memory is unavailable.
+    bool create(int port, uint64_t capacity = ObviousSharedRingFormat::defaultCapacity);
+
+    // Unmaps and unlinks the segment; writers notice OBS has stopped draining and fall back to TCP.
+    void destroy();
+
+    bool isOpen() const { return header != nullptr; }
+
+    // Tick thread: calls onMessage(sender, text) for every command written since the last call.
+    // `tick` is false for the pass before a socket command, which writers do not count as a drain.
+    template <typename Callback>
+    size_t drain(bool tick, Callback&& onMessage)
+    {
+        if (header == nullptr) return 0;
+        return ObviousSharedRingFormat::drain(header, records, stalledDrains, StallLimit, tick, [&onMessage](uint32_t sender, const char* data, size_t length) {
+            onMessage(sender, std::string_view(data, length));
+        });
+    }
+
+private:
+    // Drains (ticks) to wait on a claimed but unpublished record before skipping it
+    static constexpr uint32_t StallLimit = 60;
+
+    ObviousSharedRingFormat::Header* header = nullptr;
+    ObviousSharedRingFormat::Record* records = nullptr;
+    size_t size = 0;
+    std::string name;
+    uint32_t stalledDrains = 0;
+};
+
+} // namespace obvious
+
+#endif /* ObviousSharedRingReader_h */
@@ -0,0 +1,77 @@
+//
+//  SpscQueue.h
+//  Obvious native receiver
+//
+//  Bounded single-producer/single-consumer ring. The socket thread is the
+//  only producer of inbound messages and the tick thread the only consumer,
+//  (and the other way round for responses), so no locks are needed.
+//
+
+#ifndef SpscQueue_h
+#define SpscQueue_h
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace obvious {
+
+template <typename T>
+class SpscQueue
+{
+public:
+    // capacity is rounded up to a power of two
+    explicit SpscQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    // Producer side. Returns false (and leaves `item` untouched) when full.
+    bool push(T& item)
+    {
+        const size_t tail = tailIndex.load(std::memory_order_relaxed);
+        if (tail - cachedHead > mask) {
+            cachedHead = headIndex.load(std::memory_order_acquire);
+            if (tail - cachedHead > mask) return false;
+        }
+        std::swap(slots[tail & mask], item);
+        tailIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Swaps the oldest item into `item`.
+    bool pop(T& item)
+    {
+        const size_t head = headIndex.load(std::memory_order_relaxed);
+        if (head == cachedTail) {
+            cachedTail = tailIndex.load(std::memory_order_acquire);
+            if (head == cachedTail) return false;
+        }
+        std::swap(item, slots[head & mask]);
+        headIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t sizeApprox() const
+    {
+        return tailIndex.load(std::memory_order_acquire) - headIndex.load(std::memory_order_acquire);
+    }
+
+private:
+    std::vector<T> slots;
+    size_t mask = 0;
+
+    alignas(64) std::atomic<size_t> headIndex { 0 };
+    size_t cachedTail = 0;     // consumer-owned
+
+    alignas(64) std::atomic<size_t> tailIndex { 0 };
+    size_t cachedHead = 0;     // producer-owned
+};
+
+} // namespace obvious
+
+#endif /* SpscQueue_h */
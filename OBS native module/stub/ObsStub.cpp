@@ -0,0 +1,303 @@
+//
+//  ObsStub.cpp
+//  Obvious native receiver
+//
+
+#include "obs-module.h"
+#include "obs-stub.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+struct obs_data {
+    std::map<std::string, double> doubles;
+    std::map<std::string, std::string> strings;
+    std::map<std::string, long long> ints;
+};
+
+struct obs_scene_item {
+    obs_source_t* source = nullptr;
+    vec2 pos { 0.0f, 0.0f };
+    vec2 scale { 1.0f, 1.0f };
+    obs_sceneitem_crop crop { 0, 0, 0, 0 };
+    bool visible = true;
+    int deferDepth = 0;
+};
+
+struct obs_scene {
+    std::vector<std::unique_ptr<obs_scene_item>> items;
+};
+
+struct obs_source {
+    std::string name;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::unique_ptr<obs_scene> scene;
+    std::map<std::string, std::unique_ptr<obs_source>> filters;
+    obs_data settings;
+    int64_t mediaTime = 0;
+    bool mediaPaused = true;
+};
+
+namespace {
+
+std::map<std::string, std::unique_ptr<obs_source>> sources;
+std::vector<std::pair<void (*)(void*, float), void*>> tickCallbacks;
+obsstub::Counters stubCounters;
+bool logEnabled = true;
+
+obs_source_t* sourceNamed(const std::string& name)
+{
+    auto it = sources.find(name);
+    if (it != sources.end()) return it->second.get();
+    auto source = std::make_unique<obs_source>();
+    source->name = name;
+    obs_source_t* raw = source.get();
+    sources.emplace(name, std::move(source));
+    return raw;
+}
+
+obs_sceneitem_t* itemNamed(const std::string& sceneName, const std::string& sourceName)
+{
+    auto it = sources.find(sceneName);
+    if (it == sources.end() || !it->second->scene) return nullptr;
+    return obs_scene_find_source_recursive(it->second->scene.get(), sourceName.c_str());
+}
+
+} // namespace
+
+//==============================================================================
+extern "C" {
+
+void blog(int log_level, const char* format, ...)
+{
+    ++stubCounters.log;
+    if (!logEnabled) return;
+    va_list args;
+    va_start(args, format);
+    std::fprintf(stderr, "[%d] ", log_level);
+    std::vfprintf(stderr, format, args);
+    std::fputc('\n', stderr);
+    va_end(args);
+}
+
+void bfree(void* ptr)
+{
+    free(ptr);
+}
+
+char* obs_module_config_path(const char*)
+{
+    return nullptr;
+}
+
+obs_source_t* obs_get_source_by_name(const char* name)
+{
+    ++stubCounters.sourceLookups;
+    auto it = sources.find(name);
+    return it == sources.end() ? nullptr : it->second.get();
+}
+
+void obs_source_release(obs_source_t*)
+{
+}
+
+obs_scene_t* obs_scene_from_source(const obs_source_t* source)
+{
+    return source ? source->scene.get() : nullptr;
+}
+
+obs_sceneitem_t* obs_scene_find_source_recursive(obs_scene_t* scene, const char* name)
+{
+    for (auto& item : scene->items) {
+        if (item->source->name == name) return item.get();
+        if (item->source->scene) {
+            if (obs_sceneitem_t* nested = obs_scene_find_source_recursive(item->source->scene.get(), name)) return nested;
+        }
+    }
+    return nullptr;
+}
+
+obs_source_t* obs_sceneitem_get_source(const obs_sceneitem_t* item)
+{
+    return item->source;
+}
+
+void obs_sceneitem_get_scale(const obs_sceneitem_t* item, struct vec2* scale) { *scale = item->scale; }
+void obs_sceneitem_set_scale(obs_sceneitem_t* item, const struct vec2* scale) { item->scale = *scale; ++stubCounters.sceneItemUpdates; }
+void obs_sceneitem_get_pos(const obs_sceneitem_t* item, struct vec2* pos) { *pos = item->pos; }
+void obs_sceneitem_set_pos(obs_sceneitem_t* item, const struct vec2* pos) { item->pos = *pos; ++stubCounters.sceneItemUpdates; }
+void obs_sceneitem_get_crop(const obs_sceneitem_t* item, struct obs_sceneitem_crop* crop) { *crop = item->crop; }
+void obs_sceneitem_set_crop(obs_sceneitem_t* item, const struct obs_sceneitem_crop* crop) { item->crop = *crop; ++stubCounters.sceneItemUpdates; }
+
+bool obs_sceneitem_set_visible(obs_sceneitem_t* item, bool visible)
+{
+    item->visible = visible;
+    ++stubCounters.sceneItemUpdates;
+    return true;
+}
+
+void obs_sceneitem_defer_update_begin(obs_sceneitem_t* item) { ++item->deferDepth; }
+void obs_sceneitem_defer_update_end(obs_sceneitem_t* item) { --item->deferDepth; }
+
+uint32_t obs_source_get_width(obs_source_t* source) { return source->width; }
+uint32_t obs_source_get_height(obs_source_t* source) { return source->height; }
+
+obs_source_t* obs_source_get_filter_by_name(obs_source_t* source, const char* name)
+{
+    auto it = source->filters.find(name);
+    return it == source->filters.end() ? nullptr : it->second.get();
+}
+
+obs_data_t* obs_source_get_settings(const obs_source_t* source)
+{
+    return const_cast<obs_data_t*>(&source->settings);
+}
+
+void obs_source_update(obs_source_t* source, obs_data_t* settings)
+{
+    if (settings != &source->settings) source->settings = *settings;
+    ++stubCounters.settingsUpdates;
+}
+
+void obs_source_media_restart(obs_source_t* source) { source->mediaTime = 0; source->mediaPaused = false; ++stubCounters.mediaCalls; }
+void obs_source_media_stop(obs_source_t* source) { source->mediaTime = 0; source->mediaPaused = true; ++stubCounters.mediaCalls; }
+void obs_source_media_play_pause(obs_source_t* source, bool pause) { source->mediaPaused = pause; ++stubCounters.mediaCalls; }
+void obs_source_media_set_time(obs_source_t* source, int64_t ms) { source->mediaTime = ms; ++stubCounters.mediaCalls; }
+
+obs_data_t* obs_data_create_from_json_file_safe(const char*, const char*)
+{
+    return nullptr;
+}
+
+void obs_data_release(obs_data_t*)
+{
+}
+
+void obs_data_set_double(obs_data_t* data, const char* name, double val) { data->doubles[name] = val; }
+void obs_data_set_string(obs_data_t* data, const char* name, const char* val) { data->strings[name] = val; }
+
+void obs_data_set_default_int(obs_data_t* data, const char* name, long long val)
+{
+    data->ints.emplace(name, val);
+}
+
+long long obs_data_get_int(obs_data_t* data, const char* name)
+{
+    auto it = data->ints.find(name);
+    return it == data->ints.end() ? 0 : it->second;
+}
+
+void obs_add_tick_callback(void (*tick)(void* param, float seconds), void* param)
+{
+    tickCallbacks.emplace_back(tick, param);
+}
+
+void obs_remove_tick_callback(void (*tick)(void* param, float seconds), void* param)
+{
+    tickCallbacks.erase(std::remove(tickCallbacks.begin(), tickCallbacks.end(), std::make_pair(tick, param)), tickCallbacks.end());
+}
+
+double obs_get_active_fps(void)
+{
+    return 60.0;
+}
+
+} // extern "C"
+
+//==============================================================================
+namespace obsstub {
+
+void reset()
+{
+    sources.clear();
+    tickCallbacks.clear();
+    stubCounters = Counters();
+}
+
+obs_sceneitem_t* addSceneItem(const std::string& sceneName, const std::string& sourceName, uint32_t width, uint32_t height)
+{
+    obs_source_t* sceneSource = sourceNamed(sceneName);
+    if (!sceneSource->scene) sceneSource->scene = std::make_unique<obs_scene>();
+
+    obs_source_t* source = sourceNamed(sourceName);
+    source->width = width;
+    source->height = height;
+
+    auto item = std::make_unique<obs_scene_item>();
+    item->source = source;
+    obs_sceneitem_t* raw = item.get();
+    sceneSource->scene->items.push_back(std::move(item));
+    return raw;
+}
+
+void addFilter(const std::string& sourceName, const std::string& filterName)
+{
+    auto filter = std::make_unique<obs_source>();
+    filter->name = filterName;
+    sourceNamed(sourceName)->filters[filterName] = std::move(filter);
+}
+
+void tick(float seconds)
+{
+    for (auto& callback : std::vector<std::pair<void (*)(void*, float), void*>>(tickCallbacks))
+        callback.first(callback.second, seconds);
+}
+
+const Counters& counters() { return stubCounters; }
+void setLogEnabled(bool enabled) { logEnabled = enabled; }
+
+vec2 scale(const std::string& sceneName, const std::string& sourceName)
+{
+    obs_sceneitem_t* item = itemNamed(sceneName, sourceName);
+    return item ? item->scale : vec2 { 0.0f, 0.0f };
+}
+
+vec2 position(const std::string& sceneName, const std::string& sourceName)
+{
+    obs_sceneitem_t* item = itemNamed(sceneName, sourceName);
+    return item ? item->pos : vec2 { 0.0f, 0.0f };
+}
+
+obs_sceneitem_crop crop(const std::string& sceneName, const std::string& sourceName)
+{
+    obs_sceneitem_t* item = itemNamed(sceneName, sourceName);
+    return item ? item->crop : obs_sceneitem_crop { 0, 0, 0, 0 };
+}
+
+bool visible(const std::string& sceneName, const std::string& sourceName)
+{
+    obs_sceneitem_t* item = itemNamed(sceneName, sourceName);
+    return item && item->visible;
+}
+
+double filterValue(const std::string& sourceName, const std::string& filterName, const std::string& key)
+{
+    auto it = sources.find(sourceName);
+    if (it == sources.end()) return 0.0;
+    obs_source_t* filter = obs_source_get_filter_by_name(it->second.get(), filterName.c_str());
+    if (!filter) return 0.0;
+    auto value = filter->settings.doubles.find(key);
+    return value == filter->settings.doubles.end() ? 0.0 : value->second;
+}
+
+std::string sourceString(const std::string& sourceName, const std::string& key)
+{
+    auto it = sources.find(sourceName);
+    if (it == sources.end()) return {};
+    auto value = it->second->settings.strings.find(key);
+    return value == it->second->settings.strings.end() ? std::string() : value->second;
+}
+
+int64_t mediaTime(const std::string& sourceName)
+{
+    auto it = sources.find(sourceName);
+    return it == sources.end() ? 0 : it->second->mediaTime;
+}
+
+} // namespace obsstub
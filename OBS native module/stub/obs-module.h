@@ -0,0 +1,31 @@
+//
+//  obs-module.h
+//  Obvious native receiver
+//
+//  Stand-in for libobs' obs-module.h, see obs.h in this folder.
+//
+
+#pragma once
+
+#include "obs.h"
+
+#ifdef __cplusplus
+#define MODULE_EXPORT extern "C"
+#else
+#define MODULE_EXPORT
+#endif
+
+#define OBS_DECLARE_MODULE()
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+char* obs_module_config_path(const char* file);
+
+bool obs_module_load(void);
+void obs_module_unload(void);
+
+#ifdef __cplusplus
+}
+#endif
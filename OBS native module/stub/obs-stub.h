@@ -0,0 +1,47 @@
+//
+//  obs-stub.h
+//  Obvious native receiver
+//
+//  Controls the in-memory scene graph behind the stub libobs, so benchmarks
+//  and stand-in servers can build scenes and inspect what was applied.
+//  Not thread safe: use it from the thread that runs the tick callbacks.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "obs.h"
+
+namespace obsstub {
+
+void reset();
+
+// Creates the scene (and source) on first use and adds an item to it.
+obs_sceneitem_t* addSceneItem(const std::string& sceneName, const std::string& sourceName, uint32_t width = 1920, uint32_t height = 1080);
+void addFilter(const std::string& sourceName, const std::string& filterName);
+
+// Runs every registered tick callback once.
+void tick(float seconds);
+
+struct Counters {
+    uint64_t sourceLookups = 0;
+    uint64_t sceneItemUpdates = 0;
+    uint64_t settingsUpdates = 0;
+    uint64_t mediaCalls = 0;
+    uint64_t log = 0;
+};
+
+const Counters& counters();
+void setLogEnabled(bool enabled);
+
+vec2 scale(const std::string& sceneName, const std::string& sourceName);
+vec2 position(const std::string& sceneName, const std::string& sourceName);
+obs_sceneitem_crop crop(const std::string& sceneName, const std::string& sourceName);
+bool visible(const std::string& sceneName, const std::string& sourceName);
+double filterValue(const std::string& sourceName, const std::string& filterName, const std::string& key);
+std::string sourceString(const std::string& sourceName, const std::string& key);
+int64_t mediaTime(const std::string& sourceName);
+
+} // namespace obsstub
@@ -0,0 +1,85 @@
+//
+//  obs.h
+//  Obvious native receiver
+//
+//  Minimal stand-in for the parts of the libobs API the receiver uses, so
+//  the protocol and dispatch code can be built and benchmarked on machines
+//  without OBS. Signatures follow libobs; the implementation in ObsStub.cpp
+//  keeps an in-memory scene graph (see obs-stub.h).
+//
+
+#pragma once
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LOG_ERROR   100
+#define LOG_WARNING 200
+#define LOG_INFO    300
+#define LOG_DEBUG   400
+
+typedef struct obs_source obs_source_t;
+typedef struct obs_scene obs_scene_t;
+typedef struct obs_scene_item obs_sceneitem_t;
+typedef struct obs_data obs_data_t;
+
+struct vec2 {
+    float x, y;
+};
+
+struct obs_sceneitem_crop {
+    int left;
+    int top;
+    int right;
+    int bottom;
+};
+
+void blog(int log_level, const char* format, ...);
+void bfree(void* ptr);
+
+obs_source_t* obs_get_source_by_name(const char* name);
+void obs_source_release(obs_source_t* source);
+obs_scene_t* obs_scene_from_source(const obs_source_t* source);
+obs_sceneitem_t* obs_scene_find_source_recursive(obs_scene_t* scene, const char* name);
+obs_source_t* obs_sceneitem_get_source(const obs_sceneitem_t* item);
+
+void obs_sceneitem_get_scale(const obs_sceneitem_t* item, struct vec2* scale);
+void obs_sceneitem_set_scale(obs_sceneitem_t* item, const struct vec2* scale);
+void obs_sceneitem_get_pos(const obs_sceneitem_t* item, struct vec2* pos);
+void obs_sceneitem_set_pos(obs_sceneitem_t* item, const struct vec2* pos);
+void obs_sceneitem_get_crop(const obs_sceneitem_t* item, struct obs_sceneitem_crop* crop);
+void obs_sceneitem_set_crop(obs_sceneitem_t* item, const struct obs_sceneitem_crop* crop);
+bool obs_sceneitem_set_visible(obs_sceneitem_t* item, bool visible);
+void obs_sceneitem_defer_update_begin(obs_sceneitem_t* item);
+void obs_sceneitem_defer_update_end(obs_sceneitem_t* item);
+
+uint32_t obs_source_get_width(obs_source_t* source);
+uint32_t obs_source_get_height(obs_source_t* source);
+obs_source_t* obs_source_get_filter_by_name(obs_source_t* source, const char* name);
+obs_data_t* obs_source_get_settings(const obs_source_t* source);
+void obs_source_update(obs_source_t* source, obs_data_t* settings);
+
+void obs_source_media_restart(obs_source_t* source);
+void obs_source_media_stop(obs_source_t* source);
+void obs_source_media_play_pause(obs_source_t* source, bool pause);
+void obs_source_media_set_time(obs_source_t* source, int64_t ms);
+
+obs_data_t* obs_data_create_from_json_file_safe(const char* json_file, const char* backup_ext);
+void obs_data_release(obs_data_t* data);
+void obs_data_set_double(obs_data_t* data, const char* name, double val);
+void obs_data_set_string(obs_data_t* data, const char* name, const char* val);
+void obs_data_set_default_int(obs_data_t* data, const char* name, long long val);
+long long obs_data_get_int(obs_data_t* data, const char* name);
+
+void obs_add_tick_callback(void (*tick)(void* param, float seconds), void* param);
+void obs_remove_tick_callback(void (*tick)(void* param, float seconds), void* param);
+double obs_get_active_fps(void);
+
+#ifdef __cplusplus
+}
+#endif
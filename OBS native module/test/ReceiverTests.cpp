@@ -0,0 +1,309 @@
+//
+//  ReceiverTests.cpp
+//  Obvious native receiver
+//
+//  Checks decoding and dispatch against the stub libobs. Exits non-zero
+//  when a check fails; registered with ctest as obvious-receiver-tests.
+//
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ObviousDispatcher.h"
+#include "ObviousProtocol.h"
+#include "ObviousServer.h"
+#include "obs-stub.h"
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++failures; \
+        } \
+    } while (0)
+
+static const char US = obvious::CommandChunkDelimiter;
+static const char GS = obvious::TypeStateFieldDelimiter;
+
+static std::string command(int commandID, const std::string& scene, const std::string& source, const std::string& filter, const std::string& last)
+{
+    std::string s = std::to_string(commandID) + US + scene + US + source + US;
+    if (!filter.empty()) s += filter + US;
+    return s + last;
+}
+
+static bool near(double a, double b)
+{
+    return std::fabs(a - b) < 1.0e-4;
+}
+
+struct Response {
+    int clientID;
+    int code;
+    std::string text;
+};
+
+// Parses and applies one command, as the tick callback does
+struct Harness {
+    std::vector<Response> responses;
+    obvious::Dispatcher dispatcher { [this](int clientID, int code, const std::string& text) { responses.push_back({ clientID, code, text }); } };
+
+    Harness()
+    {
+        obsstub::reset();
+        obsstub::setLogEnabled(false);
+        obsstub::addSceneItem("Scene", "Source", 1000, 500);
+        obsstub::addFilter("Source", "Filter");
+        obsstub::addSceneItem("Scene", "Text");
+    }
+
+    bool apply(const std::string& text, int clientID = 1)
+    {
+        obvious::Message message;
+        if (!obvious::parseMessage(text, message)) return false;
+        dispatcher.apply(clientID, message);
+        return true;
+    }
+};
+
+static void testParseMessage()
+{
+    obvious::Message message;
+
+    CHECK(obvious::parseMessage(command(obvious::ScaleX, "Scene", "Source", "", "0.5"), message));
+    CHECK(message.commandID == obvious::ScaleX);
+    CHECK(message.scene == "Scene");
+    CHECK(message.source == "Source");
+    CHECK(message.hasValue && message.value == 0.5);
+
+    CHECK(obvious::parseMessage(command(obvious::Opacity, "Scene", "Source", "Filter", "75"), message));
+    CHECK(message.filter == "Filter");
+    CHECK(message.value == 75.0);
+
+    // Runs of the chunk delimiter are one delimiter, as in Obvious.lua
+    CHECK(obvious::parseMessage(std::to_string(obvious::ScaleY) + US + US + "Scene" + US + "Source" + US + US + "2", message));
+    CHECK(message.scene == "Scene" && message.source == "Source" && message.value == 2.0);
+
+    CHECK(obvious::parseMessage(command(obvious::TypeText, "Scene", "Text", "", "Hello"), message));
+    CHECK(message.lastChunk == "Hello");
+    CHECK(!message.hasValue && message.value == 0.0);
+
+    CHECK(!obvious::parseMessage("", message));
+    CHECK(!obvious::parseMessage(std::string("x") + US + "Scene", message));
+}
+
+static void testParseSequenced()
+{
+    uint32_t sender = 0;
+    uint64_t sequence = 0;
+    std::string_view inner;
+
+    const std::string wrapped = std::to_string(obvious::Sequenced) + US + "42" + US + "7" + US + command(obvious::ScaleX, "Scene", "Source", "", "1");
+    CHECK(obvious::parseSequenced(wrapped, sender, sequence, inner));
+    CHECK(sender == 42 && sequence == 7);
+    CHECK(inner == command(obvious::ScaleX, "Scene", "Source", "", "1"));
+
+    const std::string registration = std::to_string(obvious::Sequenced) + US + "42";
+    CHECK(obvious::parseSequenced(registration, sender, sequence, inner));
+    CHECK(inner.empty());
+
+    CHECK(!obvious::parseSequenced(std::to_string(obvious::Sequenced) + US + "sender", sender, sequence, inner));
+}
+
+static void testStreamSplitter()
+{
+    obvious::StreamSplitter splitter;
+    std::vector<std::string> messages;
+    auto collect = [&messages](std::string_view message) { messages.emplace_back(message); };
+
+    const std::string stream = std::string("first") + obvious::CommandDelimiter + obvious::CommandDelimiter + "second" + obvious::CommandDelimiter;
+    splitter.feed(stream.data(), 8, collect);
+    CHECK(messages.size() == 1 && messages[0] == "first");
+    splitter.feed(stream.data() + 8, stream.size() - 8, collect);
+    CHECK(messages.size() == 2 && messages[1] == "second");
+
+    CHECK(obvious::encodeResponse(obvious::ResponseCodeError, "text") == std::string("10") + US + "text" + obvious::CommandDelimiter);
+}
+
+static void testDispatchSource()
+{
+    Harness harness;
+
+    CHECK(harness.apply(command(obvious::ScaleX, "Scene", "Source", "", "0.5")));
+    CHECK(harness.apply(command(obvious::ScaleY, "Scene", "Source", "", "2")));
+    CHECK(near(obsstub::scale("Scene", "Source").x, 0.5) && near(obsstub::scale("Scene", "Source").y, 2.0));
+
+    CHECK(harness.apply(command(obvious::PositionProportionateX, "Scene", "Source", "", "0.25")));
+    CHECK(harness.apply(command(obvious::PositionProportionateY, "Scene", "Source", "", "0.5")));
+    CHECK(near(obsstub::position("Scene", "Source").x, 250.0) && near(obsstub::position("Scene", "Source").y, 250.0));
+
+    CHECK(harness.apply(command(obvious::CropLeft, "Scene", "Source", "", "12")));
+    CHECK(harness.apply(command(obvious::CropBottom, "Scene", "Source", "", "34")));
+    CHECK(obsstub::crop("Scene", "Source").left == 12 && obsstub::crop("Scene", "Source").bottom == 34);
+
+    CHECK(harness.apply(command(obvious::SetVisible, "Scene", "Source", "", "0")));
+    CHECK(!obsstub::visible("Scene", "Source"));
+    CHECK(harness.apply(command(obvious::SetVisible, "Scene", "Source", "", "1")));
+    CHECK(obsstub::visible("Scene", "Source"));
+
+    CHECK(harness.apply(command(obvious::Opacity, "Scene", "Source", "Filter", "60")));
+    CHECK(near(obsstub::filterValue("Source", "Filter", "opacity"), 60.0));
+
+    CHECK(harness.apply(command(obvious::MediaCursor, "Scene", "Source", "", "1500")));
+    CHECK(obsstub::mediaTime("Source") == 1500);
+
+    CHECK(harness.responses.empty());
+}
+
+static void testDispatchErrors()
+{
+    Harness harness;
+
+    CHECK(harness.apply(command(obvious::ScaleX, "Missing", "Source", "", "1")));
+    CHECK(harness.responses.size() == 1 && harness.responses.back().code == obvious::ResponseCodeError);
+    CHECK(harness.responses.back().text == "Could not find scene named 'Missing'");
+
+    CHECK(harness.apply(command(obvious::Hue, "Scene", "Source", "Missing", "1")));
+    CHECK(harness.responses.size() == 2 && harness.responses.back().text.find("No filter named 'Missing'") == 0);
+
+    // The plugin recognises this reply to a request the receiver does not offer
+    CHECK(harness.apply(std::to_string(obvious::CatalogueSubscribe) + US + "."));
+    CHECK(harness.responses.size() == 3 && harness.responses.back().text == "Unknown command ID (290)");
+
+    CHECK(harness.apply(command(999, "Scene", "Source", "", "1")));
+    CHECK(harness.responses.size() == 4 && harness.responses.back().text == "Unknown command ID (999)");
+}
+
+static void testDispatchUnsupported()
+{
+    Harness harness;
+
+    const int unsupported[] = { obvious::Relative, obvious::Transform, obvious::Rotation, obvious::BoundsWidth, obvious::BoundsHeight, obvious::LFO, obvious::Values, obvious::Scheduled };
+    for (int commandID : unsupported) {
+        CHECK(obvious::unsupportedCommandName(commandID) != nullptr);
+
+        const size_t before = harness.responses.size();
+        CHECK(harness.apply(command(commandID, "Scene", "Source", "", "1")));
+        CHECK(harness.responses.size() == before + 1);
+        CHECK(harness.responses.back().code == obvious::ResponseCodeError);
+        CHECK(harness.responses.back().text.find(obvious::unsupportedCommandName(commandID)) != std::string::npos);
+        CHECK(harness.responses.back().text.find("Obvious.lua") != std::string::npos);
+
+        // Reported once per client, not on every automation step
+        CHECK(harness.apply(command(commandID, "Scene", "Source", "", "1")));
+        CHECK(harness.responses.size() == before + 1);
+        CHECK(harness.apply(command(commandID, "Scene", "Source", "", "1"), 2));
+        CHECK(harness.responses.size() == before + 2 && harness.responses.back().clientID == 2);
+    }
+
+    CHECK(obvious::unsupportedCommandName(obvious::ScaleX) == nullptr);
+    CHECK(obvious::unsupportedCommandName(obvious::CatalogueSubscribe) == nullptr);
+    CHECK(near(obsstub::scale("Scene", "Source").x, 1.0));
+}
+
+static void testDispatchTypeText()
+{
+    Harness harness;
+
+    // Driven before the plugin's state arrived: ask for it once
+    CHECK(harness.apply(command(obvious::TypeSetNumChars, "Scene", "Text", "", "3")));
+    CHECK(harness.apply(command(obvious::TypeSetNumChars, "Scene", "Text", "", "4")));
+    CHECK(harness.responses.size() == 1 && harness.responses.back().code == obvious::ResponseCodeRequestTypeState);
+
+    const std::string state = std::string("5") + GS + "1" + GS + "_" + GS + "Hello world";
+    CHECK(harness.apply(command(obvious::TypeSetState, "Scene", "Text", "", state)));
+    CHECK(obsstub::sourceString("Text", "text") == "Hello_");
+
+    CHECK(harness.apply(command(obvious::TypeSetCursorVisible, "Scene", "Text", "", "0")));
+    CHECK(harness.apply(command(obvious::TypeSetNumChars, "Scene", "Text", "", "2")));
+    CHECK(obsstub::sourceString("Text", "text") == "He");
+
+    CHECK(harness.apply(command(obvious::TypeSetState, "Scene", "Text", "", "malformed")));
+    CHECK(harness.responses.size() == 2 && harness.responses.back().code == obvious::ResponseCodeError);
+
+    // Counted in characters, not bytes, as in Obvious.lua
+    CHECK(harness.apply(command(obvious::TypeText, "Scene", "Text", "", "h\xC3\xA9llo \xE2\x82\xAC")));
+    CHECK(harness.apply(command(obvious::TypeSetNumChars, "Scene", "Text", "", "2")));
+    CHECK(obsstub::sourceString("Text", "text") == "h\xC3\xA9");
+    CHECK(harness.apply(command(obvious::TypeSetNumChars, "Scene", "Text", "", "7")));
+    CHECK(obsstub::sourceString("Text", "text") == "h\xC3\xA9llo \xE2\x82\xAC");
+    CHECK(harness.apply(command(obvious::TypeSetNumChars, "Scene", "Text", "", "99")));
+    CHECK(obsstub::sourceString("Text", "text") == "h\xC3\xA9llo \xE2\x82\xAC");
+}
+
+static void testServerWritesWholeResponses()
+{
+    obvious::Server server;
+    CHECK(server.start(0));
+    if (!server.isRunning()) return;
+
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    int size = 4096;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)server.boundPort());
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK(::connect(fd, (const sockaddr*)&address, sizeof(address)) == 0);
+
+    // Heartbeats sent without reading the replies, so the server's socket fills mid-response
+    const size_t count = 1000000;
+    std::string heartbeats;
+    for (size_t i = 0; i < count; ++i) heartbeats += std::to_string(obvious::Heartbeat) + obvious::CommandDelimiter;
+    for (size_t sent = 0; sent < heartbeats.size();) {
+        const ssize_t n = ::send(fd, heartbeats.data() + sent, heartbeats.size() - sent, 0);
+        if (n <= 0) break;
+        sent += (size_t)n;
+    }
+    for (int i = 0; i < 1000 && server.messagesReceived() < count; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    // Every heartbeat is answered, or its response dropped whole
+    const std::string response = obvious::encodeResponse(obvious::HeartbeatResponse, ".");
+    std::string received;
+    char buffer[65536];
+    pollfd readable { fd, POLLIN, 0 };
+    while (received.size() / response.size() + server.droppedOutbound() < count && ::poll(&readable, 1, 2000) > 0) {
+        const ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) break;
+        received.append(buffer, (size_t)n);
+    }
+    ::close(fd);
+    server.stop();
+
+    size_t responses = 0;
+    bool whole = received.size() % response.size() == 0;
+    for (size_t i = 0; whole && i < received.size(); i += response.size(), ++responses) whole = received.compare(i, response.size(), response) == 0;
+    CHECK(whole);
+    CHECK(responses + server.droppedOutbound() == count);
+}
+
+int main()
+{
+    testParseMessage();
+    testParseSequenced();
+    testStreamSplitter();
+    testDispatchSource();
+    testDispatchErrors();
+    testDispatchUnsupported();
+    testDispatchTypeText();
+    testServerWritesWholeResponses();
+
+    if (failures > 0) {
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
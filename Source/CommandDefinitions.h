@@ -35,11 +35,29 @@ typedef enum : int {
 //              Disconnect  =   240, // placeholder... defined below as a string for easier sending
 //               Heartbeat  =   250, // placeholder... defined below as a string for easier sending
          HeartbeatResponse  =   260,
+//          StatsSubscribe  =   270, // placeholder... defined below as a string for easier sending
+//               Sequenced  =   280, // placeholder... envelope built by ObviousProtocol::encodeSequenced
+//      CatalogueSubscribe  =   290, // placeholder... defined below as a string for easier sending
+//              ValueQuery  =   300, // placeholder... defined below as a string for easier sending
+//          ValueSubscribe  =   310, // placeholder... defined below as a string for easier sending
+              TypeSetState  =   320,
+//                Relative  =   330, // placeholder... envelope built by ObviousProtocol::encodeRelative
+                 Transform  =   340,
+                  Rotation  =   350,
+               BoundsWidth  =   360,
+              BoundsHeight  =   370,
+                       LFO  =   380,
+//                  Values  =   390, // placeholder... message built by ObviousProtocol::encodeValues
+//               Scheduled  =   400, // placeholder... envelope built by ObviousProtocol::encodeScheduled
 } CommandDefinition;
 
 #define CommandDefinitionDefault PositionProportionateX
 #define CommandDisconnect "240"
 #define CommandHeartbeat "250"
+#define CommandStatsSubscribe "270"
+#define CommandCatalogueSubscribe "290"
+#define CommandValueQuery "300"
+#define CommandValueSubscribe "310"
 
 typedef enum : int {
     CommandCategorySource=10,
@@ -49,6 +67,23 @@ typedef enum : int {
 
 #define CommandCategoryDefault CommandCategorySource
 
+typedef enum : int {
+    LFOWaveformSine=1,
+    LFOWaveformTriangle=2,
+    LFOWaveformSaw=3,
+    LFOWaveformSquare=4,
+} LFOWaveform;
+
+#define LFOWaveformDefault LFOWaveformSine
+
+typedef enum : int {
+    AudioModePeak=1,
+    AudioModeRMS=2,
+    AudioModeBands=3,
+} AudioMode;
+
+#define AudioModeDefault AudioModePeak
+
 struct Command {
     CommandDefinition commandID;
     juce::String triggerParameterID;
@@ -0,0 +1,73 @@
+//
+//  CommandTable.cpp
+//  Obvious
+//
+
+#include "CommandTable.h"
+#include "../ParameterDefinitions.h"
+
+namespace CommandTable {
+
+static std::vector<Command> makeCommands() {
+
+    std::vector<Command> commands;
+
+    commands.push_back({PositionProportionateX, ParameterIDValue, "Position (x, proportionate)", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
+    commands.push_back({PositionProportionateY, ParameterIDValue, "Position (y, proportionate)", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
+    commands.push_back({ScaleX, ParameterIDValue, "Scale (x)", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
+    commands.push_back({ScaleY, ParameterIDValue, "Scale (y)", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
+    commands.push_back({MediaRestart, ParameterIDTrigger, "Media restart", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
+    commands.push_back({MediaStop, ParameterIDTrigger, "Media stop", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
+    commands.push_back({MediaPlay, ParameterIDTrigger, "Media play", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
+    commands.push_back({MediaPause, ParameterIDTrigger, "Media pause", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
+    commands.push_back({MediaCursor, ParameterIDValue, "Media cursor", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
+    commands.push_back({Hue, ParameterIDValue, "Filter hue", CommandCategoryFilter, -180, 180, false});
+    commands.push_back({Saturation, ParameterIDValue, "Filter saturation", CommandCategoryFilter, -1, 5, false});
+    commands.push_back({RollSpeedH, ParameterIDValue, "Roll speed (x)", CommandCategoryFilter, -500, 500, false});
+    commands.push_back({RollSpeedV, ParameterIDValue, "Roll speed (y)", CommandCategoryFilter, -500, 500, false});
+    commands.push_back({Opacity, ParameterIDValue, "Opacity", CommandCategoryFilter, 0, 1, false});
+    commands.push_back({CropTop, ParameterIDValue, "Crop (top)", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
+    commands.push_back({CropBottom, ParameterIDValue, "Crop (bottom)", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
+    commands.push_back({CropLeft, ParameterIDValue, "Crop (left)", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
+    commands.push_back({CropRight, ParameterIDValue, "Crop (right)", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
+    commands.push_back({SetVisible, ParameterIDTrigger, "Visible", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), true});
+    commands.push_back({Rotation, ParameterIDValue, "Rotation", CommandCategorySource, 0, 360, false});
+    commands.push_back({BoundsWidth, ParameterIDValue, "Bounds (width)", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
+    commands.push_back({BoundsHeight, ParameterIDValue, "Bounds (height)", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
+
+    return commands;
+
+}
+
+const std::vector<Command>& commands() {
+    static const std::vector<Command> table = makeCommands();
+    return table;
+}
+
+const Command& withID(int commandID) {
+
+    static const Command unknownCommand = {CommandDefinition(0), juce::String(), juce::String(), CommandCategory(0), std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false};
+
+    const std::vector<Command>& table = commands();
+    auto it = std::find_if(table.begin(), table.end(), [commandID](const Command& command) { return command.commandID == commandID; });
+
+    return it != table.end() ? *it : unknownCommand;
+
+}
+
+bool isContinuous(int commandID) {
+
+    switch (commandID) {
+        case PositionProportionateX: case PositionProportionateY:
+        case ScaleX: case ScaleY: case Rotation:
+        case CropTop: case CropBottom: case CropLeft: case CropRight:
+        case BoundsWidth: case BoundsHeight:
+        case Hue: case Saturation: case RollSpeedH: case RollSpeedV: case Opacity:
+            return true;
+        default:
+            return false;
+    }
+
+}
+
+}
@@ -0,0 +1,29 @@
+//
+//  CommandTable.h
+//  Obvious
+//
+//  The commands the plugin can send, shared by every instance.
+//
+
+#ifndef CommandTable_h
+#define CommandTable_h
+
+#include <vector>
+
+#include <juce_core/juce_core.h>
+
+#include "../CommandDefinitions.h"
+
+namespace CommandTable {
+
+const std::vector<Command>& commands();
+
+// Returns a command with commandID 0 when the ID is unknown
+const Command& withID(int commandID);
+
+// Transform, crop and filter commands, which OBS can also apply as a change to its current value or generate with an LFO
+bool isContinuous(int commandID);
+
+}
+
+#endif /* CommandTable_h */
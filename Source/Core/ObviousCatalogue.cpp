@@ -0,0 +1,170 @@
+//
+//  ObviousCatalogue.cpp
+//  Obvious
+//
+
+#include "ObviousCatalogue.h"
+
+#include <map>
+#include <vector>
+
+#include "ObviousProtocol.h"
+
+namespace {
+
+std::string joinKey(const std::string &first, const std::string &second) {
+    return first + CommandChunkDelimiter + second;
+}
+
+}
+
+std::shared_ptr<ObviousCatalogue> ObviousCatalogue::forEndpoint(const juce::String &host, int port) {
+
+    static juce::CriticalSection registryLock;
+    static std::map<std::string, std::weak_ptr<ObviousCatalogue>> registry;
+
+    const std::string key = host.trim().toLowerCase().toStdString() + ":" + std::to_string(port);
+
+    const juce::ScopedLock scope(registryLock);
+
+    auto &entry = registry[key];
+    auto catalogue = entry.lock();
+    if (catalogue == nullptr) {
+        catalogue = std::make_shared<ObviousCatalogue>();
+        entry = catalogue;
+    }
+
+    // Drop the entries of endpoints nobody uses any more
+    for (auto it = registry.begin(); it != registry.end();) {
+        if (it->second.expired()) it = registry.erase(it);
+        else ++it;
+    }
+
+    return catalogue;
+
+}
+
+bool ObviousCatalogue::claimFeeder(const void *engine) {
+
+    const void *expected = nullptr;
+    return feeder.compare_exchange_strong(expected, engine);
+
+}
+
+void ObviousCatalogue::releaseFeeder(const void *engine) {
+
+    const void *expected = engine;
+    if (feeder.compare_exchange_strong(expected, nullptr)) {
+        clear();
+    }
+
+}
+
+void ObviousCatalogue::clear() {
+
+    const juce::SpinLock::ScopedLockType scope(lock);
+    complete.store(false, std::memory_order_release);
+    scenes.clear();
+    items.clear();
+    filters.clear();
+    revision.fetch_add(1, std::memory_order_release);
+
+}
+
+void ObviousCatalogue::beginSnapshot() {
+
+    clear();
+
+}
+
+void ObviousCatalogue::endSnapshot() {
+
+    complete.store(true, std::memory_order_release);
+    revision.fetch_add(1, std::memory_order_release);
+
+}
+
+void ObviousCatalogue::apply(bool add, const std::string &entry) {
+
+    std::vector<std::string> fields;
+    size_t start = 0;
+    for (;;) {
+        const size_t end = entry.find(CatalogueFieldDelimiter, start);
+        fields.push_back(entry.substr(start, end == std::string::npos ? std::string::npos : end - start));
+        if (end == std::string::npos) break;
+        start = end + 1;
+    }
+
+    if (fields[0].size() != 1) return;
+
+    std::set<std::string> *names = nullptr;
+    std::string name;
+
+    switch ((Kind)fields[0][0]) {
+        case Kind::Scene:
+            if (fields.size() != 2) return;
+            names = &scenes;
+            name = fields[1];
+            break;
+        case Kind::Item:
+            if (fields.size() != 3) return;
+            names = &items;
+            name = joinKey(fields[1], fields[2]);
+            break;
+        case Kind::Filter:
+            if (fields.size() != 3) return;
+            names = &filters;
+            name = joinKey(fields[1], fields[2]);
+            break;
+        default:
+            return;
+    }
+
+    {
+        const juce::SpinLock::ScopedLockType scope(lock);
+        if (add) names->insert(std::move(name));
+        else names->erase(name);
+    }
+
+    revision.fetch_add(1, std::memory_order_release);
+
+}
+
+ObviousCatalogue::Check ObviousCatalogue::check(const std::string &scene, const std::string &source, const std::string &filter) const {
+
+    if (!isComplete()) return Check::Unknown;
+
+    const juce::SpinLock::ScopedTryLockType scope(lock);
+    if (!scope.isLocked()) return Check::Unknown;
+
+    if (scenes.count(scene) == 0) return Check::MissingScene;
+    if (items.count(joinKey(scene, source)) == 0) return Check::MissingSource;
+    if (!filter.empty() && filters.count(joinKey(source, filter)) == 0) return Check::MissingFilter;
+
+    return Check::Found;
+
+}
+
+juce::StringArray ObviousCatalogue::completions(Kind kind, const juce::String &context, const juce::String &prefix, int limit) const {
+
+    const std::set<std::string> *names = &scenes;
+    std::string keyPrefix;
+
+    if (kind == Kind::Item) names = &items;
+    else if (kind == Kind::Filter) names = &filters;
+
+    if (kind != Kind::Scene) keyPrefix = context.toStdString() + CommandChunkDelimiter;
+
+    const std::string wanted = keyPrefix + prefix.toStdString();
+    juce::StringArray matches;
+
+    const juce::SpinLock::ScopedLockType scope(lock);
+
+    for (auto it = names->lower_bound(wanted); it != names->end() && matches.size() < limit; ++it) {
+        if (it->compare(0, wanted.size(), wanted) != 0) break;
+        matches.add(juce::String::fromUTF8(it->data() + keyPrefix.size(), (int)(it->size() - keyPrefix.size())));
+    }
+
+    return matches;
+
+}
@@ -0,0 +1,99 @@
+//
+//  ObviousCatalogue.h
+//  Obvious
+//
+//  The scenes, scene items (including those inside groups) and filters of
+//  one OBS, as Obvious.lua reports them. Shared by every engine connected to
+//  the same address and port: one of them subscribes and feeds it, and the
+//  rest read it. Obvious.lua sends a snapshot on subscribe and then only the
+//  entries that were added or removed.
+//
+//  The editor offers its names as completions, and the engine checks every
+//  target against it before sending, so a misspelt scene, source or filter
+//  is reported without a round trip. Until a snapshot is complete nothing is
+//  rejected.
+//
+
+#ifndef ObviousCatalogue_h
+#define ObviousCatalogue_h
+
+#include <atomic>
+#include <memory>
+#include <set>
+#include <string>
+
+#include <juce_core/juce_core.h>
+
+class ObviousCatalogue
+{
+public:
+
+    // Wire names of the entry kinds, the first field of an entry
+    enum class Kind : char
+    {
+        Scene = 'S',    // scene
+        Item = 'I',     // scene, source
+        Filter = 'F'    // source, filter
+    };
+
+    enum class Check
+    {
+        Unknown,        // no complete snapshot yet, or busy being updated
+        Found,
+        MissingScene,
+        MissingSource,
+        MissingFilter
+    };
+
+    // The catalogue for one OBS, created on first use and kept while any engine holds it
+    static std::shared_ptr<ObviousCatalogue> forEndpoint(const juce::String &host, int port);
+
+    ObviousCatalogue() = default;
+
+    /*
+     Only one engine per catalogue subscribes. claimFeeder() returns true when
+     `engine` has just become the feeder and should subscribe;
+     releaseFeeder() forgets the snapshot, so another engine claims it on its
+     next heartbeat.
+     */
+    bool claimFeeder(const void *engine);
+    void releaseFeeder(const void *engine);
+    bool isFeeder(const void *engine) const { return feeder.load() == engine; }
+
+    // Called with the feeder's messages, on its reader thread
+    void beginSnapshot();
+    void endSnapshot();
+    void apply(bool add, const std::string &entry);
+
+    bool isComplete() const { return complete.load(std::memory_order_acquire); }
+
+    // Advanced by every change, so readers can tell when to check their names again
+    uint32_t getRevision() const { return revision.load(std::memory_order_acquire); }
+
+    // Any thread, including the audio thread: never waits for the reader, answering Unknown instead
+    Check check(const std::string &scene, const std::string &source, const std::string &filter) const;
+
+    /*
+     Up to `limit` names of `kind` starting with `prefix`, in order. `context`
+     is the scene for items and the source for filters.
+     */
+    juce::StringArray completions(Kind kind, const juce::String &context, const juce::String &prefix, int limit = 16) const;
+
+private:
+
+    std::atomic<const void*> feeder { nullptr };
+    std::atomic<bool> complete { false };
+    std::atomic<uint32_t> revision { 0 };
+
+    // Sorted, so a prefix is a range. Items are "scene<US>source" and filters "source<US>filter".
+    std::set<std::string> scenes;
+    std::set<std::string> items;
+    std::set<std::string> filters;
+    mutable juce::SpinLock lock;
+
+    void clear();
+
+    JUCE_DECLARE_NON_COPYABLE (ObviousCatalogue)
+};
+
+#endif /* ObviousCatalogue_h */
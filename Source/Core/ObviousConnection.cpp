@@ -0,0 +1,398 @@
+//
+//  ObviousConnection.cpp
+//  Obvious
+//
+
+#include "ObviousConnection.h"
+#include "CommandTable.h"
+#include "ObviousProtocol.h"
+#include "../CommandDefinitions.h"
+
+ObviousConnection::ObviousConnection(Listener &l, ObviousStats &s)
+    : listener(l),
+      stats(s),
+      clientThread(*this),
+      heartbeatThread(*this),
+      connectThread(*this)
+{
+    // Runs for the connection's lifetime, so requestConnect() never has to start it
+    connectThread.startThread();
+}
+
+ObviousConnection::~ObviousConnection() {
+
+    shutdown();
+
+}
+
+void ObviousConnection::shutdown() {
+
+    connectRequested = false;
+    close();
+
+    // An attempt in progress cannot be interrupted, so allow it its timeout
+    connectThread.signalThreadShouldExit();
+    connectThread.notify();
+    connectThread.stopThread(timeoutMilliseconds.load() + 1000);
+
+}
+
+void ObviousConnection::connect(const juce::String &ip, int port, int timeout) {
+
+    if (getState() != State::Idle) {
+        close();
+    }
+
+    {
+        const juce::ScopedLock lock(connectLock);
+        targetHost = ip;
+        targetPort = port;
+        timeoutMilliseconds = juce::jmax(100, timeout);
+        ++generation;
+        state = State::Connecting;
+    }
+
+    {
+        const juce::SpinLock::ScopedLockType lock(datagramAddressLock);
+        datagramHost = ip;
+        datagramPort = port;
+    }
+
+    connectThread.notify();
+
+}
+
+bool ObviousConnection::nextAttempt(juce::String &host, int &port, uint64_t &attemptGeneration) {
+
+    const juce::ScopedLock lock(connectLock);
+
+    const State current = getState();
+    if (current != State::Connecting && current != State::BackingOff) return false;
+
+    state = State::Connecting;
+    host = targetHost;
+    port = targetPort;
+    attemptGeneration = generation;
+    return true;
+
+}
+
+void ObviousConnection::attemptFinished(const juce::String &host, int port, uint64_t attemptGeneration, bool succeeded) {
+
+    {
+        const juce::ScopedLock lock(connectLock);
+
+        // close() or another connect() came in while this attempt was waiting
+        if (attemptGeneration != generation) {
+            if (succeeded) socket.close();
+            return;
+        }
+
+        if (!succeeded) {
+            state = State::BackingOff;
+            return;
+        }
+
+        // Retries while backing off are not reconnects; only a connection after an earlier one is
+        if (hasConnected) stats.reconnected();
+        hasConnected = true;
+    }
+
+    // The heartbeat thread ends itself when OBS stops answering, and may still be finishing
+    clientThread.stopThread(threadStopTimeoutMilliseconds);
+    heartbeatThread.stopThread(threadStopTimeoutMilliseconds);
+
+    // Only a script or receiver that supports it creates the segment; otherwise everything stays on TCP.
+    // Opened on this thread only, as open() changes the ring's mappings.
+    if (ObviousSharedRing::isLocalAddress(host)) sharedRing.open(port);
+
+    // Everything below is written without connectLock, so a slow socket never holds up close() or connect().
+    // The state stays Connecting until the queue is empty, so write() keeps queueing behind it.
+
+    // Ask OBS for its once-a-second apply cost report; the engine drops the error older scripts reply with
+    writeToSocket(std::string(CommandStatsSubscribe) + CommandDelimiter);
+
+    const std::string greeting = listener.connectionGreeting();
+    if (!greeting.empty()) writeToSocket(greeting);
+
+    // Write what was queued in order, then become Connected under both locks once nothing is left
+    for (;;) {
+
+        std::deque<std::string> batch;
+
+        {
+            const juce::ScopedLock lock(connectLock);
+
+            // close() saw Connecting and left the socket, and the ring opened above, to this thread
+            if (attemptGeneration != generation) {
+                sharedRing.close();
+                socket.close();
+                return;
+            }
+
+            {
+                const juce::SpinLock::ScopedLockType pendingScope(pendingLock);
+                if (!pending.empty()) batch.swap(pending);
+                else state = State::Connected;
+            }
+
+            // Started under connectLock, so a close() right after this stops them
+            if (batch.empty()) {
+                clientThread.startThread();
+                heartbeatThread.startThread();
+                return;
+            }
+        }
+
+        for (const auto &message : batch) writeToSocket(message);
+
+    }
+
+}
+
+void ObviousConnection::close() {
+
+    sharedRing.close();
+
+    bool wasConnected;
+
+    {
+        const juce::ScopedLock lock(connectLock);
+        wasConnected = getState() == State::Connected;
+        ++generation;
+        state = State::Idle;
+    }
+
+    connectThread.notify();
+
+    {
+        const juce::SpinLock::ScopedLockType lock(pendingLock);
+        pending.clear();
+    }
+
+    clientThread.signalThreadShouldExit();
+    heartbeatThread.signalThreadShouldExit();
+    heartbeatThread.notify();
+
+    // Closing the socket ends a read or write in progress on either thread
+    if (wasConnected) {
+
+        if (socket.isConnected()) {
+            std::string s = std::string(CommandDisconnect) + CommandDelimiter;
+            socket.write(s.c_str(), (int)s.length());
+        }
+        socket.close();
+
+    }
+
+    stopThreadUnlessCurrent(clientThread);
+    stopThreadUnlessCurrent(heartbeatThread);
+
+}
+
+void ObviousConnection::stopThreadUnlessCurrent(juce::Thread &thread) {
+
+    // close() is reached from the heartbeat thread when OBS stops answering; that thread ends on its own
+    if (juce::Thread::getCurrentThread() != &thread) {
+        thread.stopThread(threadStopTimeoutMilliseconds);
+    }
+
+}
+
+int ObviousConnection::write(const std::string &message) {
+
+    if (getState() != State::Connected) {
+
+        const juce::SpinLock::ScopedLockType lock(pendingLock);
+
+        // Checked again under the lock, as the connect thread sets Connected once the queue is empty
+        if (getState() != State::Connected) {
+            return holdPending(message) ? 0 : -1;
+        }
+
+    }
+
+    return writeToSocket(message);
+
+}
+
+bool ObviousConnection::holdPending(const std::string &message) {
+
+    if (pendingPolicy.load() == PendingPolicy::Drop) {
+        stats.sendSuppressed();
+        return false;
+    }
+
+    // Only the latest value (or the sum of the changes) per continuous target waits; triggers and text all wait in order
+    if (ObviousProtocol::coalesce(pending, message, CommandTable::isContinuous)) {
+        stats.sendCoalesced();
+        return true;
+    }
+
+    if (pending.size() >= maxPending) {
+        pending.pop_front();
+        stats.sendSuppressed();
+    }
+
+    pending.push_back(message);
+    stats.queueDepth(pending.size());
+    return true;
+
+}
+
+int ObviousConnection::writeToSocket(const std::string &message) {
+
+    const juce::int64 start = juce::Time::getHighResolutionTicks();
+    const int written = socket.write(message.c_str(), static_cast<int>(message.length()));
+    const juce::int64 elapsed = juce::Time::getHighResolutionTicks() - start;
+
+    stats.writeStalled(static_cast<uint64_t>(juce::Time::highResolutionTicksToSeconds(elapsed) * 1.0e6));
+    if (written > 0) {
+        stats.messageSent(static_cast<size_t>(written));
+    }
+
+    socketWriteTicks.store(sharedRing.consumerTicks(), std::memory_order_release);
+
+    return written;
+
+}
+
+int ObviousConnection::writeDatagram(const std::string &message) {
+
+    juce::String host;
+    int port;
+
+    {
+        const juce::SpinLock::ScopedLockType lock(datagramAddressLock);
+        host = datagramHost;
+        port = datagramPort;
+    }
+
+    const int written = datagramSocket.write(host, port, message.c_str(), static_cast<int>(message.length()));
+    if (written > 0) {
+        stats.messageSent(static_cast<size_t>(written));
+        stats.datagramSent();
+    }
+
+    return written;
+
+}
+
+bool ObviousConnection::writeShared(uint32_t sender, const std::string &message) {
+
+    // Anything still queued, and anything just written to the socket, goes first: OBS reads its
+    // sockets before the ring in every tick, so two ticks after that write it has been applied
+    if (!isConnected()) return false;
+    if (sharedRing.consumerTicks() < socketWriteTicks.load(std::memory_order_acquire) + 2) return false;
+
+    if (!sharedRing.write(sender, message)) return false;
+
+    stats.messageSent(message.size());
+    stats.sharedRingWrite();
+    return true;
+
+}
+
+void ObviousConnection::heartbeatResponseReceived() {
+
+    hasReceivedHeartbeatResponse = true;
+
+    const juce::int64 sent = heartbeatSentTicks.load();
+    if (sent != 0) {
+        stats.roundTrip(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - sent) * 1000.0);
+    }
+
+}
+
+void ObviousConnection::handleIncomingData(const char *data, int length) {
+
+    stats.dataReceived(static_cast<size_t>(length));
+
+    partialMessage.append(data, static_cast<size_t>(length));
+
+    // Only complete messages go to the listener; the rest waits for the next read
+    size_t start = 0;
+    size_t end;
+
+    while ((end = partialMessage.find(CommandDelimiter, start)) != std::string::npos) {
+        stats.messageReceived();
+        listener.connectionMessageReceived(partialMessage.substr(start, end - start));
+        start = end + 1;
+    }
+
+    partialMessage.erase(0, start);
+
+    // A peer that never ends its message is not allowed to grow this without bound
+    if (partialMessage.size() > maxPartialMessage) {
+        stats.protocolError();
+        partialMessage.clear();
+    }
+
+}
+
+void ObviousConnection::ConnectThread::run() {
+
+    int backoff = initialBackoffMilliseconds;
+
+    while (!threadShouldExit()) {
+
+        juce::String host;
+        int port;
+        uint64_t attemptGeneration;
+
+        // Asked for from the audio thread, which cannot look up the target or connect itself
+        if (connection.connectRequested.exchange(false, std::memory_order_acq_rel)) {
+            connection.listener.connectionRequested();
+        }
+
+        if (!connection.nextAttempt(host, port, attemptGeneration)) {
+            backoff = initialBackoffMilliseconds;
+            wait(requestPollMilliseconds);
+            continue;
+        }
+
+        const bool succeeded = connection.socket.connect(host, port, connection.timeoutMilliseconds.load());
+        connection.attemptFinished(host, port, attemptGeneration, succeeded);
+
+        if (connection.getState() == State::BackingOff) {
+            // connect() and close() notify, so a new target is tried without waiting out the backoff
+            wait(backoff);
+            backoff = juce::jmin(backoff * 2, maxBackoffMilliseconds);
+        }
+        else {
+            backoff = initialBackoffMilliseconds;
+        }
+
+    }
+
+}
+
+void ObviousConnection::HeartbeatThread::run() {
+
+    while (!threadShouldExit()) {
+
+        if (connection.socket.isConnected()) {
+
+            connection.hasReceivedHeartbeatResponse = false;
+            connection.heartbeatSentTicks = juce::Time::getHighResolutionTicks();
+
+            std::string s = std::string(CommandHeartbeat) + CommandDelimiter;
+            connection.socket.write(s.c_str(), (int)s.length());
+            connection.listener.connectionHeartbeatSent();
+
+            // close() notifies, so this never holds it up for the rest of the second
+            wait(1000);
+            if (threadShouldExit()) break;
+
+            if (!connection.hasReceivedHeartbeatResponse) {
+                connection.listener.connectionHeartbeatLost();
+                break;
+            }
+
+        }
+        else {
+            wait(10);
+        }
+    }
+
+}
@@ -0,0 +1,224 @@
+//
+//  ObviousConnection.h
+//  Obvious
+//
+//  The TCP connection to Obvious.lua, with its reader and heartbeat threads,
+//  the optional UDP path for continuous values, and the shared-memory ring
+//  used for commands when OBS is on this machine.
+//
+//  connect() never blocks: a connect thread moves the connection from
+//  Idle through Connecting to Connected, and into BackingOff (retrying at
+//  growing intervals) when OBS cannot be reached within the timeout.
+//  Commands written before it is Connected are queued, with a newer value
+//  for the same target replacing the queued one, or dropped, by policy.
+//
+
+#ifndef ObviousConnection_h
+#define ObviousConnection_h
+
+#include <atomic>
+#include <deque>
+#include <string>
+
+#include <juce_core/juce_core.h>
+
+#include "ObviousSharedRing.h"
+#include "ObviousStats.h"
+
+class ObviousConnection
+{
+public:
+
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+
+        // Called on the reader thread for every message received
+        virtual void connectionMessageReceived(const std::string &message) = 0;
+
+        // Called on the heartbeat thread when OBS stops answering
+        virtual void connectionHeartbeatLost() = 0;
+
+        // Called on the heartbeat thread after each heartbeat is written (once a second)
+        virtual void connectionHeartbeatSent() {}
+
+        // Called on the connect thread after each successful connect. What it returns is
+        // written before anything that was queued.
+        virtual std::string connectionGreeting() { return {}; }
+
+        // Called on the connect thread after requestConnect(); the listener calls connect() with its target
+        virtual void connectionRequested() {}
+    };
+
+    enum class State
+    {
+        Idle,           // closed, or never connected
+        Connecting,     // the connect thread is waiting for OBS
+        Connected,
+        BackingOff      // the last attempt failed; the next one is scheduled
+    };
+
+    // What write() does with a command while the connection is not Connected
+    enum class PendingPolicy
+    {
+        Queue,
+        Drop
+    };
+
+    static constexpr int defaultTimeoutMilliseconds = 2000;
+    static constexpr size_t maxPending = 256;
+
+    // How long close() waits for the reader and heartbeat threads to finish
+    static constexpr int threadStopTimeoutMilliseconds = 2000;
+
+    ObviousConnection(Listener &listener, ObviousStats &stats);
+    ~ObviousConnection();
+
+    // Starts connecting on the connect thread and returns immediately
+    void connect(const juce::String &ip, int port, int timeoutMilliseconds = defaultTimeoutMilliseconds);
+
+    // Stops the reader and heartbeat threads and closes the socket. Safe from the listener's callbacks.
+    void close();
+
+    // Only sets a flag the connect thread polls, so safe from the audio thread
+    void requestConnect() { connectRequested.store(true, std::memory_order_release); }
+
+    // Closes and stops the connect thread; the listener is not called once this returns
+    void shutdown();
+
+    State getState() const { return state.load(std::memory_order_acquire); }
+    bool isConnected() const { return getState() == State::Connected; }
+    bool needsConnecting() const { return getState() == State::Idle; }
+
+    void setPendingPolicy(PendingPolicy policy) { pendingPolicy = policy; }
+
+    // Writes one command, or queues or drops it when not Connected. Returns the socket's
+    // result, 0 when queued and -1 when dropped.
+    int write(const std::string &message);
+
+    // Sends one datagram to the address of the last connect(). Never blocks on OBS.
+    int writeDatagram(const std::string &message);
+
+    // Puts one command in the shared-memory ring. False when the ring is not in use or cannot take it,
+    // and until OBS has applied the last command written to the socket, which the ring must not overtake.
+    bool writeShared(uint32_t sender, const std::string &message);
+    bool isUsingSharedRing() const { return sharedRing.isOpen(); }
+
+    void heartbeatResponseReceived();
+
+    // Splits a chunk read from the socket into messages for the listener. A message cut off at
+    // the end of the chunk is kept and completed by the next one.
+    void handleIncomingData(const char *data, int length);
+
+private:
+
+    Listener &listener;
+    ObviousStats &stats;
+    juce::StreamingSocket socket = juce::StreamingSocket();
+    juce::DatagramSocket datagramSocket { false };
+    juce::String datagramHost;
+    int datagramPort = 0;
+    juce::SpinLock datagramAddressLock;
+    ObviousSharedRing sharedRing;
+
+    // The ring's consumerTicks right after the last command written to the socket
+    std::atomic<uint64_t> socketWriteTicks { 0 };
+    std::atomic<State> state { State::Idle };
+    std::atomic<PendingPolicy> pendingPolicy { PendingPolicy::Queue };
+
+    // The target of the current connect() and its generation, which close() and connect() advance
+    // so an attempt that finishes after them is discarded
+    juce::CriticalSection connectLock;
+    juce::String targetHost;
+    int targetPort = 0;
+    std::atomic<int> timeoutMilliseconds { defaultTimeoutMilliseconds };
+    uint64_t generation = 0;
+
+    // Set by the first attempt that succeeds, so each later one counts as a reconnect
+    bool hasConnected = false;
+
+    std::deque<std::string> pending;
+    juce::SpinLock pendingLock;
+
+    std::atomic<bool> connectRequested { false };
+
+    int writeToSocket(const std::string &message);
+    bool holdPending(const std::string &message);
+    bool nextAttempt(juce::String &host, int &port, uint64_t &attemptGeneration);
+    void attemptFinished(const juce::String &host, int port, uint64_t attemptGeneration, bool succeeded);
+    std::atomic<bool> hasReceivedHeartbeatResponse { false };
+    std::atomic<juce::int64> heartbeatSentTicks { 0 };
+
+    // The bytes after the last CommandDelimiter read so far; only the reader thread touches it
+    std::string partialMessage;
+    static constexpr size_t maxPartialMessage = 1 << 20;
+
+    class ObviousThread : public juce::Thread
+        {
+        public:
+            ObviousThread(ObviousConnection &c) : juce::Thread ("ObviousThread"), connection(c) {}
+
+            ObviousConnection& connection;
+
+            void run() override
+            {
+                // Started once per connection, so nothing left from the last one is completed by this one
+                connection.partialMessage.clear();
+
+                while (!threadShouldExit()) {
+
+                    if (connection.socket.isConnected()) {
+
+                        char buffer[1024];
+                        int n = connection.socket.read(buffer, 1024, false);
+                        if (n > 0) {
+                            connection.handleIncomingData(buffer, n);
+                        }
+
+                    }
+
+                    wait(10);
+                }
+            }
+        };
+
+    ObviousThread clientThread;
+
+    class HeartbeatThread : public juce::Thread
+        {
+        public:
+            HeartbeatThread(ObviousConnection &c) : juce::Thread ("HeartbeatThread"), connection(c) {}
+
+            ObviousConnection& connection;
+
+            void run() override;
+        };
+
+    HeartbeatThread heartbeatThread;
+
+    class ConnectThread : public juce::Thread
+        {
+        public:
+            ConnectThread(ObviousConnection &c) : juce::Thread ("ObviousConnectThread"), connection(c) {}
+
+            ObviousConnection& connection;
+
+            static constexpr int initialBackoffMilliseconds = 250;
+            static constexpr int maxBackoffMilliseconds = 5000;
+
+            // How often an idle connect thread looks for requestConnect()
+            static constexpr int requestPollMilliseconds = 20;
+
+            void run() override;
+        };
+
+    ConnectThread connectThread;
+
+    // Waits for the thread to finish, unless it is the one calling
+    static void stopThreadUnlessCurrent(juce::Thread &thread);
+
+    JUCE_DECLARE_NON_COPYABLE (ObviousConnection)
+};
+
+#endif /* ObviousConnection_h */
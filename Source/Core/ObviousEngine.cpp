@@ -0,0 +1,1166 @@
+//
+//  ObviousEngine.cpp
+//  Obvious
+//
+
+#include "ObviousEngine.h"
+
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+// Commands whose current value Obvious.lua can read back
+bool isReadable(int command) {
+
+    switch (command) {
+        case PositionProportionateX: case PositionProportionateY:
+        case ScaleX: case ScaleY: case Rotation:
+        case BoundsWidth: case BoundsHeight:
+        case MediaCursor:
+        case Hue: case Saturation: case RollSpeedH: case RollSpeedV: case Opacity:
+        case CropTop: case CropBottom: case CropLeft: case CropRight:
+        case SetVisible:
+            return true;
+        default:
+            return false;
+    }
+
+}
+
+// Receivers from before a request reply that they do not know it; there is nothing to tell the user
+bool isUnsupportedRequest(const std::string &error) {
+
+    for (const char *request : { CommandStatsSubscribe, CommandCatalogueSubscribe, CommandValueQuery, CommandValueSubscribe }) {
+        if (error == "Unknown command ID (" + std::string(request) + ")") return true;
+    }
+    return false;
+
+}
+
+}
+
+ObviousEngine::ObviousEngine(juce::ValueTree &s)
+    : instanceID(ObviousTrace::nextInstanceID()),
+      senderID((uint32_t)juce::Random::getSystemRandom().nextInt(std::numeric_limits<int>::max())),
+      state(s),
+      connection(*this, stats),
+      sendThread(*this)
+{
+
+    ObviousTrace::openFromEnvironment();
+
+    state.addListener(this);
+    updateModes();
+    updateBandTargets();
+    updateLFOTarget();
+
+    sendThread.startThread();
+
+}
+
+ObviousEngine::~ObviousEngine() {
+
+    sendThread.stopThread(1000);
+    state.removeListener(this);
+
+    // The connect thread calls back into this engine, so it is stopped before any member goes
+    connection.shutdown();
+    close();
+
+}
+
+juce::ValueTree ObviousEngine::settings() {
+    return state.getOrCreateChildWithName (ParameterIDSettingsStorage, nullptr);
+}
+
+float ObviousEngine::translateSliderValue(float rawValue) {
+    auto settingsStorage = settings();
+    float rangeLower = settingsStorage.getProperty (ParameterIDRangeLower, 0.0f);
+    float rangeUpper = settingsStorage.getProperty (ParameterIDRangeUpper, 1.0f);
+    float value = ((rangeUpper-rangeLower)*rawValue)+rangeLower;
+    return value;
+}
+
+void ObviousEngine::report(const juce::String &title, const juce::String &message) {
+
+    if (listener != nullptr) {
+        listener->engineMessage(title, message);
+    }
+
+}
+
+void ObviousEngine::send(const juce::String &parameterID, float value) {
+
+    // The input's envelope drives the value instead
+    if (parameterID == ParameterIDValue && isAudioReactive()) {
+        stats.sendSuppressed();
+        return;
+    }
+
+    sendParameter(parameterID, value, false);
+
+}
+
+void ObviousEngine::publishLevel(float level) {
+
+    publishedLevel.store(level, std::memory_order_relaxed);
+    levelPending.store(true, std::memory_order_release);
+
+}
+
+void ObviousEngine::updateModes() {
+
+    auto settingsStorage = settings();
+    const int command = settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault);
+    const int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
+    const Command &selectedCommand = CommandTable::withID(command);
+    const bool commandSelected = category != CommandCategoryTypeText && selectedCommand.category == category;
+
+    const bool reactive = settingsStorage.getProperty(ParameterIDAudioReactive, false);
+    const bool bands = (int)settingsStorage.getProperty(ParameterIDAudioMode, AudioModeDefault) == AudioModeBands;
+
+    audioReactive = reactive && !bands && commandSelected && selectedCommand.triggerParameterID == ParameterIDValue;
+    analysingSpectrum = reactive && bands;
+    onsetDetection = (bool)settingsStorage.getProperty(ParameterIDOnset, false)
+                     && commandSelected && selectedCommand.triggerParameterID == ParameterIDTrigger;
+    followingTransport = (bool)settingsStorage.getProperty(ParameterIDFollowTransport, false)
+                         && command == MediaCursor && category == CommandCategorySource;
+    lfoEnabled = (bool)settingsStorage.getProperty(ParameterIDLFO, false) && commandSelected && CommandTable::isContinuous(command);
+    batchingTransforms = (bool)settingsStorage.getProperty(ParameterIDBatchTransform, false) && commandSelected && ObviousTransformBatch::isField(command);
+
+}
+
+void ObviousEngine::valueTreePropertyChanged(juce::ValueTree &tree, const juce::Identifier &property) {
+
+    // Only the properties the modes depend on; others (the cursor) can be set from the audio thread
+    if (tree.getParent() == state) {
+        const juce::String name = property.toString();
+        if (name == ParameterIDCommand || name == ParameterIDCommandCategory || name == ParameterIDAudioReactive
+            || name == ParameterIDAudioMode || name == ParameterIDOnset || name == ParameterIDFollowTransport || name == ParameterIDLFO
+            || name == ParameterIDBatchTransform) {
+            updateModes();
+        }
+        if (name == ParameterIDCommand || name == ParameterIDCommandCategory || name == ParameterIDLFO || name == ParameterIDLFOWaveform
+            || name == ParameterIDLFOBeats || name == ParameterIDLFODepth || name == ParameterIDLFOOffset || name == ParameterIDLFOPhase
+            || name == ParameterIDRangeLower || name == ParameterIDRangeUpper || name == ParameterIDScene || name == ParameterIDSource
+            || name == ParameterIDFilter) {
+            updateLFOTarget();
+        }
+    }
+    // A property of one band
+    else if (tree.getParent().getType().toString() == ParameterIDSpectrumBands) {
+        updateBandTargets();
+    }
+
+}
+
+void ObviousEngine::valueTreeChildAdded(juce::ValueTree &parent, juce::ValueTree &child) {
+
+    juce::ignoreUnused(child);
+    childrenChanged(parent);
+
+}
+
+void ObviousEngine::valueTreeChildRemoved(juce::ValueTree &parent, juce::ValueTree &child, int index) {
+
+    juce::ignoreUnused(child, index);
+    childrenChanged(parent);
+
+}
+
+void ObviousEngine::childrenChanged(juce::ValueTree &parent) {
+
+    // The settings themselves, the bands in them, or one band
+    if (parent == state) {
+        updateModes();
+        updateBandTargets();
+        updateLFOTarget();
+    }
+    else if (parent.getParent() == state || parent.getType().toString() == ParameterIDSpectrumBands) {
+        updateBandTargets();
+    }
+
+}
+
+void ObviousEngine::valueTreeRedirected(juce::ValueTree &tree) {
+
+    juce::ignoreUnused(tree);
+    updateModes();
+    updateBandTargets();
+    updateLFOTarget();
+
+}
+
+void ObviousEngine::SendThread::run() {
+
+    while (!threadShouldExit()) {
+
+        if (engine.levelPending.exchange(false, std::memory_order_acquire)) {
+            engine.sendParameter(ParameterIDValue, engine.publishedLevel.load(std::memory_order_relaxed), false);
+        }
+
+        if (engine.bandsPending.exchange(false, std::memory_order_acquire)) {
+            engine.sendBands();
+        }
+
+        if (engine.transportPending.exchange(false, std::memory_order_acquire)) {
+            const bool playing = engine.publishedPlaying.load(std::memory_order_relaxed);
+            double seconds = engine.publishedSeconds.load(std::memory_order_relaxed);
+            // Moved on by the time since the audio thread saw it
+            if (playing) seconds += (juce::Time::getMillisecondCounterHiRes() - engine.publishedAtMs.load(std::memory_order_relaxed)) / 1000.0;
+            engine.followTransport(playing, seconds);
+        }
+
+        if (engine.tempoPending.exchange(false, std::memory_order_acquire)) {
+            const bool playing = engine.publishedTempoPlaying.load(std::memory_order_relaxed);
+            const double bpm = engine.publishedBpm.load(std::memory_order_relaxed);
+            double beat = engine.publishedBeat.load(std::memory_order_relaxed);
+            if (playing) beat += (juce::Time::getMillisecondCounterHiRes() - engine.publishedTempoAtMs.load(std::memory_order_relaxed)) / 60000.0 * bpm;
+            engine.followTempo(playing, bpm, beat);
+        }
+
+        const uint32_t onsets = engine.publishedOnsets.load(std::memory_order_acquire);
+        if (onsets != engine.firedOnsets) {
+            // Counted down by the time since the audio thread saw it
+            const double delayMs = engine.publishedOnsetDelayMs.load(std::memory_order_relaxed)
+                                   - (juce::Time::getMillisecondCounterHiRes() - engine.publishedOnsetAtMs.load(std::memory_order_relaxed));
+            engine.sendOnset(delayMs, onsets - engine.firedOnsets);
+            engine.firedOnsets = onsets;
+        }
+
+        // Closed by any engine on this OBS
+        if (auto batch = engine.transformBatch()) {
+            if (batch->hasClosed()) engine.flushTransforms();
+        }
+
+        const bool active = engine.isAudioReactive() || engine.isAnalysingSpectrum() || engine.detectsOnsets()
+                            || engine.isFollowingTransport() || engine.followsTempo() || engine.batchingTransforms.load(std::memory_order_relaxed);
+        wait(active ? activePollMilliseconds : idlePollMilliseconds);
+
+    }
+
+}
+
+void ObviousEngine::publishOnset(double delayMs) {
+
+    publishedOnsetDelayMs.store(delayMs, std::memory_order_relaxed);
+    publishedOnsetAtMs.store(juce::Time::getMillisecondCounterHiRes(), std::memory_order_relaxed);
+    publishedOnsets.store(publishedOnsets.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+}
+
+void ObviousEngine::sendOnset(double delayMs, uint32_t count) {
+
+    auto settingsStorage = settings();
+    const Command &selectedCommand = CommandTable::withID(settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault));
+
+    // Onsets closer together than the send thread looks fire once, a toggle ending where all of them would leave it
+    float value = 1.0f;
+    if (selectedCommand.requiresToggleButton) {
+        if (count % 2 == 1) onsetToggleState = !onsetToggleState;
+        value = onsetToggleState ? 1.0f : 0.0f;
+    }
+
+    // The trigger reaches OBS half a round trip after it is sent
+    delayMs = juce::jmax(0.0, delayMs - stats.smoothedRoundTrip() / 2.0);
+
+    sendCommand(selectedCommand.commandID, value, Delivery::Scheduled, delayMs);
+
+}
+
+void ObviousEngine::publishBands(const float *levels, int numLevels) {
+
+    const int numBands = juce::jmin(numLevels, (int)publishedBands.size());
+    for (int index = 0; index < numBands; ++index) {
+        publishedBands[(size_t)index].store(levels[index], std::memory_order_relaxed);
+    }
+
+    bandsPending.store(true, std::memory_order_release);
+
+}
+
+void ObviousEngine::updateBandTargets() {
+
+    auto targets = std::make_shared<BandTargets>();
+    auto bands = settings().getChildWithName(ParameterIDSpectrumBands);
+    const int numBands = juce::jmin(bands.getNumChildren(), (int)targets->size());
+
+    for (int index = 0; index < numBands; ++index) {
+
+        auto band = bands.getChild(index);
+        BandTarget &target = (*targets)[(size_t)index];
+
+        const int command = band.getProperty(ParameterIDCommand, 0);
+        if (!CommandTable::isContinuous(command)) continue;
+
+        const bool needsFilter = CommandTable::withID(command).category == CommandCategoryFilter;
+        target.scene = band.getProperty(ParameterIDScene, juce::String()).toString().toStdString();
+        target.source = band.getProperty(ParameterIDSource, juce::String()).toString().toStdString();
+        if (needsFilter) target.filter = band.getProperty(ParameterIDFilter, juce::String()).toString().toStdString();
+        if (target.scene.empty() || target.source.empty() || (needsFilter && target.filter.empty())) continue;
+
+        target.command = command;
+        target.rangeLower = band.getProperty(ParameterIDRangeLower, 0.0f);
+        target.rangeUpper = band.getProperty(ParameterIDRangeUpper, 1.0f);
+        target.traceHandle = ObviousTrace::targetHandle(target.scene, target.source, target.filter);
+
+    }
+
+    std::shared_ptr<const BandTargets> previous;
+
+    {
+        const juce::SpinLock::ScopedLockType lock(bandTargetsLock);
+        previous = std::move(bandTargets);
+        bandTargets = std::move(targets);
+    }
+
+    // A band whose target changed is sent again even if its level has not moved
+    bandsResync = true;
+
+}
+
+void ObviousEngine::sendBands() {
+
+    if (!sendEnabled) {
+        stats.sendSuppressed();
+        return;
+    }
+
+    std::shared_ptr<const BandTargets> targets;
+
+    {
+        const juce::SpinLock::ScopedLockType lock(bandTargetsLock);
+        targets = bandTargets;
+    }
+
+    if (targets == nullptr) return;
+
+    if (bandsResync.exchange(false)) sentBandValues.fill(std::numeric_limits<float>::quiet_NaN());
+
+    std::array<float, SpectrumBandCount> values {};
+    std::array<bool, SpectrumBandCount> sent {};
+    std::string records;
+
+    for (size_t index = 0; index < targets->size(); ++index) {
+
+        const BandTarget &target = (*targets)[index];
+        if (target.command == 0) continue;
+
+        const float level = publishedBands[index].load(std::memory_order_relaxed);
+        const float value = target.rangeLower + (target.rangeUpper - target.rangeLower) * level;
+
+        if (value == sentBandValues[index] || !checkTarget(target.scene, target.source, target.filter)) continue;
+        sentBandValues[index] = value;
+        values[index] = value;
+        sent[index] = true;
+
+        if (!records.empty()) records += ValuesRecordDelimiter;
+        records += ObviousProtocol::encodeValueRecord(target.command, target.scene, target.source, target.filter, value);
+
+    }
+
+    if (records.empty()) return;
+
+    const std::string message = ObviousProtocol::encodeValues(records);
+    int bytesWritten = (int)message.size();
+    if (!connection.writeShared(senderID, message)) bytesWritten = writeMessage(message);
+
+    // One record per band, as for batched transforms; the message's bytes are counted on the first
+    if (ObviousTrace::isOpen()) {
+        for (size_t index = 0; index < targets->size(); ++index) {
+            if (!sent[index]) continue;
+            ObviousTrace::record(instanceID, samplePosition.load(std::memory_order_relaxed), (*targets)[index].command,
+                                 (*targets)[index].traceHandle, values[index], bytesWritten);
+            bytesWritten = 0;
+        }
+    }
+
+}
+
+void ObviousEngine::sendParameter(const juce::String &parameterID, float value, bool reliable) {
+
+    const float previousRawValue = lastRawValue.load();
+
+    if (parameterID == ParameterIDValue) {
+        lastRawValue = value;
+    }
+
+    if (!sendEnabled) {
+        stats.sendSuppressed();
+        return;
+    }
+
+    auto settingsStorage = settings();
+    int commandID = settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault);
+    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
+    const Command &selectedCommand = CommandTable::withID(commandID);
+
+    if (category == CommandCategoryTypeText) {
+
+        if (parameterID == ParameterIDValue) commandID = TypeSetNumChars;
+        else if (parameterID == ParameterIDTrigger) commandID = TypeSetCursorVisible;
+
+    }
+    else if (commandID == 0 || selectedCommand.category != category) {
+        stats.sendSuppressed();
+        report("Error", "No command type selected");
+        return;
+    }
+
+    if (parameterID != selectedCommand.triggerParameterID && category != CommandCategoryTypeText) {
+        stats.sendSuppressed();
+        return;
+    }
+
+    // The host's transport drives the cursor instead
+    if (commandID == MediaCursor && (bool)settingsStorage.getProperty(ParameterIDFollowTransport, false)) {
+        stats.sendSuppressed();
+        return;
+    }
+
+    // OBS generates the value itself
+    if (parameterID == ParameterIDValue && isRunningLFO()) {
+        stats.sendSuppressed();
+        return;
+    }
+
+    if (parameterID == ParameterIDValue) {
+        value = translateSliderValue(value);
+        translatedValue.store(value, std::memory_order_relaxed);
+        if (listener != nullptr) listener->engineValueTranslated(value);
+    }
+
+    // Only the value parameter is continuous; triggers, text and everything else stay on TCP
+    Delivery delivery = Delivery::Stream;
+    if (parameterID == ParameterIDValue && (bool)settingsStorage.getProperty(ParameterIDUDP, false)) {
+        delivery = reliable ? Delivery::SequencedStream : Delivery::Datagram;
+    }
+
+    // Changes must all arrive, so they never go over UDP; a resent final value is no change at all
+    if (parameterID == ParameterIDValue && category != CommandCategoryTypeText
+        && (bool)settingsStorage.getProperty(ParameterIDRelative, false) && CommandTable::isContinuous(commandID)) {
+
+        value -= translateSliderValue(previousRawValue);
+        if (value == 0.0f) {
+            stats.sendSuppressed();
+            return;
+        }
+        delivery = Delivery::Relative;
+
+    }
+    // Instances driving fields of one item are sent together; see ObviousTransformBatch
+    else if (parameterID == ParameterIDValue && (bool)settingsStorage.getProperty(ParameterIDBatchTransform, false)
+             && ObviousTransformBatch::isField(commandID)) {
+        delivery = Delivery::Batched;
+    }
+
+    sendCommand(commandID, value, delivery);
+
+}
+
+void ObviousEngine::send(int command, float value) {
+
+    sendCommand(command, value, Delivery::Stream);
+
+}
+
+void ObviousEngine::sendCommand(int command, float value, Delivery delivery, double delayMs) {
+
+    if (!sendEnabled) {
+        stats.sendSuppressed();
+        return;
+    }
+
+    auto settingsStorage = settings();
+
+    juce::String scene = settingsStorage.getProperty (ParameterIDScene, juce::String());
+    if (scene.length() < 1) {
+        stats.sendSuppressed();
+        report("Error", "No scene specified");
+        return;
+    }
+
+    juce::String source = settingsStorage.getProperty (ParameterIDSource, juce::String());
+    if (source.length() < 1) {
+        stats.sendSuppressed();
+        report("Error", "No source specified");
+        return;
+    }
+
+    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
+
+    std::string filter;
+    std::string payload;
+
+    if (category == CommandCategoryFilter) {
+
+        filter = settingsStorage.getProperty (ParameterIDFilter, juce::String()).toString().toStdString();
+        if (filter.empty()) {
+            stats.sendSuppressed();
+            report("Error", "No filter specified");
+            return;
+        }
+
+        payload = ObviousProtocol::encodeValue(value);
+
+    }
+    else if (category == CommandCategoryTypeText && command != TypeSetNumChars && command != TypeSetCursorVisible) {
+
+        if (command == TypeText) {
+            payload = settingsStorage.getProperty(ParameterIDTypeTextText, juce::String()).toString().toStdString();
+        }
+        else if (command == TypeSetCursorCharacter) {
+            payload = settingsStorage.getProperty(ParameterIDTypeTextCursorCharacter, juce::String()).toString().toStdString();
+        }
+        else if (command == TypeSetState) {
+            payload = typeTextStatePayload(settingsStorage);
+        }
+
+    }
+    else {
+        payload = ObviousProtocol::encodeValue(value);
+    }
+
+    const std::string sceneString = scene.toStdString();
+    const std::string sourceString = source.toStdString();
+
+    if (!checkTarget(sceneString, sourceString, filter)) {
+        stats.sendSuppressed();
+        return;
+    }
+
+    std::string message = ObviousProtocol::encode(command, sceneString, sourceString, filter, payload);
+    if (delivery == Delivery::Relative) message = ObviousProtocol::encodeRelative(message);
+    else if (delivery == Delivery::Scheduled) message = ObviousProtocol::encodeScheduled(delayMs, message);
+
+    int bytesWritten;
+    auto batch = delivery == Delivery::Batched ? transformBatch() : nullptr;
+
+    if (batch != nullptr) {
+        batch->set(sceneString, sourceString, command, value);
+        bytesWritten = 0;
+    }
+    // The ring is ordered and lossless, so values in it need neither sequencing nor a resend
+    else if (connection.writeShared(senderID, message)) {
+        bytesWritten = (int)message.size();
+    }
+    else if (delivery == Delivery::Stream || delivery == Delivery::Relative || delivery == Delivery::Batched || delivery == Delivery::Scheduled) {
+        bytesWritten = writeMessage(message);
+    }
+    else {
+
+        message = ObviousProtocol::encodeSequenced(senderID, ++sequence, message);
+
+        if (delivery == Delivery::Datagram) {
+            bytesWritten = writeDatagram(message);
+            finalValuePending = true;
+        }
+        else {
+            bytesWritten = writeMessage(message);
+            stats.finalValueResent();
+        }
+
+    }
+
+    if (ObviousTrace::isOpen()) {
+        ObviousTrace::record(instanceID, samplePosition.load(std::memory_order_relaxed), command,
+                             ObviousTrace::targetHandle(sceneString, sourceString, filter), value, bytesWritten);
+    }
+
+}
+
+bool ObviousEngine::checkTarget(const std::string &scene, const std::string &source, const std::string &filter) {
+
+    auto targets = catalogue();
+    if (targets == nullptr) return true;
+
+    auto name = [](const std::string &utf8) { return "'" + juce::String::fromUTF8(utf8.c_str()) + "'"; };
+
+    // Worded as Obvious.lua words the errors it would have sent back
+    switch (targets->check(scene, source, filter)) {
+        case ObviousCatalogue::Check::MissingScene:
+            report("Error", "Could not find scene named " + name(scene));
+            return false;
+        case ObviousCatalogue::Check::MissingSource:
+            report("Error", "Could not find source named " + name(source) + " in scene named " + name(scene));
+            return false;
+        case ObviousCatalogue::Check::MissingFilter:
+            report("Error", "No filter named " + name(filter) + " was found on source named " + name(source) + " in scene named " + name(scene));
+            return false;
+        case ObviousCatalogue::Check::Unknown:
+        case ObviousCatalogue::Check::Found:
+            break;
+    }
+
+    return true;
+
+}
+
+int ObviousEngine::writeMessage(const std::string &message) {
+
+    // The connect thread looks up the target and connects; until then the message is queued or dropped
+    if (connection.needsConnecting()) {
+        connection.requestConnect();
+    }
+
+    return connection.write(message);
+
+}
+
+int ObviousEngine::writeDatagram(const std::string &message) {
+
+    // The TCP connection carries the registration and heartbeat, and answers errors for these values
+    if (connection.needsConnecting()) {
+        connection.requestConnect();
+    }
+
+    return connection.writeDatagram(message);
+
+}
+
+void ObviousEngine::gestureEnded(const juce::String &parameterID) {
+
+    if (parameterID == ParameterIDValue) {
+        resendFinalValue();
+    }
+
+}
+
+void ObviousEngine::resendFinalValue() {
+
+    if (finalValuePending.exchange(false)) {
+        sendParameter(ParameterIDValue, lastRawValue.load(), true);
+    }
+
+}
+
+void ObviousEngine::connect() {
+
+    auto settingsStorage = settings();
+
+    juce::String ip = settingsStorage.getProperty (ParameterIDIP, juce::String("127.0.0.1"));
+    int port = settingsStorage.getProperty (ParameterIDPort, juce::String("11111"));
+    int timeout = settingsStorage.getProperty (ParameterIDConnectTimeout, ObviousConnection::defaultTimeoutMilliseconds);
+    bool queue = settingsStorage.getProperty (ParameterIDQueueWhileConnecting, true);
+
+    // Engines connected to the same OBS share one catalogue and one transform batch
+    auto targets = ObviousCatalogue::forEndpoint(ip, port);
+    auto batch = ObviousTransformBatch::forEndpoint(ip, port);
+    std::shared_ptr<ObviousCatalogue> previous;
+
+    {
+        const juce::SpinLock::ScopedLockType lock(endpointLock);
+        if (endpointCatalogue != targets) {
+            previous = std::move(endpointCatalogue);
+            endpointCatalogue = std::move(targets);
+        }
+        endpointBatch = std::move(batch);
+    }
+
+    if (previous != nullptr) previous->releaseFeeder(this);
+
+    connection.setPendingPolicy(queue ? ObviousConnection::PendingPolicy::Queue : ObviousConnection::PendingPolicy::Drop);
+    connection.connect(ip, port, timeout);
+
+}
+
+ObviousConnection::State ObviousEngine::connectionState() const {
+
+    return connection.getState();
+
+}
+
+std::shared_ptr<ObviousCatalogue> ObviousEngine::catalogue() const {
+
+    const juce::SpinLock::ScopedLockType lock(endpointLock);
+    return endpointCatalogue;
+
+}
+
+std::shared_ptr<ObviousTransformBatch> ObviousEngine::transformBatch() const {
+
+    const juce::SpinLock::ScopedLockType lock(endpointLock);
+    return endpointBatch;
+
+}
+
+void ObviousEngine::endTransformBlock() {
+
+    if (auto batch = transformBatch()) batch->close();
+
+}
+
+void ObviousEngine::flushTransforms() {
+
+    auto batch = transformBatch();
+    if (batch == nullptr || !batch->hasClosed()) return;
+
+    for (const auto &message : batch->take()) {
+        if (!connection.writeShared(senderID, message)) writeMessage(message);
+    }
+
+}
+
+void ObviousEngine::close() {
+
+    connection.close();
+
+    {
+        const juce::SpinLock::ScopedLockType lock(requestLock);
+        requestedTarget.clear();
+    }
+
+    // Another engine on the same OBS takes over feeding the catalogue
+    if (auto targets = catalogue()) targets->releaseFeeder(this);
+
+}
+
+void ObviousEngine::connectionMessageReceived(const std::string &message) {
+
+    clientMessageReceived(message);
+
+}
+
+void ObviousEngine::clientMessageReceived(std::string message) {
+
+    std::stringstream stringStream(message);
+    std::string segment;
+    std::vector<std::string> seglist;
+
+    while(std::getline(stringStream, segment, CommandChunkDelimiter))
+    {
+       seglist.push_back(segment);
+    }
+
+    // A message whose first chunk is not a whole number is not one this plugin knows
+    int responseCode = 0;
+    bool hasCode = false;
+
+    if (seglist.size() == 2) {
+        const char *first = seglist[0].data();
+        const char *last = first + seglist[0].size();
+        const auto parsed = std::from_chars(first, last, responseCode);
+        hasCode = parsed.ec == std::errc() && parsed.ptr == last;
+    }
+
+    if (hasCode) {
+
+        if (responseCode == HeartbeatResponse) {
+            connection.heartbeatResponseReceived();
+        }
+        else if (responseCode == ResponseCodeRequestTypeState) {
+            sendTypeTextState();
+        }
+        // Obvious.lua from before TypeSetState asks for one piece at a time
+        else if (responseCode == ResponseCodeRequestTypeText) {
+            send(TypeText, 0.0f);
+        }
+        else if (responseCode == ResponseCodeRequestTypeNumChars) {
+            sendParameter(ParameterIDValue, lastRawValue.load(), true);
+        }
+        else if (responseCode == ResponseCodeRequestTypeCursorChar) {
+            send(TypeSetCursorCharacter, 0.0f);
+        }
+        else if (responseCode == ResponseCodeStats) {
+            stats.obsReported(seglist[1]);
+        }
+        else if (responseCode == ResponseCodeValue) {
+            valueReceived(seglist[1]);
+        }
+        else if (responseCode == ResponseCodeCatalogueBegin || responseCode == ResponseCodeCatalogueAdd
+                 || responseCode == ResponseCodeCatalogueRemove || responseCode == ResponseCodeCatalogueEnd) {
+            catalogueMessageReceived(responseCode, seglist[1]);
+        }
+        else if (responseCode == ResponseCodeError && isUnsupportedRequest(seglist[1])) {
+            // No stats, catalogue or read-back from this receiver; everything else works as before
+        }
+        else if (responseCode == ResponseCodeRequestTypeCursorVisible) {
+            float visibleValue = 0.0f;
+            juce::ValueTree settingsStorage = settings();
+            if (settingsStorage.getProperty(ParameterIDTypeTextCursorVisible, false)) visibleValue = 1.0f;
+            send(TypeSetCursorVisible, visibleValue);
+        }
+        else {
+            report("Error", message);
+        }
+
+    }
+    else {
+        stats.protocolError();
+        report("Error", message);
+    }
+
+}
+
+void ObviousEngine::catalogueMessageReceived(int responseCode, const std::string &payload) {
+
+    auto targets = catalogue();
+    if (targets == nullptr || !targets->isFeeder(this)) return;
+
+    if (responseCode == ResponseCodeCatalogueBegin) targets->beginSnapshot();
+    else if (responseCode == ResponseCodeCatalogueEnd) targets->endSnapshot();
+    else targets->apply(responseCode == ResponseCodeCatalogueAdd, payload);
+
+}
+
+void ObviousEngine::sendTypeTextState() {
+
+    if ((int)settings().getProperty(ParameterIDCommandCategory, CommandCategoryDefault) != CommandCategoryTypeText) return;
+
+    send(TypeSetState, 0.0f);
+
+}
+
+std::string ObviousEngine::typeTextStatePayload(const juce::ValueTree &settingsStorage) {
+
+    const float numChars = translateSliderValue(lastRawValue.load());
+    const bool cursorVisible = settingsStorage.getProperty(ParameterIDTypeTextCursorVisible, false);
+    const std::string cursorCharacter = settingsStorage.getProperty(ParameterIDTypeTextCursorCharacter, juce::String()).toString().toStdString();
+    const std::string text = settingsStorage.getProperty(ParameterIDTypeTextText, juce::String()).toString().toStdString();
+
+    return ObviousProtocol::encodeTypeTextState(numChars, cursorVisible, cursorCharacter, text);
+
+}
+
+void ObviousEngine::requestValue() {
+
+    // Until connected, the greeting carries the request
+    if (!connection.isConnected()) return;
+
+    const std::string request = valueRequest();
+    if (!request.empty()) connection.write(request);
+
+}
+
+std::string ObviousEngine::valueRequest() {
+
+    auto settingsStorage = settings();
+    int command = settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault);
+    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
+    // Following the transport needs every media time OBS shows
+    const bool follow = (bool)settingsStorage.getProperty(ParameterIDFollowOBS, true)
+                        || (command == MediaCursor && (bool)settingsStorage.getProperty(ParameterIDFollowTransport, false));
+
+    const std::string scene = settingsStorage.getProperty(ParameterIDScene, juce::String()).toString().toStdString();
+    const std::string source = settingsStorage.getProperty(ParameterIDSource, juce::String()).toString().toStdString();
+    std::string filter;
+    if (category == CommandCategoryFilter) filter = settingsStorage.getProperty(ParameterIDFilter, juce::String()).toString().toStdString();
+
+    const bool readable = CommandTable::withID(command).category == category && isReadable(command)
+                          && !scene.empty() && !source.empty() && (category != CommandCategoryFilter || !filter.empty());
+
+    std::string target;
+    if (readable) {
+        target = std::string(follow ? "S" : "Q") + std::to_string(command) + CatalogueFieldDelimiter + scene
+                 + CatalogueFieldDelimiter + source + CatalogueFieldDelimiter + filter;
+    }
+
+    bool wasSubscribed;
+
+    {
+        const juce::SpinLock::ScopedLockType lock(requestLock);
+        if (target == requestedTarget) return {};
+        wasSubscribed = !requestedTarget.empty() && requestedTarget[0] == 'S';
+        requestedTarget = target;
+    }
+
+    // A subscription to command 0 ends the previous one
+    std::string request;
+    if (wasSubscribed && !(readable && follow)) {
+        request = ObviousProtocol::encode(std::atoi(CommandValueSubscribe), "", "", "", "0");
+    }
+
+    if (readable) {
+        request += ObviousProtocol::encode(std::atoi(follow ? CommandValueSubscribe : CommandValueQuery), scene, source, filter, std::to_string(command));
+    }
+
+    return request;
+
+}
+
+void ObviousEngine::valueReceived(const std::string &payload) {
+
+    const size_t valueStart = payload.rfind(CatalogueFieldDelimiter);
+    if (valueStart == std::string::npos) return;
+
+    // Answers for an earlier command or target are dropped
+    {
+        const juce::SpinLock::ScopedLockType lock(requestLock);
+        if (requestedTarget.empty() || requestedTarget.compare(1, std::string::npos, payload, 0, valueStart) != 0) return;
+    }
+
+    const Command &command = CommandTable::withID(std::atoi(payload.c_str()));
+    const float value = (float)std::atof(payload.c_str() + valueStart + 1);
+    float rawValue;
+
+    // Compared with the host's position on the audio thread; the parameter is not moved
+    if (command.commandID == MediaCursor && isFollowingTransport()) {
+        reportedMediaMs.store(value);
+        reportedAtMs.store(juce::Time::getMillisecondCounterHiRes());
+        return;
+    }
+
+    if (command.triggerParameterID == ParameterIDTrigger) {
+        rawValue = value >= 0.5f ? 1.0f : 0.0f;
+    }
+    else {
+
+        auto settingsStorage = settings();
+        float rangeLower = settingsStorage.getProperty (ParameterIDRangeLower, 0.0f);
+        float rangeUpper = settingsStorage.getProperty (ParameterIDRangeUpper, 1.0f);
+        if (rangeUpper == rangeLower) return;
+
+        rawValue = juce::jlimit(0.0f, 1.0f, (value - rangeLower) / (rangeUpper - rangeLower));
+        lastRawValue = rawValue;
+        translatedValue.store(translateSliderValue(rawValue), std::memory_order_relaxed);
+
+    }
+
+    if (listener != nullptr) {
+        listener->engineValueReceived(command.triggerParameterID, rawValue);
+    }
+
+}
+
+void ObviousEngine::publishTransport(bool playing, double seconds) {
+
+    publishedPlaying.store(playing, std::memory_order_relaxed);
+    publishedSeconds.store(seconds, std::memory_order_relaxed);
+    publishedAtMs.store(juce::Time::getMillisecondCounterHiRes(), std::memory_order_relaxed);
+    transportPending.store(true, std::memory_order_release);
+
+}
+
+void ObviousEngine::followTransport(bool playing, double seconds) {
+
+    const double nowMs = juce::Time::getMillisecondCounterHiRes();
+    const double hostMs = juce::jmax(0.0, seconds * 1000.0);
+    const double threshold = settings().getProperty(ParameterIDDriftThreshold, 80.0);
+
+    // Started, stopped, or newly connected: put OBS where the host is, in the same state
+    if (playing != transportPlaying || transportResync.exchange(false)) {
+        transportPlaying = playing;
+        seekMedia(hostMs, nowMs);
+        send(playing ? MediaPlay : MediaPause, 1.0f);
+        return;
+    }
+
+    // Moved while stopped
+    if (!playing) {
+        if (std::abs(hostMs - lastSeekMs) > threshold) seekMedia(hostMs, nowMs);
+        return;
+    }
+
+    // Reports from before a seek has taken effect, or none for a while (the media has ended), say nothing
+    static constexpr double seekSettleMs = 250.0;
+    static constexpr double reportStaleMs = 500.0;
+    const double reportedAt = reportedAtMs.load();
+    if (reportedAt < seekSentAtMs + seekSettleMs || nowMs - reportedAt > reportStaleMs) return;
+
+    // The media time OBS reported, moved on by the time since
+    const double mediaMs = reportedMediaMs.load() + (nowMs - reportedAt);
+    if (std::abs(hostMs - mediaMs) > threshold) seekMedia(hostMs, nowMs);
+
+}
+
+void ObviousEngine::seekMedia(double mediaMs, double nowMs) {
+
+    send(MediaCursor, (float)mediaMs);
+    lastSeekMs = mediaMs;
+    seekSentAtMs = nowMs;
+
+}
+
+void ObviousEngine::updateLFOTarget() {
+
+    auto target = std::make_shared<LFOTarget>();
+    ObviousProtocol::LFO &lfo = target->lfo;
+    std::string &scene = target->scene, &source = target->source, &filter = target->filter;
+
+    if (isRunningLFO()) {
+
+        auto settingsStorage = settings();
+
+        const int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
+        const float rangeLower = settingsStorage.getProperty(ParameterIDRangeLower, 0.0f);
+        const float rangeUpper = settingsStorage.getProperty(ParameterIDRangeUpper, 1.0f);
+        const float depth = juce::jlimit(0.0f, 1.0f, (float)settingsStorage.getProperty(ParameterIDLFODepth, 1.0f));
+        const float offset = juce::jlimit(0.0f, 1.0f, (float)settingsStorage.getProperty(ParameterIDLFOOffset, 0.5f));
+
+        lfo.command = settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault);
+        lfo.waveform = juce::jlimit((int)LFOWaveformSine, (int)LFOWaveformSquare, (int)settingsStorage.getProperty(ParameterIDLFOWaveform, LFOWaveformDefault));
+        lfo.beats = juce::jmax(1.0f / 64.0f, (float)settingsStorage.getProperty(ParameterIDLFOBeats, 1.0f));
+        lfo.phase = settingsStorage.getProperty(ParameterIDLFOPhase, 0.0f);
+        lfo.centre = translateSliderValue(offset);
+        lfo.amplitude = std::abs(rangeUpper - rangeLower) * depth / 2.0f;
+        lfo.lower = juce::jmin(rangeLower, rangeUpper);
+        lfo.upper = juce::jmax(rangeLower, rangeUpper);
+
+        scene = settingsStorage.getProperty(ParameterIDScene, juce::String()).toString().toStdString();
+        source = settingsStorage.getProperty(ParameterIDSource, juce::String()).toString().toStdString();
+        if (category == CommandCategoryFilter) filter = settingsStorage.getProperty(ParameterIDFilter, juce::String()).toString().toStdString();
+
+        // Nothing runs until the target is complete
+        if (scene.empty() || source.empty() || (category == CommandCategoryFilter && filter.empty())) lfo.waveform = 0;
+
+    }
+
+    std::shared_ptr<const LFOTarget> previous;
+
+    {
+        const juce::SpinLock::ScopedLockType lock(lfoTargetLock);
+        previous = std::move(lfoTarget);
+        lfoTarget = std::move(target);
+    }
+
+}
+
+void ObviousEngine::publishTempo(bool playing, double bpm, double beat) {
+
+    publishedTempoPlaying.store(playing, std::memory_order_relaxed);
+    publishedBpm.store(bpm, std::memory_order_relaxed);
+    publishedBeat.store(beat, std::memory_order_relaxed);
+    publishedTempoAtMs.store(juce::Time::getMillisecondCounterHiRes(), std::memory_order_relaxed);
+    tempoPending.store(true, std::memory_order_release);
+
+}
+
+void ObviousEngine::followTempo(bool playing, double bpm, double beat) {
+
+    if (!sendEnabled) return;
+
+    std::shared_ptr<const LFOTarget> target;
+
+    {
+        const juce::SpinLock::ScopedLockType lock(lfoTargetLock);
+        target = lfoTarget;
+    }
+
+    if (target == nullptr) return;
+
+    const ObviousProtocol::LFO &lfo = target->lfo;
+    const std::string &scene = target->scene, &source = target->source, &filter = target->filter;
+
+    // Switched off, or moved to another command or target: the LFO running in OBS stops
+    if (lfoSent.waveform != 0 && (lfo.waveform == 0 || lfo.command != lfoSent.command || scene != lfoScene || source != lfoSource || filter != lfoFilter)) {
+        ObviousProtocol::LFO stop;
+        stop.command = lfoSent.command;
+        writeMessage(ObviousProtocol::encode(LFO, lfoScene, lfoSource, lfoFilter, ObviousProtocol::encodeLFO(stop, 0.0, 0.0, false)));
+        lfoSent = stop;
+        lfoRunning = false;
+    }
+
+    if (lfo.waveform == 0) return;
+
+    // How far the host may be from the last anchor's beat, and how long an anchor lasts while playing
+    static constexpr double beatTolerance = 0.05;
+    static constexpr double anchorRefreshMs = 2000.0;
+
+    const double nowMs = juce::Time::getMillisecondCounterHiRes();
+    const double anchoredBeat = lfoAnchorBeat + (lfoAnchorPlaying ? (nowMs - lfoAnchorMs) / 60000.0 * lfoAnchorBpm : 0.0);
+
+    const bool resend = lfoResync.exchange(false) || lfo != lfoSent || playing != lfoAnchorPlaying || bpm != lfoAnchorBpm
+                        || std::abs(beat - anchoredBeat) > beatTolerance || (playing && nowMs - lfoAnchorMs > anchorRefreshMs);
+    if (!resend) return;
+
+    lfoSent = lfo;
+    lfoRunning = true;
+    lfoScene = scene;
+    lfoSource = source;
+    lfoFilter = filter;
+    lfoAnchorPlaying = playing;
+    lfoAnchorBpm = bpm;
+    lfoAnchorBeat = beat;
+    lfoAnchorMs = nowMs;
+
+    // A missing target is reported, and tried again with the next anchor
+    if (!checkTarget(scene, source, filter)) {
+        stats.sendSuppressed();
+        return;
+    }
+
+    const int bytesWritten = writeMessage(ObviousProtocol::encode(LFO, scene, source, filter, ObviousProtocol::encodeLFO(lfo, bpm, beat, playing)));
+
+    if (ObviousTrace::isOpen()) {
+        ObviousTrace::record(instanceID, samplePosition.load(std::memory_order_relaxed), LFO,
+                             ObviousTrace::targetHandle(scene, source, filter), (float)beat, bytesWritten);
+    }
+
+}
+
+std::string ObviousEngine::connectionGreeting() {
+
+    std::string greeting;
+
+    // A followed transport, a running LFO and the band values are sent again in full once connected
+    transportResync = true;
+    lfoResync = true;
+    bandsResync = true;
+
+    // Replies about values sent over UDP or the ring reach this connection through the sender ID
+    const bool sendsOutsideStream = (bool)settings().getProperty(ParameterIDUDP, false) || connection.isUsingSharedRing();
+    if (sendsOutsideStream) greeting = ObviousProtocol::encodeSenderRegistration(senderID);
+
+    // Only the first engine connected to this OBS asks for the catalogue
+    auto targets = catalogue();
+    if (targets != nullptr && targets->claimFeeder(this)) {
+        greeting += std::string(CommandCatalogueSubscribe) + CommandDelimiter;
+    }
+
+    // OBS answers with the current value, so a session opens showing what OBS shows
+    {
+        const juce::SpinLock::ScopedLockType lock(requestLock);
+        requestedTarget.clear();
+    }
+    greeting += valueRequest();
+
+    // A type-text target is drawn as soon as OBS has this, after a restart of OBS too
+    auto settingsStorage = settings();
+    if (sendEnabled && (int)settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault) == CommandCategoryTypeText) {
+        const std::string scene = settingsStorage.getProperty(ParameterIDScene, juce::String()).toString().toStdString();
+        const std::string source = settingsStorage.getProperty(ParameterIDSource, juce::String()).toString().toStdString();
+        if (!scene.empty() && !source.empty()) {
+            greeting += ObviousProtocol::encode(TypeSetState, scene, source, "", typeTextStatePayload(settingsStorage));
+        }
+    }
+
+    return greeting;
+
+}
+
+void ObviousEngine::connectionHeartbeatSent() {
+
+    // Values without a gesture (host automation) get their final value resent here
+    resendFinalValue();
+    endTransformBlock();
+    flushTransforms();
+
+    // The engine that fed the catalogue has disconnected
+    auto targets = catalogue();
+    if (targets != nullptr && targets->claimFeeder(this)) {
+        connection.write(std::string(CommandCatalogueSubscribe) + CommandDelimiter);
+    }
+
+    // Picks up a target or command changed without the editor (a restored state, ObviousHost)
+    requestValue();
+
+}
+
+void ObviousEngine::connectionRequested() {
+
+    // Still wanted: a close() or an editor connect() may have come in since the request
+    if (connection.needsConnecting()) {
+        connect();
+    }
+
+}
+
+void ObviousEngine::connectionHeartbeatLost() {
+
+    report("Info", "OBS has disconnected");
+    close();
+
+}
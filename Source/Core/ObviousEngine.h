@@ -0,0 +1,389 @@
+//
+//  ObviousEngine.h
+//  Obvious
+//
+//  Everything an Obvious instance does apart from its GUI: settings, value
+//  translation, protocol encoding and the connection to OBS. Used by the
+//  plugin and by the console host, without any juce_gui dependency.
+//
+
+#ifndef ObviousEngine_h
+#define ObviousEngine_h
+
+#include <array>
+#include <atomic>
+#include <string>
+
+#include <juce_core/juce_core.h>
+#include <juce_data_structures/juce_data_structures.h>
+
+#include "../CommandDefinitions.h"
+#include "../ParameterDefinitions.h"
+#include "CommandTable.h"
+#include "ObviousCatalogue.h"
+#include "ObviousConnection.h"
+#include "ObviousProtocol.h"
+#include "ObviousStats.h"
+#include "ObviousTrace.h"
+#include "ObviousTransformBatch.h"
+
+class ObviousEngine : private ObviousConnection::Listener, private juce::ValueTree::Listener
+{
+public:
+
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+
+        // A value is about to be sent, after translation into the configured range. Called on the
+        // sending thread (the audio thread in a plugin); GUIs should poll lastTranslatedValue() instead.
+        virtual void engineValueTranslated(float value) { juce::ignoreUnused(value); }
+
+        /*
+         OBS reported the selected command's value on the selected target, as a
+         raw value for `parameterID`. Called on the reader thread; the parameter
+         should be set without sending the value back.
+         */
+        virtual void engineValueReceived(const juce::String &parameterID, float rawValue) { juce::ignoreUnused(parameterID, rawValue); }
+
+        // Errors and information for the user. May be called from any thread.
+        virtual void engineMessage(const juce::String &title, const juce::String &message) { juce::ignoreUnused(title, message); }
+    };
+
+    /*
+     `state` is the root of the instance's state (AudioProcessorValueTreeState::state
+     in the plugin). The engine keeps a reference, so the tree can be replaced
+     when state is restored.
+     */
+    explicit ObviousEngine(juce::ValueTree &state);
+    ~ObviousEngine() override;
+
+    void setListener(Listener *newListener) { listener = newListener; }
+
+    juce::ValueTree settings();
+
+    float translateSliderValue(float rawValue);
+
+    // The last value sent for the value parameter, after translation; safe to read from any thread
+    float lastTranslatedValue() const { return translatedValue.load(std::memory_order_relaxed); }
+
+    // Sends the selected command for a change of the value or trigger parameter
+    void send(const juce::String &parameterID, float value);
+
+    // Sends a command with the configured target
+    void send(int command, float value);
+
+    // The audioreactive setting on a value command: the input's envelope drives the value instead of the parameter.
+    // Like isAnalysingSpectrum() and detectsOnsets(), a copy kept up to date when the settings change, so the
+    // audio thread can check it every block.
+    bool isAudioReactive() const { return audioReactive.load(std::memory_order_relaxed); }
+
+    /*
+     Audio thread: a level from the input's envelope (0..1). Only stored; the
+     send thread sends the latest one as the value parameter would be sent.
+     */
+    void publishLevel(float level);
+
+    // The audioreactive setting in the bands audiomode: the input's frequency bands drive the targets in the spectrumbands settings
+    bool isAnalysingSpectrum() const { return analysingSpectrum.load(std::memory_order_relaxed); }
+
+    /*
+     Audio thread, once per video frame: each band's level (0..1). Only
+     stored; the send thread maps the latest levels onto the range of each
+     band's target and sends the bands whose value changed in one Values
+     command.
+     */
+    void publishBands(const float *levels, int numLevels);
+
+    // The onset setting on a trigger command: hits in the input fire the command
+    bool detectsOnsets() const { return onsetDetection.load(std::memory_order_relaxed); }
+
+    /*
+     Audio thread: an onset that will be heard in `delayMs`. Only stored; the
+     send thread fires the trigger command for it, for OBS to apply when the
+     onset is heard, less half the measured round trip. A toggle command
+     alternates with each onset.
+     */
+    void publishOnset(double delayMs);
+
+    /*
+     Call when the user lets go of a parameter. With UDP on, the last value
+     is resent over TCP so a lost final datagram cannot leave OBS behind.
+     Values without a gesture (host automation) are covered by the same
+     resend on the next heartbeat.
+     */
+    void gestureEnded(const juce::String &parameterID);
+
+    // Returns at once; the connection is made on its own thread with the configured timeout
+    void connect();
+    void close();
+
+    ObviousConnection::State connectionState() const;
+
+    /*
+     Asks OBS for the current value of the selected command on the selected
+     target: a subscription, after which OBS pushes every change once a frame,
+     or with the followobs setting off a single query. Does nothing unless the
+     command or target changed since the last request, so it can be called
+     whenever either might have. Also sent on every connect.
+     */
+    void requestValue();
+
+    /*
+     Sends everything the selected type-text target shows (text, characters
+     shown, cursor character and visibility) as one TypeSetState, so OBS can
+     draw it without asking for each piece. Does nothing outside the type-text
+     category. Also sent on every connect.
+     */
+    void sendTypeTextState();
+
+    /*
+     Audio thread, once per block: closes what every engine on this OBS has
+     batched since the last block, without allocating. The send thread sends
+     it, one Transform per scene item; the heartbeat closes and sends too,
+     for hosts that stop processing.
+     */
+    void endTransformBlock();
+
+    // The Media cursor command with the followtransport setting on: the cursor follows the host's timeline.
+    // Kept up to date when the settings change, like isAudioReactive().
+    bool isFollowingTransport() const { return followingTransport.load(std::memory_order_relaxed); }
+
+    /*
+     Audio thread, once per block while isFollowingTransport(), with the
+     host's play state and position. Only stored; the send thread sends play,
+     pause and a seek when the transport starts, stops or is moved, and
+     otherwise a seek only when the media time OBS reports has drifted from
+     the host's by more than the driftthreshold setting (in milliseconds).
+     */
+    void publishTransport(bool playing, double seconds);
+
+    /*
+     The lfo setting is on for a transform, crop or filter command, or an LFO
+     this engine started still runs in OBS: call followTempo() every audio block.
+     */
+    bool followsTempo() const { return lfoEnabled.load(std::memory_order_relaxed) || lfoRunning.load(std::memory_order_relaxed); }
+
+    /*
+     Audio thread, once per block while followsTempo(), with the host's play
+     state, tempo and position in beats. Only stored; the send thread sends
+     the LFO to OBS when it is switched on, its settings or target change or
+     the host's tempo or play state does, and otherwise only when the host's
+     beat has moved from where the last anchor puts it, or every couple of
+     seconds while playing so OBS's clock cannot drift from the host's. It
+     stops the LFO when switched off.
+     */
+    void publishTempo(bool playing, double bpm, double beat);
+
+    // The scenes, sources and filters of the OBS this engine connects to; null before the first connect()
+    std::shared_ptr<ObviousCatalogue> catalogue() const;
+
+    void clientMessageReceived(std::string message);
+    void handleIncomingData(const char *data, int length) { connection.handleIncomingData(data, length); }
+
+    bool sendEnabled = false;
+
+    // Counters for this engine and its connection; safe to read from any thread
+    ObviousStats stats;
+
+    // Host timeline position for the trace, updated from the audio thread (-1 when unknown)
+    std::atomic<juce::int64> samplePosition { -1 };
+
+    const uint32_t instanceID;
+
+    // Identifies this engine's sequenced values to OBS; random, as instance IDs repeat across processes
+    const uint32_t senderID;
+
+protected:
+
+    // Asks the connect thread to connect if necessary and writes one encoded command, returning the
+    // socket's result (0 when queued until connected). Virtual so benchmarks can stub the socket.
+    virtual int writeMessage(const std::string &message);
+    virtual int writeDatagram(const std::string &message);
+
+private:
+
+    juce::ValueTree &state;
+    ObviousConnection connection;
+    Listener *listener = nullptr;
+
+    std::shared_ptr<ObviousCatalogue> endpointCatalogue;
+    std::shared_ptr<ObviousTransformBatch> endpointBatch;
+    mutable juce::SpinLock endpointLock;
+
+    // "S" or "Q" (subscribed or queried) and command<GS>scene<GS>source<GS>filter of the last value request
+    std::string requestedTarget;
+    juce::SpinLock requestLock;
+
+    // The raw value parameter, for the number of characters in TypeSetState
+    std::atomic<float> lastRawValue { 0.5f };
+    std::atomic<float> translatedValue { 0.5f };
+
+    enum class Delivery
+    {
+        Stream,             // plain command over TCP
+        Datagram,           // sequenced over UDP; may be lost, and older ones are dropped by OBS
+        SequencedStream,    // sequenced over TCP, for a final value that must arrive
+        Relative,           // the change since the previous value, over TCP; OBS adds it to its own
+        Batched,            // a field of the item's next Transform, sent by flushTransforms()
+        Scheduled           // over TCP, applied by OBS after a delay
+    };
+
+    std::atomic<uint64_t> sequence { 0 };
+
+    // The host's transport from the audio thread and when it was seen (ms on the hi-res counter),
+    // until the send thread follows it
+    std::atomic<bool> publishedPlaying { false };
+    std::atomic<double> publishedSeconds { 0.0 };
+    std::atomic<double> publishedAtMs { 0.0 };
+    std::atomic<bool> transportPending { false };
+
+    // Transport following: the state last sent, on the send thread, and the media time OBS last
+    // reported with when it arrived (ms on the hi-res counter), from the reader thread
+    bool transportPlaying = false;
+    double lastSeekMs = -1.0;
+    double seekSentAtMs = 0.0;
+    std::atomic<bool> transportResync { true };
+    std::atomic<double> reportedMediaMs { 0.0 };
+    std::atomic<double> reportedAtMs { 0.0 };
+
+    void followTransport(bool playing, double seconds);
+    void seekMedia(double mediaMs, double nowMs);
+
+    // The latest band levels from the audio thread, until the send thread sends them
+    std::array<std::atomic<float>, SpectrumBandCount> publishedBands {};
+    std::atomic<bool> bandsPending { false };
+
+    // Each band's target, copied from the spectrumbands settings whenever they change. Swapped whole,
+    // so the send thread never reads a band the editor is halfway through changing.
+    struct BandTarget
+    {
+        int command = 0;            // 0 when the band has no complete target
+        std::string scene, source, filter;
+        float rangeLower = 0.0f;
+        float rangeUpper = 1.0f;
+        uint64_t traceHandle = 0;
+    };
+
+    using BandTargets = std::array<BandTarget, SpectrumBandCount>;
+    std::shared_ptr<const BandTargets> bandTargets;
+    juce::SpinLock bandTargetsLock;
+    void updateBandTargets();
+
+    // The value last sent for each band, on the send thread; forgotten on connect so all are sent again
+    std::array<float, SpectrumBandCount> sentBandValues {};
+    std::atomic<bool> bandsResync { true };
+    void sendBands();
+
+    // Onsets from the audio thread: how many so far, and the delay of the latest and when it was
+    // seen (ms on the hi-res counter). The send thread fires one command for those since it last looked.
+    std::atomic<uint32_t> publishedOnsets { 0 };
+    std::atomic<double> publishedOnsetDelayMs { 0.0 };
+    std::atomic<double> publishedOnsetAtMs { 0.0 };
+    uint32_t firedOnsets = 0;
+
+    // The state an onset last set a toggle command to, on the send thread
+    bool onsetToggleState = false;
+    void sendOnset(double delayMs, uint32_t count);
+
+    // The host's tempo from the audio thread and when it was seen (ms on the hi-res counter),
+    // until the send thread follows it
+    std::atomic<bool> publishedTempoPlaying { false };
+    std::atomic<double> publishedBpm { 120.0 };
+    std::atomic<double> publishedBeat { 0.0 };
+    std::atomic<double> publishedTempoAtMs { 0.0 };
+    std::atomic<bool> tempoPending { false };
+
+    // The LFO the settings describe and its target, copied whenever they change; lfo.waveform is 0
+    // when none should run. Swapped whole, like the band targets.
+    struct LFOTarget
+    {
+        ObviousProtocol::LFO lfo;
+        std::string scene, source, filter;
+    };
+
+    std::shared_ptr<const LFOTarget> lfoTarget;
+    juce::SpinLock lfoTargetLock;
+    void updateLFOTarget();
+
+    // The LFO last sent and its target and anchor, on the send thread; lfoSent.waveform is 0 when none runs,
+    // as is lfoRunning, the copy followsTempo() reads
+    ObviousProtocol::LFO lfoSent;
+    std::atomic<bool> lfoRunning { false };
+    std::string lfoScene, lfoSource, lfoFilter;
+    bool lfoAnchorPlaying = false;
+    double lfoAnchorBpm = 0.0;
+    double lfoAnchorBeat = 0.0;
+    double lfoAnchorMs = 0.0;
+    std::atomic<bool> lfoResync { true };
+
+    // The lfo setting on a transform, crop or filter command: OBS generates the value
+    bool isRunningLFO() const { return lfoEnabled.load(std::memory_order_relaxed); }
+    void followTempo(bool playing, double bpm, double beat);
+
+    // A datagram has been sent since the last value resent over TCP
+    std::atomic<bool> finalValuePending { false };
+
+    // The modes the audio thread checks every block, copied from the settings whenever they change
+    std::atomic<bool> audioReactive { false };
+    std::atomic<bool> analysingSpectrum { false };
+    std::atomic<bool> onsetDetection { false };
+    std::atomic<bool> followingTransport { false };
+    std::atomic<bool> lfoEnabled { false };
+    std::atomic<bool> batchingTransforms { false };
+    void updateModes();
+
+    // The latest level from the audio thread, until the send thread sends it
+    std::atomic<float> publishedLevel { 0.0f };
+    std::atomic<bool> levelPending { false };
+
+    // Encodes and writes what the audio thread publishes, so the audio thread never allocates,
+    // locks or touches the socket for it. Polls, as waking it would take a lock on the audio thread.
+    class SendThread : public juce::Thread
+    {
+    public:
+        SendThread(ObviousEngine &e) : juce::Thread ("ObviousSendThread"), engine(e) {}
+
+        ObviousEngine& engine;
+
+        // Well under a video frame while something is published every frame
+        static constexpr int activePollMilliseconds = 2;
+        static constexpr int idlePollMilliseconds = 50;
+
+        void run() override;
+    };
+
+    SendThread sendThread;
+
+    // Sends the closed transform batch, on the send thread or the heartbeat
+    void flushTransforms();
+
+    void sendParameter(const juce::String &parameterID, float value, bool reliable);
+    void sendCommand(int command, float value, Delivery delivery, double delayMs = 0.0);
+    void resendFinalValue();
+
+    void report(const juce::String &title, const juce::String &message);
+    std::shared_ptr<ObviousTransformBatch> transformBatch() const;
+    bool checkTarget(const std::string &scene, const std::string &source, const std::string &filter);
+    void catalogueMessageReceived(int responseCode, const std::string &payload);
+    std::string valueRequest();
+    std::string typeTextStatePayload(const juce::ValueTree &settingsStorage);
+    void valueReceived(const std::string &payload);
+
+    void connectionMessageReceived(const std::string &message) override;
+    void connectionHeartbeatLost() override;
+    void connectionHeartbeatSent() override;
+    std::string connectionGreeting() override;
+    void connectionRequested() override;
+
+    void valueTreePropertyChanged(juce::ValueTree &tree, const juce::Identifier &property) override;
+    void valueTreeChildAdded(juce::ValueTree &parent, juce::ValueTree &child) override;
+    void valueTreeChildRemoved(juce::ValueTree &parent, juce::ValueTree &child, int index) override;
+    void childrenChanged(juce::ValueTree &parent);
+    void valueTreeRedirected(juce::ValueTree &tree) override;
+
+    JUCE_DECLARE_NON_COPYABLE (ObviousEngine)
+};
+
+#endif /* ObviousEngine_h */
@@ -0,0 +1,256 @@
+//
+//  ObviousProtocol.cpp
+//  Obvious
+//
+
+#include "ObviousProtocol.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ObviousProtocol {
+
+namespace {
+
+// A held command read through the Relative envelope. Envelopes whose target is
+// further in (Sequenced, Scheduled) or that carry several targets (Values) are
+// not read, and neither is anything without a scene and source.
+struct HeldCommand
+{
+    bool readable = false;
+    bool relative = false;
+    int command = 0;
+    size_t commandStart = 0;        // after the Relative envelope
+    size_t valueStart = 0;          // after the US before the value
+    std::string_view scene, source;
+};
+
+HeldCommand readHeld(const std::string &message) {
+
+    HeldCommand held;
+
+    const size_t envelopeLength = sizeof(CommandRelative) - 1;
+    if (message.compare(0, envelopeLength, CommandRelative) == 0 && message.size() > envelopeLength && message[envelopeLength] == CommandChunkDelimiter) {
+        held.relative = true;
+        held.commandStart = envelopeLength + 1;
+    }
+
+    const size_t commandEnd = message.find(CommandChunkDelimiter, held.commandStart);
+    const size_t sceneEnd = message.find(CommandChunkDelimiter, commandEnd + 1);
+    const size_t sourceEnd = message.find(CommandChunkDelimiter, sceneEnd + 1);
+    if (commandEnd == std::string::npos || sceneEnd == std::string::npos || sourceEnd == std::string::npos) return held;
+
+    held.command = std::atoi(message.c_str() + held.commandStart);
+    const std::string command = std::to_string(held.command);
+    if (command == CommandSequenced || command == CommandScheduled || command == CommandValues) return held;
+
+    const std::string_view text(message);
+    held.scene = text.substr(commandEnd + 1, sceneEnd - commandEnd - 1);
+    held.source = text.substr(sceneEnd + 1, sourceEnd - sceneEnd - 1);
+    held.valueStart = message.rfind(CommandChunkDelimiter) + 1;
+    held.readable = true;
+    return held;
+
+}
+
+// The fields of a Transform, "command<GS>value<GS>command<GS>value...", with those of `later` replacing the same fields of `earlier`
+std::string mergeTransformFields(std::string_view earlier, std::string_view later) {
+
+    std::vector<std::pair<std::string_view, std::string_view>> fields;
+
+    for (std::string_view list : { earlier, later }) {
+        size_t start = 0;
+        while (start < list.size()) {
+            const size_t commandEnd = list.find(CatalogueFieldDelimiter, start);
+            if (commandEnd == std::string_view::npos) break;
+            const size_t valueEnd = std::min(list.find(CatalogueFieldDelimiter, commandEnd + 1), list.size());
+            const std::string_view command = list.substr(start, commandEnd - start);
+            const std::string_view value = list.substr(commandEnd + 1, valueEnd - commandEnd - 1);
+
+            auto field = std::find_if(fields.begin(), fields.end(), [command](const auto &f) { return f.first == command; });
+            if (field != fields.end()) field->second = value;
+            else fields.emplace_back(command, value);
+
+            start = valueEnd + 1;
+        }
+    }
+
+    std::string merged;
+    for (const auto &field : fields) {
+        if (!merged.empty()) merged += CatalogueFieldDelimiter;
+        merged.append(field.first).append(1, CatalogueFieldDelimiter).append(field.second);
+    }
+    return merged;
+
+}
+
+// The records of a Values command, "record<FS>record...", or false when it is not one
+bool valuesRecords(const std::string &message, std::string_view &records) {
+
+    const size_t envelopeLength = sizeof(CommandValues) - 1;
+    if (message.compare(0, envelopeLength, CommandValues) != 0 || message.size() <= envelopeLength || message[envelopeLength] != CommandChunkDelimiter) return false;
+
+    records = std::string_view(message).substr(envelopeLength + 1);
+    if (!records.empty() && records.back() == CommandDelimiter) records.remove_suffix(1);
+    return true;
+
+}
+
+// Records keyed by everything before their value, "command<GS>scene<GS>source<GS>filter<GS>", with those of `later` replacing the same targets' in `earlier`
+std::string mergeValuesRecords(std::string_view earlier, std::string_view later) {
+
+    std::vector<std::string_view> records;
+
+    for (std::string_view list : { earlier, later }) {
+        size_t start = 0;
+        while (start < list.size()) {
+            const size_t end = std::min(list.find(ValuesRecordDelimiter, start), list.size());
+            const std::string_view record = list.substr(start, end - start);
+            const std::string_view key = record.substr(0, record.rfind(CatalogueFieldDelimiter) + 1);
+
+            auto existing = std::find_if(records.begin(), records.end(), [key](std::string_view r) { return r.compare(0, key.size(), key) == 0 && r.rfind(CatalogueFieldDelimiter) + 1 == key.size(); });
+            if (existing != records.end()) *existing = record;
+            else if (!record.empty()) records.push_back(record);
+
+            start = end + 1;
+        }
+    }
+
+    std::string merged;
+    for (std::string_view record : records) {
+        if (!merged.empty()) merged += ValuesRecordDelimiter;
+        merged.append(record);
+    }
+    return merged;
+
+}
+
+// The payload of a held command, without the closing delimiter
+std::string_view heldPayload(const std::string &message, const HeldCommand &held) {
+
+    std::string_view payload = std::string_view(message).substr(held.valueStart);
+    if (!payload.empty() && payload.back() == CommandDelimiter) payload.remove_suffix(1);
+    return payload;
+
+}
+
+}
+
+std::string encode(int command, const std::string &scene, const std::string &source, const std::string &filter, const std::string &payload) {
+
+    std::string message = std::to_string(command) + CommandChunkDelimiter + scene + CommandChunkDelimiter + source + CommandChunkDelimiter;
+
+    if (!filter.empty()) {
+        message = message + filter + CommandChunkDelimiter;
+    }
+
+    return message + payload + CommandDelimiter;
+
+}
+
+std::string encodeValue(float value) {
+    return std::to_string(value);
+}
+
+std::string encodeRelative(const std::string &message) {
+    return std::string(CommandRelative) + CommandChunkDelimiter + message;
+}
+
+bool isRelative(const std::string &message) {
+    const std::string prefix = std::string(CommandRelative) + CommandChunkDelimiter;
+    return message.compare(0, prefix.size(), prefix) == 0;
+}
+
+std::string encodeScheduled(double delayMs, const std::string &message) {
+    return std::string(CommandScheduled) + CommandChunkDelimiter + encodeValue((float)delayMs) + CommandChunkDelimiter + message;
+}
+
+std::string encodeTypeTextState(float numChars, bool cursorVisible, const std::string &cursorCharacter, const std::string &text) {
+    return encodeValue(numChars) + CatalogueFieldDelimiter + (cursorVisible ? "1" : "0") + CatalogueFieldDelimiter + cursorCharacter + CatalogueFieldDelimiter + text;
+}
+
+bool LFO::operator==(const LFO &other) const {
+    return command == other.command && waveform == other.waveform && beats == other.beats && phase == other.phase
+           && centre == other.centre && amplitude == other.amplitude && lower == other.lower && upper == other.upper;
+}
+
+std::string encodeLFO(const LFO &lfo, double bpm, double beat, bool playing) {
+
+    std::string payload = std::to_string(lfo.command) + CatalogueFieldDelimiter + std::to_string(lfo.waveform);
+
+    for (double field : { (double)lfo.beats, (double)lfo.phase, (double)lfo.centre, (double)lfo.amplitude, (double)lfo.lower, (double)lfo.upper, bpm, beat }) {
+        payload += CatalogueFieldDelimiter + std::to_string(field);
+    }
+
+    return payload + CatalogueFieldDelimiter + (playing ? "1" : "0");
+
+}
+
+std::string encodeValueRecord(int command, const std::string &scene, const std::string &source, const std::string &filter, float value) {
+    return std::to_string(command) + CatalogueFieldDelimiter + scene + CatalogueFieldDelimiter + source + CatalogueFieldDelimiter + filter + CatalogueFieldDelimiter + encodeValue(value);
+}
+
+std::string encodeValues(const std::string &records) {
+    return std::string(CommandValues) + CommandChunkDelimiter + records + CommandDelimiter;
+}
+
+std::string encodeSequenced(uint32_t sender, uint64_t sequence, const std::string &message) {
+    return std::string(CommandSequenced) + CommandChunkDelimiter + std::to_string(sender) + CommandChunkDelimiter + std::to_string(sequence) + CommandChunkDelimiter + message;
+}
+
+std::string encodeSenderRegistration(uint32_t sender) {
+    return std::string(CommandSequenced) + CommandChunkDelimiter + std::to_string(sender) + CommandDelimiter;
+}
+
+bool coalesce(std::deque<std::string> &pending, const std::string &message, bool (*isContinuous)(int command)) {
+
+    // Nothing follows the last command, so merging into it changes no order
+    std::string_view records, queuedRecords;
+    if (valuesRecords(message, records)) {
+        if (pending.empty() || !valuesRecords(pending.back(), queuedRecords)) return false;
+        pending.back() = encodeValues(mergeValuesRecords(queuedRecords, records));
+        return true;
+    }
+
+    const HeldCommand held = readHeld(message);
+    const bool transform = held.readable && !held.relative && std::to_string(held.command) == CommandTransform;
+    if (!held.readable || (!transform && !isContinuous(held.command))) return false;
+
+    for (auto queued = pending.rbegin(); queued != pending.rend(); ++queued) {
+
+        const HeldCommand other = readHeld(*queued);
+
+        // Anything that may touch the item keeps its place ahead of this command
+        if (!other.readable) return false;
+        if (other.scene != held.scene || other.source != held.source) continue;
+
+        // The latest command for the item: folded only when it is the same command on the same target
+        const size_t keyLength = held.valueStart - held.commandStart;
+        if (other.valueStart - other.commandStart != keyLength || queued->compare(other.commandStart, keyLength, message, held.commandStart, keyLength) != 0) {
+            return false;
+        }
+
+        // A change is added to the waiting value or change, which keeps its own envelope; a value replaces either
+        if (transform) {
+            if (other.relative) return false;
+            *queued = queued->substr(0, other.valueStart) + mergeTransformFields(heldPayload(*queued, other), heldPayload(message, held)) + CommandDelimiter;
+        }
+        else if (held.relative) {
+            const float sum = (float)(std::atof(queued->c_str() + other.valueStart) + std::atof(message.c_str() + held.valueStart));
+            *queued = queued->substr(0, other.valueStart) + encodeValue(sum) + CommandDelimiter;
+        }
+        else {
+            *queued = message;
+        }
+        return true;
+
+    }
+
+    return false;
+
+}
+
+}
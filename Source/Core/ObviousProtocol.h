@@ -0,0 +1,151 @@
+//
+//  ObviousProtocol.h
+//  Obvious
+//
+//  Framing and response codes shared with Obvious.lua.
+//
+
+#ifndef ObviousProtocol_h
+#define ObviousProtocol_h
+
+#include <cstdint>
+#include <deque>
+#include <string>
+
+#define CommandDelimiter char(30)
+#define CommandChunkDelimiter char(31)
+
+// Envelope for sequenced values; see encodeSequenced
+#define CommandSequenced "280"
+
+// Envelope for changes to add to the current value; see encodeRelative
+#define CommandRelative "330"
+
+// Several transform fields of one scene item, applied in one update; see ObviousTransformBatch
+#define CommandTransform "340"
+
+// Values for several targets; see encodeValues
+#define CommandValues "390"
+
+// Envelope for a command OBS applies after a delay; see encodeScheduled
+#define CommandScheduled "400"
+
+// Separates the fields of a catalogue entry; see ObviousCatalogue
+#define CatalogueFieldDelimiter char(29)
+
+// Separates the targets of a Values command; see encodeValues
+#define ValuesRecordDelimiter char(28)
+
+typedef enum : int {
+    ResponseCodeError=10,
+    ResponseCodeRequestTypeText=20,
+    ResponseCodeRequestTypeCursorChar=30,
+    ResponseCodeRequestTypeCursorVisible=40,
+    ResponseCodeRequestTypeNumChars=50,
+    ResponseCodeStats=60,
+    ResponseCodeCatalogueBegin=70,      // a full catalogue follows; forget the previous one
+    ResponseCodeCatalogueAdd=80,        // one entry: kind<GS>name[<GS>name]
+    ResponseCodeCatalogueRemove=90,
+    ResponseCodeCatalogueEnd=100,       // the full catalogue has been sent; entries after this are changes
+    ResponseCodeValue=110,              // command<GS>scene<GS>source<GS>filter<GS>value, for a value query or subscription
+    ResponseCodeRequestTypeState=120,   // send TypeSetState for this target
+} ResponseCode;
+
+namespace ObviousProtocol {
+
+/*
+ Builds "command<US>scene<US>source<US>[filter<US>]payload<RS>".
+ An empty filter is left out, as the Lua script expects for source commands.
+ */
+std::string encode(int command, const std::string &scene, const std::string &source, const std::string &filter, const std::string &payload);
+
+// The value payload, formatted as std::to_string() has always done it
+std::string encodeValue(float value);
+
+/*
+ Wraps an encoded command as "280<US>sender<US>sequence<US>command...<RS>".
+ Continuous values sent over UDP (and their end-of-gesture resend over TCP)
+ use this, so the receiver can drop anything older than a value it has
+ already applied from the same sender.
+ */
+std::string encodeSequenced(uint32_t sender, uint64_t sequence, const std::string &message);
+
+/*
+ Wraps an encoded command as "330<US>command...<RS>": its value is a change
+ to add to what OBS shows rather than the value to set. Obvious.lua sums
+ the changes per target and applies them once a frame, so several senders
+ moving one target all move it.
+ */
+std::string encodeRelative(const std::string &message);
+bool isRelative(const std::string &message);
+
+/*
+ Wraps an encoded command as "400<US>delayMs<US>command...<RS>": OBS applies
+ it on the first video frame at least delayMs after it arrives, so a trigger
+ sent ahead of time lands on the frame it was meant for.
+ */
+std::string encodeScheduled(double delayMs, const std::string &message);
+
+/*
+ The TypeSetState payload, "numChars<GS>cursorVisible<GS>cursorCharacter<GS>text":
+ everything a type-text target shows, in one command. The text goes last so
+ it may contain the delimiter.
+ */
+std::string encodeTypeTextState(float numChars, bool cursorVisible, const std::string &cursorCharacter, const std::string &text);
+
+/*
+ An LFO that Obvious.lua runs on a target's value, evaluated at the time of
+ every rendered frame so the plugin sends nothing while the tempo holds.
+ Sent as the payload of an LFO command with the host's tempo and position
+ as its anchor:
+ "command<GS>waveform<GS>beats<GS>phase<GS>centre<GS>amplitude<GS>lower<GS>upper<GS>bpm<GS>beat<GS>playing".
+ OBS moves the beat on from when the command arrived, at the given tempo
+ while playing. One LFO runs per command and target; waveform 0 stops it.
+ */
+struct LFO
+{
+    int command = 0;
+    int waveform = 0;           // an LFOWaveform, or 0
+    float beats = 1.0f;         // the length of one cycle
+    float phase = 0.0f;         // in cycles, added to the beat's position in the cycle
+    float centre = 0.0f;        // the value swings by amplitude either side of centre,
+    float amplitude = 0.0f;
+    float lower = 0.0f;         // clamped to lower..upper
+    float upper = 1.0f;
+
+    bool operator==(const LFO &other) const;
+    bool operator!=(const LFO &other) const { return !(*this == other); }
+};
+
+std::string encodeLFO(const LFO &lfo, double bpm, double beat, bool playing);
+
+/*
+ Values for several targets in one message, "390<US>record<FS>record...<RS>",
+ each record being "command<GS>scene<GS>source<GS>filter<GS>value" with an
+ empty filter for source commands. Obvious.lua applies them in the same
+ frame, the transform values for one item in one update.
+ */
+std::string encodeValueRecord(int command, const std::string &scene, const std::string &source, const std::string &filter, float value);
+std::string encodeValues(const std::string &records);
+
+// "280<US>sender<RS>", sent over TCP so replies about a sender's datagrams reach its connection
+std::string encodeSenderRegistration(uint32_t sender);
+
+/*
+ Folds `message`, a command held until the connection is made, into the
+ commands already waiting in `pending`, and returns false when it has to be
+ appended instead. Only the latest waiting command for the same scene item
+ is looked at, so the commands for one item keep the order they were sent in:
+ a value of a continuous command (see CommandTable::isContinuous) replaces
+ that command's value for the same target, and a relative change is added
+ to it. A Transform's fields are merged into the waiting Transform's, a field
+ sent again replacing its earlier value. A Values command directly after
+ another is merged into it per target, so a band that changed only in the
+ earlier one is still sent. Triggers, text and everything else are never
+ folded, so a press and its release both arrive.
+ */
+bool coalesce(std::deque<std::string> &pending, const std::string &message, bool (*isContinuous)(int command));
+
+}
+
+#endif /* ObviousProtocol_h */
@@ -0,0 +1,124 @@
+//
+//  ObviousSharedRing.cpp
+//  Obvious
+//
+
+#include "ObviousSharedRing.h"
+#include "ObviousProtocol.h"
+
+#if JUCE_LINUX || JUCE_MAC || JUCE_BSD
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+ #define OBVIOUS_SHARED_RING_SUPPORTED 1
+#else
+ #define OBVIOUS_SHARED_RING_SUPPORTED 0
+#endif
+
+ObviousSharedRing::Mapping::~Mapping() {
+   #if OBVIOUS_SHARED_RING_SUPPORTED
+    munmap(static_cast<void*>(header), size);
+   #endif
+}
+
+ObviousSharedRing::~ObviousSharedRing() {
+    close();
+    mappings.clear();
+}
+
+bool ObviousSharedRing::isLocalAddress(const juce::String &ip) {
+    const juce::String trimmed = ip.trim();
+    return trimmed == "127.0.0.1" || trimmed.equalsIgnoreCase("localhost") || trimmed == "::1";
+}
+
+bool ObviousSharedRing::open(int port) {
+
+    close();
+
+   #if OBVIOUS_SHARED_RING_SUPPORTED
+
+    const int fd = shm_open(ObviousSharedRingFormat::segmentName(port).c_str(), O_RDWR, 0);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(ObviousSharedRingFormat::Header)) {
+        ::close(fd);
+        return false;
+    }
+
+    const size_t size = (size_t)info.st_size;
+    const uint64_t identity = ((uint64_t)info.st_dev << 32) ^ (uint64_t)info.st_ino;
+
+    for (auto &existing : mappings) {
+        if (existing->identity == identity && existing->size == size) {
+            ::close(fd);
+            lastConsumerTicks = existing->header->consumerTicks.load(std::memory_order_relaxed);
+            lastConsumerProgressMs = juce::Time::getMillisecondCounter();
+            active.store(existing.get(), std::memory_order_release);
+            return true;
+        }
+    }
+
+    void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (data == MAP_FAILED) return false;
+
+    auto *h = static_cast<ObviousSharedRingFormat::Header*>(data);
+    if (!ObviousSharedRingFormat::isValid(h, size)) {
+        munmap(data, size);
+        return false;
+    }
+
+    mappings.push_back(std::unique_ptr<Mapping>(new Mapping { h, reinterpret_cast<ObviousSharedRingFormat::Record*>(h + 1), size, identity }));
+    lastConsumerTicks = h->consumerTicks.load(std::memory_order_relaxed);
+    lastConsumerProgressMs = juce::Time::getMillisecondCounter();
+    active.store(mappings.back().get(), std::memory_order_release);
+
+    return true;
+
+   #else
+    juce::ignoreUnused(port);
+    return false;
+   #endif
+
+}
+
+void ObviousSharedRing::close() {
+    active.store(nullptr, std::memory_order_release);
+}
+
+uint64_t ObviousSharedRing::consumerTicks() const {
+
+    Mapping *mapping = active.load(std::memory_order_acquire);
+    return mapping == nullptr ? 0 : mapping->header->consumerTicks.load(std::memory_order_acquire);
+
+}
+
+bool ObviousSharedRing::write(uint32_t sender, const std::string &message) {
+
+    Mapping *mapping = active.load(std::memory_order_acquire);
+    if (mapping == nullptr) return false;
+
+    auto *h = mapping->header;
+
+    // An unlinked or abandoned segment stays mapped; stop using it once OBS stops draining it
+    const uint64_t ticks = h->consumerTicks.load(std::memory_order_relaxed);
+    const juce::uint32 now = juce::Time::getMillisecondCounter();
+
+    if (ticks != lastConsumerTicks.load(std::memory_order_relaxed)) {
+        lastConsumerTicks.store(ticks, std::memory_order_relaxed);
+        lastConsumerProgressMs.store(now, std::memory_order_relaxed);
+    }
+    else if (now - lastConsumerProgressMs.load(std::memory_order_relaxed) > consumerTimeoutMs) {
+        return false;
+    }
+
+    // Commands are written without their CommandDelimiter
+    size_t length = message.size();
+    if (length > 0 && message[length - 1] == CommandDelimiter) --length;
+
+    return ObviousSharedRingFormat::tryWrite(h, mapping->records, sender, message.data(), length);
+
+}
@@ -0,0 +1,72 @@
+//
+//  ObviousSharedRing.h
+//  Obvious
+//
+//  The writer's side of the shared-memory ring (see ObviousSharedRingFormat.h).
+//  Opened by ObviousConnection when OBS is on this machine; every write
+//  that cannot go into the ring (no segment, ring full, OBS not draining
+//  it, message too long) returns false and the caller uses TCP instead.
+//  POSIX shared memory only, so on Windows open() always fails.
+//
+
+#ifndef ObviousSharedRing_h
+#define ObviousSharedRing_h
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <juce_core/juce_core.h>
+
+#include "ObviousSharedRingFormat.h"
+
+class ObviousSharedRing
+{
+public:
+
+    ObviousSharedRing() = default;
+    ~ObviousSharedRing();
+
+    // Maps the segment OBS created for `port`. Returns false if there is none. Only ever called from one
+    // thread (the connection's connect thread), as it is the only one that changes `mappings`.
+    bool open(int port);
+
+    // Stops writing; safe from any thread. Mappings are only released on destruction, as another
+    // thread may still be writing.
+    void close();
+
+    bool isOpen() const { return active.load(std::memory_order_acquire) != nullptr; }
+
+    // How many times OBS has drained the ring (see ObviousSharedRingFormat.h); 0 when not open
+    uint64_t consumerTicks() const;
+
+    // Safe from any thread, including the audio thread; never blocks
+    bool write(uint32_t sender, const std::string &message);
+
+    // True for the addresses that mean "this machine"
+    static bool isLocalAddress(const juce::String &ip);
+
+private:
+
+    struct Mapping
+    {
+        ObviousSharedRingFormat::Header *header;
+        ObviousSharedRingFormat::Record *records;
+        size_t size;
+        uint64_t identity;      // device and inode, so reconnecting to the same segment reuses its mapping
+        ~Mapping();
+    };
+
+    std::atomic<Mapping*> active { nullptr };
+    std::vector<std::unique_ptr<Mapping>> mappings;     // open() and the destructor only
+
+    // OBS is taken to have stopped draining when consumerTicks has not moved for this long
+    static constexpr juce::uint32 consumerTimeoutMs = 1000;
+    std::atomic<uint64_t> lastConsumerTicks { 0 };
+    std::atomic<juce::uint32> lastConsumerProgressMs { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (ObviousSharedRing)
+};
+
+#endif /* ObviousSharedRing_h */
@@ -0,0 +1,176 @@
+//
+//  ObviousSharedRingFormat.h
+//  Obvious
+//
+//  Layout of the shared-memory ring used instead of TCP when the plugin and
+//  OBS run on the same machine. Plain C++ with no JUCE dependency: the
+//  plugin writes to it, and the native receiver and Obvious.lua (through
+//  LuaJIT FFI) read it.
+//
+//  OBS creates the POSIX shared memory object segmentName(port) and owns
+//  readIndex. Any number of writers, in any number of processes, claim slot
+//  writeIndex % capacity with a compare-and-swap that fails when the ring
+//  is full, copy one encoded command into it and publish it by storing
+//  sequence = index + 1. The checksum lets a reader without atomics (Lua)
+//  tell a half-visible record from a complete one.
+//
+//  A writer also uses TCP, for commands the ring cannot take and those that
+//  never go in it. So that neither overtakes the other, OBS drains the ring
+//  up to what is published before it applies each command read from a
+//  socket (a draining pass that is not a tick), and reads its sockets before
+//  the ring in every tick; a writer only goes back to the ring once
+//  consumerTicks has advanced twice since its last socket write, as by then
+//  OBS has read and applied that write.
+//
+
+#ifndef ObviousSharedRingFormat_h
+#define ObviousSharedRingFormat_h
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace ObviousSharedRingFormat {
+
+constexpr char magic[8] = { 'O', 'B', 'V', 'S', 'H', 'R', 'N', 'G' };
+constexpr uint32_t version = 1;
+constexpr uint64_t defaultCapacity = 4096;
+constexpr size_t maxMessageLength = 232;
+
+struct Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t capacity;
+    std::atomic<uint64_t> writeIndex;       // next slot a writer will claim
+    std::atomic<uint64_t> readIndex;        // next slot OBS will read
+    std::atomic<uint64_t> consumerTicks;    // advanced by OBS every drain, so writers can tell it is alive
+    uint8_t reserved[16];
+};
+
+struct Record
+{
+    std::atomic<uint64_t> sequence;         // index + 1 once the record is complete
+    uint32_t sender;                        // the engine's senderID, registered over TCP for replies
+    uint16_t length;
+    uint16_t reserved;
+    uint32_t checksum;                      // adler32 of bytes[0, length)
+    uint32_t padding;
+    char bytes[maxMessageLength];           // one command without its CommandDelimiter
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring counters must be lock-free to live in shared memory");
+static_assert(sizeof(Header) == 64, "shared ring header layout changed");
+static_assert(sizeof(Record) == 256, "shared ring record layout changed");
+
+inline std::string segmentName(int port) {
+    return "/obvious-" + std::to_string(port);
+}
+
+inline size_t segmentSize(uint64_t capacity) {
+    return sizeof(Header) + (size_t)capacity * sizeof(Record);
+}
+
+inline uint32_t adler32(const char *data, size_t length) {
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < length; ++i) {
+        a = (a + (uint8_t)data[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+inline bool isValid(const Header *header, size_t mappedSize) {
+    return mappedSize >= sizeof(Header)
+        && std::memcmp(header->magic, magic, sizeof(magic)) == 0
+        && header->version == version
+        && header->recordSize == sizeof(Record)
+        && header->capacity > 0
+        && mappedSize >= segmentSize(header->capacity);
+}
+
+// Sets up a new segment, or one left behind by an earlier OBS session (anything unread is dropped)
+inline void initialise(Header *header, uint64_t capacity) {
+    const bool reuse = isValid(header, segmentSize(capacity)) && header->capacity == capacity;
+    const uint64_t start = reuse ? header->writeIndex.load() : 0;
+
+    if (!reuse) {
+        std::memset(static_cast<void*>(header), 0, segmentSize(capacity));
+        std::memcpy(header->magic, magic, sizeof(magic));
+        header->version = version;
+        header->recordSize = sizeof(Record);
+        header->capacity = capacity;
+    }
+
+    header->writeIndex.store(start);
+    header->readIndex.store(start);
+}
+
+// Writer side. Returns false when the message does not fit or the ring is full.
+inline bool tryWrite(Header *header, Record *records, uint32_t sender, const char *data, size_t length) {
+
+    if (length > maxMessageLength) return false;
+
+    const uint64_t capacity = header->capacity;
+    uint64_t index = header->writeIndex.load(std::memory_order_relaxed);
+
+    do {
+        if (index - header->readIndex.load(std::memory_order_acquire) >= capacity) return false;
+    } while (!header->writeIndex.compare_exchange_weak(index, index + 1, std::memory_order_relaxed));
+
+    Record &r = records[index % capacity];
+    r.sender = sender;
+    r.length = (uint16_t)length;
+    std::memcpy(r.bytes, data, length);
+    r.checksum = adler32(data, length);
+    r.sequence.store(index + 1, std::memory_order_release);
+
+    return true;
+
+}
+
+/*
+ Reader side (one reader). Calls onMessage(sender, data, length) for each
+ published record in order and returns how many were read. A slot that was
+ claimed but never published (a writer that crashed mid-write) blocks the
+ ring; after `stallLimit` ticks without progress it is skipped. A pass that
+ is not a tick (before a socket command) neither advances consumerTicks nor
+ counts towards the stall.
+ */
+template <typename Callback>
+size_t drain(Header *header, Record *records, uint32_t &stalledDrains, uint32_t stallLimit, bool tick, Callback &&onMessage) {
+
+    if (tick) header->consumerTicks.fetch_add(1, std::memory_order_relaxed);
+
+    const uint64_t capacity = header->capacity;
+    uint64_t index = header->readIndex.load(std::memory_order_relaxed);
+    const uint64_t end = header->writeIndex.load(std::memory_order_acquire);
+    size_t count = 0;
+
+    while (index < end) {
+
+        Record &r = records[index % capacity];
+
+        if (r.sequence.load(std::memory_order_acquire) != index + 1 || r.length > maxMessageLength || adler32(r.bytes, r.length) != r.checksum) {
+            if (!tick || ++stalledDrains < stallLimit) break;
+        }
+        else {
+            onMessage(r.sender, r.bytes, (size_t)r.length);
+            ++count;
+        }
+
+        stalledDrains = 0;
+        ++index;
+        header->readIndex.store(index, std::memory_order_release);
+
+    }
+
+    return count;
+
+}
+
+}
+
+#endif /* ObviousSharedRingFormat_h */
@@ -0,0 +1,205 @@
+//
+//  ObviousStats.cpp
+//  Obvious
+//
+
+#include "ObviousStats.h"
+
+#include <sstream>
+
+constexpr std::array<double, 9> ObviousStats::rttBucketLimits;
+
+void ObviousStats::raiseTo(std::atomic<uint64_t> &maximum, uint64_t value) {
+
+    uint64_t current = maximum.load(std::memory_order_relaxed);
+    while (value > current && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+
+}
+
+void ObviousStats::queueDepth(size_t depth) {
+    raiseTo(queueHighWater, depth);
+}
+
+void ObviousStats::writeStalled(uint64_t microseconds) {
+
+    writeStallMicroseconds.fetch_add(microseconds, std::memory_order_relaxed);
+    raiseTo(longestWriteStallMicroseconds, microseconds);
+
+}
+
+void ObviousStats::roundTrip(double milliseconds) {
+
+    size_t bucket = 0;
+    while (bucket < rttBucketLimits.size() && milliseconds > rttBucketLimits[bucket]) {
+        ++bucket;
+    }
+
+    rttBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    // Only the connection thread measures, so a plain load and store cannot lose an update
+    const double smoothed = smoothedRoundTripMs.load(std::memory_order_relaxed);
+    smoothedRoundTripMs.store(smoothed == 0.0 ? milliseconds : smoothed + (milliseconds - smoothed) / 8.0, std::memory_order_relaxed);
+
+}
+
+void ObviousStats::obsReported(const std::string &payload) {
+
+    ObsReport report = ObsReport::parse(payload);
+    report.receivedAt = juce::Time::currentTimeMillis();
+
+    const juce::SpinLock::ScopedLockType lock(obsReportLock);
+    obsReport = report;
+
+}
+
+ObviousStats::ObsReport ObviousStats::ObsReport::parse(const std::string &payload) {
+
+    ObsReport report;
+    std::stringstream stream(payload);
+    std::string field;
+
+    while (std::getline(stream, field, ';')) {
+
+        const size_t equals = field.find('=');
+        if (equals == std::string::npos) continue;
+
+        const std::string key = field.substr(0, equals);
+
+        // The target name may itself contain ';', so it is always last and takes the remainder
+        if (key == "slowTarget") {
+            std::string rest;
+            std::getline(stream, rest, '\0');
+            report.slowTarget = juce::String(field.substr(equals + 1) + (rest.empty() ? "" : ";" + rest));
+            break;
+        }
+
+        const double value = std::atof(field.c_str() + equals + 1);
+
+        if (key == "receiveUs") report.receiveUs = value;
+        else if (key == "parseUs") report.parseUs = value;
+        else if (key == "applyUs") report.applyUs = value;
+        else if (key == "tickMaxUs") report.tickMaxUs = value;
+        else if (key == "messages") report.messages = value;
+        else if (key == "perFrame") report.perFrame = value;
+        else if (key == "maxPerTick") report.maxPerTick = value;
+        else if (key == "backlog") report.backlog = value;
+        else if (key == "stale") report.stale = value;
+        else if (key == "targetAvgUs") report.targetAvgUs = value;
+        else if (key == "targetMaxUs") report.targetMaxUs = value;
+        else continue;
+
+        report.valid = true;
+
+    }
+
+    return report;
+
+}
+
+juce::var ObviousStats::ObsReport::toVar() const {
+
+    auto *object = new juce::DynamicObject();
+
+    object->setProperty("receiveMicrosecondsPerTick", receiveUs);
+    object->setProperty("parseMicrosecondsPerTick", parseUs);
+    object->setProperty("applyMicrosecondsPerTick", applyUs);
+    object->setProperty("longestTickMicroseconds", tickMaxUs);
+    object->setProperty("messages", messages);
+    object->setProperty("messagesPerFrame", perFrame);
+    object->setProperty("maxMessagesPerTick", maxPerTick);
+    object->setProperty("backlog", backlog);
+    object->setProperty("staleValuesDropped", stale);
+    object->setProperty("slowTarget", slowTarget);
+    object->setProperty("slowTargetAverageMicroseconds", targetAvgUs);
+    object->setProperty("slowTargetLongestMicroseconds", targetMaxUs);
+    object->setProperty("receivedAt", receivedAt);
+
+    return juce::var(object);
+
+}
+
+ObviousStats::Snapshot ObviousStats::snapshot() const {
+
+    Snapshot s;
+    s.messagesSent = messagesSent.load(std::memory_order_relaxed);
+    s.bytesSent = bytesSent.load(std::memory_order_relaxed);
+    s.messagesReceived = messagesReceived.load(std::memory_order_relaxed);
+    s.bytesReceived = bytesReceived.load(std::memory_order_relaxed);
+    s.sendsSuppressed = sendsSuppressed.load(std::memory_order_relaxed);
+    s.sendsCoalesced = sendsCoalesced.load(std::memory_order_relaxed);
+    s.datagramsSent = datagramsSent.load(std::memory_order_relaxed);
+    s.finalValueResends = finalValueResends.load(std::memory_order_relaxed);
+    s.sharedRingWrites = sharedRingWrites.load(std::memory_order_relaxed);
+    s.queueHighWater = queueHighWater.load(std::memory_order_relaxed);
+    s.writeStallMicroseconds = writeStallMicroseconds.load(std::memory_order_relaxed);
+    s.longestWriteStallMicroseconds = longestWriteStallMicroseconds.load(std::memory_order_relaxed);
+    s.reconnects = reconnects.load(std::memory_order_relaxed);
+    s.protocolErrors = protocolErrors.load(std::memory_order_relaxed);
+
+    for (size_t i = 0; i < numRttBuckets; ++i) {
+        s.rttBuckets[i] = rttBuckets[i].load(std::memory_order_relaxed);
+    }
+
+    {
+        const juce::SpinLock::ScopedLockType lock(obsReportLock);
+        s.obs = obsReport;
+    }
+
+    return s;
+
+}
+
+double ObviousStats::Snapshot::rttPercentile(double fraction) const {
+
+    uint64_t total = 0;
+    for (auto count : rttBuckets) total += count;
+    if (total == 0) return 0.0;
+
+    const double target = fraction * (double)total;
+    uint64_t cumulative = 0;
+
+    for (size_t i = 0; i < rttBucketLimits.size(); ++i) {
+        cumulative += rttBuckets[i];
+        if ((double)cumulative >= target) return rttBucketLimits[i];
+    }
+
+    return std::numeric_limits<double>::infinity();
+
+}
+
+juce::var ObviousStats::Snapshot::toVar() const {
+
+    auto *object = new juce::DynamicObject();
+
+    object->setProperty("messagesSent", (juce::int64)messagesSent);
+    object->setProperty("bytesSent", (juce::int64)bytesSent);
+    object->setProperty("messagesReceived", (juce::int64)messagesReceived);
+    object->setProperty("bytesReceived", (juce::int64)bytesReceived);
+    object->setProperty("sendsSuppressed", (juce::int64)sendsSuppressed);
+    object->setProperty("sendsCoalesced", (juce::int64)sendsCoalesced);
+    object->setProperty("datagramsSent", (juce::int64)datagramsSent);
+    object->setProperty("finalValueResends", (juce::int64)finalValueResends);
+    object->setProperty("sharedRingWrites", (juce::int64)sharedRingWrites);
+    object->setProperty("queueHighWater", (juce::int64)queueHighWater);
+    object->setProperty("writeStallMicroseconds", (juce::int64)writeStallMicroseconds);
+    object->setProperty("longestWriteStallMicroseconds", (juce::int64)longestWriteStallMicroseconds);
+    object->setProperty("reconnects", (juce::int64)reconnects);
+    object->setProperty("protocolErrors", (juce::int64)protocolErrors);
+
+    juce::Array<juce::var> buckets;
+    for (size_t i = 0; i < numRttBuckets; ++i) {
+
+        auto *bucket = new juce::DynamicObject();
+        if (i < rttBucketLimits.size()) bucket->setProperty("upToMilliseconds", rttBucketLimits[i]);
+        else bucket->setProperty("upToMilliseconds", juce::var());
+        bucket->setProperty("count", (juce::int64)rttBuckets[i]);
+        buckets.add(juce::var(bucket));
+
+    }
+    object->setProperty("rttHistogram", buckets);
+
+    if (obs.valid) object->setProperty("obs", obs.toVar());
+
+    return juce::var(object);
+
+}
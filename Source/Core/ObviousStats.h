@@ -0,0 +1,145 @@
+//
+//  ObviousStats.h
+//  Obvious
+//
+//  Counters for one engine and its connection. Writers use relaxed atomic
+//  increments and readers take a Snapshot, so neither side ever blocks;
+//  the values in a snapshot are individually exact but not taken at the
+//  same instant.
+//
+//  The OBS side's own report (apply cost per tick, backlog, slowest target)
+//  arrives as one block of text once a second on the socket thread, so it
+//  is kept whole behind a SpinLock; neither writer nor reader is the audio
+//  thread.
+//
+
+#ifndef ObviousStats_h
+#define ObviousStats_h
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include <juce_core/juce_core.h>
+
+class ObviousStats
+{
+public:
+
+    // Upper bounds (ms) of the round-trip histogram buckets; the last bucket is open-ended
+    static constexpr std::array<double, 9> rttBucketLimits { 1, 2, 5, 10, 20, 50, 100, 200, 500 };
+    static constexpr size_t numRttBuckets = rttBucketLimits.size() + 1;
+
+    // Cost of applying commands inside OBS, as reported by the script or native receiver
+    struct ObsReport
+    {
+        bool valid = false;
+        double receiveUs = 0.0;         // per tick, averaged over the report interval
+        double parseUs = 0.0;
+        double applyUs = 0.0;
+        double tickMaxUs = 0.0;         // worst single tick
+        double messages = 0.0;          // commands applied in the interval
+        double perFrame = 0.0;          // commands per rendered frame
+        double maxPerTick = 0.0;
+        double backlog = 0.0;           // times the receive buffer was full, or queued commands
+        double stale = 0.0;             // sequenced values dropped for arriving after a newer one
+        double targetAvgUs = 0.0;       // slowest target's average apply time
+        double targetMaxUs = 0.0;
+        juce::String slowTarget;
+        juce::int64 receivedAt = 0;     // juce::Time::currentTimeMillis()
+
+        // Parses the "key=value;...;slowTarget=name" payload of ResponseCodeStats
+        static ObsReport parse(const std::string &payload);
+
+        juce::var toVar() const;
+    };
+
+    struct Snapshot
+    {
+        uint64_t messagesSent = 0;
+        uint64_t bytesSent = 0;
+        uint64_t messagesReceived = 0;
+        uint64_t bytesReceived = 0;
+        uint64_t sendsSuppressed = 0;
+        uint64_t sendsCoalesced = 0;
+        uint64_t datagramsSent = 0;
+        uint64_t finalValueResends = 0;
+        uint64_t sharedRingWrites = 0;
+        uint64_t queueHighWater = 0;
+        uint64_t writeStallMicroseconds = 0;
+        uint64_t longestWriteStallMicroseconds = 0;
+        uint64_t reconnects = 0;
+        uint64_t protocolErrors = 0;
+        std::array<uint64_t, numRttBuckets> rttBuckets {};
+        ObsReport obs;
+
+        // Approximate percentile (0-1) from the histogram, as the bucket's upper bound in ms
+        double rttPercentile(double fraction) const;
+
+        juce::var toVar() const;
+        juce::String toJSON() const { return juce::JSON::toString(toVar()); }
+    };
+
+    void messageSent(size_t bytes) {
+        messagesSent.fetch_add(1, std::memory_order_relaxed);
+        bytesSent.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void messageReceived() { messagesReceived.fetch_add(1, std::memory_order_relaxed); }
+    void dataReceived(size_t bytes) { bytesReceived.fetch_add(bytes, std::memory_order_relaxed); }
+
+    // A send() that was dropped before reaching the socket (disabled, incomplete settings, wrong parameter)
+    void sendSuppressed() { sendsSuppressed.fetch_add(1, std::memory_order_relaxed); }
+
+    // A value that replaced one still waiting to be written
+    void sendCoalesced() { sendsCoalesced.fetch_add(1, std::memory_order_relaxed); }
+
+    // A continuous value sent over UDP, and a final value resent over TCP to cover a lost datagram
+    void datagramSent() { datagramsSent.fetch_add(1, std::memory_order_relaxed); }
+    void finalValueResent() { finalValueResends.fetch_add(1, std::memory_order_relaxed); }
+
+    // A command written to the shared-memory ring instead of a socket
+    void sharedRingWrite() { sharedRingWrites.fetch_add(1, std::memory_order_relaxed); }
+
+    void queueDepth(size_t depth);
+    void writeStalled(uint64_t microseconds);
+    void reconnected() { reconnects.fetch_add(1, std::memory_order_relaxed); }
+
+    // A message from OBS that could not be parsed, or data that never formed a complete message
+    void protocolError() { protocolErrors.fetch_add(1, std::memory_order_relaxed); }
+
+    void roundTrip(double milliseconds);
+    void obsReported(const std::string &payload);
+
+    // The heartbeat round trip averaged over the last few, as TCP smooths it; 0 until one is measured
+    double smoothedRoundTrip() const { return smoothedRoundTripMs.load(std::memory_order_relaxed); }
+
+    Snapshot snapshot() const;
+
+private:
+
+    std::atomic<uint64_t> messagesSent { 0 };
+    std::atomic<uint64_t> bytesSent { 0 };
+    std::atomic<uint64_t> messagesReceived { 0 };
+    std::atomic<uint64_t> bytesReceived { 0 };
+    std::atomic<uint64_t> sendsSuppressed { 0 };
+    std::atomic<uint64_t> sendsCoalesced { 0 };
+    std::atomic<uint64_t> datagramsSent { 0 };
+    std::atomic<uint64_t> finalValueResends { 0 };
+    std::atomic<uint64_t> sharedRingWrites { 0 };
+    std::atomic<uint64_t> queueHighWater { 0 };
+    std::atomic<uint64_t> writeStallMicroseconds { 0 };
+    std::atomic<uint64_t> longestWriteStallMicroseconds { 0 };
+    std::atomic<uint64_t> reconnects { 0 };
+    std::atomic<uint64_t> protocolErrors { 0 };
+    std::array<std::atomic<uint64_t>, numRttBuckets> rttBuckets {};
+    std::atomic<double> smoothedRoundTripMs { 0.0 };
+
+    ObsReport obsReport;
+    mutable juce::SpinLock obsReportLock;
+
+    static void raiseTo(std::atomic<uint64_t> &maximum, uint64_t value);
+};
+
+#endif /* ObviousStats_h */
@@ -0,0 +1,85 @@
+//
+//  ObviousStatusQueue.cpp
+//  Obvious
+//
+
+#include "ObviousStatusQueue.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// FNV-1a over the title, a separator and the message; never 0, which marks a free slot
+uint64_t statusKey(const char *title, const char *message) {
+
+    uint64_t h = 14695981039346656037ull;
+    auto add = [&h](const char *text) {
+        for (; *text != 0; ++text) {
+            h ^= (uint8_t)*text;
+            h *= 1099511628211ull;
+        }
+        h ^= 0xff;
+        h *= 1099511628211ull;
+    };
+
+    add(title);
+    add(message);
+    return h == 0 ? 1 : h;
+
+}
+
+}
+
+void ObviousStatusQueue::post(const juce::String &title, const juce::String &message) {
+
+    const uint64_t key = statusKey(title.toRawUTF8(), message.toRawUTF8());
+
+    for (size_t i = 0; i < numSlots; ++i) {
+
+        Slot &slot = slots[(key + i) % numSlots];
+        uint64_t current = slot.key.load(std::memory_order_acquire);
+
+        if (current == 0 && slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+
+            title.copyToUTF8(slot.title, maxTitleBytes);
+            message.copyToUTF8(slot.message, maxMessageBytes);
+            slot.ready.store(true, std::memory_order_release);
+            slot.count.fetch_add(1, std::memory_order_relaxed);
+            return;
+
+        }
+
+        if (current == key) {
+            slot.count.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+    }
+
+    dropped.fetch_add(1, std::memory_order_relaxed);
+
+}
+
+juce::Array<ObviousStatusQueue::Status> ObviousStatusQueue::read() {
+
+    juce::Array<Status> statuses;
+
+    for (auto &slot : slots) {
+
+        if (!slot.ready.load(std::memory_order_acquire)) continue;
+
+        Status status;
+        status.title = juce::String::fromUTF8(slot.title);
+        status.message = juce::String::fromUTF8(slot.message);
+        status.count = std::max(1u, slot.count.exchange(0, std::memory_order_relaxed));
+        statuses.add(status);
+
+        slot.ready.store(false, std::memory_order_relaxed);
+        slot.key.store(0, std::memory_order_release);
+
+    }
+
+    return statuses;
+
+}
@@ -0,0 +1,68 @@
+//
+//  ObviousStatusQueue.h
+//  Obvious
+//
+//  Errors and information for the user, posted from any thread (audio,
+//  socket, heartbeat) and read by the editor on a timer. Posting never
+//  blocks or allocates: each distinct title and message claims one of a
+//  fixed set of slots, and posting it again only bumps that slot's count,
+//  so an error repeated on every automation step costs one increment.
+//
+//  Counts are exact for a single poster and approximate under contention
+//  around the moment a slot is read and freed. When every slot is taken,
+//  further statuses are counted as dropped until the reader catches up.
+//
+
+#ifndef ObviousStatusQueue_h
+#define ObviousStatusQueue_h
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include <juce_core/juce_core.h>
+
+class ObviousStatusQueue
+{
+public:
+
+    struct Status
+    {
+        juce::String title;
+        juce::String message;
+        uint32_t count = 0;     // posts since the previous read
+    };
+
+    static constexpr size_t numSlots = 32;
+    static constexpr size_t maxTitleBytes = 32;
+    static constexpr size_t maxMessageBytes = 224;
+
+    ObviousStatusQueue() = default;
+
+    // Any thread. Titles and messages longer than the slot are truncated.
+    void post(const juce::String &title, const juce::String &message);
+
+    // One reader only. Returns every status posted since the last call, and frees its slot.
+    juce::Array<Status> read();
+
+    // Statuses that found no free slot since the last call
+    uint32_t readDropped() { return dropped.exchange(0, std::memory_order_relaxed); }
+
+private:
+
+    struct Slot
+    {
+        std::atomic<uint64_t> key { 0 };        // hash of title and message; 0 while free
+        std::atomic<bool> ready { false };      // title and message are complete
+        std::atomic<uint32_t> count { 0 };
+        char title[maxTitleBytes];
+        char message[maxMessageBytes];
+    };
+
+    std::array<Slot, numSlots> slots;
+    std::atomic<uint32_t> dropped { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (ObviousStatusQueue)
+};
+
+#endif /* ObviousStatusQueue_h */
@@ -0,0 +1,143 @@
+//
+//  ObviousTrace.cpp
+//  Obvious
+//
+
+#include "ObviousTrace.h"
+
+#include <chrono>
+#include <cstring>
+#include <mutex>
+
+namespace ObviousTrace {
+
+class Ring
+{
+public:
+    Ring(std::unique_ptr<juce::MemoryMappedFile> m, uint64_t c)
+        : mapping(std::move(m)),
+          capacity(c),
+          header(static_cast<ObviousTraceFormat::Header*>(mapping->getData())),
+          records(reinterpret_cast<ObviousTraceFormat::Record*>(header + 1))
+    {
+    }
+
+    void record(uint32_t instanceID, int64_t samplePosition, int command, uint64_t handle, float value, int bytesWritten) {
+
+        const uint64_t index = header->writeIndex.fetch_add(1, std::memory_order_relaxed);
+        ObviousTraceFormat::Record &r = records[index % capacity];
+
+        r.sequence.store(0, std::memory_order_relaxed);
+        r.wallClockNanoseconds = wallClockNanoseconds();
+        r.samplePosition = samplePosition;
+        r.targetHandle = handle;
+        r.instanceID = instanceID;
+        r.command = command;
+        r.value = value;
+        r.bytesWritten = bytesWritten;
+        r.sequence.store(index + 1, std::memory_order_release);
+
+    }
+
+    static uint64_t wallClockNanoseconds() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    std::unique_ptr<juce::MemoryMappedFile> mapping;
+    const uint64_t capacity;
+    ObviousTraceFormat::Header *header;
+    ObviousTraceFormat::Record *records;
+};
+
+static std::unique_ptr<Ring> ownedRing;
+static std::atomic<Ring*> activeRing { nullptr };
+static std::atomic<uint32_t> instanceCounter { 0 };
+
+bool open(const juce::File &file, uint64_t capacity) {
+
+    close();
+
+    if (capacity == 0) {
+        return false;
+    }
+
+    const int64_t size = (int64_t)(sizeof(ObviousTraceFormat::Header) + capacity * sizeof(ObviousTraceFormat::Record));
+
+    file.deleteFile();
+    {
+        // Extend the file to its full size; the mapping cannot grow it
+        juce::FileOutputStream stream(file);
+        if (stream.failedToOpen() || !stream.setPosition(size - 1) || !stream.writeByte(0)) {
+            return false;
+        }
+    }
+
+    auto mapping = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readWrite, false);
+    if (mapping->getData() == nullptr || (int64_t)mapping->getSize() < size) {
+        return false;
+    }
+
+    auto *header = static_cast<ObviousTraceFormat::Header*>(mapping->getData());
+    std::memset(mapping->getData(), 0, (size_t)size);
+    header->version = ObviousTraceFormat::version;
+    header->recordSize = sizeof(ObviousTraceFormat::Record);
+    header->capacity = capacity;
+    header->writeIndex.store(0, std::memory_order_relaxed);
+    header->createdWallClockNanoseconds = Ring::wallClockNanoseconds();
+    // Written last, so a file with a valid magic always has a valid header
+    std::memcpy(header->magic, ObviousTraceFormat::magic, sizeof(header->magic));
+
+    ownedRing = std::make_unique<Ring>(std::move(mapping), capacity);
+    activeRing.store(ownedRing.get(), std::memory_order_release);
+
+    return true;
+
+}
+
+void openFromEnvironment() {
+
+    static std::once_flag once;
+    std::call_once(once, [] {
+        const juce::String path = juce::SystemStats::getEnvironmentVariable("OBVIOUS_TRACE", {});
+        if (path.isNotEmpty()) {
+            open(juce::File(path));
+        }
+    });
+
+}
+
+void close() {
+
+    activeRing.store(nullptr, std::memory_order_release);
+    ownedRing.reset();
+
+}
+
+bool isOpen() {
+    return activeRing.load(std::memory_order_relaxed) != nullptr;
+}
+
+uint32_t nextInstanceID() {
+    return instanceCounter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+uint64_t targetHandle(const std::string &scene, const std::string &source, const std::string &filter) {
+
+    uint64_t h = ObviousTraceFormat::hash(scene.data(), scene.size());
+    h = ObviousTraceFormat::hash("\x1f", 1, h);
+    h = ObviousTraceFormat::hash(source.data(), source.size(), h);
+    h = ObviousTraceFormat::hash("\x1f", 1, h);
+    return ObviousTraceFormat::hash(filter.data(), filter.size(), h);
+
+}
+
+void record(uint32_t instanceID, int64_t samplePosition, int command, uint64_t handle, float value, int bytesWritten) {
+
+    if (Ring *ring = activeRing.load(std::memory_order_acquire)) {
+        ring->record(instanceID, samplePosition, command, handle, value, bytesWritten);
+    }
+
+}
+
+}
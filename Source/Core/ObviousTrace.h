@@ -0,0 +1,48 @@
+//
+//  ObviousTrace.h
+//  Obvious
+//
+//  Optional, process-wide trace of every outbound command, written to a
+//  memory-mapped ring file (see ObviousTraceFormat.h) so it survives a host
+//  crash. Tracing is off unless open() is called, or the OBVIOUS_TRACE
+//  environment variable names a file when the first engine is created.
+//  Read the file with Tools/ObviousTrace.
+//
+
+#ifndef ObviousTrace_h
+#define ObviousTrace_h
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <juce_core/juce_core.h>
+
+#include "ObviousTraceFormat.h"
+
+namespace ObviousTrace {
+
+constexpr uint64_t defaultCapacity = 1 << 20;
+
+// Creates (or replaces) the trace file. Returns false if it cannot be mapped.
+bool open(const juce::File &file, uint64_t capacity = defaultCapacity);
+
+// Opens the file named by OBVIOUS_TRACE, once per process
+void openFromEnvironment();
+
+// Stops tracing. Must not race with record().
+void close();
+
+bool isOpen();
+
+uint32_t nextInstanceID();
+
+uint64_t targetHandle(const std::string &scene, const std::string &source, const std::string &filter);
+
+// Lock-free; safe from any thread, including the audio thread
+void record(uint32_t instanceID, int64_t samplePosition, int command, uint64_t targetHandle, float value, int bytesWritten);
+
+}
+
+#endif /* ObviousTrace_h */
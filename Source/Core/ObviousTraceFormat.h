@@ -0,0 +1,65 @@
+//
+//  ObviousTraceFormat.h
+//  Obvious
+//
+//  On-disk layout of the outbound message trace. Plain C++ with no JUCE
+//  dependency, so the reader tool can build anywhere.
+//
+//  The file is a Header followed by `capacity` Records used as a ring.
+//  Writers claim slot writeIndex % capacity with a fetch_add, fill in the
+//  record and then publish it by storing sequence = index + 1. A reader
+//  only trusts records whose sequence matches the slot it expects, so
+//  records torn by a crash or a wrap-around are skipped.
+//
+
+#ifndef ObviousTraceFormat_h
+#define ObviousTraceFormat_h
+
+#include <atomic>
+#include <cstdint>
+
+namespace ObviousTraceFormat {
+
+constexpr char magic[8] = { 'O', 'B', 'V', 'T', 'R', 'A', 'C', 'E' };
+constexpr uint32_t version = 1;
+
+struct Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t capacity;
+    std::atomic<uint64_t> writeIndex;
+    uint64_t createdWallClockNanoseconds;
+    uint8_t reserved[24];
+};
+
+struct Record
+{
+    std::atomic<uint64_t> sequence;     // index + 1 once the record is complete
+    uint64_t wallClockNanoseconds;      // system clock, since the Unix epoch
+    int64_t samplePosition;             // host timeline position, -1 when unknown
+    uint64_t targetHandle;              // hash of scene, source and filter
+    uint32_t instanceID;                // engine number within the process
+    int32_t command;
+    float value;
+    int32_t bytesWritten;               // socket write result, -1 on failure
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "trace counters must be lock-free to live in a shared mapping");
+static_assert(sizeof(Header) == 64, "trace header layout changed");
+static_assert(sizeof(Record) == 48, "trace record layout changed");
+
+// FNV-1a, used for targetHandle so a target can be followed across a trace without storing its names
+inline uint64_t hash(const char *data, uint64_t length, uint64_t seed = 14695981039346656037ull) {
+    uint64_t h = seed;
+    for (uint64_t i = 0; i < length; ++i) {
+        h ^= (uint8_t)data[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+}
+
+#endif /* ObviousTraceFormat_h */
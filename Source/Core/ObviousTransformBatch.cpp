@@ -0,0 +1,101 @@
+//
+//  ObviousTransformBatch.cpp
+//  Obvious
+//
+
+#include "ObviousTransformBatch.h"
+
+#include "../CommandDefinitions.h"
+#include "ObviousProtocol.h"
+
+std::shared_ptr<ObviousTransformBatch> ObviousTransformBatch::forEndpoint(const juce::String &host, int port) {
+
+    static juce::CriticalSection registryLock;
+    static std::map<std::string, std::weak_ptr<ObviousTransformBatch>> registry;
+
+    const std::string key = host.trim().toLowerCase().toStdString() + ":" + std::to_string(port);
+
+    const juce::ScopedLock scope(registryLock);
+
+    auto &entry = registry[key];
+    auto batch = entry.lock();
+    if (batch == nullptr) {
+        batch = std::make_shared<ObviousTransformBatch>();
+        entry = batch;
+    }
+
+    for (auto it = registry.begin(); it != registry.end();) {
+        if (it->second.expired()) it = registry.erase(it);
+        else ++it;
+    }
+
+    return batch;
+
+}
+
+bool ObviousTransformBatch::isField(int command) {
+
+    switch (command) {
+        case PositionProportionateX: case PositionProportionateY:
+        case ScaleX: case ScaleY:
+        case Rotation:
+        case CropTop: case CropBottom: case CropLeft: case CropRight:
+        case BoundsWidth: case BoundsHeight:
+            return true;
+        default:
+            return false;
+    }
+
+}
+
+void ObviousTransformBatch::set(const std::string &scene, const std::string &source, int command, float value) {
+
+    const juce::SpinLock::ScopedLockType scope(lock);
+    items[scene + CommandChunkDelimiter + source][command] = value;
+
+}
+
+void ObviousTransformBatch::close() {
+
+    if (hasClosed()) return;
+
+    const juce::SpinLock::ScopedTryLockType scope(lock);
+    if (!scope.isLocked() || items.empty() || !closedItems.empty()) return;
+
+    // closedItems is empty, so nothing is freed here
+    closedItems.swap(items);
+    closed.store(true, std::memory_order_release);
+
+}
+
+std::vector<std::string> ObviousTransformBatch::take() {
+
+    std::vector<std::string> messages;
+    if (!hasClosed()) return messages;
+
+    Items taken;
+
+    {
+        const juce::SpinLock::ScopedTryLockType scope(lock);
+        if (!scope.isLocked()) return messages;
+        taken.swap(closedItems);
+        closed.store(false, std::memory_order_release);
+    }
+
+    for (const auto &item : taken) {
+
+        const size_t split = item.first.find(CommandChunkDelimiter);
+
+        std::string fields;
+        for (const auto &field : item.second) {
+            if (!fields.empty()) fields += CatalogueFieldDelimiter;
+            fields += std::to_string(field.first) + CatalogueFieldDelimiter + ObviousProtocol::encodeValue(field.second);
+        }
+
+        messages.push_back(ObviousProtocol::encode(Transform, item.first.substr(0, split), item.first.substr(split + 1), "", fields));
+
+    }
+
+    return messages;
+
+}
@@ -0,0 +1,72 @@
+//
+//  ObviousTransformBatch.h
+//  Obvious
+//
+//  Transform values (position, scale, rotation, crop and bounds) waiting to
+//  be sent as one Transform command per scene item. Shared by every engine
+//  connected to the same address and port, so instances driving different
+//  fields of one source are sent together: whichever engine ends an audio
+//  block first closes what all of them set since the last block, a send
+//  thread sends it, and Obvious.lua applies each item's fields in one
+//  deferred update instead of rendering a frame between them.
+//
+//  A Transform is "340<US>scene<US>source<US>fields<RS>", the fields being
+//  "command<GS>value<GS>command<GS>value..." with the IDs of the single
+//  commands.
+//
+
+#ifndef ObviousTransformBatch_h
+#define ObviousTransformBatch_h
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <juce_core/juce_core.h>
+
+class ObviousTransformBatch
+{
+public:
+
+    // The batch for one OBS, created on first use and kept while any engine holds it
+    static std::shared_ptr<ObviousTransformBatch> forEndpoint(const juce::String &host, int port);
+
+    // Commands that can be sent as a field of a Transform
+    static bool isField(int command);
+
+    ObviousTransformBatch() = default;
+
+    // Any thread. A later value for the same field of the same item replaces the earlier one.
+    void set(const std::string &scene, const std::string &source, int command, float value);
+
+    /*
+     Any thread, including the audio thread: closes what was set since the
+     last call, for take() to send. Swaps the maps without allocating, and
+     does nothing while another thread holds the batch or the last closed
+     batch has not been taken yet, in which case the values wait for the
+     next call.
+     */
+    void close();
+
+    bool hasClosed() const { return closed.load(std::memory_order_acquire); }
+
+    // Any thread. One encoded Transform per item in the last closed batch; empty when another thread is taking them.
+    std::vector<std::string> take();
+
+private:
+
+    // Keyed by "scene<US>source"; the fields are keyed by command ID
+    using Items = std::map<std::string, std::map<int, float>>;
+
+    // Set since the last close(), and closed but not yet taken
+    Items items;
+    Items closedItems;
+    std::atomic<bool> closed { false };
+    juce::SpinLock lock;
+
+    JUCE_DECLARE_NON_COPYABLE (ObviousTransformBatch)
+};
+
+#endif /* ObviousTransformBatch_h */
@@ -0,0 +1,129 @@
+//
+//  EnvelopeFollower.cpp
+//  Obvious
+//
+
+#include "EnvelopeFollower.h"
+
+#include <cmath>
+
+void EnvelopeFollower::prepare(double newSampleRate) {
+
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+    attackMs = -1.0f;
+    releaseMs = -1.0f;
+    reset();
+
+}
+
+void EnvelopeFollower::reset() {
+
+    envelope = 0.0f;
+    frameMaximum = 0.0f;
+    samplesUntilReport = 0.0;
+
+}
+
+float EnvelopeFollower::coefficient(float milliseconds, int numSamples) const {
+
+    // How much of the previous envelope is left after numSamples: a one-pole filter reaching 63% in `milliseconds`
+    const double samples = juce::jmax(1.0, (double)milliseconds * 0.001 * sampleRate);
+    return (float)std::exp(-(double)numSamples / samples);
+
+}
+
+float EnvelopeFollower::sumOfSquares(float *scratch, const float *values, int numValues) {
+
+    juce::FloatVectorOperations::multiply(scratch, values, values, numValues);
+
+    // Four running sums the compiler can keep in one vector register
+    float partial[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    int i = 0;
+    for (; i + 4 <= numValues; i += 4) {
+        partial[0] += scratch[i];
+        partial[1] += scratch[i + 1];
+        partial[2] += scratch[i + 2];
+        partial[3] += scratch[i + 3];
+    }
+    for (; i < numValues; ++i) partial[0] += scratch[i];
+
+    return (partial[0] + partial[1]) + (partial[2] + partial[3]);
+
+}
+
+float EnvelopeFollower::toRange(float level, const Settings &settings) {
+
+    const float floorDecibels = juce::jmin(settings.floorDecibels, -1.0f);
+    const float decibels = juce::Decibels::gainToDecibels(level * juce::Decibels::decibelsToGain(settings.gainDecibels), floorDecibels);
+
+    return juce::jlimit(0.0f, 1.0f, (decibels - floorDecibels) / -floorDecibels);
+
+}
+
+float EnvelopeFollower::detect(const float* const* channels, int numChannels, int offset, int numSamples, Mode mode) {
+
+    float detected = 0.0f;
+
+    if (mode == RMS) {
+
+        float sum = 0.0f;
+        for (int channel = 0; channel < numChannels; ++channel) {
+            sum += sumOfSquares(squares.data(), channels[channel] + offset, numSamples);
+        }
+        detected = std::sqrt(sum / (float)(numSamples * numChannels));
+
+    }
+    else {
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            const auto range = juce::FloatVectorOperations::findMinAndMax(channels[channel] + offset, numSamples);
+            detected = juce::jmax(detected, -range.getStart(), range.getEnd());
+        }
+
+    }
+
+    return detected;
+
+}
+
+bool EnvelopeFollower::process(const float* const* channels, int numChannels, int numSamples, const Settings &settings, float &level) {
+
+    if (numChannels < 1 || numSamples < 1) return false;
+
+    if (settings.attackMs != attackMs || settings.releaseMs != releaseMs) {
+        attackMs = settings.attackMs;
+        releaseMs = settings.releaseMs;
+        attackCoefficient = coefficient(attackMs, subBlockSize);
+        releaseCoefficient = coefficient(releaseMs, subBlockSize);
+    }
+
+    bool reportDue = false;
+
+    for (int offset = 0; offset < numSamples; offset += subBlockSize) {
+
+        const int length = juce::jmin(subBlockSize, numSamples - offset);
+        const float detected = detect(channels, numChannels, offset, length, settings.mode);
+
+        float smoothing = detected > envelope ? attackCoefficient : releaseCoefficient;
+        if (length != subBlockSize) smoothing = coefficient(detected > envelope ? attackMs : releaseMs, length);
+
+        envelope = detected + smoothing * (envelope - detected);
+        frameMaximum = juce::jmax(frameMaximum, envelope);
+
+        // A block longer than a frame still reports once; the reports would reach OBS together anyway
+        samplesUntilReport -= length;
+        while (samplesUntilReport <= 0.0) {
+            reportDue = true;
+            samplesUntilReport += sampleRate / (double)juce::jmax(1.0f, settings.framesPerSecond);
+        }
+
+    }
+
+    if (!reportDue) return false;
+
+    level = toRange(frameMaximum, settings);
+    frameMaximum = 0.0f;
+
+    return true;
+
+}
@@ -0,0 +1,85 @@
+//
+//  EnvelopeFollower.h
+//  Obvious
+//
+//  Peak or RMS envelope of the plugin's input, for the audio-reactive mode.
+//  Each block is taken in sub-blocks of 32 samples: their level is found
+//  with juce::FloatVectorOperations, which uses SSE, AVX or NEON, and the
+//  attack and release smoothing runs once per sub-block instead of once per
+//  sample. A level is reported once per video frame, as the highest the
+//  envelope reached since the last one, so a kick shorter than a frame is
+//  not missed between two reports.
+//
+//  Audio thread only. Nothing is allocated or locked after prepare().
+//
+
+#ifndef EnvelopeFollower_h
+#define EnvelopeFollower_h
+
+#include <array>
+
+#include <JuceHeader.h>
+#include "CommandDefinitions.h"
+
+class EnvelopeFollower
+{
+public:
+
+    enum Mode
+    {
+        Peak = AudioModePeak,
+        RMS = AudioModeRMS
+    };
+
+    struct Settings
+    {
+        Mode mode = Peak;
+        float attackMs = 5.0f;
+        float releaseMs = 150.0f;
+        float gainDecibels = 0.0f;
+        float floorDecibels = -48.0f;   // the level reported as 0; 0 dBFS is reported as 1
+        float framesPerSecond = 60.0f;
+    };
+
+    EnvelopeFollower() = default;
+
+    void prepare(double sampleRate);
+    void reset();
+
+    /*
+     Follows one block of `numChannels` channels. Returns true when a video
+     frame has passed since the last report, with `level` set to the
+     envelope after the gain, from 0 at the floor to 1 at 0 dBFS.
+     */
+    bool process(const float* const* channels, int numChannels, int numSamples, const Settings &settings, float &level);
+
+    // The sum of the squares of `values`, squared into `scratch` (at least numValues long) with FloatVectorOperations
+    static float sumOfSquares(float *scratch, const float *values, int numValues);
+
+    // `level` after `gainDecibels`, from 0 at `floorDecibels` to 1 at 0 dBFS
+    static float toRange(float level, const Settings &settings);
+
+private:
+
+    static constexpr int subBlockSize = 32;
+
+    double sampleRate = 44100.0;
+    float envelope = 0.0f;
+    float frameMaximum = 0.0f;
+    double samplesUntilReport = 0.0;
+
+    // Smoothing per full sub-block, recalculated only when the times change
+    float attackMs = -1.0f;
+    float releaseMs = -1.0f;
+    float attackCoefficient = 0.0f;
+    float releaseCoefficient = 0.0f;
+
+    std::array<float, subBlockSize> squares {};
+
+    float coefficient(float milliseconds, int numSamples) const;
+    float detect(const float* const* channels, int numChannels, int offset, int numSamples, Mode mode);
+
+    JUCE_DECLARE_NON_COPYABLE (EnvelopeFollower)
+};
+
+#endif /* EnvelopeFollower_h */
@@ -0,0 +1,62 @@
+//
+//  OnsetDetector.cpp
+//  Obvious
+//
+
+#include "OnsetDetector.h"
+
+#include <cmath>
+#include <limits>
+
+void OnsetDetector::prepare(double newSampleRate) {
+
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+    averageCoefficient = (float)std::exp(-(double)subBlockSize / ((double)averageMs * 0.001 * sampleRate));
+    reset();
+
+}
+
+void OnsetDetector::reset() {
+
+    average = 0.0f;
+    // So the first hit is an onset, however soon it comes
+    samplesSinceOnset = std::numeric_limits<double>::max();
+
+}
+
+int OnsetDetector::process(const float* const* channels, int numChannels, int numSamples, const Settings &settings) {
+
+    if (numChannels < 1 || numSamples < 1) return -1;
+
+    // Compared as power, so the thresholds in dB are squared once here rather than rooting every sub-block
+    const float thresholdRatio = juce::Decibels::decibelsToGain(juce::jmax(0.0f, settings.thresholdDecibels) * 2.0f);
+    const float floorPower = juce::Decibels::decibelsToGain(settings.floorDecibels * 2.0f);
+    const double holdSamples = (double)juce::jmax(0.0f, settings.holdMs) * 0.001 * sampleRate;
+
+    int onset = -1;
+
+    for (int offset = 0; offset < numSamples; offset += subBlockSize) {
+
+        const int length = juce::jmin(subBlockSize, numSamples - offset);
+
+        float sum = 0.0f;
+        for (int channel = 0; channel < numChannels; ++channel) {
+            sum += EnvelopeFollower::sumOfSquares(squares.data(), channels[channel] + offset, length);
+        }
+        const float power = sum / (float)(length * numChannels);
+
+        if (onset < 0 && power > floorPower && power > average * thresholdRatio && samplesSinceOnset >= holdSamples) {
+            onset = offset;
+            samplesSinceOnset = 0.0;
+        }
+
+        // A short last sub-block moves the average as far as its length would
+        const float coefficient = length == subBlockSize ? averageCoefficient : std::pow(averageCoefficient, (float)length / subBlockSize);
+        average = power + coefficient * (average - power);
+        samplesSinceOnset += length;
+
+    }
+
+    return onset;
+
+}
@@ -0,0 +1,61 @@
+//
+//  OnsetDetector.h
+//  Obvious
+//
+//  Onsets (hits) in the plugin's input, for firing a trigger command on the
+//  beat. Energy-based: each 32-sample sub-block's mean square, found with
+//  EnvelopeFollower::sumOfSquares, is compared with a running average of the
+//  last 100 ms. An onset is a sub-block louder than the average by the
+//  threshold and above the floor, at least the hold time after the last
+//  one. Onsets are found to within a sub-block, under a millisecond at
+//  44.1 kHz, which spectral flux over an FFT window could not match.
+//
+//  Audio thread only. Nothing is allocated or locked.
+//
+
+#ifndef OnsetDetector_h
+#define OnsetDetector_h
+
+#include <array>
+
+#include <JuceHeader.h>
+#include "EnvelopeFollower.h"
+
+class OnsetDetector
+{
+public:
+
+    struct Settings
+    {
+        float thresholdDecibels = 6.0f;     // above the running average
+        float holdMs = 100.0f;              // no onset sooner than this after the last
+        float floorDecibels = -48.0f;       // nothing quieter is an onset
+    };
+
+    OnsetDetector() = default;
+
+    void prepare(double sampleRate);
+    void reset();
+
+    /*
+     Follows one block of `numChannels` channels. Returns the sample in the
+     block where the first onset starts, or -1 if there is none.
+     */
+    int process(const float* const* channels, int numChannels, int numSamples, const Settings &settings);
+
+private:
+
+    static constexpr int subBlockSize = 32;
+    static constexpr float averageMs = 100.0f;
+
+    double sampleRate = 44100.0;
+    float average = 0.0f;
+    float averageCoefficient = 0.0f;
+    double samplesSinceOnset = 0.0;
+
+    std::array<float, subBlockSize> squares {};
+
+    JUCE_DECLARE_NON_COPYABLE (OnsetDetector)
+};
+
+#endif /* OnsetDetector_h */
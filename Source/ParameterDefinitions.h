@@ -17,6 +17,40 @@
 #define ParameterIDCommandCategory "commandcategory"
 #define ParameterIDIP "ip"
 #define ParameterIDPort "port"
+#define ParameterIDUDP "udp"
+#define ParameterIDConnectTimeout "connecttimeout"
+#define ParameterIDQueueWhileConnecting "queuewhileconnecting"
+#define ParameterIDFollowOBS "followobs"
+#define ParameterIDRelative "relative"
+#define ParameterIDBatchTransform "batchtransform"
+#define ParameterIDFollowTransport "followtransport"
+#define ParameterIDDriftThreshold "driftthreshold"
+#define ParameterIDLFO "lfo"
+#define ParameterIDLFOWaveform "lfowaveform"
+#define ParameterIDLFOBeats "lfobeats"
+#define ParameterIDLFODepth "lfodepth"
+#define ParameterIDLFOOffset "lfooffset"
+#define ParameterIDLFOPhase "lfophase"
+#define ParameterIDAudioReactive "audioreactive"
+#define ParameterIDAudioMode "audiomode"
+#define ParameterIDAudioAttack "audioattack"
+#define ParameterIDAudioRelease "audiorelease"
+#define ParameterIDAudioGain "audiogain"
+#define ParameterIDAudioFloor "audiofloor"
+#define ParameterIDAudioFrameRate "audioframerate"
+
+// One child per band (of SpectrumBandCount), with the scene, source, filter, command, rangelower and rangeupper properties
+#define ParameterIDSpectrumBands "spectrumbands"
+#define ParameterIDSpectrumBand "band"
+#define SpectrumBandCount 8
+
+// Onsets in the input fire the trigger command; see OnsetDetector
+#define ParameterIDOnset "onset"
+#define ParameterIDOnsetThreshold "onsetthreshold"
+#define ParameterIDOnsetHold "onsethold"
+#define ParameterIDOnsetFloor "onsetfloor"
+#define ParameterIDOnsetLookahead "onsetlookahead"
+
 #define ParameterIDRangeLower "rangelower"
 #define ParameterIDRangeUpper "rangeupper"
 #define ParameterIDTypeTextText "typetexttext"
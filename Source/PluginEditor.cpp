@@ -10,107 +10,657 @@
 #include "PluginEditor.h"
 #include "ParameterDefinitions.h"
 
-bool allowAutoResize = false;
-
 //==============================================================================
 ObviousAudioProcessorEditor::ObviousAudioProcessorEditor (ObviousAudioProcessor& p, juce::AudioProcessorValueTreeState& valueTreeState)
-    : AudioProcessorEditor (&p), audioProcessor (p)
+    : AudioProcessorEditor (&p), audioProcessor (p), statsPanel (p.engine.stats), statusLine (p.status)
 {
             
     setResizable(true, true);
     
-    addAndMakeVisible(p.ipLabel);
-    addAndMakeVisible(p.portLabel);
-    addAndMakeVisible(p.sceneLabel);
-    addAndMakeVisible(p.sourceLabel);
-    addAndMakeVisible(p.valueSlider);
-    addAndMakeVisible(p.valueSliderValue);
-    addAndMakeVisible(p.commandSelectorSource);
-    addAndMakeVisible(p.commandSelectorFilter);
-    addAndMakeVisible(p.commandSelectorTypeText);
-    addAndMakeVisible(p.commandCategorySelector);
-    addAndMakeVisible(p.commandSelectorTitle);
-    addAndMakeVisible(p.commandCategorySelectorTitle);
-    addAndMakeVisible(p.triggerButton);
-    addAndMakeVisible(p.connectionLabel);
-    addAndMakeVisible(p.ipTitleLabel);
-    addAndMakeVisible(p.portTitleLabel);
-    addAndMakeVisible(p.targetLabel);
-    addAndMakeVisible(p.sceneTitleLabel);
-    addAndMakeVisible(p.sourceTitleLabel);
-    addAndMakeVisible(p.filterLabel);
-    addAndMakeVisible(p.filterTitleLabel);
-    addAndMakeVisible(p.commandLabel);
-    addAndMakeVisible(p.rangeLabel);
-    addAndMakeVisible(p.rangeLowerTitleLabel);
-    addAndMakeVisible(p.rangeUpperTitleLabel);
-    addAndMakeVisible(p.rangeLowerLabel);
-    addAndMakeVisible(p.rangeUpperLabel);
-    addAndMakeVisible(p.typeTextTextLabel);
-    addAndMakeVisible(p.typeTextTitleLabel);
-    addAndMakeVisible(p.typeTextCursorCharacterLabel);
-    addAndMakeVisible(p.typeTextCursorCharacterTitleLabel);
+    addAndMakeVisible(ipLabel);
+    addAndMakeVisible(portLabel);
+    addAndMakeVisible(sceneLabel);
+    addAndMakeVisible(sourceLabel);
+    addAndMakeVisible(valueSlider);
+    addAndMakeVisible(valueSliderValue);
+    addAndMakeVisible(commandSelectorSource);
+    addAndMakeVisible(commandSelectorFilter);
+    addAndMakeVisible(commandSelectorTypeText);
+    addAndMakeVisible(commandCategorySelector);
+    addAndMakeVisible(commandSelectorTitle);
+    addAndMakeVisible(commandCategorySelectorTitle);
+    addAndMakeVisible(triggerButton);
+    addAndMakeVisible(connectionLabel);
+    addAndMakeVisible(udpToggle);
+    addAndMakeVisible(queueToggle);
+    addAndMakeVisible(ipTitleLabel);
+    addAndMakeVisible(portTitleLabel);
+    addAndMakeVisible(targetLabel);
+    addAndMakeVisible(sceneTitleLabel);
+    addAndMakeVisible(sourceTitleLabel);
+    addAndMakeVisible(filterLabel);
+    addAndMakeVisible(filterTitleLabel);
+    addAndMakeVisible(commandLabel);
+    addAndMakeVisible(rangeLabel);
+    addAndMakeVisible(relativeToggle);
+    addAndMakeVisible(batchTransformToggle);
+    addAndMakeVisible(followTransportToggle);
+    addAndMakeVisible(rangeLowerTitleLabel);
+    addAndMakeVisible(rangeUpperTitleLabel);
+    addAndMakeVisible(rangeLowerLabel);
+    addAndMakeVisible(rangeUpperLabel);
+    addAndMakeVisible(lfoLabel);
+    addAndMakeVisible(lfoWaveformSelector);
+    addAndMakeVisible(lfoToggle);
+    addAndMakeVisible(lfoBeatsTitleLabel);
+    addAndMakeVisible(lfoDepthTitleLabel);
+    addAndMakeVisible(lfoOffsetTitleLabel);
+    addAndMakeVisible(lfoPhaseTitleLabel);
+    addAndMakeVisible(lfoBeatsLabel);
+    addAndMakeVisible(lfoDepthLabel);
+    addAndMakeVisible(lfoOffsetLabel);
+    addAndMakeVisible(lfoPhaseLabel);
+    addAndMakeVisible(audioLabel);
+    addAndMakeVisible(audioModeSelector);
+    addAndMakeVisible(audioToggle);
+    addAndMakeVisible(audioAttackTitleLabel);
+    addAndMakeVisible(audioReleaseTitleLabel);
+    addAndMakeVisible(audioGainTitleLabel);
+    addAndMakeVisible(audioFloorTitleLabel);
+    addAndMakeVisible(audioAttackLabel);
+    addAndMakeVisible(audioReleaseLabel);
+    addAndMakeVisible(audioGainLabel);
+    addAndMakeVisible(audioFloorLabel);
+    addAndMakeVisible(bandTitleLabel);
+    addAndMakeVisible(bandSelector);
+    addAndMakeVisible(bandCommandSelector);
+    addAndMakeVisible(bandLowerTitleLabel);
+    addAndMakeVisible(bandUpperTitleLabel);
+    addAndMakeVisible(bandLowerLabel);
+    addAndMakeVisible(bandUpperLabel);
+    addAndMakeVisible(bandSceneTitleLabel);
+    addAndMakeVisible(bandSourceTitleLabel);
+    addAndMakeVisible(bandFilterTitleLabel);
+    addAndMakeVisible(bandSceneLabel);
+    addAndMakeVisible(bandSourceLabel);
+    addAndMakeVisible(bandFilterLabel);
+    addAndMakeVisible(onsetLabel);
+    addAndMakeVisible(onsetToggle);
+    addAndMakeVisible(onsetThresholdTitleLabel);
+    addAndMakeVisible(onsetHoldTitleLabel);
+    addAndMakeVisible(onsetFloorTitleLabel);
+    addAndMakeVisible(onsetLookaheadTitleLabel);
+    addAndMakeVisible(onsetThresholdLabel);
+    addAndMakeVisible(onsetHoldLabel);
+    addAndMakeVisible(onsetFloorLabel);
+    addAndMakeVisible(onsetLookaheadLabel);
+    addAndMakeVisible(typeTextTextLabel);
+    addAndMakeVisible(typeTextTitleLabel);
+    addAndMakeVisible(typeTextCursorCharacterLabel);
+    addAndMakeVisible(typeTextCursorCharacterTitleLabel);
+    addAndMakeVisible(statsPanel);
+    addAndMakeVisible(statusLine);
     
     auto settingsStorage = audioProcessor.settings();
     
-    p.connectionLabel.setText("Connection", juce::dontSendNotification);
-    p.connectionLabel.setColour(juce::Label::backgroundColourId, juce::Colours::darkgrey);
-    p.ipTitleLabel.setText("IP Address", juce::dontSendNotification);
-    p.portTitleLabel.setText("Port", juce::dontSendNotification);
-    p.ipLabel.setText(settingsStorage.getProperty (ParameterIDIP, juce::String("127.0.0.1")), juce::dontSendNotification);
-    p.ipLabel.setColour(juce::Label::outlineColourId, juce::Colours::lightgrey);
-    p.portLabel.setText(settingsStorage.getProperty (ParameterIDPort, juce::String("11111")), juce::dontSendNotification);
-    p.portLabel.setColour(juce::Label::outlineColourId, juce::Colours::lightgrey);
-    
-    p.targetLabel.setText("Target", juce::dontSendNotification);
-    p.targetLabel.setColour(juce::Label::backgroundColourId, juce::Colours::darkgrey);
-    p.sceneTitleLabel.setText("Scene", juce::dontSendNotification);
-    p.sourceTitleLabel.setText("Source", juce::dontSendNotification);
-    p.filterTitleLabel.setText("Filter", juce::dontSendNotification);
-    p.sourceLabel.setText(settingsStorage.getProperty (ParameterIDSource, juce::String()), juce::dontSendNotification);
-    p.sourceLabel.setColour(juce::Label::outlineColourId, juce::Colours::lightgrey);
-    p.sceneLabel.setText(settingsStorage.getProperty (ParameterIDScene, juce::String()), juce::dontSendNotification);
-    p.sceneLabel.setColour(juce::Label::outlineColourId, juce::Colours::lightgrey);
-    p.filterLabel.setText(settingsStorage.getProperty (ParameterIDFilter, juce::String()), juce::dontSendNotification);
-    p.filterLabel.setColour(juce::Label::outlineColourId, juce::Colours::lightgrey);
-    
-    p.commandLabel.setText("Command", juce::dontSendNotification);
-    p.commandLabel.setColour(juce::Label::backgroundColourId, juce::Colours::darkgrey);
-    p.commandSelectorTitle.setText("Command", juce::dontSendNotification);
-    p.commandCategorySelectorTitle.setText("Category", juce::dontSendNotification);
-    p.commandCategorySelector.setSelectedId(settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault));
-    p.commandSelectorSource.setSelectedId(settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault));
-    p.commandSelectorFilter.setSelectedId(settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault));
-    p.commandSelectorTypeText.setSelectedId(settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault));
-    
-    
-    p.valueSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, false, 0, 0);
-    p.valueSliderValue.setColour(juce::Label::textColourId, juce::Colours::darkgrey);
-    
-    p.rangeLabel.setText("Range", juce::dontSendNotification);
-    p.rangeLabel.setColour(juce::Label::backgroundColourId, juce::Colours::darkgrey);
-    p.rangeLowerTitleLabel.setText("Lower", juce::dontSendNotification);
-    p.rangeUpperTitleLabel.setText("Upper", juce::dontSendNotification);
-    p.rangeLowerLabel.setColour(juce::Label::outlineColourId, juce::Colours::lightgrey);
-    p.rangeUpperLabel.setColour(juce::Label::outlineColourId, juce::Colours::lightgrey);
-    p.rangeLowerLabel.setText(settingsStorage.getProperty (ParameterIDRangeLower, juce::String("0.0")), juce::dontSendNotification);
-    p.rangeUpperLabel.setText(settingsStorage.getProperty (ParameterIDRangeUpper, juce::String("1.0")), juce::dontSendNotification);
-    
-    p.typeTextTextLabel.setColour(juce::Label::outlineColourId, juce::Colours::lightgrey);
-    p.typeTextTitleLabel.setColour(juce::Label::backgroundColourId, juce::Colours::darkgrey);
-    p.typeTextTitleLabel.setText("Text", juce::dontSendNotification);
-    p.typeTextCursorCharacterTitleLabel.setText("Cursor character", juce::dontSendNotification);
-    p.typeTextCursorCharacterTitleLabel.setColour(juce::Label::backgroundColourId, juce::Colours::darkgrey);
-    p.typeTextCursorCharacterLabel.setText(settingsStorage.getProperty(ParameterIDTypeTextCursorCharacter, juce::String()), juce::dontSendNotification);
-    p.typeTextCursorCharacterLabel.setColour(juce::Label::outlineColourId, juce::Colours::lightgrey);
-    
-    p.translateSliderValueAndDisplay(p.valueSlider.getValue());
-    p.setCommandComboVisibleState();
-    
-    p.sendEnabled = true;
+    ipLabel.setEditable(true);
+    ipLabel.onTextChange = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDIP, ipLabel.getText(), nullptr);
+        audioProcessor.engine.close();
+        audioProcessor.engine.connect();
+    };
+    
+    portLabel.setEditable(true);
+    portLabel.onTextChange = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDPort, portLabel.getText(), nullptr);
+        audioProcessor.engine.close();
+        audioProcessor.engine.connect();
+    };
+    
+    udpToggle.onClick = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDUDP, udpToggle.getToggleState(), nullptr);
+        audioProcessor.engine.close();
+        audioProcessor.engine.connect();
+    };
+    
+    queueToggle.onClick = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDQueueWhileConnecting, queueToggle.getToggleState(), nullptr);
+        audioProcessor.engine.close();
+        audioProcessor.engine.connect();
+    };
+    
+    sourceLabel.setEditable(true);
+    sourceLabel.onTextChange = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDSource, sourceLabel.getText(), nullptr);
+        audioProcessor.engine.requestValue();
+        audioProcessor.engine.sendTypeTextState();
+    };
+    
+    sceneLabel.setEditable(true);
+    sceneLabel.onTextChange = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDScene, sceneLabel.getText(), nullptr);
+        audioProcessor.engine.requestValue();
+        audioProcessor.engine.sendTypeTextState();
+    };
+    
+    filterLabel.setEditable(true);
+    filterLabel.onTextChange = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDFilter, filterLabel.getText(), nullptr);
+        audioProcessor.engine.requestValue();
+    };
+    
+    attachCompletion(sceneLabel, ObviousCatalogue::Kind::Scene);
+    attachCompletion(sourceLabel, ObviousCatalogue::Kind::Item);
+    attachCompletion(filterLabel, ObviousCatalogue::Kind::Filter);
+    
+    rangeLowerLabel.setEditable(true);
+    rangeLowerLabel.onTextChange = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDRangeLower, rangeLowerLabel.getText().getDoubleValue(), nullptr);
+    };
+    
+    rangeUpperLabel.setEditable(true);
+    rangeUpperLabel.onTextChange = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDRangeUpper, rangeUpperLabel.getText().getDoubleValue(), nullptr);
+    };
+    
+    relativeToggle.onClick = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDRelative, relativeToggle.getToggleState(), nullptr);
+    };
+    
+    batchTransformToggle.onClick = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDBatchTransform, batchTransformToggle.getToggleState(), nullptr);
+    };
+    
+    followTransportToggle.onClick = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDFollowTransport, followTransportToggle.getToggleState(), nullptr);
+        audioProcessor.engine.requestValue();
+    };
+    
+    // The engine picks up LFO changes on the next audio block
+    lfoToggle.onClick = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDLFO, lfoToggle.getToggleState(), nullptr);
+    };
+    
+    lfoWaveformSelector.addItem("Sine", LFOWaveformSine);
+    lfoWaveformSelector.addItem("Triangle", LFOWaveformTriangle);
+    lfoWaveformSelector.addItem("Saw", LFOWaveformSaw);
+    lfoWaveformSelector.addItem("Square", LFOWaveformSquare);
+    lfoWaveformSelector.onChange = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDLFOWaveform, lfoWaveformSelector.getSelectedId(), nullptr);
+    };
+    
+    lfoBeatsLabel.setEditable(true);
+    lfoBeatsLabel.onTextChange = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDLFOBeats, lfoBeatsLabel.getText().getDoubleValue(), nullptr);
+    };
+    
+    lfoDepthLabel.setEditable(true);
+    lfoDepthLabel.onTextChange = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDLFODepth, lfoDepthLabel.getText().getDoubleValue(), nullptr);
+    };
+    
+    lfoOffsetLabel.setEditable(true);
+    lfoOffsetLabel.onTextChange = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDLFOOffset, lfoOffsetLabel.getText().getDoubleValue(), nullptr);
+    };
+    
+    lfoPhaseLabel.setEditable(true);
+    lfoPhaseLabel.onTextChange = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDLFOPhase, lfoPhaseLabel.getText().getDoubleValue(), nullptr);
+    };
+    
+    audioToggle.onClick = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDAudioReactive, audioToggle.getToggleState(), nullptr);
+    };
+    
+    audioModeSelector.addItem("Peak", AudioModePeak);
+    audioModeSelector.addItem("RMS", AudioModeRMS);
+    audioModeSelector.addItem("Bands", AudioModeBands);
+    audioModeSelector.onChange = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDAudioMode, audioModeSelector.getSelectedId(), nullptr);
+        layout(EditorLayoutPurposeUIActivity);
+    };
+    
+    audioAttackLabel.setEditable(true);
+    audioAttackLabel.onTextChange = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDAudioAttack, audioAttackLabel.getText().getDoubleValue(), nullptr);
+    };
+    
+    audioReleaseLabel.setEditable(true);
+    audioReleaseLabel.onTextChange = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDAudioRelease, audioReleaseLabel.getText().getDoubleValue(), nullptr);
+    };
+    
+    audioGainLabel.setEditable(true);
+    audioGainLabel.onTextChange = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDAudioGain, audioGainLabel.getText().getDoubleValue(), nullptr);
+    };
+    
+    audioFloorLabel.setEditable(true);
+    audioFloorLabel.onTextChange = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDAudioFloor, audioFloorLabel.getText().getDoubleValue(), nullptr);
+    };
+    
+    for (int band = 1; band <= SpectrumBandCount; ++band)
+        bandSelector.addItem(juce::String(band), band);
+    bandSelector.onChange = [this] {
+        showSelectedBand();
+    };
+    
+    // Only commands with a continuous value can follow a band
+    for (const Command &command : CommandTable::commands()) {
+        if ((command.category == CommandCategorySource || command.category == CommandCategoryFilter) && CommandTable::isContinuous(command.commandID))
+            bandCommandSelector.addItem(command.displayName, command.commandID);
+    }
+    bandCommandSelector.onChange = [this] {
+        selectedBand().setProperty(ParameterIDCommand, bandCommandSelector.getSelectedId(), nullptr);
+    };
+    
+    bandLowerLabel.setEditable(true);
+    bandLowerLabel.onTextChange = [this] {
+        selectedBand().setProperty(ParameterIDRangeLower, bandLowerLabel.getText().getDoubleValue(), nullptr);
+    };
+    
+    bandUpperLabel.setEditable(true);
+    bandUpperLabel.onTextChange = [this] {
+        selectedBand().setProperty(ParameterIDRangeUpper, bandUpperLabel.getText().getDoubleValue(), nullptr);
+    };
+    
+    bandSceneLabel.setEditable(true);
+    bandSceneLabel.onTextChange = [this] {
+        selectedBand().setProperty(ParameterIDScene, bandSceneLabel.getText(), nullptr);
+    };
+    
+    bandSourceLabel.setEditable(true);
+    bandSourceLabel.onTextChange = [this] {
+        selectedBand().setProperty(ParameterIDSource, bandSourceLabel.getText(), nullptr);
+    };
+    
+    bandFilterLabel.setEditable(true);
+    bandFilterLabel.onTextChange = [this] {
+        selectedBand().setProperty(ParameterIDFilter, bandFilterLabel.getText(), nullptr);
+    };
+    
+    // The lookahead delays the audio only while onsets are detected
+    onsetToggle.onClick = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDOnset, onsetToggle.getToggleState(), nullptr);
+        audioProcessor.updateLookahead();
+    };
+    
+    onsetThresholdLabel.setEditable(true);
+    onsetThresholdLabel.onTextChange = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDOnsetThreshold, onsetThresholdLabel.getText().getDoubleValue(), nullptr);
+    };
+    
+    onsetHoldLabel.setEditable(true);
+    onsetHoldLabel.onTextChange = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDOnsetHold, onsetHoldLabel.getText().getDoubleValue(), nullptr);
+    };
+    
+    onsetFloorLabel.setEditable(true);
+    onsetFloorLabel.onTextChange = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDOnsetFloor, onsetFloorLabel.getText().getDoubleValue(), nullptr);
+    };
+    
+    onsetLookaheadLabel.setEditable(true);
+    onsetLookaheadLabel.onTextChange = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDOnsetLookahead, onsetLookaheadLabel.getText().getDoubleValue(), nullptr);
+        audioProcessor.updateLookahead();
+    };
+
+    
+    sliderAttachment.reset (new juce::AudioProcessorValueTreeState::SliderAttachment (audioProcessor.parameters, ParameterIDValue, valueSlider));
+    buttonAttachment.reset (new juce::AudioProcessorValueTreeState::ButtonAttachment (audioProcessor.parameters, ParameterIDTrigger, triggerButton));
+    
+    valueSliderValue.setEditable(true);
+    valueSliderValue.onTextChange = [this] {
+        auto settingsStorage = audioProcessor.settings();
+        juce::String text = valueSliderValue.getText().trim();
+        float rangeLower = settingsStorage.getProperty(ParameterIDRangeLower, 0.0f);
+        float rangeUpper = settingsStorage.getProperty(ParameterIDRangeUpper, 1.0f);
+        float range = rangeUpper-rangeLower;
+        
+        // Not a number, or no range to place it in: put the slider's value back
+        if (!text.containsAnyOf("0123456789") || !text.containsOnly("0123456789.-+eE") || range == 0.0f) {
+            translateSliderValueAndDisplay((float)valueSlider.getValue());
+            return;
+        }
+        
+        double rawValue = text.getDoubleValue();
+        double value = (rawValue-rangeLower) / range;
+        
+        valueSlider.setValue(value);
+    };
+    
+    typeTextTextLabel.setEditable(true);
+    typeTextTextLabel.onTextChange = [this] {
+        
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDTypeTextText, typeTextTextLabel.getText(), nullptr);
+        audioProcessor.engine.sendTypeTextState();
+        
+    };
+    
+    typeTextCursorCharacterLabel.setEditable(true);
+    typeTextCursorCharacterLabel.onTextChange = [this] {
+        
+        auto settingsStorage = audioProcessor.settings();
+        settingsStorage.setProperty(ParameterIDTypeTextCursorCharacter, typeTextCursorCharacterLabel.getText(), nullptr);
+        audioProcessor.engine.sendTypeTextState();
+        
+    };
+    
+    triggerButton.onStateChange = [this] {
+        
+        auto settingsStorage = audioProcessor.settings();
+        int commandID = settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault);
+        int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
+        Command command = audioProcessor.commandWithID(commandID);
+//        if ((int)settingsStorage.getProperty(ParameterIDCommandCategory) == CommandCategoryTypeText) {
+//            juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::NoIcon, "Error", "No command type selected" );
+//
+//            return;
+//        }
+        
+        /*
+         We don't need to do anything if the button is a toggle
+         Toggling it causes the parameter to change, and sending
+         is therefore handled in parameterChanged()
+         */
+        if (command.requiresToggleButton || category == CommandCategoryTypeText) {
+            return;
+        }
+        
+        float value;
+        juce::Button::ButtonState state = triggerButton.getState();
+        if (state == juce::Button::buttonDown) {
+            buttonPreviouslyDown = true;
+            
+//            if (command.requiresToggleButton || category == CommandCategoryTypeText) {
+//                return;
+//            }
+            
+            value = 1.0f;
+        }
+        else if (state == juce::Button::buttonOver) {
+            if (buttonPreviouslyDown == false) {
+                return;
+            }
+            buttonPreviouslyDown = false;
+            
+            /*if (command.requiresToggleButton || category == CommandCategoryTypeText) {
+                if (triggerButton.getToggleState()) {
+                    value = 0.0f;
+                }
+                else {
+                    value = 1.0f;
+                }
+            }
+            else*/ value = 0.0f;
+        }
+        else {
+            return;
+        }
+
+//        if (category == CommandCategoryTypeText) {
+//            send(TypeSetCursorVisible, value);
+//        }
+//        else {
+            audioProcessor.engine.send(ParameterIDTrigger, value);
+//        }
+    };
+    
+    commandCategorySelector.addItem("Source", CommandCategorySource);
+    commandCategorySelector.addItem("Filter", CommandCategoryFilter);
+    commandCategorySelector.addItem("Type text", CommandCategoryTypeText);
+    commandCategorySelector.onChange = [this] {
+        
+        handleCommandCategoryChange();
+        
+    };
+    
+    
+    commandSelectorTypeText.setTextWhenNoChoicesAvailable("chill we got this");
+    
+    /*
+     TypeText needs slider, TypeSetCursorCharacter needs toggle button
+     Add command selector for this category and remember to show/hide it as necessary along with the others
+     Only add TypeText and TypeSetCursorCharacter to the command selector (SetTypeNumChars is hidden)
+     */
+    
+    /*
+     One combo box per category. Reloading a single combo box when the category changed stopped it
+     selecting the saved command on startup
+     */
+    const std::vector<Command>& commands = CommandTable::commands();
+    std::for_each(commands.begin(), commands.end(), [this](const Command& command){
+        
+        switch (command.category) {
+            case CommandCategorySource:
+                commandSelectorSource.addItem(command.displayName, command.commandID);
+                break;
+                
+            case CommandCategoryFilter:
+                commandSelectorFilter.addItem(command.displayName, command.commandID);
+                break;
+                
+            case CommandCategoryTypeText:
+                commandSelectorTypeText.addItem(command.displayName, command.commandID);
+                break;
+                
+            default:
+                break;
+        }
+        
+    });
+        
+    commandSelectorSource.onChange = [this] {
+
+        handleCommandChange(commandSelectorSource.getSelectedId());
+
+    };
+    
+    commandSelectorFilter.onChange = [this] {
+        handleCommandChange(commandSelectorFilter.getSelectedId());
+    };
+    
+    commandSelectorTypeText.onChange = [this] {
+        handleCommandChange(commandSelectorTypeText.getSelectedId());
+    };
+    
+    int commandID = settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault);
+//    juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::NoIcon, "Error", std::to_string(commandID) );
+//    Command command = audioProcessor.commandWithID(commandID);
+//    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
+    
+    // Restoring the saved command is not a change by the user, so no range warning or relayout yet
+    ignoreCommandSelectorChanges = true;
+    handleCommandCategoryChange();
+    handleCommandChange(commandID);
+    ignoreCommandSelectorChanges = false;
+    setCommandComboVisibleState();
+    
+    connectionLabel.setText("Connection", juce::dontSendNotification);
+    connectionLabel.setColour(juce::Label::backgroundColourId, juce::Colours::darkgrey);
+    ipTitleLabel.setText("IP Address", juce::dontSendNotification);
+    portTitleLabel.setText("Port", juce::dontSendNotification);
+    ipLabel.setText(settingsStorage.getProperty (ParameterIDIP, juce::String("127.0.0.1")), juce::dontSendNotification);
+    ipLabel.setColour(juce::Label::outlineColourId, juce::Colours::lightgrey);
+    portLabel.setText(settingsStorage.getProperty (ParameterIDPort, juce::String("11111")), juce::dontSendNotification);
+    portLabel.setColour(juce::Label::outlineColourId, juce::Colours::lightgrey);
+    udpToggle.setButtonText("Values over UDP");
+    udpToggle.setToggleState(settingsStorage.getProperty (ParameterIDUDP, false), juce::dontSendNotification);
+    queueToggle.setButtonText("Queue while connecting");
+    queueToggle.setToggleState(settingsStorage.getProperty (ParameterIDQueueWhileConnecting, true), juce::dontSendNotification);
+    
+    targetLabel.setText("Target", juce::dontSendNotification);
+    targetLabel.setColour(juce::Label::backgroundColourId, juce::Colours::darkgrey);
+    sceneTitleLabel.setText("Scene", juce::dontSendNotification);
+    sourceTitleLabel.setText("Source", juce::dontSendNotification);
+    filterTitleLabel.setText("Filter", juce::dontSendNotification);
+    sourceLabel.setText(settingsStorage.getProperty (ParameterIDSource, juce::String()), juce::dontSendNotification);
+    sourceLabel.setColour(juce::Label::outlineColourId, juce::Colours::lightgrey);
+    sceneLabel.setText(settingsStorage.getProperty (ParameterIDScene, juce::String()), juce::dontSendNotification);
+    sceneLabel.setColour(juce::Label::outlineColourId, juce::Colours::lightgrey);
+    filterLabel.setText(settingsStorage.getProperty (ParameterIDFilter, juce::String()), juce::dontSendNotification);
+    filterLabel.setColour(juce::Label::outlineColourId, juce::Colours::lightgrey);
+    
+    commandLabel.setText("Command", juce::dontSendNotification);
+    commandLabel.setColour(juce::Label::backgroundColourId, juce::Colours::darkgrey);
+    commandSelectorTitle.setText("Command", juce::dontSendNotification);
+    commandCategorySelectorTitle.setText("Category", juce::dontSendNotification);
+    // The combo boxes are new with every editor, so showing the saved selection must not look like a change
+    commandCategorySelector.setSelectedId(settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault), juce::dontSendNotification);
+    commandSelectorSource.setSelectedId(settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault), juce::dontSendNotification);
+    commandSelectorFilter.setSelectedId(settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault), juce::dontSendNotification);
+    commandSelectorTypeText.setSelectedId(settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault), juce::dontSendNotification);
+    
+    
+    valueSlider.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::NoTextBox, false, 0, 0);
+    valueSliderValue.setColour(juce::Label::textColourId, juce::Colours::darkgrey);
+    
+    rangeLabel.setText("Range", juce::dontSendNotification);
+    rangeLabel.setColour(juce::Label::backgroundColourId, juce::Colours::darkgrey);
+    relativeToggle.setButtonText("Relative");
+    relativeToggle.setTooltip("Send changes of the value, which OBS adds to what it shows");
+    relativeToggle.setToggleState(settingsStorage.getProperty (ParameterIDRelative, false), juce::dontSendNotification);
+    batchTransformToggle.setButtonText("Batch transform");
+    batchTransformToggle.setTooltip("Send with the other position, scale, rotation, crop and bounds values set for this source in the same audio block, applied by OBS in one update");
+    batchTransformToggle.setToggleState(settingsStorage.getProperty (ParameterIDBatchTransform, false), juce::dontSendNotification);
+    followTransportToggle.setButtonText("Follow transport");
+    followTransportToggle.setTooltip("Play, pause and seek the media with the host's transport, correcting it when it drifts");
+    followTransportToggle.setToggleState(settingsStorage.getProperty (ParameterIDFollowTransport, false), juce::dontSendNotification);
+    rangeLowerTitleLabel.setText("Lower", juce::dontSendNotification);
+    rangeUpperTitleLabel.setText("Upper", juce::dontSendNotification);
+    rangeLowerLabel.setColour(juce::Label::outlineColourId, juce::Colours::lightgrey);
+    rangeUpperLabel.setColour(juce::Label::outlineColourId, juce::Colours::lightgrey);
+    rangeLowerLabel.setText(settingsStorage.getProperty (ParameterIDRangeLower, juce::String("0.0")), juce::dontSendNotification);
+    rangeUpperLabel.setText(settingsStorage.getProperty (ParameterIDRangeUpper, juce::String("1.0")), juce::dontSendNotification);
+    
+    lfoLabel.setText("LFO", juce::dontSendNotification);
+    lfoLabel.setColour(juce::Label::backgroundColourId, juce::Colours::darkgrey);
+    lfoWaveformSelector.setSelectedId(settingsStorage.getProperty (ParameterIDLFOWaveform, LFOWaveformDefault), juce::dontSendNotification);
+    lfoToggle.setButtonText("On");
+    lfoToggle.setTooltip("OBS moves the value through the range in time with the host's tempo, instead of following the slider");
+    lfoToggle.setToggleState(settingsStorage.getProperty (ParameterIDLFO, false), juce::dontSendNotification);
+    lfoBeatsTitleLabel.setText("Beats", juce::dontSendNotification);
+    lfoBeatsTitleLabel.setTooltip("Length of one cycle, in beats");
+    lfoDepthTitleLabel.setText("Depth", juce::dontSendNotification);
+    lfoDepthTitleLabel.setTooltip("How much of the range the value swings through, 0 to 1");
+    lfoOffsetTitleLabel.setText("Offset", juce::dontSendNotification);
+    lfoOffsetTitleLabel.setTooltip("Centre of the swing, 0 to 1 across the range");
+    lfoPhaseTitleLabel.setText("Phase", juce::dontSendNotification);
+    lfoPhaseTitleLabel.setTooltip("Start of the cycle, in cycles");
+    lfoBeatsLabel.setText(settingsStorage.getProperty (ParameterIDLFOBeats, juce::String("1.0")), juce::dontSendNotification);
+    lfoDepthLabel.setText(settingsStorage.getProperty (ParameterIDLFODepth, juce::String("1.0")), juce::dontSendNotification);
+    lfoOffsetLabel.setText(settingsStorage.getProperty (ParameterIDLFOOffset, juce::String("0.5")), juce::dontSendNotification);
+    lfoPhaseLabel.setText(settingsStorage.getProperty (ParameterIDLFOPhase, juce::String("0.0")), juce::dontSendNotification);
+    for (auto* label : { &lfoBeatsLabel, &lfoDepthLabel, &lfoOffsetLabel, &lfoPhaseLabel })
+        label->setColour(juce::Label::outlineColourId, juce::Colours::lightgrey);
+    
+    const EnvelopeFollower::Settings envelopeDefaults;
+    audioLabel.setText("Audio", juce::dontSendNotification);
+    audioLabel.setColour(juce::Label::backgroundColourId, juce::Colours::darkgrey);
+    audioModeSelector.setSelectedId(settingsStorage.getProperty (ParameterIDAudioMode, AudioModeDefault), juce::dontSendNotification);
+    audioToggle.setButtonText("On");
+    audioToggle.setTooltip("The plugin's input drives the value instead of the slider, sent once per video frame");
+    audioToggle.setToggleState(settingsStorage.getProperty (ParameterIDAudioReactive, false), juce::dontSendNotification);
+    audioAttackTitleLabel.setText("Attack", juce::dontSendNotification);
+    audioAttackTitleLabel.setTooltip("How fast the value rises with the input, in milliseconds");
+    audioReleaseTitleLabel.setText("Release", juce::dontSendNotification);
+    audioReleaseTitleLabel.setTooltip("How fast the value falls back, in milliseconds");
+    audioGainTitleLabel.setText("Gain", juce::dontSendNotification);
+    audioGainTitleLabel.setTooltip("Applied to the input's level, in dB");
+    audioFloorTitleLabel.setText("Floor", juce::dontSendNotification);
+    audioFloorTitleLabel.setTooltip("The level at the bottom of the range, in dB; 0 dB is the top");
+    audioAttackLabel.setText(settingsStorage.getProperty (ParameterIDAudioAttack, envelopeDefaults.attackMs).toString(), juce::dontSendNotification);
+    audioReleaseLabel.setText(settingsStorage.getProperty (ParameterIDAudioRelease, envelopeDefaults.releaseMs).toString(), juce::dontSendNotification);
+    audioGainLabel.setText(settingsStorage.getProperty (ParameterIDAudioGain, envelopeDefaults.gainDecibels).toString(), juce::dontSendNotification);
+    audioFloorLabel.setText(settingsStorage.getProperty (ParameterIDAudioFloor, envelopeDefaults.floorDecibels).toString(), juce::dontSendNotification);
+    for (auto* label : { &audioAttackLabel, &audioReleaseLabel, &audioGainLabel, &audioFloorLabel })
+        label->setColour(juce::Label::outlineColourId, juce::Colours::lightgrey);
+    
+    bandTitleLabel.setText("Band", juce::dontSendNotification);
+    bandTitleLabel.setTooltip("Bands are spaced evenly in pitch, from 1 at 40 Hz to 8 ending at 16 kHz; each drives its own target");
+    bandCommandSelector.setTooltip("The command the band's level sets, from Lower at the floor to Upper at 0 dB");
+    bandLowerTitleLabel.setText("Lower", juce::dontSendNotification);
+    bandUpperTitleLabel.setText("Upper", juce::dontSendNotification);
+    bandSceneTitleLabel.setText("Scene", juce::dontSendNotification);
+    bandSourceTitleLabel.setText("Source", juce::dontSendNotification);
+    bandFilterTitleLabel.setText("Filter", juce::dontSendNotification);
+    for (auto* label : { &bandLowerLabel, &bandUpperLabel, &bandSceneLabel, &bandSourceLabel, &bandFilterLabel })
+        label->setColour(juce::Label::outlineColourId, juce::Colours::lightgrey);
+    bandSelector.setSelectedId(1, juce::dontSendNotification);
+    showSelectedBand();
+    
+    const OnsetDetector::Settings onsetDefaults;
+    onsetLabel.setText("Onset", juce::dontSendNotification);
+    onsetLabel.setColour(juce::Label::backgroundColourId, juce::Colours::darkgrey);
+    onsetToggle.setButtonText("On");
+    onsetToggle.setTooltip("Hits in the plugin's input fire the command, applied by OBS on the frame the hit is heard");
+    onsetToggle.setToggleState(settingsStorage.getProperty (ParameterIDOnset, false), juce::dontSendNotification);
+    onsetThresholdTitleLabel.setText("Threshold", juce::dontSendNotification);
+    onsetThresholdTitleLabel.setTooltip("How much louder than the last 100 ms a hit is, in dB");
+    onsetHoldTitleLabel.setText("Hold", juce::dontSendNotification);
+    onsetHoldTitleLabel.setTooltip("The shortest time between two hits, in milliseconds");
+    onsetFloorTitleLabel.setText("Floor", juce::dontSendNotification);
+    onsetFloorTitleLabel.setTooltip("Nothing quieter is a hit, in dB");
+    onsetLookaheadTitleLabel.setText("Lookahead", juce::dontSendNotification);
+    onsetLookaheadTitleLabel.setTooltip("Delays the audio by up to 100 ms, reported to the host as latency, so hits are sent early enough to cover the network");
+    onsetThresholdLabel.setText(settingsStorage.getProperty (ParameterIDOnsetThreshold, onsetDefaults.thresholdDecibels).toString(), juce::dontSendNotification);
+    onsetHoldLabel.setText(settingsStorage.getProperty (ParameterIDOnsetHold, onsetDefaults.holdMs).toString(), juce::dontSendNotification);
+    onsetFloorLabel.setText(settingsStorage.getProperty (ParameterIDOnsetFloor, onsetDefaults.floorDecibels).toString(), juce::dontSendNotification);
+    onsetLookaheadLabel.setText(settingsStorage.getProperty (ParameterIDOnsetLookahead, 0.0f).toString(), juce::dontSendNotification);
+    for (auto* label : { &onsetThresholdLabel, &onsetHoldLabel, &onsetFloorLabel, &onsetLookaheadLabel })
+        label->setColour(juce::Label::outlineColourId, juce::Colours::lightgrey);
+    
+    typeTextTextLabel.setColour(juce::Label::outlineColourId, juce::Colours::lightgrey);
+    typeTextTitleLabel.setColour(juce::Label::backgroundColourId, juce::Colours::darkgrey);
+    typeTextTitleLabel.setText("Text", juce::dontSendNotification);
+    typeTextCursorCharacterTitleLabel.setText("Cursor character", juce::dontSendNotification);
+    typeTextCursorCharacterTitleLabel.setColour(juce::Label::backgroundColourId, juce::Colours::darkgrey);
+    typeTextCursorCharacterLabel.setText(settingsStorage.getProperty(ParameterIDTypeTextCursorCharacter, juce::String()), juce::dontSendNotification);
+    typeTextCursorCharacterLabel.setColour(juce::Label::outlineColourId, juce::Colours::lightgrey);
+    
+    translateSliderValueAndDisplay(valueSlider.getValue());
+    setCommandComboVisibleState();
+    
+    p.engine.sendEnabled = true;
 //    
     setSize (settingsStorage.getProperty(ParameterIDWindowWidth, 400), settingsStorage.getProperty(ParameterIDWindowHeight, 300));
     
+    displayedValue = p.engine.lastTranslatedValue();
+    startTimerHz(refreshHz);
+    
 }
 
 
@@ -129,6 +679,328 @@ bool ObviousAudioProcessorEditor::hitTest (int x, int y)
 
 ObviousAudioProcessorEditor::~ObviousAudioProcessorEditor()
 {
+    stopTimer();
+    saveWindowSize();
+}
+
+void ObviousAudioProcessorEditor::timerCallback()
+{
+    
+    // Only formatted and redrawn when the engine has sent a different value
+    const float value = audioProcessor.engine.lastTranslatedValue();
+    if (value != displayedValue) {
+        displayedValue = value;
+        valueSliderValue.setText(juce::String(value, 6), juce::dontSendNotification);
+    }
+    
+    ++refreshTicks;
+    if (refreshTicks % statusEveryTicks == 0) {
+        statusLine.refresh();
+        refreshTargetValidity();
+    }
+    if (refreshTicks % statsEveryTicks == 0) statsPanel.refresh();
+    
+    if (unsavedWidth > 0 && ++ticksSinceResize >= sizeSettledTicks) {
+        saveWindowSize();
+    }
+    
+}
+
+void ObviousAudioProcessorEditor::saveWindowSize()
+{
+    
+    if (unsavedWidth <= 0) return;
+    
+    auto settingsStorage = audioProcessor.settings();
+    settingsStorage.setProperty(ParameterIDWindowWidth, unsavedWidth, nullptr);
+    settingsStorage.setProperty(ParameterIDWindowHeight, unsavedHeight, nullptr);
+    unsavedWidth = 0;
+    unsavedHeight = 0;
+    
+}
+
+void ObviousAudioProcessorEditor::attachCompletion(juce::Label &label, ObviousCatalogue::Kind kind)
+{
+    
+    label.onEditorShow = [this, &label, kind] {
+        if (auto *editor = label.getCurrentTextEditor()) {
+            auto typed = std::make_shared<juce::String>(editor->getText());
+            editor->onTextChange = [this, editor, kind, typed] { completeName(*editor, kind, *typed); };
+        }
+    };
+    
+}
+
+/*
+ Completes the name inline as the user types, with the completed part
+ selected so the next key replaces it. Deleting never completes, so a name
+ that is a prefix of another can still be entered.
+ */
+void ObviousAudioProcessorEditor::completeName(juce::TextEditor &editor, ObviousCatalogue::Kind kind, juce::String &typed)
+{
+    
+    const juce::String text = editor.getText();
+    const bool appended = text.length() > typed.length() && text.startsWith(typed)
+                          && editor.getHighlightedRegion().isEmpty() && editor.getCaretPosition() == text.length();
+    typed = text;
+    
+    auto targets = audioProcessor.engine.catalogue();
+    if (!appended || targets == nullptr) return;
+    
+    auto settingsStorage = audioProcessor.settings();
+    juce::String context;
+    if (kind == ObviousCatalogue::Kind::Item) context = settingsStorage.getProperty(ParameterIDScene, juce::String());
+    else if (kind == ObviousCatalogue::Kind::Filter) context = settingsStorage.getProperty(ParameterIDSource, juce::String());
+    
+    const juce::StringArray matches = targets->completions(kind, context, text, 1);
+    if (matches.isEmpty() || matches[0].length() <= text.length()) return;
+    
+    editor.setText(matches[0], false);
+    editor.setHighlightedRegion({ text.length(), matches[0].length() });
+    
+}
+
+// Marks the scene, source or filter OBS does not have, once the catalogue is complete
+void ObviousAudioProcessorEditor::refreshTargetValidity()
+{
+    
+    auto targets = audioProcessor.engine.catalogue();
+    const bool known = targets != nullptr && targets->isComplete();
+    const uint32_t revision = known ? targets->getRevision() : 0;
+    
+    auto settingsStorage = audioProcessor.settings();
+    const juce::String scene = settingsStorage.getProperty(ParameterIDScene, juce::String());
+    const juce::String source = settingsStorage.getProperty(ParameterIDSource, juce::String());
+    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
+    const juce::String filter = category == CommandCategoryFilter ? settingsStorage.getProperty(ParameterIDFilter, juce::String()).toString() : juce::String();
+    
+    const juce::String target = scene + "/" + source + "/" + filter;
+    if (revision == checkedCatalogueRevision && target == checkedTarget) return;
+    
+    auto result = ObviousCatalogue::Check::Unknown;
+    if (known) {
+        result = targets->check(scene.toStdString(), source.toStdString(), filter.toStdString());
+        // The catalogue was being updated; look again on the next refresh
+        if (result == ObviousCatalogue::Check::Unknown) return;
+    }
+    
+    checkedCatalogueRevision = revision;
+    checkedTarget = target;
+    
+    auto mark = [](juce::Label &label, bool missing) {
+        if (missing) {
+            label.setColour(juce::Label::textColourId, juce::Colours::orange);
+            label.setTooltip("Not found in OBS");
+        }
+        else {
+            label.removeColour(juce::Label::textColourId);
+            label.setTooltip({});
+        }
+    };
+    
+    mark(sceneLabel, result == ObviousCatalogue::Check::MissingScene);
+    mark(sourceLabel, result == ObviousCatalogue::Check::MissingSource);
+    mark(filterLabel, result == ObviousCatalogue::Check::MissingFilter);
+    
+}
+
+float ObviousAudioProcessorEditor::translateSliderValueAndDisplay(float rawValue) {
+    float translated = audioProcessor.translateSliderValue(rawValue);
+    valueSliderValue.setText(juce::String(translated, 6), juce::dontSendNotification);
+    return translated;
+}
+
+void ObviousAudioProcessorEditor::handleCommandCategoryChange() {
+    
+    if (!ignoreCommandSelectorChanges) {
+        
+        int categoryID = commandCategorySelector.getSelectedId();
+        if (categoryID > 0) {
+            auto settingsStorage = audioProcessor.settings();
+            settingsStorage.setProperty(ParameterIDCommandCategory, categoryID, nullptr);
+            layout(EditorLayoutPurposeUIActivity);
+        }
+        
+        setButtonTitle();
+        setButtonColour();
+        setTriggerVisibleState();
+        setTriggerButtonToggleState();
+        
+    }
+    
+}
+
+void ObviousAudioProcessorEditor::setButtonColour() {
+    
+    auto settingsStorage = audioProcessor.settings();
+    int commandID = settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault);
+    Command command = audioProcessor.commandWithID(commandID);
+    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
+    
+    if (command.requiresToggleButton || category == CommandCategoryTypeText) {
+        triggerButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::green);
+        triggerButton.setColour(juce::TextButton::buttonColourId, juce::Colours::orange);
+    }
+    else {
+        triggerButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::transparentBlack);
+        triggerButton.setColour(juce::TextButton::buttonColourId, juce::Colours::transparentBlack);
+    }
+    
+}
+
+void ObviousAudioProcessorEditor::setButtonTitle() {
+    
+    auto settingsStorage = audioProcessor.settings();
+    
+    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
+    if (category == CommandCategoryTypeText) {
+        triggerButton.setButtonText("Show cursor");
+    }
+    else {
+        int commandID = settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault);
+        switch (commandID) {
+            case MediaRestart:
+                triggerButton.setButtonText("Restart");
+                break;
+                
+            case MediaStop:
+                triggerButton.setButtonText("Stop");
+                break;
+                
+            case MediaPlay:
+                triggerButton.setButtonText("Play");
+                break;
+                
+            case MediaPause:
+                triggerButton.setButtonText("Pause");
+                break;
+                
+            case SetVisible:
+                triggerButton.setButtonText("Visible");
+                break;
+                
+            default:
+                triggerButton.setButtonText("Send");
+                break;
+        }
+    }
+    
+}
+
+void ObviousAudioProcessorEditor::setTriggerButtonToggleState() {
+    
+    auto settingsStorage = audioProcessor.settings();
+    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
+    int commandID = settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault);
+    Command selectedCommand = audioProcessor.commandWithID(commandID);
+    triggerButton.setClickingTogglesState(selectedCommand.requiresToggleButton || category == CommandCategoryTypeText);
+    
+    if (category == CommandCategoryTypeText) {
+        triggerButton.setToggleState(settingsStorage.getProperty(ParameterIDTypeTextCursorVisible, false), juce::dontSendNotification);
+    }
+    
+}
+
+void ObviousAudioProcessorEditor::handleCommandChange(int commandID) {
+    
+//            if (!ignoreCommandSelectorChanges) {
+//
+//                ignoreCommandSelectorChanges = true;
+                
+    
+
+//                int commandID = selector.getSelectedId();
+
+                if (commandID > 0) {
+
+                    auto settingsStorage = audioProcessor.settings();
+                    
+                    settingsStorage.setProperty(ParameterIDCommand, commandID, nullptr);
+                    Command selectedCommand = audioProcessor.commandWithID(commandID);
+                    selectedCommand = audioProcessor.commandWithID(commandID);
+
+                    triggerButton.setToggleState(false, juce::dontSendNotification);
+
+                    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
+
+                    if (selectedCommand.triggerParameterID == ParameterIDTrigger || category == CommandCategoryTypeText) {
+
+                        setTriggerButtonToggleState();
+//                        juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::NoIcon, "Info", std::to_string(category) );
+                    }
+
+                    switch (selectedCommand.category) {
+                        case CommandCategorySource:
+                            commandSelectorFilter.setSelectedId(0);
+                            commandSelectorTypeText.setSelectedId(0);
+                            break;
+
+                        case CommandCategoryFilter:
+                            commandSelectorSource.setSelectedId(0);
+                            commandSelectorTypeText.setSelectedId(0);
+                            break;
+
+                        case CommandCategoryTypeText:
+                            commandSelectorSource.setSelectedId(0);
+                            commandSelectorFilter.setSelectedId(0);
+                            break;
+
+                        default:
+                            break;
+                    }
+
+                    if (!ignoreCommandSelectorChanges) {
+                        if (selectedCommand.recommendedRangeLower != std::numeric_limits<int>::max() || selectedCommand.recommendedRangeUpper != std::numeric_limits<int>::max()) {
+
+
+                            float rangeLower = settingsStorage.getProperty (ParameterIDRangeLower, 0);
+                            float rangeUpper = settingsStorage.getProperty (ParameterIDRangeUpper, 1);
+
+                            if (selectedCommand.recommendedRangeLower != rangeLower || selectedCommand.recommendedRangeUpper != rangeUpper) {
+
+                                std::string rangeWarning = "The recommended range for this command is " + std::to_string(selectedCommand.recommendedRangeLower) + " to " + std::to_string(selectedCommand.recommendedRangeUpper) + " (current range: " + std::to_string(rangeLower) + " to " + std::to_string(rangeUpper) + ")";
+                                juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::NoIcon, "Info", rangeWarning );
+
+                            }
+
+                        }
+                        setTriggerVisibleState();
+                        layout(EditorLayoutPurposeUIActivity);
+                        setButtonTitle();
+                        setButtonColour();
+                        audioProcessor.engine.requestValue();
+                        audioProcessor.engine.sendTypeTextState();
+//                        layout(EditorLayoutPurposeUIActivity);
+                    }
+                    
+                }
+                
+//                ignoreCommandSelectorChanges = false;
+//
+//            }
+    
+}
+
+void ObviousAudioProcessorEditor::setTriggerVisibleState() {
+    
+    auto settingsStorage = audioProcessor.settings();
+    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
+    int commandID = settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault);
+    Command selectedCommand = audioProcessor.commandWithID(commandID);
+    
+    valueSlider.setVisible(selectedCommand.triggerParameterID == ParameterIDValue || category == CommandCategoryTypeText);
+    triggerButton.setVisible(selectedCommand.triggerParameterID == ParameterIDTrigger || category == CommandCategoryTypeText);
+    
+}
+
+void ObviousAudioProcessorEditor::setCommandComboVisibleState() {
+    
+    auto settingsStorage = audioProcessor.settings();
+    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
+    commandSelectorSource.setVisible(category == CommandCategorySource);
+    commandSelectorFilter.setVisible(category == CommandCategoryFilter);
+    commandSelectorTypeText.setVisible(category == CommandCategoryTypeText);
+    
 }
 
 //==============================================================================
@@ -138,10 +1010,10 @@ void ObviousAudioProcessorEditor::paint (juce::Graphics& g)
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
     
-    if (audioProcessor.valueSlider.isVisible()) {
+    if (valueSlider.isVisible()) {
         
         g.setColour(juce::Colours::lightgrey);
-        juce::Rectangle<int> sliderBounds = audioProcessor.valueSlider.getBounds();
+        juce::Rectangle<int> sliderBounds = valueSlider.getBounds();
         sliderBounds.setWidth(getWidth());
         g.fillRect(sliderBounds);
         
@@ -149,34 +1021,69 @@ void ObviousAudioProcessorEditor::paint (juce::Graphics& g)
 
 }
 
-int ObviousAudioProcessorEditor::numItems() {
+int ObviousAudioProcessorEditor::numItems(int category, const Command &command) {
+    
+    // Two rows of each are the status line and the stats panel, and two more the band target in the bands audio mode
+    const int bandItems = bandsVisible(category, command) ? 2 : 0;
+    if (category == CommandCategoryTypeText) return 16;
+    else if (CommandTable::isContinuous(command.commandID)) return 15 + bandItems;
+    else if (command.triggerParameterID == ParameterIDValue) return 13 + bandItems;
+    else return 11;
+}
+
+bool ObviousAudioProcessorEditor::bandsVisible(int category, const Command &command) {
     
     auto settingsStorage = audioProcessor.settings();
-    int commandID = settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault);
-    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
+    return category != CommandCategoryTypeText && command.triggerParameterID == ParameterIDValue
+           && (int)settingsStorage.getProperty(ParameterIDAudioMode, AudioModeDefault) == AudioModeBands;
+    
+}
+
+// The settings of the band being edited, with all the bands created the first time one is
+juce::ValueTree ObviousAudioProcessorEditor::selectedBand() {
+    
+    auto bands = audioProcessor.settings().getOrCreateChildWithName(ParameterIDSpectrumBands, nullptr);
+    while (bands.getNumChildren() < SpectrumBandCount)
+        bands.appendChild(juce::ValueTree(ParameterIDSpectrumBand), nullptr);
+    
+    return bands.getChild(juce::jlimit(0, SpectrumBandCount - 1, bandSelector.getSelectedId() - 1));
+    
+}
+
+void ObviousAudioProcessorEditor::showSelectedBand() {
+    
+    // Read without creating the bands, so opening the editor does not change the settings
+    auto bands = audioProcessor.settings().getChildWithName(ParameterIDSpectrumBands);
+    auto band = bands.getChild(juce::jlimit(0, SpectrumBandCount - 1, bandSelector.getSelectedId() - 1));
+    bandCommandSelector.setSelectedId(band.getProperty(ParameterIDCommand, 0), juce::dontSendNotification);
+    bandLowerLabel.setText(band.getProperty(ParameterIDRangeLower, juce::String("0.0")), juce::dontSendNotification);
+    bandUpperLabel.setText(band.getProperty(ParameterIDRangeUpper, juce::String("1.0")), juce::dontSendNotification);
+    bandSceneLabel.setText(band.getProperty(ParameterIDScene, juce::String()), juce::dontSendNotification);
+    bandSourceLabel.setText(band.getProperty(ParameterIDSource, juce::String()), juce::dontSendNotification);
+    bandFilterLabel.setText(band.getProperty(ParameterIDFilter, juce::String()), juce::dontSendNotification);
     
-    Command command = audioProcessor.commandWithID(commandID);
-    if (category == CommandCategoryTypeText) return 14;
-    else if (command.triggerParameterID == ParameterIDValue) return 9;
-    else return 7;
 }
 
 void ObviousAudioProcessorEditor::resized() {
     
     layout(EditorLayoutPurposeResized);
     
-    audioProcessor.setButtonTitle();
-    audioProcessor.setButtonColour();
-    audioProcessor.setTriggerVisibleState();
-    audioProcessor.setTriggerButtonToggleState();
+    setButtonTitle();
+    setButtonColour();
+    setTriggerVisibleState();
+    setTriggerButtonToggleState();
 }
 
-int previousNumItems = -1;
-
 void ObviousAudioProcessorEditor::layout(EditorLayoutPurpose purpose)
 {
     
-    int currentNumItems = numItems();
+    // One lookup of the settings and the command for the whole layout
+    auto settingsStorage = audioProcessor.settings();
+    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
+    int commandID = settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault);
+    const Command &command = CommandTable::withID(commandID);
+    
+    int currentNumItems = numItems(category, command);
     
     juce::Rectangle<int> bounds = getBounds();
     int width = bounds.getWidth();
@@ -195,10 +1102,10 @@ void ObviousAudioProcessorEditor::layout(EditorLayoutPurpose purpose)
 
     }
 
-    auto settingsStorage = audioProcessor.settings();
+    unsavedWidth = width;
+    unsavedHeight = height;
+    ticksSinceResize = 0;
     
-    settingsStorage.setProperty(ParameterIDWindowWidth, width, nullptr);
-    settingsStorage.setProperty(ParameterIDWindowHeight, height, nullptr);
     int halfWidth = width/2;
     int quarterWidth = width/4;
     int threeQuarterWidth = halfWidth+quarterWidth;
@@ -215,69 +1122,69 @@ void ObviousAudioProcessorEditor::layout(EditorLayoutPurpose purpose)
     /*
      CONNECTION
      */
-    audioProcessor.connectionLabel.setBounds(0, y, width, itemHeight);
+    connectionLabel.setBounds(0, y, width, itemHeight);
+    queueToggle.setBounds(halfWidth, y, quarterWidth, itemHeight);
+    udpToggle.setBounds(threeQuarterWidth, y, quarterWidth, itemHeight);
     y += itemHeight;
 
-    audioProcessor.ipTitleLabel.setBounds(0, y, quarterWidth, itemHeight);
-    audioProcessor.portTitleLabel.setBounds(halfWidth, y, quarterWidth, itemHeight);
+    ipTitleLabel.setBounds(0, y, quarterWidth, itemHeight);
+    portTitleLabel.setBounds(halfWidth, y, quarterWidth, itemHeight);
 
-    audioProcessor.ipLabel.setBounds(quarterWidthPlusInset, y+labelInset, quarterWidthMinusInset, labelHeight);
-    audioProcessor.portLabel.setBounds(threeQuarterWidthPlusInset, y+labelInset, quarterWidthMinusInset, labelHeight);
+    ipLabel.setBounds(quarterWidthPlusInset, y+labelInset, quarterWidthMinusInset, labelHeight);
+    portLabel.setBounds(threeQuarterWidthPlusInset, y+labelInset, quarterWidthMinusInset, labelHeight);
 
     y += itemHeight;
 
     /*
      COMMAND
      */
-    audioProcessor.commandLabel.setBounds(0, y, width, itemHeight);
+    commandLabel.setBounds(0, y, width, itemHeight);
     y+= itemHeight;
 
-    audioProcessor.commandCategorySelectorTitle.setBounds(0, y, quarterWidth, itemHeight);
-    audioProcessor.commandCategorySelector.setBounds(quarterWidth, y, quarterWidth, itemHeight);
-    audioProcessor.commandSelectorTitle.setBounds(halfWidth, y, quarterWidth, itemHeight);
+    commandCategorySelectorTitle.setBounds(0, y, quarterWidth, itemHeight);
+    commandCategorySelector.setBounds(quarterWidth, y, quarterWidth, itemHeight);
+    commandSelectorTitle.setBounds(halfWidth, y, quarterWidth, itemHeight);
     juce::Rectangle<int> commandSelectorBounds = juce::Rectangle<int>(threeQuarterWidth, y, quarterWidth, itemHeight);
-    audioProcessor.commandSelectorSource.setBounds(commandSelectorBounds);
-    audioProcessor.commandSelectorFilter.setBounds(commandSelectorBounds);
-    audioProcessor.commandSelectorTypeText.setBounds(commandSelectorBounds);
-    audioProcessor.setCommandComboVisibleState();
+    commandSelectorSource.setBounds(commandSelectorBounds);
+    commandSelectorFilter.setBounds(commandSelectorBounds);
+    commandSelectorTypeText.setBounds(commandSelectorBounds);
+    setCommandComboVisibleState();
 
     y += itemHeight;
 
     /*
      OBS TARGET
      */
-    audioProcessor.targetLabel.setBounds(0, y, width, itemHeight);
+    targetLabel.setBounds(0, y, width, itemHeight);
     y+= itemHeight;
 
-    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
-
     if (category == CommandCategoryFilter) {
 
         int thirdWidth = width/3;
         int sixthWidth = width/6;
         int sixthWidthMinusInset = sixthWidth-(labelInset*2);
 
-        audioProcessor.sceneTitleLabel.setBounds(0, y, sixthWidth, itemHeight);
-        audioProcessor.sourceTitleLabel.setBounds(thirdWidth, y, sixthWidth, itemHeight);
+        sceneTitleLabel.setBounds(0, y, sixthWidth, itemHeight);
+        sourceTitleLabel.setBounds(thirdWidth, y, sixthWidth, itemHeight);
 
-        audioProcessor.sceneLabel.setBounds(sixthWidth+labelInset, y+labelInset, sixthWidthMinusInset, labelHeight);
-        audioProcessor.sourceLabel.setBounds(halfWidth+labelInset, y+labelInset, sixthWidthMinusInset, labelHeight);
+        sceneLabel.setBounds(sixthWidth+labelInset, y+labelInset, sixthWidthMinusInset, labelHeight);
+        sourceLabel.setBounds(halfWidth+labelInset, y+labelInset, sixthWidthMinusInset, labelHeight);
 
-        audioProcessor.filterTitleLabel.setBounds(thirdWidth*2, y, sixthWidth, itemHeight);
-        audioProcessor.filterLabel.setBounds(sixthWidth*5, y+labelInset, sixthWidthMinusInset, labelHeight);
+        filterTitleLabel.setBounds(thirdWidth*2, y, sixthWidth, itemHeight);
+        filterLabel.setBounds(sixthWidth*5, y+labelInset, sixthWidthMinusInset, labelHeight);
 
-        audioProcessor.filterLabel.setVisible(true);
-        audioProcessor.filterTitleLabel.setVisible(true);
+        filterLabel.setVisible(true);
+        filterTitleLabel.setVisible(true);
     }
     else {
-        audioProcessor.sceneTitleLabel.setBounds(0, y, quarterWidth, itemHeight);
-        audioProcessor.sourceTitleLabel.setBounds(halfWidth, y, quarterWidth, itemHeight);
+        sceneTitleLabel.setBounds(0, y, quarterWidth, itemHeight);
+        sourceTitleLabel.setBounds(halfWidth, y, quarterWidth, itemHeight);
 
-        audioProcessor.sceneLabel.setBounds(quarterWidthPlusInset, y+labelInset, quarterWidthMinusInset, labelHeight);
-        audioProcessor.sourceLabel.setBounds(threeQuarterWidthPlusInset, y+labelInset, quarterWidthMinusInset, labelHeight);
+        sceneLabel.setBounds(quarterWidthPlusInset, y+labelInset, quarterWidthMinusInset, labelHeight);
+        sourceLabel.setBounds(threeQuarterWidthPlusInset, y+labelInset, quarterWidthMinusInset, labelHeight);
 
-        audioProcessor.filterLabel.setVisible(false);
-        audioProcessor.filterTitleLabel.setVisible(false);
+        filterLabel.setVisible(false);
+        filterTitleLabel.setVisible(false);
     }
 
     y += itemHeight;
@@ -286,34 +1193,31 @@ void ObviousAudioProcessorEditor::layout(EditorLayoutPurpose purpose)
      TYPE TEXT FIELDS
      */
 
-    int commandID = settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault);
-    Command command = audioProcessor.commandWithID(commandID);
-
     if (category == CommandCategoryTypeText) {
-        audioProcessor.typeTextTitleLabel.setBounds(0, y, width, itemHeight);
+        typeTextTitleLabel.setBounds(0, y, width, itemHeight);
         y += itemHeight;
         
-        audioProcessor.typeTextTextLabel.setText(settingsStorage.getProperty(ParameterIDTypeTextText, juce::String()), juce::dontSendNotification);
-        audioProcessor.typeTextTextLabel.setBounds(labelInset, y+labelInset, width-(labelInset*2), labelHeight);
+        typeTextTextLabel.setText(settingsStorage.getProperty(ParameterIDTypeTextText, juce::String()), juce::dontSendNotification);
+        typeTextTextLabel.setBounds(labelInset, y+labelInset, width-(labelInset*2), labelHeight);
         y += itemHeight;
         
-        audioProcessor.typeTextCursorCharacterTitleLabel.setBounds(0, y, width, itemHeight);
+        typeTextCursorCharacterTitleLabel.setBounds(0, y, width, itemHeight);
         y += itemHeight;
         
-        audioProcessor.typeTextCursorCharacterLabel.setText(settingsStorage.getProperty(ParameterIDTypeTextCursorCharacter), juce::dontSendNotification);
-        audioProcessor.typeTextCursorCharacterLabel.setBounds(labelInset, y+labelInset, width-(labelInset*2), labelHeight);
+        typeTextCursorCharacterLabel.setText(settingsStorage.getProperty(ParameterIDTypeTextCursorCharacter), juce::dontSendNotification);
+        typeTextCursorCharacterLabel.setBounds(labelInset, y+labelInset, width-(labelInset*2), labelHeight);
         y += itemHeight;
         
-        audioProcessor.typeTextTitleLabel.setVisible(true);
-        audioProcessor.typeTextTextLabel.setVisible(true);
-        audioProcessor.typeTextCursorCharacterTitleLabel.setVisible(true);
-        audioProcessor.typeTextCursorCharacterLabel.setVisible(true);
+        typeTextTitleLabel.setVisible(true);
+        typeTextTextLabel.setVisible(true);
+        typeTextCursorCharacterTitleLabel.setVisible(true);
+        typeTextCursorCharacterLabel.setVisible(true);
     }
     else {
-        audioProcessor.typeTextTitleLabel.setVisible(false);
-        audioProcessor.typeTextTextLabel.setVisible(false);
-        audioProcessor.typeTextCursorCharacterTitleLabel.setVisible(false);
-        audioProcessor.typeTextCursorCharacterLabel.setVisible(false);
+        typeTextTitleLabel.setVisible(false);
+        typeTextTextLabel.setVisible(false);
+        typeTextCursorCharacterTitleLabel.setVisible(false);
+        typeTextCursorCharacterLabel.setVisible(false);
     }
 
 
@@ -322,41 +1226,181 @@ void ObviousAudioProcessorEditor::layout(EditorLayoutPurpose purpose)
      RANGE
      */
     if (command.triggerParameterID == ParameterIDValue || category == CommandCategoryTypeText) {
-        audioProcessor.rangeLabel.setVisible(true);
-        audioProcessor.rangeLabel.setBounds(0, y, width, itemHeight);
+        rangeLabel.setVisible(true);
+        rangeLabel.setBounds(0, y, width, itemHeight);
+        relativeToggle.setVisible(category != CommandCategoryTypeText && CommandTable::isContinuous(commandID));
+        relativeToggle.setBounds(threeQuarterWidth, y, quarterWidth, itemHeight);
+        batchTransformToggle.setVisible(category == CommandCategorySource && ObviousTransformBatch::isField(commandID));
+        batchTransformToggle.setBounds(halfWidth, y, quarterWidth, itemHeight);
+        followTransportToggle.setVisible(category == CommandCategorySource && commandID == MediaCursor);
+        followTransportToggle.setBounds(threeQuarterWidth, y, quarterWidth, itemHeight);
         y += itemHeight;
 
-        audioProcessor.rangeLowerTitleLabel.setVisible(true);
-        audioProcessor.rangeLowerTitleLabel.setBounds(0, y, quarterWidth, itemHeight);
+        rangeLowerTitleLabel.setVisible(true);
+        rangeLowerTitleLabel.setBounds(0, y, quarterWidth, itemHeight);
 
-        audioProcessor.rangeUpperTitleLabel.setVisible(true);
-        audioProcessor.rangeUpperTitleLabel.setBounds(halfWidth, y, quarterWidth, itemHeight);
+        rangeUpperTitleLabel.setVisible(true);
+        rangeUpperTitleLabel.setBounds(halfWidth, y, quarterWidth, itemHeight);
 
-        audioProcessor.rangeLowerLabel.setVisible(true);
-        audioProcessor.rangeLowerLabel.setBounds(quarterWidthPlusInset, y+labelInset, quarterWidthMinusInset, labelHeight);
+        rangeLowerLabel.setVisible(true);
+        rangeLowerLabel.setBounds(quarterWidthPlusInset, y+labelInset, quarterWidthMinusInset, labelHeight);
 
-        audioProcessor.rangeUpperLabel.setVisible(true);
-        audioProcessor.rangeUpperLabel.setBounds(threeQuarterWidthPlusInset, y+labelInset, quarterWidthMinusInset, labelHeight);
+        rangeUpperLabel.setVisible(true);
+        rangeUpperLabel.setBounds(threeQuarterWidthPlusInset, y+labelInset, quarterWidthMinusInset, labelHeight);
 
         y += itemHeight;
     }
     else {
-        audioProcessor.rangeLabel.setVisible(false);
-        audioProcessor.rangeLowerTitleLabel.setVisible(false);
-        audioProcessor.rangeUpperTitleLabel.setVisible(false);
-        audioProcessor.rangeLowerLabel.setVisible(false);
-        audioProcessor.rangeUpperLabel.setVisible(false);
+        rangeLabel.setVisible(false);
+        relativeToggle.setVisible(false);
+        batchTransformToggle.setVisible(false);
+        followTransportToggle.setVisible(false);
+        rangeLowerTitleLabel.setVisible(false);
+        rangeUpperTitleLabel.setVisible(false);
+        rangeLowerLabel.setVisible(false);
+        rangeUpperLabel.setVisible(false);
+    }
+
+    /*
+     LFO
+     */
+    const bool lfoVisible = category != CommandCategoryTypeText && CommandTable::isContinuous(commandID);
+
+    for (juce::Component* component : std::initializer_list<juce::Component*> { &lfoLabel, &lfoWaveformSelector, &lfoToggle,
+                                                                                &lfoBeatsTitleLabel, &lfoDepthTitleLabel, &lfoOffsetTitleLabel, &lfoPhaseTitleLabel,
+                                                                                &lfoBeatsLabel, &lfoDepthLabel, &lfoOffsetLabel, &lfoPhaseLabel })
+        component->setVisible(lfoVisible);
+
+    if (lfoVisible) {
+        lfoLabel.setBounds(0, y, width, itemHeight);
+        lfoWaveformSelector.setBounds(halfWidth, y, quarterWidth, itemHeight);
+        lfoToggle.setBounds(threeQuarterWidth, y, quarterWidth, itemHeight);
+        y += itemHeight;
+
+        int eighthWidth = width/8;
+        int eighthWidthMinusInset = eighthWidth-(labelInset*2);
+
+        lfoBeatsTitleLabel.setBounds(0, y, eighthWidth, itemHeight);
+        lfoBeatsLabel.setBounds(eighthWidth+labelInset, y+labelInset, eighthWidthMinusInset, labelHeight);
+        lfoDepthTitleLabel.setBounds(quarterWidth, y, eighthWidth, itemHeight);
+        lfoDepthLabel.setBounds(quarterWidth+eighthWidth+labelInset, y+labelInset, eighthWidthMinusInset, labelHeight);
+        lfoOffsetTitleLabel.setBounds(halfWidth, y, eighthWidth, itemHeight);
+        lfoOffsetLabel.setBounds(halfWidth+eighthWidth+labelInset, y+labelInset, eighthWidthMinusInset, labelHeight);
+        lfoPhaseTitleLabel.setBounds(threeQuarterWidth, y, eighthWidth, itemHeight);
+        lfoPhaseLabel.setBounds(threeQuarterWidth+eighthWidth+labelInset, y+labelInset, eighthWidthMinusInset, labelHeight);
+        y += itemHeight;
+    }
+
+    /*
+     AUDIO
+     */
+    const bool audioVisible = category != CommandCategoryTypeText && command.triggerParameterID == ParameterIDValue;
+
+    for (juce::Component* component : std::initializer_list<juce::Component*> { &audioLabel, &audioModeSelector, &audioToggle,
+                                                                                &audioAttackTitleLabel, &audioReleaseTitleLabel, &audioGainTitleLabel, &audioFloorTitleLabel,
+                                                                                &audioAttackLabel, &audioReleaseLabel, &audioGainLabel, &audioFloorLabel })
+        component->setVisible(audioVisible);
+
+    if (audioVisible) {
+        audioLabel.setBounds(0, y, width, itemHeight);
+        audioModeSelector.setBounds(halfWidth, y, quarterWidth, itemHeight);
+        audioToggle.setBounds(threeQuarterWidth, y, quarterWidth, itemHeight);
+        y += itemHeight;
+
+        int eighthWidth = width/8;
+        int eighthWidthMinusInset = eighthWidth-(labelInset*2);
+
+        audioAttackTitleLabel.setBounds(0, y, eighthWidth, itemHeight);
+        audioAttackLabel.setBounds(eighthWidth+labelInset, y+labelInset, eighthWidthMinusInset, labelHeight);
+        audioReleaseTitleLabel.setBounds(quarterWidth, y, eighthWidth, itemHeight);
+        audioReleaseLabel.setBounds(quarterWidth+eighthWidth+labelInset, y+labelInset, eighthWidthMinusInset, labelHeight);
+        audioGainTitleLabel.setBounds(halfWidth, y, eighthWidth, itemHeight);
+        audioGainLabel.setBounds(halfWidth+eighthWidth+labelInset, y+labelInset, eighthWidthMinusInset, labelHeight);
+        audioFloorTitleLabel.setBounds(threeQuarterWidth, y, eighthWidth, itemHeight);
+        audioFloorLabel.setBounds(threeQuarterWidth+eighthWidth+labelInset, y+labelInset, eighthWidthMinusInset, labelHeight);
+        y += itemHeight;
+    }
+
+    const bool bandVisible = bandsVisible(category, command);
+
+    for (juce::Component* component : std::initializer_list<juce::Component*> { &bandTitleLabel, &bandSelector, &bandCommandSelector,
+                                                                                &bandLowerTitleLabel, &bandUpperTitleLabel, &bandLowerLabel, &bandUpperLabel,
+                                                                                &bandSceneTitleLabel, &bandSourceTitleLabel, &bandFilterTitleLabel,
+                                                                                &bandSceneLabel, &bandSourceLabel, &bandFilterLabel })
+        component->setVisible(bandVisible);
+
+    if (bandVisible) {
+        int eighthWidth = width/8;
+        int eighthWidthMinusInset = eighthWidth-(labelInset*2);
+
+        bandTitleLabel.setBounds(0, y, eighthWidth, itemHeight);
+        bandSelector.setBounds(eighthWidth, y, eighthWidth, itemHeight);
+        bandCommandSelector.setBounds(quarterWidth, y, quarterWidth, itemHeight);
+        bandLowerTitleLabel.setBounds(halfWidth, y, eighthWidth, itemHeight);
+        bandLowerLabel.setBounds(halfWidth+eighthWidth+labelInset, y+labelInset, eighthWidthMinusInset, labelHeight);
+        bandUpperTitleLabel.setBounds(threeQuarterWidth, y, eighthWidth, itemHeight);
+        bandUpperLabel.setBounds(threeQuarterWidth+eighthWidth+labelInset, y+labelInset, eighthWidthMinusInset, labelHeight);
+        y += itemHeight;
+
+        int thirdWidth = width/3;
+        int sixthWidth = width/6;
+        int sixthWidthMinusInset = sixthWidth-(labelInset*2);
+
+        bandSceneTitleLabel.setBounds(0, y, sixthWidth, itemHeight);
+        bandSceneLabel.setBounds(sixthWidth+labelInset, y+labelInset, sixthWidthMinusInset, labelHeight);
+        bandSourceTitleLabel.setBounds(thirdWidth, y, sixthWidth, itemHeight);
+        bandSourceLabel.setBounds(halfWidth+labelInset, y+labelInset, sixthWidthMinusInset, labelHeight);
+        bandFilterTitleLabel.setBounds(thirdWidth*2, y, sixthWidth, itemHeight);
+        bandFilterLabel.setBounds(sixthWidth*5, y+labelInset, sixthWidthMinusInset, labelHeight);
+        y += itemHeight;
+    }
+
+    /*
+     ONSET
+     */
+    const bool onsetVisible = category != CommandCategoryTypeText && command.triggerParameterID == ParameterIDTrigger;
+
+    for (juce::Component* component : std::initializer_list<juce::Component*> { &onsetLabel, &onsetToggle,
+                                                                                &onsetThresholdTitleLabel, &onsetHoldTitleLabel, &onsetFloorTitleLabel, &onsetLookaheadTitleLabel,
+                                                                                &onsetThresholdLabel, &onsetHoldLabel, &onsetFloorLabel, &onsetLookaheadLabel })
+        component->setVisible(onsetVisible);
+
+    if (onsetVisible) {
+        onsetLabel.setBounds(0, y, width, itemHeight);
+        onsetToggle.setBounds(threeQuarterWidth, y, quarterWidth, itemHeight);
+        y += itemHeight;
+
+        int eighthWidth = width/8;
+        int eighthWidthMinusInset = eighthWidth-(labelInset*2);
+
+        onsetThresholdTitleLabel.setBounds(0, y, eighthWidth, itemHeight);
+        onsetThresholdLabel.setBounds(eighthWidth+labelInset, y+labelInset, eighthWidthMinusInset, labelHeight);
+        onsetHoldTitleLabel.setBounds(quarterWidth, y, eighthWidth, itemHeight);
+        onsetHoldLabel.setBounds(quarterWidth+eighthWidth+labelInset, y+labelInset, eighthWidthMinusInset, labelHeight);
+        onsetFloorTitleLabel.setBounds(halfWidth, y, eighthWidth, itemHeight);
+        onsetFloorLabel.setBounds(halfWidth+eighthWidth+labelInset, y+labelInset, eighthWidthMinusInset, labelHeight);
+        onsetLookaheadTitleLabel.setBounds(threeQuarterWidth, y, eighthWidth, itemHeight);
+        onsetLookaheadLabel.setBounds(threeQuarterWidth+eighthWidth+labelInset, y+labelInset, eighthWidthMinusInset, labelHeight);
+        y += itemHeight;
     }
 
     /*
      TRIGGERS
      */
-    audioProcessor.valueSlider.setBounds(0, y, threeQuarterWidth, itemHeight);
-    audioProcessor.valueSliderValue.setBounds(threeQuarterWidth, y, quarterWidth, itemHeight);
+    valueSlider.setBounds(0, y, threeQuarterWidth, itemHeight);
+    valueSliderValue.setBounds(threeQuarterWidth, y, quarterWidth, itemHeight);
     
     if (category == CommandCategoryTypeText) y += itemHeight;
     
-    audioProcessor.triggerButton.setBounds(0, y, width, itemHeight);
-//    y += itemHeight;
+    triggerButton.setBounds(0, y, width, itemHeight);
+    y += itemHeight;
+    
+    /*
+     STATUS AND STATS
+     */
+    statusLine.setBounds(0, y, width, itemHeight);
+    y += itemHeight;
+    
+    statsPanel.setBounds(0, y, width, itemHeight);
     
 }
@@ -11,6 +11,8 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 #include "CommandDefinitions.h"
+#include "StatsPanel.h"
+#include "StatusLine.h"
 
 //==============================================================================
 /**
@@ -22,7 +24,7 @@ typedef enum : int {
 } EditorLayoutPurpose;
 
 
-class ObviousAudioProcessorEditor  : public juce::AudioProcessorEditor
+class ObviousAudioProcessorEditor  : public juce::AudioProcessorEditor, private juce::Timer
 {
 public:    
     ObviousAudioProcessorEditor (ObviousAudioProcessor&, juce::AudioProcessorValueTreeState&);
@@ -39,7 +41,157 @@ private:
     // access the processor object that created it.
     ObviousAudioProcessor& audioProcessor;
     
-    int numItems();
+    juce::Slider valueSlider;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> sliderAttachment;
+    juce::Label valueSliderValue;
+    
+    juce::Label targetLabel;
+    juce::Label sceneTitleLabel;
+    juce::Label sourceTitleLabel;
+    juce::Label sceneLabel;
+    juce::Label sourceLabel;
+    juce::Label filterLabel;
+    juce::Label filterTitleLabel;
+    
+    juce::Label commandSelectorTitle;
+    juce::Label commandCategorySelectorTitle;
+    juce::ComboBox commandCategorySelector;
+    juce::ComboBox commandSelectorSource;
+    juce::ComboBox commandSelectorFilter;
+    juce::ComboBox commandSelectorTypeText;
+    
+    juce::Label connectionLabel;
+    juce::Label ipTitleLabel;
+    juce::Label portTitleLabel;
+    juce::Label ipLabel;
+    juce::Label portLabel;
+    juce::ToggleButton udpToggle;
+    juce::ToggleButton queueToggle;
+    
+    juce::Label commandLabel;
+    
+    juce::Label rangeLabel;
+    juce::ToggleButton relativeToggle;
+    juce::ToggleButton batchTransformToggle;
+    juce::ToggleButton followTransportToggle;
+    juce::Label rangeLowerTitleLabel;
+    juce::Label rangeUpperTitleLabel;
+    juce::Label rangeLowerLabel;
+    juce::Label rangeUpperLabel;
+    
+    juce::Label lfoLabel;
+    juce::ComboBox lfoWaveformSelector;
+    juce::ToggleButton lfoToggle;
+    juce::Label lfoBeatsTitleLabel;
+    juce::Label lfoDepthTitleLabel;
+    juce::Label lfoOffsetTitleLabel;
+    juce::Label lfoPhaseTitleLabel;
+    juce::Label lfoBeatsLabel;
+    juce::Label lfoDepthLabel;
+    juce::Label lfoOffsetLabel;
+    juce::Label lfoPhaseLabel;
+    
+    juce::Label audioLabel;
+    juce::ComboBox audioModeSelector;
+    juce::ToggleButton audioToggle;
+    juce::Label audioAttackTitleLabel;
+    juce::Label audioReleaseTitleLabel;
+    juce::Label audioGainTitleLabel;
+    juce::Label audioFloorTitleLabel;
+    juce::Label audioAttackLabel;
+    juce::Label audioReleaseLabel;
+    juce::Label audioGainLabel;
+    juce::Label audioFloorLabel;
+    
+    // The target of one band at a time, chosen with bandSelector, in the bands audio mode
+    juce::Label bandTitleLabel;
+    juce::ComboBox bandSelector;
+    juce::ComboBox bandCommandSelector;
+    juce::Label bandLowerTitleLabel;
+    juce::Label bandUpperTitleLabel;
+    juce::Label bandLowerLabel;
+    juce::Label bandUpperLabel;
+    juce::Label bandSceneTitleLabel;
+    juce::Label bandSourceTitleLabel;
+    juce::Label bandFilterTitleLabel;
+    juce::Label bandSceneLabel;
+    juce::Label bandSourceLabel;
+    juce::Label bandFilterLabel;
+    
+    juce::Label onsetLabel;
+    juce::ToggleButton onsetToggle;
+    juce::Label onsetThresholdTitleLabel;
+    juce::Label onsetHoldTitleLabel;
+    juce::Label onsetFloorTitleLabel;
+    juce::Label onsetLookaheadTitleLabel;
+    juce::Label onsetThresholdLabel;
+    juce::Label onsetHoldLabel;
+    juce::Label onsetFloorLabel;
+    juce::Label onsetLookaheadLabel;
+    
+    juce::Label typeTextTitleLabel;
+    juce::Label typeTextTextLabel;
+    juce::Label typeTextCursorCharacterTitleLabel;
+    juce::Label typeTextCursorCharacterLabel;
+    
+    juce::TextButton triggerButton;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> buttonAttachment;
+    bool buttonPreviouslyDown = false;
+    
+    bool ignoreCommandSelectorChanges = false;
+    
+    StatsPanel statsPanel;
+    StatusLine statusLine;
+    juce::TooltipWindow tooltipWindow { this };
+    
+    /*
+     Everything that changes without the user touching the editor (the
+     translated value, the status line and the stats) is redrawn from one
+     30 Hz timer that reads what the engine publishes, rather than from the
+     thread that sent the value.
+     */
+    static constexpr int refreshHz = 30;
+    static constexpr int statusEveryTicks = 8;      // about 4 Hz
+    static constexpr int statsEveryTicks = 15;      // 2 Hz
+    static constexpr int sizeSettledTicks = 15;     // a resize is saved once it has stopped for half a second
+    
+    int refreshTicks = 0;
+    float displayedValue = 0.0f;
+    
+    int previousNumItems = -1;
+    bool allowAutoResize = false;
+    
+    // Window size waiting to be written to the settings, so dragging does not write the tree every frame
+    int unsavedWidth = 0;
+    int unsavedHeight = 0;
+    int ticksSinceResize = 0;
+    
+    float translateSliderValueAndDisplay(float rawValue);
+    
+    void setCommandComboVisibleState();
+    void setButtonTitle();
+    void setButtonColour();
+    void setTriggerVisibleState();
+    void setTriggerButtonToggleState();
+    
+    void handleCommandChange(int commandID);
+    void handleCommandCategoryChange();
+    
+    int numItems(int category, const Command &command);
+    bool bandsVisible(int category, const Command &command);
+    juce::ValueTree selectedBand();
+    void showSelectedBand();
+    void saveWindowSize();
+    
+    // Scene, source and filter names are completed from, and checked against, the catalogue OBS sent
+    uint32_t checkedCatalogueRevision = 0;
+    juce::String checkedTarget;
+    
+    void attachCompletion(juce::Label &label, ObviousCatalogue::Kind kind);
+    void completeName(juce::TextEditor &editor, ObviousCatalogue::Kind kind, juce::String &typed);
+    void refreshTargetValidity();
+    
+    void timerCallback() override;
 //    
     bool hitTest (int x, int y) override;
         
@@ -11,11 +11,7 @@
 
 Command ObviousAudioProcessor::commandWithID(int commandID) {
     
-    std::vector<Command>::iterator it = std::find_if(
-        commands.begin(), commands.end(),
-        [&commandID](const Command& command) { return command.commandID == commandID;});
-    
-    return *it;
+    return CommandTable::withID(commandID);
     
 }
 
@@ -37,493 +33,38 @@ ObviousAudioProcessor::ObviousAudioProcessor()
                            
                            
                        }),
-                        clientThread(ObviousThread(*this)),
-                        heartbeatThread(HeartbeatThread(*this))
+                        engine(parameters.state)
 #endif
 {
     
-    auto settingsStorage = settings();
+    engine.setListener(this);
     
     parameters.addParameterListener(ParameterIDValue, this);
     parameters.addParameterListener(ParameterIDTrigger, this);
+    parameters.getParameter(ParameterIDValue)->addListener(this);
     
-    
-    
-    ipLabel.setEditable(true);
-    ipLabel.onTextChange = [this] {
-        auto settingsStorage = settings();
-        settingsStorage.setProperty(ParameterIDIP, ipLabel.getText(), nullptr);
-        closeSocket();
-        connectSocket();
-    };
-    
-    portLabel.setEditable(true);
-    portLabel.onTextChange = [this] {
-        auto settingsStorage = settings();
-        settingsStorage.setProperty(ParameterIDPort, portLabel.getText(), nullptr);
-        closeSocket();
-        connectSocket();
-    };
-    
-    sourceLabel.setEditable(true);
-    sourceLabel.onTextChange = [this] {
-        auto settingsStorage = settings();
-        settingsStorage.setProperty(ParameterIDSource, sourceLabel.getText(), nullptr);
-    };
-    
-    sceneLabel.setEditable(true);
-    sceneLabel.onTextChange = [this] {
-        auto settingsStorage = settings();
-        settingsStorage.setProperty(ParameterIDScene, sceneLabel.getText(), nullptr);
-    };
-    
-    filterLabel.setEditable(true);
-    filterLabel.onTextChange = [this] {
-        auto settingsStorage = settings();
-        settingsStorage.setProperty(ParameterIDFilter, filterLabel.getText(), nullptr);
-    };
-    
-    rangeLowerLabel.setEditable(true);
-    rangeLowerLabel.onTextChange = [this] {
-        auto settingsStorage = settings();
-        settingsStorage.setProperty(ParameterIDRangeLower, rangeLowerLabel.getText().getDoubleValue(), nullptr);
-    };
-    
-    rangeUpperLabel.setEditable(true);
-    rangeUpperLabel.onTextChange = [this] {
-        auto settingsStorage = settings();
-        settingsStorage.setProperty(ParameterIDRangeUpper, rangeUpperLabel.getText().getDoubleValue(), nullptr);
-    };
-    
-    sliderAttachment.reset (new juce::AudioProcessorValueTreeState::SliderAttachment (parameters, ParameterIDValue, valueSlider));
-    buttonAttachment.reset (new juce::AudioProcessorValueTreeState::ButtonAttachment (parameters, ParameterIDTrigger, triggerButton));
-    
-    valueSliderValue.setEditable(true);
-    valueSliderValue.onTextChange = [this] {
-        auto settingsStorage = settings();
-        double rawValue = std::stod(valueSliderValue.getText().toStdString());
-        float rangeLower = settingsStorage.getProperty(ParameterIDRangeLower, 0.0f);
-        float rangeUpper = settingsStorage.getProperty(ParameterIDRangeUpper, 1.0f);
-        float range = rangeUpper-rangeLower;
-        double value = (rawValue-rangeLower) / range;
-        
-        valueSlider.setValue(value);
-    };
-    
-    typeTextTextLabel.setEditable(true);
-    typeTextTextLabel.onTextChange = [this] {
-        
-        auto settingsStorage = settings();
-        settingsStorage.setProperty(ParameterIDTypeTextText, typeTextTextLabel.getText(), nullptr);
-        send(TypeText, 0.0f);
-        
-    };
-    
-    typeTextCursorCharacterLabel.setEditable(true);
-    typeTextCursorCharacterLabel.onTextChange = [this] {
-        
-        auto settingsStorage = settings();
-        settingsStorage.setProperty(ParameterIDTypeTextCursorCharacter, typeTextCursorCharacterLabel.getText(), nullptr);
-        send(TypeSetCursorCharacter, 0.0f);
-        
-    };
-    
-    triggerButton.onStateChange = [this] {
-        
-        auto settingsStorage = settings();
-        int commandID = settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault);
-        int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
-        Command command = commandWithID(commandID);
-//        if ((int)settingsStorage.getProperty(ParameterIDCommandCategory) == CommandCategoryTypeText) {
-//            juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::NoIcon, "Error", "No command type selected" );
-//
-//            return;
-//        }
-        
-        /*
-         We don't need to do anything if the button is a toggle
-         Toggling it causes the parameter to change, and sending
-         is therefore handled in parameterChanged()
-         */
-        if (command.requiresToggleButton || category == CommandCategoryTypeText) {
-            return;
-        }
-        
-        float value;
-        juce::Button::ButtonState state = triggerButton.getState();
-        if (state == juce::Button::buttonDown) {
-            buttonPreviouslyDown = true;
-            
-//            if (command.requiresToggleButton || category == CommandCategoryTypeText) {
-//                return;
-//            }
-            
-            value = 1.0f;
-        }
-        else if (state == juce::Button::buttonOver) {
-            if (buttonPreviouslyDown == false) {
-                return;
-            }
-            buttonPreviouslyDown = false;
-            
-            /*if (command.requiresToggleButton || category == CommandCategoryTypeText) {
-                if (triggerButton.getToggleState()) {
-                    value = 0.0f;
-                }
-                else {
-                    value = 1.0f;
-                }
-            }
-            else*/ value = 0.0f;
-        }
-        else {
-            return;
-        }
-
-//        if (category == CommandCategoryTypeText) {
-//            send(TypeSetCursorVisible, value);
-//        }
-//        else {
-            send(ParameterIDTrigger, value);
-//        }
-    };
-    
-    commandCategorySelector.addItem("Source", CommandCategorySource);
-    commandCategorySelector.addItem("Filter", CommandCategoryFilter);
-    commandCategorySelector.addItem("Type text", CommandCategoryTypeText);
-    commandCategorySelector.onChange = [this] {
-        
-        handleCommandCategoryChange();
-        
-    };
-    
-    
-    commands.push_back({PositionProportionateX, ParameterIDValue, "Position (x, proportionate)", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
-    commands.push_back({PositionProportionateY, ParameterIDValue, "Position (y, proportionate)", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
-    commands.push_back({ScaleX, ParameterIDValue, "Scale (x)", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
-    commands.push_back({ScaleY, ParameterIDValue, "Scale (y)", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
-    commands.push_back({MediaRestart, ParameterIDTrigger, "Media restart", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
-    commands.push_back({MediaStop, ParameterIDTrigger, "Media stop", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
-    commands.push_back({MediaPlay, ParameterIDTrigger, "Media play", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
-    commands.push_back({MediaPause, ParameterIDTrigger, "Media pause", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
-    commands.push_back({MediaCursor, ParameterIDValue, "Media cursor", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
-    commands.push_back({Hue, ParameterIDValue, "Filter hue", CommandCategoryFilter, -180, 180, false});
-    commands.push_back({Saturation, ParameterIDValue, "Filter saturation", CommandCategoryFilter, -1, 5, false});
-    commands.push_back({RollSpeedH, ParameterIDValue, "Roll speed (x)", CommandCategoryFilter, -500, 500, false});
-    commands.push_back({RollSpeedV, ParameterIDValue, "Roll speed (y)", CommandCategoryFilter, -500, 500, false});
-    commands.push_back({Opacity, ParameterIDValue, "Opacity", CommandCategoryFilter, 0, 1, false});
-    commands.push_back({CropTop, ParameterIDValue, "Crop (top)", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
-    commands.push_back({CropBottom, ParameterIDValue, "Crop (bottom)", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
-    commands.push_back({CropLeft, ParameterIDValue, "Crop (left)", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
-    commands.push_back({CropRight, ParameterIDValue, "Crop (right)", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), false});
-    commands.push_back({SetVisible, ParameterIDTrigger, "Visible", CommandCategorySource, std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), true});
-    
-    commandSelectorTypeText.setTextWhenNoChoicesAvailable("chill we got this");
-    
-    /*
-     TypeText needs slider, TypeSetCursorCharacter needs toggle button
-     Add command selector for this category and remember to show/hide it as necessary along with the others
-     Only add TypeText and TypeSetCursorCharacter to the command selector (SetTypeNumChars is hidden)
-     */
-    
-    /*
-     If I can get populateCommandsList() working then this will go here, instead of the following for_each function
-     which populates two separate combo boxes, one for each category
-     */
-    std::for_each(commands.begin(), commands.end(), [this](Command command){
-        
-        switch (command.category) {
-            case CommandCategorySource:
-                commandSelectorSource.addItem(command.displayName, command.commandID);
-                break;
-                
-            case CommandCategoryFilter:
-                commandSelectorFilter.addItem(command.displayName, command.commandID);
-                break;
-                
-            case CommandCategoryTypeText:
-                commandSelectorTypeText.addItem(command.displayName, command.commandID);
-                break;
-                
-            default:
-                break;
-        }
-        
-    });
-        
-    commandSelectorSource.onChange = [this] {
-
-        handleCommandChange(commandSelectorSource.getSelectedId());
-
-    };
-    
-    commandSelectorFilter.onChange = [this] {
-        handleCommandChange(commandSelectorFilter.getSelectedId());
-    };
-    
-    commandSelectorTypeText.onChange = [this] {
-        handleCommandChange(commandSelectorTypeText.getSelectedId());
-    };
-    
-    int commandID = settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault);
-//    juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::NoIcon, "Error", std::to_string(commandID) );
-//    Command command = commandWithID(commandID);
-//    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
-    
-    handleCommandCategoryChange();
-    handleCommandChange(commandID);
-    setCommandComboVisibleState();
-        
-}
-
-void ObviousAudioProcessor::handleCommandCategoryChange() {
-    
-    if (!ignoreCommandSelectorChanges) {
-        
-        int categoryID = commandCategorySelector.getSelectedId();
-        if (categoryID > 0) {
-            auto settingsStorage = settings();
-            settingsStorage.setProperty(ParameterIDCommandCategory, categoryID, nullptr);
-            ((ObviousAudioProcessorEditor*)getActiveEditor())->layout(EditorLayoutPurposeUIActivity);
-//            populateCommandsList();
-        }
-        
-        setButtonTitle();
-        setButtonColour();
-        setTriggerVisibleState();
-        setTriggerButtonToggleState();
-        
-    }
-    
-}
-
-void ObviousAudioProcessor::setButtonColour() {
-    
-    auto settingsStorage = settings();
-    int commandID = settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault);
-    Command command = commandWithID(commandID);
-    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
-    
-    if (command.requiresToggleButton || category == CommandCategoryTypeText) {
-        triggerButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::green);
-        triggerButton.setColour(juce::TextButton::buttonColourId, juce::Colours::orange);
-    }
-    else {
-        triggerButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::transparentBlack);
-        triggerButton.setColour(juce::TextButton::buttonColourId, juce::Colours::transparentBlack);
-    }
-    
-}
-
-void ObviousAudioProcessor::setButtonTitle() {
-    
-    auto settingsStorage = settings();
-    
-    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
-    if (category == CommandCategoryTypeText) {
-        triggerButton.setButtonText("Show cursor");
-    }
-    else {
-        int commandID = settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault);
-        switch (commandID) {
-            case MediaRestart:
-                triggerButton.setButtonText("Restart");
-                break;
-                
-            case MediaStop:
-                triggerButton.setButtonText("Stop");
-                break;
-                
-            case MediaPlay:
-                triggerButton.setButtonText("Play");
-                break;
-                
-            case MediaPause:
-                triggerButton.setButtonText("Pause");
-                break;
-                
-            case SetVisible:
-                triggerButton.setButtonText("Visible");
-                break;
-                
-            default:
-                triggerButton.setButtonText("Send");
-                break;
-        }
-    }
-    
-}
-
-void ObviousAudioProcessor::setTriggerButtonToggleState() {
-    
-    auto settingsStorage = settings();
-    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
-    int commandID = settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault);
-    Command selectedCommand = commandWithID(commandID);
-    triggerButton.setClickingTogglesState(selectedCommand.requiresToggleButton || category == CommandCategoryTypeText);
-    
-    if (category == CommandCategoryTypeText) {
-        triggerButton.setToggleState(settingsStorage.getProperty(ParameterIDTypeTextCursorVisible, false), juce::dontSendNotification);
-    }
-    
-}
-
-void ObviousAudioProcessor::handleCommandChange(int commandID) {
-    
-//            if (!ignoreCommandSelectorChanges) {
-//
-//                ignoreCommandSelectorChanges = true;
-                
-    
-
-//                int commandID = selector.getSelectedId();
-
-                if (commandID > 0) {
-
-                    auto settingsStorage = settings();
-                    
-                    settingsStorage.setProperty(ParameterIDCommand, commandID, nullptr);
-                    Command selectedCommand = commandWithID(commandID);
-                    selectedCommand = commandWithID(commandID);
-
-                    triggerButton.setToggleState(false, juce::dontSendNotification);
-
-                    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
-
-                    if (selectedCommand.triggerParameterID == ParameterIDTrigger || category == CommandCategoryTypeText) {
-
-                        setTriggerButtonToggleState();
-//                        juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::NoIcon, "Info", std::to_string(category) );
-                    }
-
-                    switch (selectedCommand.category) {
-                        case CommandCategorySource:
-                            commandSelectorFilter.setSelectedId(0);
-                            commandSelectorTypeText.setSelectedId(0);
-                            break;
-
-                        case CommandCategoryFilter:
-                            commandSelectorSource.setSelectedId(0);
-                            commandSelectorTypeText.setSelectedId(0);
-                            break;
-
-                        case CommandCategoryTypeText:
-                            commandSelectorSource.setSelectedId(0);
-                            commandSelectorFilter.setSelectedId(0);
-                            break;
-
-                        default:
-                            break;
-                    }
-
-                    if (!ignoreCommandSelectorChanges) {
-                        if (selectedCommand.recommendedRangeLower != std::numeric_limits<int>::max() || selectedCommand.recommendedRangeUpper != std::numeric_limits<int>::max()) {
-
-
-                            float rangeLower = settingsStorage.getProperty (ParameterIDRangeLower, 0);
-                            float rangeUpper = settingsStorage.getProperty (ParameterIDRangeUpper, 1);
-
-                            if (selectedCommand.recommendedRangeLower != rangeLower || selectedCommand.recommendedRangeUpper != rangeUpper) {
-
-                                std::string rangeWarning = "The recommended range for this command is " + std::to_string(selectedCommand.recommendedRangeLower) + " to " + std::to_string(selectedCommand.recommendedRangeUpper) + " (current range: " + std::to_string(rangeLower) + " to " + std::to_string(rangeUpper) + ")";
-                                juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::NoIcon, "Info", rangeWarning );
-
-                            }
-
-                        }
-                        setTriggerVisibleState();
-                        ObviousAudioProcessorEditor *editor = (ObviousAudioProcessorEditor*)getActiveEditor();
-                        if (editor != nullptr) {
-                            editor->layout(EditorLayoutPurposeUIActivity);
-                        }
-                        setButtonTitle();
-                        setButtonColour();
-//                        ((ObviousAudioProcessorEditor*)getActiveEditor())->layout(EditorLayoutPurposeUIActivity);
-                    }
-                    
-                }
-                
-//                ignoreCommandSelectorChanges = false;
-//
-//            }
-    
-}
-
-/*
- 
- NOT WORKING. :(
- 
- I had hoped to use the selected command category to determine which items should be in the command selector combo box.
- Unfortunately the command selector will not switch to the selected command on startup when this is the case.
- This function is unused, and there are instead two combo boxes, one for each command category.
- If I can get the below working then I can switch back to a single combo and reload its contents each time the category is changed.
- 
- */
-#warning fix?
-void ObviousAudioProcessor::populateCommandsList() {
-    
-    auto settingsStorage = settings();
-    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
-    
-    if (category == 0) {
-        return;
-    }
-    
-    commandSelectorSource.clear();
-
-    std::for_each(commands.begin(), commands.end(), [this, &category](Command command){
-        if (command.category == category) {
-            commandSelectorSource.addItem(command.displayName, command.commandID);
-        }
-    });
-        
-}
-
-void ObviousAudioProcessor::setTriggerVisibleState() {
-    
-    auto settingsStorage = settings();
-    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
-    int commandID = settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault);
-    Command selectedCommand = commandWithID(commandID);
-    
-    valueSlider.setVisible(selectedCommand.triggerParameterID == ParameterIDValue || category == CommandCategoryTypeText);
-    triggerButton.setVisible(selectedCommand.triggerParameterID == ParameterIDTrigger || category == CommandCategoryTypeText);
-    
-}
-
-void ObviousAudioProcessor::setCommandComboVisibleState() {
-    
-    auto settingsStorage = settings();
-    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
-    commandSelectorSource.setVisible(category == CommandCategorySource);
-    commandSelectorFilter.setVisible(category == CommandCategoryFilter);
-    commandSelectorTypeText.setVisible(category == CommandCategoryTypeText);
+    parameters.state.addListener(this);
+    cacheSettings();
     
 }
 
 juce::ValueTree ObviousAudioProcessor::settings() {
-    return parameters.state.getOrCreateChildWithName (ParameterIDSettingsStorage, nullptr);
+    return engine.settings();
 }
 
 ObviousAudioProcessor::~ObviousAudioProcessor()
 {
     
-    closeSocket();
+    parameters.getParameter(ParameterIDValue)->removeListener(this);
+    parameters.state.removeListener(this);
+    engine.setListener(nullptr);
+    engine.close();
+    cancelPendingUpdate();
     
 }
 
 float ObviousAudioProcessor::translateSliderValue(float rawValue) {
-    auto settingsStorage = settings();
-    float rangeLower = settingsStorage.getProperty (ParameterIDRangeLower, 0.0f);
-    float rangeUpper = settingsStorage.getProperty (ParameterIDRangeUpper, 1.0f);
-    float value = ((rangeUpper-rangeLower)*rawValue)+rangeLower;
-    return value;
-}
-
-float ObviousAudioProcessor::translateSliderValueAndDisplay(float rawValue) {
-    float translated = translateSliderValue(rawValue);
-    valueSliderValue.setText(juce::String(translated, 6), juce::dontSendNotification);
-    return translated;
+    return engine.translateSliderValue(rawValue);
 }
 
 void ObviousAudioProcessor::parameterChanged(const juce::String &parameterID, float newValue) {
@@ -539,206 +80,61 @@ void ObviousAudioProcessor::parameterChanged(const juce::String &parameterID, fl
     
     if (sendOnParameterChange) {
 //            juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::NoIcon, "Error", juce::String(newValue) );
-        send(parameterID, newValue);
+        engine.send(parameterID, newValue);
         
     }
     
 }
 
-void ObviousAudioProcessor::send(const juce::String &parameterID, float value) {
-    
-    if (!sendEnabled) {
-        return;
-    }
-        
-    auto settingsStorage = settings();
-    int commandID = settingsStorage.getProperty(ParameterIDCommand, CommandDefinitionDefault);
-    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
-    Command selectedCommand = commandWithID(commandID);
-    
-    if (category == CommandCategoryTypeText) {
-        
-        if (parameterID == ParameterIDValue) commandID = TypeSetNumChars;
-        else if (parameterID == ParameterIDTrigger) commandID = TypeSetCursorVisible;
-
-    }
-    else if ((commandID == 0 || selectedCommand.category != (int)settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault))) {
-        juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::NoIcon, "Error", "No command type selected" );
-        return;
-    }
-    
-    
-    
-    if (parameterID != selectedCommand.triggerParameterID && category != CommandCategoryTypeText) {
-        return;
-    }
-    
-    if (parameterID == ParameterIDValue) {
-        value = translateSliderValueAndDisplay(value);
-    }
-    
-    send(commandID, value);
-    
+void ObviousAudioProcessor::parameterValueChanged(int parameterIndex, float newValue) {
+    // Values are sent from parameterChanged()
+    juce::ignoreUnused(parameterIndex, newValue);
 }
 
-void ObviousAudioProcessor::send(int command, float value) {
+void ObviousAudioProcessor::parameterGestureChanged(int parameterIndex, bool gestureIsStarting) {
     
-    if (!sendEnabled) {
-        return;
-    }
-        
-    auto settingsStorage = settings();
+    juce::ignoreUnused(parameterIndex);
     
-    juce::String scene = settingsStorage.getProperty (ParameterIDScene, juce::String());
-    if (scene.length() < 1) {
-        juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::NoIcon, "Error", "No scene specified" );
-        return;
+    if (!gestureIsStarting) {
+        engine.gestureEnded(ParameterIDValue);
     }
     
-    juce::String source = settingsStorage.getProperty (ParameterIDSource, juce::String());
-    if (source.length() < 1) {
-        juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::NoIcon, "Error", "No source specified" );
-        return;
-    }
-    
-    std::string sendString = std::to_string(command) + CommandChunkDelimiter + scene.toStdString() + CommandChunkDelimiter + source.toStdString() + CommandChunkDelimiter;
-    
-    int category = settingsStorage.getProperty(ParameterIDCommandCategory, CommandCategoryDefault);
-    
-    if (category == CommandCategoryFilter) {
-        
-        juce::String filter = settingsStorage.getProperty (ParameterIDFilter, juce::String());
-        if (filter.length() < 1) {
-            juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::NoIcon, "Error", "No filter specified" );
-            return;
-        }
-        
-        sendString = sendString + filter.toStdString() + CommandChunkDelimiter + std::to_string(value);
-        
-    }
-    
-    else if (category == CommandCategoryTypeText && command != TypeSetNumChars && command != TypeSetCursorVisible) {
-        
-        if (command == TypeText) {
-            sendString = sendString + settingsStorage.getProperty(ParameterIDTypeTextText, juce::String()).toString().toStdString();
-        }
-        else if (command == TypeSetCursorCharacter) {
-            sendString = sendString + settingsStorage.getProperty(ParameterIDTypeTextCursorCharacter, juce::String()).toString().toStdString();
-        }
-        
-    }
-    else {
-        sendString = sendString + std::to_string(value);
-    }
-    
-    sendString = sendString + CommandDelimiter;
-        
-    if (!socket.isConnected() || forceConnect) {
-        connectSocket();
-    }
-    
-//    juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::NoIcon, "Send", sendString );
-    socket.write(sendString.c_str(), static_cast<int>(sendString.length()));
-    
 }
 
-void ObviousAudioProcessor::connectSocket() {
-    
-//    juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::NoIcon, "Info", "Connecting" );
-
-    
-    auto settingsStorage = settings();
-    
-    juce::String ip = settingsStorage.getProperty (ParameterIDIP, juce::String("127.0.0.1"));
-    int port = settingsStorage.getProperty (ParameterIDPort, juce::String("11111"));
-    
-    socket.connect(ip, port);
-    
-    clientThread.shouldRun = true;
-    clientThread.startThread();
-    
-    heartbeatThread.shouldRun = true;
-    heartbeatThread.startThread();
-    
-    forceConnect = false;
-    
+void ObviousAudioProcessor::engineMessage(const juce::String &title, const juce::String &message) {
+    status.post(title, message);
 }
 
-void ObviousAudioProcessor::closeSocket() {
-    
-    clientThread.shouldRun = false;
-    clientThread.stopThread(0);
+void ObviousAudioProcessor::engineValueReceived(const juce::String &parameterID, float rawValue) {
     
-    heartbeatThread.shouldRun = false;
-    heartbeatThread.stopThread(0);
-    
-    if (socket.isConnected()) {
-        
-        forceConnect = true;
-        
-//        if (forceConnect) juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::NoIcon, "yes", "yes" );
-//        else juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::NoIcon, "NO", "NO" );
-        
-        std::string s = std::string(CommandDisconnect) + CommandDelimiter;
-        const char * ss = s.c_str();
-        socket.write(ss, (int)strlen(ss));
-        socket.close();
-        
-//        juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::NoIcon, "close", "close" );
+    if (parameterID == ParameterIDValue) {
+        receivedValue = rawValue;
+        receivedValuePending = true;
+    }
+    else if (parameterID == ParameterIDTrigger) {
+        receivedTrigger = rawValue;
+        receivedTriggerPending = true;
     }
     
-    
-    
-    
+    triggerAsyncUpdate();
     
 }
 
-void ObviousAudioProcessor::clientMessageReceived(std::string message) {
+void ObviousAudioProcessor::handleAsyncUpdate() {
     
-    std::stringstream stringStream(message);
-    std::string segment;
-    std::vector<std::string> seglist;
-
-    while(std::getline(stringStream, segment, CommandChunkDelimiter))
-    {
-       seglist.push_back(segment);
-    }
+    // The host sees the change, so automation recording and the editor follow OBS
+    sendOnParameterChange = false;
     
-    if (seglist.size() == 2) {
-        
-        int responseCode = std::stoi(seglist[0]);
-        if (responseCode == HeartbeatResponse) {
-            hasReceivedHeartbeatResponse = true;
-        }
-        else if (responseCode == ResponseCodeRequestTypeText) {
-            send(TypeText, 0.0f);
-        }
-        else if (responseCode == ResponseCodeRequestTypeNumChars) {
-            send(ParameterIDValue, valueSlider.getValue());
-        }
-        else if (responseCode == ResponseCodeRequestTypeCursorChar) {
-            send(TypeSetCursorCharacter, 0.0f);
-        }
-        else if (responseCode == ResponseCodeRequestTypeCursorVisible) {
-            float visibleValue = 0.0f;
-            juce::ValueTree settingsStorage = settings();
-            if (settingsStorage.getProperty(ParameterIDTypeTextCursorVisible, false)) visibleValue = 1.0f;
-            send(TypeSetCursorVisible, visibleValue);
-        }
-        else {
-            juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::NoIcon, "Error", message );
-        }
-        
+    if (receivedValuePending.exchange(false)) {
+        parameters.getParameter(ParameterIDValue)->setValueNotifyingHost(receivedValue.load());
     }
-    else {
-        juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::NoIcon, "Error", message );
+    
+    if (receivedTriggerPending.exchange(false)) {
+        parameters.getParameter(ParameterIDTrigger)->setValueNotifyingHost(receivedTrigger.load());
     }
     
-}
-
-void ObviousAudioProcessor::heartbeatLost() {
-    juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::NoIcon, "Info", "OBS has disconnected" );
-    closeSocket();
+    sendOnParameterChange = true;
+    
 }
 
 //==============================================================================
@@ -808,6 +204,89 @@ void ObviousAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBloc
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
+    envelope.prepare (sampleRate);
+    spectrum.prepare (sampleRate);
+    onsets.prepare (sampleRate);
+    
+    lookahead.setMaximumDelayInSamples ((int) std::ceil (maxLookaheadMs * 0.001 * sampleRate));
+    lookahead.prepare ({ sampleRate, (juce::uint32) samplesPerBlock, (juce::uint32) juce::jmax (1, getTotalNumOutputChannels()) });
+    appliedLookaheadSamples = 0;
+    updateLookahead();
+}
+
+void ObviousAudioProcessor::updateLookahead()
+{
+    auto settingsStorage = settings();
+    float milliseconds = 0.0f;
+    if ((bool) settingsStorage.getProperty (ParameterIDOnset, false))
+        milliseconds = juce::jlimit (0.0f, maxLookaheadMs, (float) settingsStorage.getProperty (ParameterIDOnsetLookahead, 0.0f));
+    
+    const int samples = (int) std::lround (milliseconds * 0.001 * getSampleRate());
+    lookaheadSamples = samples;
+    setLatencySamples (samples);
+}
+
+void ObviousAudioProcessor::cacheSettings()
+{
+    auto settingsStorage = settings();
+    
+    const EnvelopeFollower::Settings envelopeDefaults;
+    cachedAudioMode = (int) settingsStorage.getProperty (ParameterIDAudioMode, EnvelopeFollower::Peak) == EnvelopeFollower::RMS ? EnvelopeFollower::RMS : EnvelopeFollower::Peak;
+    cachedAttackMs = settingsStorage.getProperty (ParameterIDAudioAttack, envelopeDefaults.attackMs);
+    cachedReleaseMs = settingsStorage.getProperty (ParameterIDAudioRelease, envelopeDefaults.releaseMs);
+    cachedGainDecibels = settingsStorage.getProperty (ParameterIDAudioGain, envelopeDefaults.gainDecibels);
+    cachedFloorDecibels = settingsStorage.getProperty (ParameterIDAudioFloor, envelopeDefaults.floorDecibels);
+    cachedFramesPerSecond = settingsStorage.getProperty (ParameterIDAudioFrameRate, envelopeDefaults.framesPerSecond);
+    
+    const OnsetDetector::Settings onsetDefaults;
+    cachedOnsetThresholdDecibels = settingsStorage.getProperty (ParameterIDOnsetThreshold, onsetDefaults.thresholdDecibels);
+    cachedOnsetHoldMs = settingsStorage.getProperty (ParameterIDOnsetHold, onsetDefaults.holdMs);
+    cachedOnsetFloorDecibels = settingsStorage.getProperty (ParameterIDOnsetFloor, onsetDefaults.floorDecibels);
+}
+
+void ObviousAudioProcessor::valueTreePropertyChanged (juce::ValueTree& tree, const juce::Identifier& property)
+{
+    // Only the settings read here; others (the cursor) can be set from the audio thread
+    if (tree.getParent() != parameters.state)
+        return;
+    
+    const juce::String changed = property.toString();
+    for (const char* name : { ParameterIDAudioMode, ParameterIDAudioAttack, ParameterIDAudioRelease, ParameterIDAudioGain, ParameterIDAudioFloor,
+                              ParameterIDAudioFrameRate, ParameterIDOnsetThreshold, ParameterIDOnsetHold, ParameterIDOnsetFloor })
+    {
+        if (changed == name)
+        {
+            cacheSettings();
+            return;
+        }
+    }
+}
+
+void ObviousAudioProcessor::valueTreeRedirected (juce::ValueTree&)
+{
+    // A restored state
+    cacheSettings();
+}
+
+OnsetDetector::Settings ObviousAudioProcessor::onsetSettings() const
+{
+    OnsetDetector::Settings onsetSettings;
+    onsetSettings.thresholdDecibels = cachedOnsetThresholdDecibels.load (std::memory_order_relaxed);
+    onsetSettings.holdMs = cachedOnsetHoldMs.load (std::memory_order_relaxed);
+    onsetSettings.floorDecibels = cachedOnsetFloorDecibels.load (std::memory_order_relaxed);
+    return onsetSettings;
+}
+
+EnvelopeFollower::Settings ObviousAudioProcessor::envelopeSettings() const
+{
+    EnvelopeFollower::Settings envelopeSettings;
+    envelopeSettings.mode = (EnvelopeFollower::Mode) cachedAudioMode.load (std::memory_order_relaxed);
+    envelopeSettings.attackMs = cachedAttackMs.load (std::memory_order_relaxed);
+    envelopeSettings.releaseMs = cachedReleaseMs.load (std::memory_order_relaxed);
+    envelopeSettings.gainDecibels = cachedGainDecibels.load (std::memory_order_relaxed);
+    envelopeSettings.floorDecibels = cachedFloorDecibels.load (std::memory_order_relaxed);
+    envelopeSettings.framesPerSecond = cachedFramesPerSecond.load (std::memory_order_relaxed);
+    return envelopeSettings;
 }
 
 void ObviousAudioProcessor::releaseResources()
@@ -856,6 +335,74 @@ void ObviousAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce
     // this code if your algorithm always overwrites all the output channels.
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
+    
+    // The host's position stamps trace records, drives the media cursor when it follows the transport,
+    // and anchors the LFO to the host's tempo
+    const bool tracing = ObviousTrace::isOpen();
+    const bool followingTransport = engine.isFollowingTransport();
+    const bool followingTempo = engine.followsTempo();
+    
+    if (tracing || followingTransport || followingTempo) {
+        juce::int64 position = -1;
+        juce::Optional<double> seconds;
+        juce::Optional<double> beat;
+        double bpm = 120.0;
+        bool playing = false;
+        if (auto* playHead = getPlayHead()) {
+            if (auto info = playHead->getPosition()) {
+                if (auto timeInSamples = info->getTimeInSamples())
+                    position = *timeInSamples;
+                if (auto hostBpm = info->getBpm())
+                    bpm = *hostBpm;
+                seconds = info->getTimeInSeconds();
+                beat = info->getPpqPosition();
+                playing = info->getIsPlaying();
+            }
+        }
+        if (tracing)
+            engine.samplePosition.store(position, std::memory_order_relaxed);
+        if (followingTransport && seconds.hasValue())
+            engine.publishTransport(playing, *seconds);
+        if (followingTempo) {
+            if (!beat.hasValue() && seconds.hasValue())
+                beat = *seconds * bpm / 60.0;
+            engine.publishTempo(playing, bpm, beat.hasValue() ? *beat : 0.0);
+        }
+    }
+    
+    // Audio-reactive: the input's envelope moves the value, once per video frame
+    if (engine.isAudioReactive()) {
+        float level;
+        if (envelope.process (buffer.getArrayOfReadPointers(), totalNumInputChannels, buffer.getNumSamples(), envelopeSettings(), level))
+            engine.publishLevel (level);
+    }
+    else if (engine.isAnalysingSpectrum()) {
+        SpectrumAnalyser::Levels levels;
+        if (spectrum.process (buffer.getArrayOfReadPointers(), totalNumInputChannels, buffer.getNumSamples(), envelopeSettings(), levels))
+            engine.publishBands (levels.data(), (int) levels.size());
+    }
+    
+    // Onsets fire the trigger command, to be applied when the hit is heard: after its place in
+    // the block and the lookahead the audio is delayed by below
+    const int delaySamples = lookaheadSamples.load();
+    if (engine.detectsOnsets()) {
+        const int onset = onsets.process (buffer.getArrayOfReadPointers(), totalNumInputChannels, buffer.getNumSamples(), onsetSettings());
+        if (onset >= 0)
+            engine.publishOnset ((onset + delaySamples) * 1000.0 / getSampleRate());
+    }
+    
+    if (delaySamples != appliedLookaheadSamples) {
+        lookahead.reset();
+        lookahead.setDelay ((float) delaySamples);
+        appliedLookaheadSamples = delaySamples;
+    }
+    if (delaySamples > 0 && totalNumOutputChannels > 0) {
+        auto block = juce::dsp::AudioBlock<float> (buffer).getSubsetChannelBlock (0, (size_t) totalNumOutputChannels);
+        lookahead.process (juce::dsp::ProcessContextReplacing<float> (block));
+    }
+    
+    // Transform values set by any instance on this OBS during the block go out together, from the send thread
+    engine.endTransformBlock();
 
     // This is the place where you'd normally do the guts of your plugin's
     // audio processing...
@@ -901,13 +448,14 @@ juce::AudioProcessorEditor* ObviousAudioProcessor::createEditor()
 //==============================================================================
 void ObviousAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    // Binary rather than XML: hosts save and restore every instance on project load
+    // and autosave, and parsing XML was a visible part of that in large sessions.
     
     auto state = parameters.copyState();
-    std::unique_ptr<juce::XmlElement> xml (state.createXml());
-    copyXmlToBinary (*xml, destData);
+    juce::MemoryOutputStream stream (destData, false);
+    stream.writeInt ((int) stateMagic);
+    stream.writeInt ((int) stateVersion);
+    state.writeToStream (stream);
 }
 
 void ObviousAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
@@ -915,11 +463,35 @@ void ObviousAudioProcessor::setStateInformation (const void* data, int sizeInByt
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
     
+    if (sizeInBytes >= stateHeaderSize && juce::ByteOrder::littleEndianInt (data) == stateMagic)
+    {
+        auto version = juce::ByteOrder::littleEndianInt (juce::addBytesToPointer (data, 4));
+        if (version > stateVersion)
+        {
+            status.post ("Error", "This project was saved by a newer version of Obvious; its settings were not loaded");
+            return;
+        }
+        
+        auto state = juce::ValueTree::readFromData (juce::addBytesToPointer (data, stateHeaderSize), (size_t) (sizeInBytes - stateHeaderSize));
+        if (state.hasType (parameters.state.getType()))
+        {
+            parameters.replaceState (state);
+            // A project saved with a lookahead reports its latency before playback starts
+            updateLookahead();
+        }
+        
+        return;
+    }
+    
+    // Projects saved before the binary format
     std::unique_ptr<juce::XmlElement> xmlState (getXmlFromBinary (data, sizeInBytes));
      
     if (xmlState.get() != nullptr)
         if (xmlState->hasTagName (parameters.state.getType()))
+        {
             parameters.replaceState (juce::ValueTree::fromXml (*xmlState));
+            updateLookahead();
+        }
 }
 
 //==============================================================================
@@ -11,11 +11,16 @@
 #include <JuceHeader.h>
 #include "CommandDefinitions.h"
 #include "ParameterDefinitions.h"
+#include "Core/ObviousEngine.h"
+#include "Core/ObviousStatusQueue.h"
+#include "EnvelopeFollower.h"
+#include "SpectrumAnalyser.h"
+#include "OnsetDetector.h"
 
 //==============================================================================
 /**
 */
-class ObviousAudioProcessor  : public juce::AudioProcessor, public juce::AudioProcessorValueTreeState::Listener
+class ObviousAudioProcessor  : public juce::AudioProcessor, public juce::AudioProcessorValueTreeState::Listener, private juce::AudioProcessorParameter::Listener, private ObviousEngine::Listener, private juce::AsyncUpdater, private juce::ValueTree::Listener
                             #if JucePlugin_Enable_ARA
                              , public juce::AudioProcessorARAExtension
                             #endif
@@ -58,195 +63,83 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
     
-    juce::AudioProcessorValueTreeState parameters;
-    
-    juce::Slider valueSlider;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> sliderAttachment;
-    juce::Label valueSliderValue;
-    
-    juce::Label targetLabel;
-    juce::Label sceneTitleLabel;
-    juce::Label sourceTitleLabel;
-    juce::Label sceneLabel;
-    juce::Label sourceLabel;
-    juce::Label filterLabel;
-    juce::Label filterTitleLabel;
-    
-    juce::Label commandSelectorTitle;
-    juce::Label commandCategorySelectorTitle;
-    juce::ComboBox commandCategorySelector;
-    juce::ComboBox commandSelectorSource;
-    juce::ComboBox commandSelectorFilter;
-    juce::ComboBox commandSelectorTypeText;
-    
-    juce::Label connectionLabel;
-    juce::Label ipTitleLabel;
-    juce::Label portTitleLabel;
-    juce::Label ipLabel;
-    juce::Label portLabel;
-    
-    juce::Label commandLabel;
-    
-    juce::Label rangeLabel;
-    juce::Label rangeLowerTitleLabel;
-    juce::Label rangeUpperTitleLabel;
-    juce::Label rangeLowerLabel;
-    juce::Label rangeUpperLabel;
-    
-    juce::Label typeTextTitleLabel;
-    juce::Label typeTextTextLabel;
-    juce::Label typeTextCursorCharacterTitleLabel;
-    juce::Label typeTextCursorCharacterLabel;
+    // Saved state is the parameter ValueTree in JUCE's binary stream format, after
+    // stateMagic and stateVersion. Anything without the magic is read as the XML
+    // state earlier versions saved.
+    static constexpr juce::uint32 stateMagic = 0x5342424f; // "OBBS" as little-endian bytes
+    static constexpr juce::uint32 stateVersion = 1;
+    static constexpr int stateHeaderSize = 8;
     
+    juce::AudioProcessorValueTreeState parameters;
     
-    juce::TextButton triggerButton;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> buttonAttachment;
-    bool buttonPreviouslyDown = false;
+    // Engine errors and information, posted from any thread and shown by the editor's status line.
+    // Declared before the engine so it outlives the engine's threads.
+    ObviousStatusQueue status;
     
-//    Command selectedCommand;
+    // Settings, protocol and connection; everything that does not need the GUI.
+    // The GUI's components live in the editor.
+    ObviousEngine engine;
     
-    float translateSliderValueAndDisplay(float rawValue);
     float translateSliderValue(float rawValue);
     
-    bool ignoreCommandSelectorChanges = false;
-    
-    void setCommandComboVisibleState();
-    
-    bool sendEnabled = false;
-    bool sendOnParameterChange = true;
-    bool typeTextHasSentText = false;
+    // Cleared while a value reported by OBS is applied, so it is not sent straight back
+    std::atomic<bool> sendOnParameterChange { true };
     
     Command commandWithID(int commandID);
     
-    void clientMessageReceived(std::string message);
-    
-    void setButtonTitle();
-    void setButtonColour();
-    void setTriggerVisibleState();
-    void setTriggerButtonToggleState();
-    
-    void connectSocket();
-    void closeSocket();
-    
-    bool hasReceivedHeartbeatResponse = false;
-    void heartbeatLost();
-    
     juce::ValueTree settings();
+    
+    // The audio is delayed by the onset lookahead, and the host told so, so that onsets
+    // are sent ahead of the hits being heard; call when the onset settings change
+    static constexpr float maxLookaheadMs = 100.0f;
+    void updateLookahead();
             
 private:
     
-    typedef enum : int {
-        ResponseCodeError=10,
-        ResponseCodeRequestTypeText=20,
-        ResponseCodeRequestTypeCursorChar=30,
-        ResponseCodeRequestTypeCursorVisible=40,
-        ResponseCodeRequestTypeNumChars=50,
-    } ResponseCode;
-
-    #define CommandDelimiter char(30)
-    #define CommandChunkDelimiter char(31)
     
-    void send(const juce::String &parameterID, float value);
-    void send(int command, float value);
-    juce::StreamingSocket socket = juce::StreamingSocket();
     
-    std::vector<Command> commands;
     
     
+    void parameterChanged(const juce::String &parameterID, float newValue) override;
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override;
     
+    void engineMessage(const juce::String &title, const juce::String &message) override;
+    void engineValueReceived(const juce::String &parameterID, float rawValue) override;
     
-    void parameterChanged(const juce::String &parameterID, float newValue) override;
+    // Values reported by OBS, waiting for the message thread to set the parameters
+    std::atomic<float> receivedValue { 0.0f };
+    std::atomic<float> receivedTrigger { 0.0f };
+    std::atomic<bool> receivedValuePending { false };
+    std::atomic<bool> receivedTriggerPending { false };
     
-    void populateCommandsList();
-    void handleCommandChange(int commandID);
-    void handleCommandCategoryChange();
+    void handleAsyncUpdate() override;
     
-    bool forceConnect = false;
+    // The input's envelope, for the audio-reactive mode
+    EnvelopeFollower envelope;
+    EnvelopeFollower::Settings envelopeSettings() const;
     
-//    void sendTextType(float numChars);
+    // The input's frequency bands, for the bands audio-reactive mode
+    SpectrumAnalyser spectrum;
     
-    class ObviousThread : public juce::Thread
-        {
-        public:
-            ObviousThread(ObviousAudioProcessor &p) : juce::Thread ("ObviousThread"), audioProcessor(p) {}
-            
-            ObviousAudioProcessor& audioProcessor;
-            bool shouldRun = true;
-            
-            void run() override
-            {
-                while (shouldRun) {
-                                            
-                    if (audioProcessor.socket.isConnected()) {
-                        
-                        char buffer[1024];
-                        int n = audioProcessor.socket.read(buffer, 1024, false);
-                        if (n > 0) {
-                            std::string messages = std::string(buffer).substr(0, n);
-                            
-                            std::stringstream stringStream(messages);
-                            std::string segment;
-                            std::vector<std::string> seglist;
-
-                            while(std::getline(stringStream, segment, CommandDelimiter))
-                            {
-                               seglist.push_back(segment);
-                            }
-                            
-                            std::for_each(seglist.begin(), seglist.end(), [this](std::string message){
-                                audioProcessor.clientMessageReceived(message);
-                            });
-                            
-                            // audioProcessor.clientMessageReceived(s);
-                        }
-                        
-                    }
-                                            
-                    sleep(10);
-                }
-            }
-        };
-
-    ObviousThread clientThread;
+    // Hits in the input, for firing the trigger command, and the audio delayed by the lookahead
+    OnsetDetector onsets;
+    OnsetDetector::Settings onsetSettings() const;
+    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None> lookahead;
+    std::atomic<int> lookaheadSamples { 0 };
+    int appliedLookaheadSamples = 0;
+    
+    // The envelope and onset settings, copied from the settings tree on the thread that changes it,
+    // so the audio thread never reads the tree
+    std::atomic<int> cachedAudioMode { EnvelopeFollower::Peak };
+    std::atomic<float> cachedAttackMs { 0.0f }, cachedReleaseMs { 0.0f }, cachedGainDecibels { 0.0f };
+    std::atomic<float> cachedFloorDecibels { 0.0f }, cachedFramesPerSecond { 0.0f };
+    std::atomic<float> cachedOnsetThresholdDecibels { 0.0f }, cachedOnsetHoldMs { 0.0f }, cachedOnsetFloorDecibels { 0.0f };
+    void cacheSettings();
+    
+    void valueTreePropertyChanged (juce::ValueTree& tree, const juce::Identifier& property) override;
+    void valueTreeRedirected (juce::ValueTree& tree) override;
     
-    class HeartbeatThread : public juce::Thread
-        {
-        public:
-            HeartbeatThread(ObviousAudioProcessor &p) : juce::Thread ("HeartbeatThread"), audioProcessor(p) {}
-            
-            ObviousAudioProcessor& audioProcessor;
-            bool shouldRun = true;
-            
-            void run() override
-            {
-                while (shouldRun) {
-                                            
-                    if (audioProcessor.socket.isConnected()) {
-                        
-                        audioProcessor.hasReceivedHeartbeatResponse = false;
-                        
-                        std::string s = std::string(CommandHeartbeat) + CommandDelimiter;
-                        const char * ss = s.c_str();
-                        audioProcessor.socket.write(ss, (int)strlen(ss));
-                        
-//                        audioProcessor.socket.write(CommandHeartbeat, strlen(CommandHeartbeat));
-                        sleep(1000);
-                        
-                        if (!audioProcessor.hasReceivedHeartbeatResponse) {
-                            audioProcessor.heartbeatLost();
-                            shouldRun = false;
-                        }
-                        
-                    }
-                                            
-//                    sleep(1000);
-                }
-            }
-        };
-    
-    HeartbeatThread heartbeatThread;
-    
-        
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ObviousAudioProcessor)
 };
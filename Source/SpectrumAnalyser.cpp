@@ -0,0 +1,112 @@
+//
+//  SpectrumAnalyser.cpp
+//  Obvious
+//
+
+#include "SpectrumAnalyser.h"
+
+#include <algorithm>
+#include <cmath>
+
+void SpectrumAnalyser::prepare(double newSampleRate) {
+
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : 44100.0;
+
+    const double highest = juce::jmin((double)highestHz, sampleRate * 0.45);
+    const double ratio = std::pow(highest / (double)lowestHz, 1.0 / SpectrumBandCount);
+
+    double edgeHz = lowestHz;
+    for (int band = 0; band <= SpectrumBandCount; ++band) {
+        const int bin = (int)std::lround(edgeHz * fftSize / sampleRate);
+        // Every band gets at least one bin, however narrow it is at this rate
+        bandEdges[(size_t)band] = band == 0 ? juce::jmax(1, bin) : juce::jlimit(bandEdges[(size_t)band - 1] + 1, fftSize / 2, bin);
+        edgeHz *= ratio;
+    }
+
+    reset();
+
+}
+
+void SpectrumAnalyser::reset() {
+
+    fifo.fill(0.0f);
+    fifoPosition = 0;
+    samplesSinceTransform = 0;
+    envelopes.fill(0.0f);
+    frameMaxima.fill(0.0f);
+    samplesUntilReport = 0.0;
+
+}
+
+bool SpectrumAnalyser::process(const float* const* channels, int numChannels, int numSamples, const EnvelopeFollower::Settings &settings, Levels &levels) {
+
+    if (numChannels < 1 || numSamples < 1) return false;
+
+    // Mixed to mono into the FIFO, a contiguous run at a time
+    const float channelGain = 1.0f / (float)numChannels;
+    for (int written = 0; written < numSamples;) {
+        const int length = juce::jmin(numSamples - written, fftSize - fifoPosition);
+        float *destination = fifo.data() + fifoPosition;
+        juce::FloatVectorOperations::copyWithMultiply(destination, channels[0] + written, channelGain, length);
+        for (int channel = 1; channel < numChannels; ++channel) {
+            juce::FloatVectorOperations::addWithMultiply(destination, channels[channel] + written, channelGain, length);
+        }
+        fifoPosition = (fifoPosition + length) % fftSize;
+        written += length;
+    }
+
+    samplesSinceTransform += numSamples;
+    if (samplesSinceTransform >= hopSize) {
+        transform(samplesSinceTransform, settings);
+        samplesSinceTransform = 0;
+    }
+
+    bool reportDue = false;
+    samplesUntilReport -= numSamples;
+    while (samplesUntilReport <= 0.0) {
+        reportDue = true;
+        samplesUntilReport += sampleRate / (double)juce::jmax(1.0f, settings.framesPerSecond);
+    }
+
+    if (!reportDue) return false;
+
+    for (size_t band = 0; band < levels.size(); ++band) {
+        levels[band] = EnvelopeFollower::toRange(frameMaxima[band], settings);
+    }
+    frameMaxima.fill(0.0f);
+
+    return true;
+
+}
+
+void SpectrumAnalyser::transform(int elapsedSamples, const EnvelopeFollower::Settings &settings) {
+
+    const int oldest = fftSize - fifoPosition;
+    std::copy(fifo.begin() + fifoPosition, fifo.end(), fftData.begin());
+    std::copy(fifo.begin(), fifo.begin() + fifoPosition, fftData.begin() + oldest);
+
+    window.multiplyWithWindowingTable(fftData.data(), (size_t)fftSize);
+    fft.performFrequencyOnlyForwardTransform(fftData.data(), true);
+
+    // A full-scale sine centred on a bin, after the Hann window, sums to this (its bin and half of each neighbour)
+    static const float fullScale = (float)fftSize / 4.0f * std::sqrt(1.5f);
+
+    // The smoothing for the time since the last transform, as EnvelopeFollower's over a sub-block
+    const auto coefficient = [this, elapsedSamples](float milliseconds) {
+        const double samples = juce::jmax(1.0, (double)milliseconds * 0.001 * sampleRate);
+        return (float)std::exp(-(double)elapsedSamples / samples);
+    };
+    const float attack = coefficient(settings.attackMs);
+    const float release = coefficient(settings.releaseMs);
+
+    float *scratch = fftData.data() + fftSize;
+
+    for (size_t band = 0; band < envelopes.size(); ++band) {
+        const int first = bandEdges[band];
+        const float power = EnvelopeFollower::sumOfSquares(scratch, fftData.data() + first, bandEdges[band + 1] - first);
+        const float level = std::sqrt(power) / fullScale;
+        envelopes[band] = level + (level > envelopes[band] ? attack : release) * (envelopes[band] - level);
+        frameMaxima[band] = juce::jmax(frameMaxima[band], envelopes[band]);
+    }
+
+}
@@ -0,0 +1,82 @@
+//
+//  SpectrumAnalyser.h
+//  Obvious
+//
+//  Levels of SpectrumBandCount frequency bands of the plugin's input, for
+//  the audio-reactive Bands mode. The input, mixed to mono, is transformed
+//  with juce::dsp::FFT over a Hann-windowed 1024-sample window every 256
+//  samples (75% overlap). Each band's level is the root of the summed power
+//  of its bins, squared and summed with EnvelopeFollower::sumOfSquares. The
+//  bands are spaced evenly in pitch from lowestHz to highestHz, and each is
+//  smoothed and reported once per video frame as EnvelopeFollower does.
+//
+//  At most one transform runs per audio block, so at 64-sample blocks the
+//  cost is one transform every fourth block and the rest only copy samples.
+//  A block longer than the hop still gets one transform, of its latest
+//  window.
+//
+//  Audio thread only. Nothing is allocated or locked after construction.
+//
+
+#ifndef SpectrumAnalyser_h
+#define SpectrumAnalyser_h
+
+#include <array>
+
+#include <JuceHeader.h>
+#include "ParameterDefinitions.h"
+#include "EnvelopeFollower.h"
+
+class SpectrumAnalyser
+{
+public:
+
+    static constexpr int fftOrder = 10;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = fftSize / 4;
+    static constexpr float lowestHz = 40.0f;
+    static constexpr float highestHz = 16000.0f;
+
+    using Levels = std::array<float, SpectrumBandCount>;
+
+    SpectrumAnalyser() = default;
+
+    void prepare(double sampleRate);
+    void reset();
+
+    /*
+     Follows one block of `numChannels` channels. Returns true when a video
+     frame has passed since the last report, with `levels` set to each
+     band's level mapped as EnvelopeFollower maps its envelope. The mode
+     in `settings` is not used.
+     */
+    bool process(const float* const* channels, int numChannels, int numSamples, const EnvelopeFollower::Settings &settings, Levels &levels);
+
+private:
+
+    juce::dsp::FFT fft { fftOrder };
+    juce::dsp::WindowingFunction<float> window { (size_t)fftSize, juce::dsp::WindowingFunction<float>::hann, false };
+
+    double sampleRate = 44100.0;
+
+    // The last fftSize samples, oldest at fifoPosition
+    std::array<float, fftSize> fifo {};
+    int fifoPosition = 0;
+    int samplesSinceTransform = 0;
+
+    // The transform's input and output; its second half is also the scratch for the band sums
+    std::array<float, 2 * fftSize> fftData {};
+
+    // The first bin of each band, then the bin after the last band
+    std::array<int, SpectrumBandCount + 1> bandEdges {};
+
+    Levels envelopes {};
+    Levels frameMaxima {};
+    double samplesUntilReport = 0.0;
+
+    void transform(int elapsedSamples, const EnvelopeFollower::Settings &settings);
+
+    JUCE_DECLARE_NON_COPYABLE (SpectrumAnalyser)
+};
+
+#endif /* SpectrumAnalyser_h */
@@ -0,0 +1,71 @@
+//
+//  StatsPanel.cpp
+//  Obvious
+//
+
+#include "StatsPanel.h"
+
+StatsPanel::StatsPanel(const ObviousStats &s)
+    : stats(s)
+{
+
+    summaryLabel.setColour(juce::Label::textColourId, juce::Colours::lightgrey);
+    summaryLabel.setMinimumHorizontalScale(0.5f);
+    addAndMakeVisible(summaryLabel);
+
+    copyButton.setButtonText("Copy stats");
+    copyButton.onClick = [this] {
+        juce::SystemClipboard::copyTextToClipboard(stats.snapshot().toJSON());
+    };
+    addAndMakeVisible(copyButton);
+
+    previous = stats.snapshot();
+    previousTime = juce::Time::getMillisecondCounterHiRes();
+    refresh();
+
+}
+
+void StatsPanel::resized() {
+
+    auto bounds = getLocalBounds();
+    copyButton.setBounds(bounds.removeFromRight(bounds.getWidth()/4));
+    summaryLabel.setBounds(bounds);
+
+}
+
+void StatsPanel::refresh() {
+
+    const ObviousStats::Snapshot current = stats.snapshot();
+    const double now = juce::Time::getMillisecondCounterHiRes();
+    const double seconds = juce::jmax(0.001, (now-previousTime)/1000.0);
+
+    const double messagesPerSecond = (double)(current.messagesSent-previous.messagesSent)/seconds;
+    const double bytesPerSecond = (double)(current.bytesSent-previous.bytesSent)/seconds;
+
+    auto rtt = [&current](double fraction) {
+        const double ms = current.rttPercentile(fraction);
+        return std::isinf(ms) ? juce::String(">" + juce::String(juce::roundToInt(ObviousStats::rttBucketLimits.back()))) : juce::String(juce::roundToInt(ms));
+    };
+
+    juce::String summary;
+    summary << juce::roundToInt(messagesPerSecond) << " msg/s  "
+            << juce::String(bytesPerSecond/1024.0, 1) << " KB/s  "
+            << "sent " << (juce::int64)current.messagesSent << "  "
+            << "suppressed " << (juce::int64)current.sendsSuppressed << "  "
+            << "reconnects " << (juce::int64)current.reconnects << "  "
+            << "RTT p50/p99 " << rtt(0.5) << "/" << rtt(0.99) << " ms  "
+            << "longest write " << juce::String((double)current.longestWriteStallMicroseconds/1000.0, 1) << " ms";
+
+    // Only shown while the script or receiver is still reporting (once a second)
+    if (current.obs.valid && juce::Time::currentTimeMillis() - current.obs.receivedAt < 5000) {
+        summary << "  OBS apply " << juce::String(current.obs.applyUs/1000.0, 2) << " ms/tick  "
+                << juce::String(current.obs.perFrame, 1) << " msg/frame  "
+                << "backlog " << juce::roundToInt(current.obs.backlog);
+    }
+
+    summaryLabel.setText(summary, juce::dontSendNotification);
+
+    previous = current;
+    previousTime = now;
+
+}
@@ -0,0 +1,37 @@
+//
+//  StatsPanel.h
+//  Obvious
+//
+//  One line of connection statistics at the bottom of the editor, refreshed
+//  by the editor's timer. Clicking "Copy stats" puts a JSON snapshot on the
+//  clipboard.
+//
+
+#ifndef StatsPanel_h
+#define StatsPanel_h
+
+#include <JuceHeader.h>
+#include "Core/ObviousStats.h"
+
+class StatsPanel : public juce::Component
+{
+public:
+    explicit StatsPanel(const ObviousStats &stats);
+
+    void resized() override;
+
+    // Takes a snapshot and updates the line; rates are averaged since the previous call
+    void refresh();
+
+private:
+    const ObviousStats &stats;
+    ObviousStats::Snapshot previous;
+    double previousTime = 0.0;
+
+    juce::Label summaryLabel;
+    juce::TextButton copyButton;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StatsPanel)
+};
+
+#endif /* StatsPanel_h */
@@ -0,0 +1,97 @@
+//
+//  StatusLine.cpp
+//  Obvious
+//
+
+#include "StatusLine.h"
+
+StatusLine::StatusLine(ObviousStatusQueue &q)
+    : queue(q)
+{
+
+    statusLabel.setColour(juce::Label::textColourId, juce::Colours::lightgrey);
+    statusLabel.setMinimumHorizontalScale(0.5f);
+    addAndMakeVisible(statusLabel);
+
+    clearButton.setButtonText("Clear");
+    clearButton.onClick = [this] {
+        entries.clear();
+        dropped = 0;
+        update();
+    };
+    addAndMakeVisible(clearButton);
+
+    refresh();
+
+}
+
+void StatusLine::resized() {
+
+    auto bounds = getLocalBounds();
+    clearButton.setBounds(bounds.removeFromRight(bounds.getWidth()/4));
+    statusLabel.setBounds(bounds);
+
+}
+
+void StatusLine::refresh() {
+
+    const auto statuses = queue.read();
+    const juce::uint32 newlyDropped = queue.readDropped();
+
+    if (statuses.isEmpty() && newlyDropped == 0) return;
+
+    dropped += newlyDropped;
+
+    for (const auto &status : statuses) {
+
+        Entry entry;
+        for (int i = 0; i < entries.size(); ++i) {
+            if (entries.getReference(i).title == status.title && entries.getReference(i).message == status.message) {
+                entry = entries.removeAndReturn(i);
+                break;
+            }
+        }
+
+        entry.title = status.title;
+        entry.message = status.message;
+        entry.count += status.count;
+        entries.add(entry);
+
+    }
+
+    while (entries.size() > maxEntries) {
+        entries.remove(0);
+    }
+
+    update();
+
+}
+
+void StatusLine::update() {
+
+    if (entries.isEmpty()) {
+        statusLabel.setText({}, juce::dontSendNotification);
+        statusLabel.setTooltip({});
+        return;
+    }
+
+    auto describe = [](const Entry &entry) {
+        juce::String text = entry.title + ": " + entry.message;
+        if (entry.count > 1) text << " (x" << entry.count << ")";
+        return text;
+    };
+
+    const Entry &latest = entries.getReference(entries.size()-1);
+
+    juce::String summary = describe(latest);
+    if (entries.size() > 1) summary << "  +" << (entries.size()-1) << " more";
+    if (dropped > 0) summary << "  (" << dropped << " not shown)";
+
+    juce::StringArray lines;
+    for (const auto &entry : entries) lines.add(describe(entry));
+
+    statusLabel.setColour(juce::Label::textColourId, latest.title == "Error" ? juce::Colours::orange : juce::Colours::lightgrey);
+    statusLabel.setText(summary, juce::dontSendNotification);
+    statusLabel.setTooltip(lines.joinIntoString("\n"));
+
+}
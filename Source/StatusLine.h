@@ -0,0 +1,52 @@
+//
+//  StatusLine.h
+//  Obvious
+//
+//  The latest error or information from the engine, in one row of the
+//  editor instead of a dialog. The editor's timer has it read the
+//  processor's ObviousStatusQueue a few times a second, so however often a
+//  status is posted it is drawn at that rate, with a count of how often it
+//  was repeated.
+//
+
+#ifndef StatusLine_h
+#define StatusLine_h
+
+#include <JuceHeader.h>
+#include "Core/ObviousStatusQueue.h"
+
+class StatusLine : public juce::Component
+{
+public:
+    explicit StatusLine(ObviousStatusQueue &queue);
+
+    void resized() override;
+
+    // Reads the queue, and redraws only when something was posted
+    void refresh();
+
+private:
+
+    struct Entry
+    {
+        juce::String title;
+        juce::String message;
+        juce::int64 count = 0;
+    };
+
+    // Distinct statuses, most recent last
+    static constexpr int maxEntries = 8;
+
+    ObviousStatusQueue &queue;
+    juce::Array<Entry> entries;
+    juce::int64 dropped = 0;
+
+    juce::Label statusLabel;
+    juce::TextButton clearButton;
+
+    void update();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StatusLine)
+};
+
+#endif /* StatusLine_h */
@@ -0,0 +1,192 @@
+//
+//  ObviousProtocolTests.cpp
+//  Obvious
+//
+//  Checks the parts of ObviousProtocol that need no JUCE. Exits non-zero
+//  when a check fails; registered with ctest as obvious-protocol-tests.
+//
+
+#include <cstdio>
+#include <deque>
+#include <string>
+
+#include "Core/ObviousProtocol.h"
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++failures; \
+        } \
+    } while (0)
+
+// The IDs used below, as in CommandDefinitions.h
+enum : int {
+    ScaleX = 30,
+    ScaleY = 40,
+    MediaRestart = 50,
+    Opacity = 140,
+    SetVisible = 190,
+    TypeText = 200,
+    Transform = 340,
+};
+
+// As CommandTable::isContinuous, for the commands used here
+static bool isContinuous(int command)
+{
+    return command == ScaleX || command == ScaleY || command == Opacity;
+}
+
+// As ObviousConnection::holdPending
+static void hold(std::deque<std::string> &pending, const std::string &message)
+{
+    if (!ObviousProtocol::coalesce(pending, message, isContinuous)) pending.push_back(message);
+}
+
+static std::string value(int command, const std::string &source, float v)
+{
+    return ObviousProtocol::encode(command, "Scene", source, "", ObviousProtocol::encodeValue(v));
+}
+
+static std::string relative(int command, const std::string &source, float change)
+{
+    return ObviousProtocol::encodeRelative(value(command, source, change));
+}
+
+static void testTriggersKeepEveryPress()
+{
+    std::deque<std::string> pending;
+
+    hold(pending, value(MediaRestart, "Source", 1.0f));
+    hold(pending, value(MediaRestart, "Source", 0.0f));
+    hold(pending, value(MediaRestart, "Source", 1.0f));
+    hold(pending, value(MediaRestart, "Source", 0.0f));
+
+    CHECK(pending.size() == 4);
+    CHECK(pending[0] == value(MediaRestart, "Source", 1.0f));
+    CHECK(pending[1] == value(MediaRestart, "Source", 0.0f));
+    CHECK(pending[2] == value(MediaRestart, "Source", 1.0f));
+
+    hold(pending, value(SetVisible, "Source", 0.0f));
+    hold(pending, value(SetVisible, "Source", 1.0f));
+    hold(pending, ObviousProtocol::encode(TypeText, "Scene", "Source", "", "one"));
+    hold(pending, ObviousProtocol::encode(TypeText, "Scene", "Source", "", "two"));
+    CHECK(pending.size() == 8);
+}
+
+static void testValuesKeepTheLatest()
+{
+    std::deque<std::string> pending;
+
+    hold(pending, value(ScaleX, "Source", 1.0f));
+    hold(pending, value(ScaleX, "Source", 2.0f));
+    hold(pending, value(ScaleX, "Other", 3.0f));
+    hold(pending, value(ScaleX, "Source", 4.0f));
+
+    CHECK(pending.size() == 2);
+    CHECK(pending[0] == value(ScaleX, "Source", 4.0f));
+    CHECK(pending[1] == value(ScaleX, "Other", 3.0f));
+
+    // Values for different filters of one source are not folded together
+    hold(pending, ObviousProtocol::encode(Opacity, "Scene", "Other", "A", "0.5"));
+    hold(pending, ObviousProtocol::encode(Opacity, "Scene", "Other", "B", "0.5"));
+    CHECK(pending.size() == 4);
+}
+
+static void testChangesAreSummed()
+{
+    std::deque<std::string> pending;
+
+    hold(pending, relative(ScaleX, "Source", 0.25f));
+    hold(pending, relative(ScaleX, "Source", 0.5f));
+    CHECK(pending.size() == 1 && pending[0] == relative(ScaleX, "Source", 0.75f));
+
+    // A value replaces the changes before it, and a change after it is added to the value
+    hold(pending, value(ScaleX, "Source", 2.0f));
+    hold(pending, relative(ScaleX, "Source", 0.5f));
+    CHECK(pending.size() == 1 && pending[0] == value(ScaleX, "Source", 2.5f));
+}
+
+static void testOrderPerItem()
+{
+    std::deque<std::string> pending;
+
+    // A value sent after another command for the item is not moved ahead of it
+    hold(pending, value(ScaleX, "Source", 1.0f));
+    hold(pending, value(MediaRestart, "Source", 1.0f));
+    hold(pending, value(ScaleX, "Source", 2.0f));
+    CHECK(pending.size() == 3);
+    CHECK(pending[0] == value(ScaleX, "Source", 1.0f) && pending[2] == value(ScaleX, "Source", 2.0f));
+
+    // Nor past an envelope that may hold a command for it
+    pending.clear();
+    hold(pending, value(ScaleY, "Source", 1.0f));
+    hold(pending, ObviousProtocol::encodeScheduled(10.0, value(ScaleY, "Source", 5.0f)));
+    hold(pending, value(ScaleY, "Source", 2.0f));
+    CHECK(pending.size() == 3);
+}
+
+static std::string transform(const std::string &source, const std::string &fields)
+{
+    return ObviousProtocol::encode(Transform, "Scene", source, "", fields);
+}
+
+static void testTransformsMergeFields()
+{
+    const char GS = CatalogueFieldDelimiter;
+    std::deque<std::string> pending;
+
+    // Batches for one item carrying different fields keep all of them, and a field sent again keeps its latest value
+    hold(pending, transform("Source", std::string("30") + GS + "1.5" + GS + "150" + GS + "10"));
+    hold(pending, transform("Other", std::string("30") + GS + "2"));
+    hold(pending, transform("Source", std::string("10") + GS + "0.25" + GS + "150" + GS + "20"));
+
+    CHECK(pending.size() == 2);
+    CHECK(pending[0] == transform("Source", std::string("30") + GS + "1.5" + GS + "150" + GS + "20" + GS + "10" + GS + "0.25"));
+    CHECK(pending[1] == transform("Other", std::string("30") + GS + "2"));
+
+    // Not merged past another command for the item
+    hold(pending, value(ScaleX, "Other", 3.0f));
+    hold(pending, transform("Other", std::string("30") + GS + "4"));
+    CHECK(pending.size() == 4);
+}
+
+static void testValuesMergeRecords()
+{
+    const char FS = ValuesRecordDelimiter;
+    const std::string band1 = ObviousProtocol::encodeValueRecord(ScaleX, "Scene", "One", "", 1.0f);
+    const std::string band2 = ObviousProtocol::encodeValueRecord(ScaleY, "Scene", "Two", "", 2.0f);
+    const std::string band2Later = ObviousProtocol::encodeValueRecord(ScaleY, "Scene", "Two", "", 3.0f);
+    const std::string band3 = ObviousProtocol::encodeValueRecord(Opacity, "Scene", "Two", "Filter", 0.5f);
+    std::deque<std::string> pending;
+
+    // A band that changed only in the earlier message is kept
+    hold(pending, ObviousProtocol::encodeValues(band1 + FS + band2));
+    hold(pending, ObviousProtocol::encodeValues(band2Later + FS + band3));
+    CHECK(pending.size() == 1);
+    CHECK(pending[0] == ObviousProtocol::encodeValues(band1 + FS + band2Later + FS + band3));
+
+    // Not merged past another command
+    hold(pending, value(ScaleX, "One", 4.0f));
+    hold(pending, ObviousProtocol::encodeValues(band1));
+    CHECK(pending.size() == 3);
+}
+
+int main()
+{
+    testTriggersKeepEveryPress();
+    testValuesKeepTheLatest();
+    testChangesAreSummed();
+    testOrderPerItem();
+    testTransformsMergeFields();
+    testValuesMergeRecords();
+
+    if (failures > 0) {
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
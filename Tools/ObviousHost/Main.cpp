@@ -0,0 +1,172 @@
+//
+//  Main.cpp
+//  ObviousHost
+//
+//  Runs one or more ObviousEngines without a DAW or GUI, for soak tests and
+//  render boxes. Values (0 to 1) are read from stdin, one per line, and sent
+//  by every engine; --sweep replaces stdin with a generated ramp.
+//
+//  Usage: ObviousHost --scene S --source SRC [--filter F] [--command ID]
+//                     [--ip 127.0.0.1] [--port 11111] [--engines N]
+//                     [--range-lower L] [--range-upper U]
+//                     [--sweep seconds] [--rate Hz] [--stats]
+//                     [--trace file] [--udp] [--connect-timeout ms]
+//                     [--drop-while-connecting] [--relative] [--batch-transform]
+//
+//  With several engines the source name gets the engine's index appended
+//  (SRC0, SRC1, ...) unless --same-source is given. --stats prints each
+//  engine's counters as JSON on exit. --trace records every command to a
+//  trace file for Tools/ObviousTrace. --udp sends values as datagrams, with
+//  the final value resent over TCP. Engines connect in the background; what
+//  they send before OBS answers is queued unless --drop-while-connecting.
+//  --relative sends each value as the change since the previous one, which
+//  OBS adds to what it shows. --batch-transform sends the engines' position,
+//  scale, rotation, crop and bounds values for one source as one Transform
+//  per step.
+//
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Core/ObviousEngine.h"
+
+// Owns the state tree, and is a base so the tree exists before ObviousEngine binds to it
+struct HostState
+{
+    juce::ValueTree hostState { "Obvious" };
+};
+
+class HostEngine : private HostState, public ObviousEngine, private ObviousEngine::Listener
+{
+public:
+    HostEngine() : ObviousEngine(hostState) { setListener(this); }
+    ~HostEngine() override { setListener(nullptr); }
+
+private:
+    void engineMessage(const juce::String &title, const juce::String &message) override {
+        std::fprintf(stderr, "%s: %s\n", title.toRawUTF8(), message.toRawUTF8());
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+
+    auto option = [&args](const juce::String& name, const juce::String& fallback) {
+        return args.containsOption(name) ? args.getValueForOption(name) : fallback;
+    };
+
+    const juce::String scene = option("--scene", {});
+    const juce::String source = option("--source", {});
+    if (scene.isEmpty() || source.isEmpty()) {
+        std::fprintf(stderr, "--scene and --source are required\n");
+        return 1;
+    }
+
+    const int commandID = option("--command", juce::String((int)CommandDefinitionDefault)).getIntValue();
+    const Command& command = CommandTable::withID(commandID);
+    if (command.commandID == 0) {
+        std::fprintf(stderr, "Unknown command %d\n", commandID);
+        return 1;
+    }
+
+    if (args.containsOption("--trace") && !ObviousTrace::open(juce::File::getCurrentWorkingDirectory().getChildFile(option("--trace", {})))) {
+        std::fprintf(stderr, "Could not create the trace file\n");
+        return 1;
+    }
+
+    const int numEngines = juce::jmax(1, option("--engines", "1").getIntValue());
+    const bool sameSource = args.containsOption("--same-source");
+
+    std::vector<std::unique_ptr<HostEngine>> engines;
+    for (int i = 0; i < numEngines; ++i) {
+        auto engine = std::make_unique<HostEngine>();
+        auto settingsStorage = engine->settings();
+        settingsStorage.setProperty(ParameterIDIP, option("--ip", "127.0.0.1"), nullptr);
+        settingsStorage.setProperty(ParameterIDPort, option("--port", "11111"), nullptr);
+        settingsStorage.setProperty(ParameterIDScene, scene, nullptr);
+        settingsStorage.setProperty(ParameterIDSource, sameSource || numEngines == 1 ? source : source + juce::String(i), nullptr);
+        settingsStorage.setProperty(ParameterIDFilter, option("--filter", {}), nullptr);
+        settingsStorage.setProperty(ParameterIDCommandCategory, (int)command.category, nullptr);
+        settingsStorage.setProperty(ParameterIDCommand, commandID, nullptr);
+        settingsStorage.setProperty(ParameterIDRangeLower, option("--range-lower", "0").getDoubleValue(), nullptr);
+        settingsStorage.setProperty(ParameterIDRangeUpper, option("--range-upper", "1").getDoubleValue(), nullptr);
+        settingsStorage.setProperty(ParameterIDUDP, args.containsOption("--udp"), nullptr);
+        settingsStorage.setProperty(ParameterIDRelative, args.containsOption("--relative"), nullptr);
+        settingsStorage.setProperty(ParameterIDBatchTransform, args.containsOption("--batch-transform"), nullptr);
+        settingsStorage.setProperty(ParameterIDConnectTimeout, option("--connect-timeout", juce::String(ObviousConnection::defaultTimeoutMilliseconds)).getIntValue(), nullptr);
+        settingsStorage.setProperty(ParameterIDQueueWhileConnecting, !args.containsOption("--drop-while-connecting"), nullptr);
+        engine->sendEnabled = true;
+        engine->connect();
+        engines.push_back(std::move(engine));
+    }
+
+    // Connecting happens in the background; give OBS the connect timeout to answer before sending
+    const auto connectDeadline = std::chrono::steady_clock::now()
+        + std::chrono::milliseconds(option("--connect-timeout", juce::String(ObviousConnection::defaultTimeoutMilliseconds)).getIntValue());
+    for (auto& engine : engines) {
+        while (engine->connectionState() != ObviousConnection::State::Connected && std::chrono::steady_clock::now() < connectDeadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    auto sendAll = [&engines, &command](float value) {
+        for (auto& engine : engines) engine->send(command.triggerParameterID, value);
+        for (auto& engine : engines) engine->endTransformBlock();
+    };
+
+    uint64_t sent = 0;
+
+    if (args.containsOption("--sweep")) {
+
+        const double seconds = option("--sweep", "10").getDoubleValue();
+        const double rate = juce::jmax(1.0, option("--rate", "60").getDoubleValue());
+        const auto interval = std::chrono::duration<double>(1.0 / rate);
+        const auto start = std::chrono::steady_clock::now();
+        auto next = start;
+
+        for (int64_t step = 0; std::chrono::steady_clock::now() - start < std::chrono::duration<double>(seconds); ++step) {
+            // Triangle wave for values, square wave for triggers
+            const double phase = std::fmod(step / rate, 2.0);
+            const float value = command.triggerParameterID == ParameterIDTrigger ? (phase < 1.0 ? 1.0f : 0.0f)
+                                                                                  : (float)(phase < 1.0 ? phase : 2.0 - phase);
+            sendAll(value);
+            sent += engines.size();
+
+            next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+            std::this_thread::sleep_until(next);
+        }
+
+    }
+    else {
+
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            if (line.empty()) continue;
+            sendAll((float)std::atof(line.c_str()));
+            sent += engines.size();
+        }
+
+    }
+
+    // The end of the input is the end of the gesture
+    for (auto& engine : engines) engine->gestureEnded(command.triggerParameterID);
+
+    std::printf("%llu commands sent by %d engine(s)\n", (unsigned long long)sent, numEngines);
+
+    if (args.containsOption("--stats")) {
+        for (auto& engine : engines) std::printf("%s\n", engine->stats.snapshot().toJSON().toRawUTF8());
+    }
+
+    for (auto& engine : engines) engine->close();
+    engines.clear();
+    ObviousTrace::close();
+
+    return 0;
+}
@@ -0,0 +1,136 @@
+//
+//  main.cpp
+//  obvious-trace
+//
+//  Converts an outbound message trace (see Source/Core/ObviousTraceFormat.h)
+//  to CSV or Chrome trace JSON (load the latter in chrome://tracing or
+//  Perfetto). Records are printed oldest first; incomplete records are
+//  skipped and counted on stderr.
+//
+//  Usage: obvious-trace [--csv | --chrome] trace-file [output-file]
+//
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Core/ObviousTraceFormat.h"
+
+struct TraceRecord
+{
+    uint64_t index;
+    uint64_t wallClockNanoseconds;
+    int64_t samplePosition;
+    uint64_t targetHandle;
+    uint32_t instanceID;
+    int32_t command;
+    float value;
+    int32_t bytesWritten;
+};
+
+static bool readTrace(FILE *file, std::vector<TraceRecord> &records, uint64_t &skipped)
+{
+    ObviousTraceFormat::Header header;
+    if (std::fread(&header, sizeof(header), 1, file) != 1 || std::memcmp(header.magic, ObviousTraceFormat::magic, sizeof(header.magic)) != 0) {
+        std::fprintf(stderr, "Not an Obvious trace file\n");
+        return false;
+    }
+
+    if (header.version != ObviousTraceFormat::version || header.recordSize != sizeof(ObviousTraceFormat::Record) || header.capacity == 0) {
+        std::fprintf(stderr, "Unsupported trace version %u (record size %u)\n", header.version, header.recordSize);
+        return false;
+    }
+
+    std::vector<ObviousTraceFormat::Record> ring(header.capacity);
+    const size_t read = std::fread(ring.data(), sizeof(ObviousTraceFormat::Record), ring.size(), file);
+
+    const uint64_t writeIndex = header.writeIndex.load();
+    const uint64_t count = writeIndex < header.capacity ? writeIndex : header.capacity;
+
+    for (uint64_t index = writeIndex - count; index < writeIndex; ++index) {
+        const uint64_t slot = index % header.capacity;
+        const ObviousTraceFormat::Record &r = ring[slot];
+
+        if (slot >= read || r.sequence.load() != index + 1) {
+            ++skipped;
+            continue;
+        }
+
+        records.push_back({ index, r.wallClockNanoseconds, r.samplePosition, r.targetHandle, r.instanceID, r.command, r.value, r.bytesWritten });
+    }
+
+    return true;
+}
+
+static void writeCSV(FILE *out, const std::vector<TraceRecord> &records)
+{
+    std::fprintf(out, "index,wall_clock_ns,sample_position,instance,command,target,value,bytes_written\n");
+    for (const auto &r : records) {
+        std::fprintf(out, "%" PRIu64 ",%" PRIu64 ",%" PRId64 ",%u,%d,%016" PRIx64 ",%.6f,%d\n",
+                     r.index, r.wallClockNanoseconds, r.samplePosition, r.instanceID, r.command, r.targetHandle, (double)r.value, r.bytesWritten);
+    }
+}
+
+static void writeChromeTrace(FILE *out, const std::vector<TraceRecord> &records)
+{
+    // Instant events, one thread per instance, timestamps in µs relative to the first record
+    const uint64_t origin = records.empty() ? 0 : records.front().wallClockNanoseconds;
+
+    std::fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    for (size_t i = 0; i < records.size(); ++i) {
+        const auto &r = records[i];
+        const double ts = (double)(int64_t)(r.wallClockNanoseconds - origin) / 1000.0;
+        std::fprintf(out, "{\"name\":\"%d\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,"
+                          "\"args\":{\"target\":\"%016" PRIx64 "\",\"value\":%.6f,\"bytes\":%d,\"sample\":%" PRId64 "}}%s\n",
+                     r.command, r.instanceID, ts, r.targetHandle, (double)r.value, r.bytesWritten, r.samplePosition,
+                     i + 1 < records.size() ? "," : "");
+    }
+    std::fprintf(out, "]}\n");
+}
+
+int main(int argc, char *argv[])
+{
+    bool chrome = false;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--chrome") chrome = true;
+        else if (arg == "--csv") chrome = false;
+        else paths.push_back(arg);
+    }
+
+    if (paths.empty() || paths.size() > 2) {
+        std::fprintf(stderr, "Usage: obvious-trace [--csv | --chrome] trace-file [output-file]\n");
+        return 1;
+    }
+
+    FILE *in = std::fopen(paths[0].c_str(), "rb");
+    if (in == nullptr) {
+        std::fprintf(stderr, "Could not open %s\n", paths[0].c_str());
+        return 1;
+    }
+
+    std::vector<TraceRecord> records;
+    uint64_t skipped = 0;
+    const bool ok = readTrace(in, records, skipped);
+    std::fclose(in);
+    if (!ok) return 1;
+
+    FILE *out = paths.size() > 1 ? std::fopen(paths[1].c_str(), "w") : stdout;
+    if (out == nullptr) {
+        std::fprintf(stderr, "Could not write %s\n", paths[1].c_str());
+        return 1;
+    }
+
+    if (chrome) writeChromeTrace(out, records);
+    else writeCSV(out, records);
+
+    if (out != stdout) std::fclose(out);
+
+    if (skipped > 0) std::fprintf(stderr, "%" PRIu64 " incomplete record(s) skipped\n", skipped);
+
+    return 0;
+}